@@ -0,0 +1,328 @@
+/**
+ * @file async_log.c
+ * @brief Async Log Implementation
+ *
+ * 記錄放在固定數量、每筆 ASYNC_LOG_RECORD_SIZE 的槽位組成的環形緩衝區。
+ * 每個槽位有序號: 寫入端以 CAS 推進 tail 取得槽位,直接格式化到槽位內,
+ * 再以序號 pos + 1 發佈;背景執行緒 (唯一的讀取端) 依序讀取已發佈的
+ * 槽位,寫入 logger 後以 pos + 容量歸還。寫入端不配置記憶體、不加鎖
+ * 也不進入核心 (時間取自 vclock,真實時鐘下為 vDSO)。
+ *
+ * 限速狀態放在每個呼叫位置的 static 變數;視窗以 CAS 換新,
+ * 換新的一方負責回報上一個視窗的略過次數。曾經略過的呼叫位置
+ * 加入清單,背景執行緒替之後不再呼叫的位置補上摘要。
+ *
+ * @version 1.0.0
+ * @date 2025-12-07
+ */
+
+#include "async_log.h"
+#include "vclock.h"
+
+#ifndef TESTING
+  #ifdef OPENWRT_BUILD
+    #include <gaming/logger.h>
+  #else
+    #include "../../gaming-core/src/logger.h"
+  #endif
+#endif
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <signal.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 環形緩衝區的槽位數 (未寫出的記錄數;共約 68 KB) */
+#define ASYNC_LOG_QUEUE_SIZE    256
+
+/** 背景執行緒檢查佇列的間隔 */
+#define ASYNC_LOG_DRAIN_US      (20 * VCLOCK_US_PER_MS)
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct {
+    uint64_t seq;                       // pos: 可寫入, pos + 1: 已發佈 (atomic)
+    int level;
+    char text[ASYNC_LOG_RECORD_SIZE];
+} async_log_slot_t;
+
+typedef struct {
+    async_log_slot_t slots[ASYNC_LOG_QUEUE_SIZE];
+    uint64_t tail;                      // 下一個寫入位置 (atomic)
+    uint64_t head;                      // 下一個讀取位置 (只有讀取端使用)
+    bool running;                       // 背景執行緒運作中 (atomic)
+    bool stopping;                      // 要求背景執行緒結束 (atomic)
+    int min_level;                      // 執行期最低等級 (atomic)
+    uint32_t dropped;                   // 佇列滿時丟棄的筆數 (atomic)
+    async_log_site_t *sites;            // 曾經略過的呼叫位置 (atomic push)
+    pthread_t thread;
+} async_log_context_t;
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+static async_log_context_t g_async_log;
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+/**
+ * @brief 寫入 logger (背景執行緒,或未啟動時呼叫端)
+ */
+static void emit(int level, const char *text) {
+    #ifndef TESTING
+    switch (level) {
+        case ASYNC_LOG_DEBUG:   logger_debug("%s", text);   break;
+        case ASYNC_LOG_INFO:    logger_info("%s", text);    break;
+        case ASYNC_LOG_WARNING: logger_warning("%s", text); break;
+        default:                logger_error("%s", text);   break;
+    }
+    #else
+    static const char *const k_names[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+    fprintf(stderr, "[%s] %s\n", k_names[level & 3], text);
+    #endif
+}
+
+/**
+ * @brief 寫出已發佈的記錄 (背景執行緒;停止時由 async_log_stop 在 join 之後呼叫)
+ *
+ * 遇到已取得但尚未發佈的槽位即停止,下次再從該處繼續。
+ */
+static void drain_queue(void) {
+    async_log_context_t *ctx = &g_async_log;
+
+    for (;;) {
+        async_log_slot_t *slot = &ctx->slots[ctx->head % ASYNC_LOG_QUEUE_SIZE];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ctx->head + 1) {
+            break;
+        }
+        emit(slot->level, slot->text);
+        __atomic_store_n(&slot->seq, ctx->head + ASYNC_LOG_QUEUE_SIZE, __ATOMIC_RELEASE);
+        ctx->head++;
+    }
+
+    uint32_t dropped = __atomic_exchange_n(&g_async_log.dropped, 0, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        char text[64];
+        snprintf(text, sizeof(text), "Log queue full, dropped %u messages", dropped);
+        emit(ASYNC_LOG_WARNING, text);
+    }
+}
+
+/**
+ * @brief 取得一個可寫入的槽位
+ *
+ * @return 槽位 (寫入後以 publish_slot 發佈), NULL 表示緩衝區已滿
+ */
+static async_log_slot_t* claim_slot(uint64_t *pos_out) {
+    async_log_context_t *ctx = &g_async_log;
+    uint64_t pos = __atomic_load_n(&ctx->tail, __ATOMIC_RELAXED);
+
+    for (;;) {
+        async_log_slot_t *slot = &ctx->slots[pos % ASYNC_LOG_QUEUE_SIZE];
+        int64_t diff = (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ctx->tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *pos_out = pos;
+                return slot;
+            }
+        } else if (diff < 0) {
+            // 槽位還沒被讀取端歸還 (上一輪的記錄)
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&ctx->tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief 送出一筆記錄 (背景執行緒運作時格式化到槽位,否則直接寫入)
+ */
+static void vsubmit(int level, const char *fmt, va_list ap) {
+    if (!__atomic_load_n(&g_async_log.running, __ATOMIC_ACQUIRE)) {
+        char text[ASYNC_LOG_RECORD_SIZE];
+        if (vsnprintf(text, sizeof(text), fmt, ap) >= 0) {
+            emit(level, text);
+        }
+        return;
+    }
+
+    uint64_t pos;
+    async_log_slot_t *slot = claim_slot(&pos);
+    if (slot == NULL) {
+        __atomic_fetch_add(&g_async_log.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // 超過長度時截斷;格式錯誤仍須發佈,否則讀取端會停在此槽位
+    slot->level = level;
+    if (vsnprintf(slot->text, sizeof(slot->text), fmt, ap) < 0) {
+        slot->text[0] = '\0';
+    }
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+static void submit(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void submit(int level, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsubmit(level, fmt, ap);
+    va_end(ap);
+}
+
+/**
+ * @brief 回報上一個視窗略過的次數
+ */
+static void report_suppressed(const async_log_site_t *site, uint32_t suppressed) {
+    if (suppressed > 0) {
+        submit(site->level, "Message repeated %u more times (rate limited): %.160s",
+               suppressed, site->fmt);
+    }
+}
+
+/**
+ * @brief 視窗已過期時換新並回報略過次數 (同時換新時只有一方成功)
+ */
+static void roll_window(async_log_site_t *site, uint64_t now_ms) {
+    uint64_t start = __atomic_load_n(&site->window_start_ms, __ATOMIC_RELAXED);
+    if (now_ms - start < ASYNC_LOG_SITE_WINDOW_MS ||
+        !__atomic_compare_exchange_n(&site->window_start_ms, &start, now_ms, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    __atomic_store_n(&site->count, 0, __ATOMIC_RELAXED);
+    report_suppressed(site, __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief 加入背景執行緒檢查的清單 (只加入一次,之後不移除)
+ */
+static void list_site(async_log_site_t *site) {
+    if (__atomic_exchange_n(&site->listed, true, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    async_log_site_t *head = __atomic_load_n(&g_async_log.sites, __ATOMIC_RELAXED);
+    do {
+        site->next = head;
+    } while (!__atomic_compare_exchange_n(&g_async_log.sites, &head, site, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief 替已不再呼叫的位置補上略過次數 (背景執行緒與停止時)
+ *
+ * @param force 不等視窗結束 (停止時)
+ */
+static void flush_sites(bool force) {
+    uint64_t now_ms = vclock_now_ms();
+
+    for (async_log_site_t *site = __atomic_load_n(&g_async_log.sites, __ATOMIC_ACQUIRE);
+         site != NULL; site = site->next) {
+        if (__atomic_load_n(&site->suppressed, __ATOMIC_RELAXED) == 0) {
+            continue;
+        }
+        if (force) {
+            report_suppressed(site, __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED));
+        } else {
+            roll_window(site, now_ms);
+        }
+    }
+}
+
+static void* drain_thread(void *arg) {
+    (void)arg;
+
+    while (!__atomic_load_n(&g_async_log.stopping, __ATOMIC_ACQUIRE)) {
+        drain_queue();
+        flush_sites(false);
+        vclock_sleep_us(ASYNC_LOG_DRAIN_US);
+    }
+
+    drain_queue();
+    return NULL;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int async_log_start(int min_level) {
+    async_log_context_t *ctx = &g_async_log;
+
+    if (__atomic_load_n(&ctx->running, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    // 背景執行緒未運作,沒有其他寫入端或讀取端
+    for (uint64_t i = 0; i < ASYNC_LOG_QUEUE_SIZE; i++) {
+        ctx->slots[i].seq = i;
+    }
+    ctx->tail = 0;
+    ctx->head = 0;
+    __atomic_store_n(&ctx->min_level, min_level, __ATOMIC_RELAXED);
+    __atomic_store_n(&ctx->stopping, false, __ATOMIC_RELAXED);
+
+    // 信號只由主執行緒處理
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int rc = pthread_create(&ctx->thread, NULL, drain_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if (rc != 0) {
+        return -1;
+    }
+
+    __atomic_store_n(&ctx->running, true, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void async_log_stop(void) {
+    async_log_context_t *ctx = &g_async_log;
+
+    if (__atomic_load_n(&ctx->running, __ATOMIC_ACQUIRE)) {
+        // 之後的呼叫同步寫入
+        __atomic_store_n(&ctx->running, false, __ATOMIC_RELEASE);
+        __atomic_store_n(&ctx->stopping, true, __ATOMIC_RELEASE);
+        vclock_wake_sleepers();
+        pthread_join(ctx->thread, NULL);
+
+        // 背景執行緒最後一次讀取之後才放入的記錄
+        drain_queue();
+    }
+
+    flush_sites(true);
+}
+
+void async_log_write(async_log_site_t *site, int level, const char *fmt, ...) {
+    if (level < __atomic_load_n(&g_async_log.min_level, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    uint64_t now_ms = vclock_now_ms();
+    roll_window(site, now_ms);
+
+    uint32_t burst = (level >= ASYNC_LOG_ERROR) ? ASYNC_LOG_ERROR_BURST : ASYNC_LOG_SITE_BURST;
+    if (__atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED) >= burst) {
+        __atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+        list_site(site);
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, fmt);
+    vsubmit(level, fmt, ap);
+    va_end(ap);
+}
@@ -0,0 +1,167 @@
+/**
+ * @file async_log.h
+ * @brief Async Log - gaming-core logger 前的非同步、限速日誌層
+ *
+ * 此模組提供:
+ * - 呼叫端只把記錄格式化到無鎖環形緩衝區的固定大小槽位,
+ *   不配置記憶體,由背景執行緒寫入 logger (syslog 阻塞時不影響主循環)
+ * - 每個呼叫位置各自限速: ASYNC_LOG_SITE_WINDOW_MS 內最多
+ *   ASYNC_LOG_SITE_BURST 筆 (錯誤為 ASYNC_LOG_ERROR_BURST 筆),
+ *   其餘只計數,之後輸出 "repeated N times"
+ * - 編譯期等級過濾: 低於 ASYNC_LOG_MIN_LEVEL 的呼叫不產生任何程式碼
+ *   (參數仍做格式檢查)
+ *
+ * 佇列滿時丟棄新記錄並計數,呼叫端永不阻塞。
+ * async_log_start() 之前與 async_log_stop() 之後直接同步寫入 logger。
+ *
+ * 使用範例:
+ * @code
+ * logger_init(...);
+ * async_log_start(ASYNC_LOG_INFO);
+ *
+ * log_warning("Failed to query PS5 status (consecutive errors: %d)", errors);
+ *
+ * async_log_stop();       // 寫完剩餘記錄
+ * logger_cleanup();
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-07
+ * @version 1.0.0
+ */
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 日誌等級 (與 gaming-core log_level_t 順序相同,供前置處理器比較) */
+#define ASYNC_LOG_DEBUG             0
+#define ASYNC_LOG_INFO              1
+#define ASYNC_LOG_WARNING           2
+#define ASYNC_LOG_ERROR             3
+
+/** 編譯期最低等級 (例如 -DASYNC_LOG_MIN_LEVEL=1 移除所有 debug 日誌) */
+#ifndef ASYNC_LOG_MIN_LEVEL
+#define ASYNC_LOG_MIN_LEVEL         ASYNC_LOG_DEBUG
+#endif
+
+/** 每個呼叫位置的限速視窗 */
+#ifndef ASYNC_LOG_SITE_WINDOW_MS
+#define ASYNC_LOG_SITE_WINDOW_MS    60000
+#endif
+
+/** 每個視窗內每個呼叫位置最多輸出的筆數 */
+#ifndef ASYNC_LOG_SITE_BURST
+#define ASYNC_LOG_SITE_BURST        5
+#endif
+
+/** 錯誤等級的呼叫位置每個視窗最多輸出的筆數 (錯誤不應只留下前幾筆) */
+#ifndef ASYNC_LOG_ERROR_BURST
+#define ASYNC_LOG_ERROR_BURST       50
+#endif
+
+/** 一筆記錄的最大長度 (含 '\0',超過時截斷) */
+#define ASYNC_LOG_RECORD_SIZE       256
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 呼叫位置的限速狀態 (由巨集以 static 變數建立,不直接使用)
+ */
+typedef struct async_log_site {
+    const char *fmt;                /**< 格式字串 (摘要中識別呼叫位置) */
+    int level;
+    uint64_t window_start_ms;       /**< 目前視窗開始時間 (atomic) */
+    uint32_t count;                 /**< 視窗內的呼叫次數 (atomic) */
+    uint32_t suppressed;            /**< 尚未回報的略過次數 (atomic) */
+    bool listed;                    /**< 已加入背景執行緒檢查的清單 (atomic) */
+    struct async_log_site *next;
+} async_log_site_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 啟動背景寫入執行緒 (logger_init() 與 daemon() 之後)
+ *
+ * @param min_level 執行期最低等級,低於此等級的記錄不格式化
+ * @return 0 成功, -1 無法建立執行緒 (維持同步寫入)
+ */
+int async_log_start(int min_level);
+
+/**
+ * @brief 寫完佇列中的記錄與未回報的略過次數並停止執行緒
+ *
+ * 在其他會寫日誌的執行緒結束之後、logger_cleanup() 之前呼叫。
+ * 可重複呼叫;之後的日誌同步寫入。
+ */
+void async_log_stop(void);
+
+/**
+ * @brief 記錄一筆日誌 (經由 log_debug() 等巨集呼叫)
+ */
+void async_log_write(async_log_site_t *site, int level, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief 編譯期停用的等級: 只做格式檢查,不產生呼叫
+ */
+static inline void async_log_disabled(const char *fmt, ...)
+    __attribute__((format(printf, 1, 2)));
+static inline void async_log_disabled(const char *fmt, ...) {
+    (void)fmt;
+}
+
+/* ============================================================
+ *  Logging Macros
+ * ============================================================ */
+
+#define ASYNC_LOG_AT(lvl, msg, ...) do {                                        \
+    static async_log_site_t async_log_site_ = { .fmt = (msg), .level = (lvl) }; \
+    async_log_write(&async_log_site_, (lvl), msg, ##__VA_ARGS__);               \
+} while (0)
+
+#define ASYNC_LOG_OFF(msg, ...) do {                                            \
+    if (0) {                                                                    \
+        async_log_disabled(msg, ##__VA_ARGS__);                                 \
+    }                                                                           \
+} while (0)
+
+#if ASYNC_LOG_MIN_LEVEL <= ASYNC_LOG_DEBUG
+#define log_debug(msg, ...)     ASYNC_LOG_AT(ASYNC_LOG_DEBUG, msg, ##__VA_ARGS__)
+#else
+#define log_debug(msg, ...)     ASYNC_LOG_OFF(msg, ##__VA_ARGS__)
+#endif
+
+#if ASYNC_LOG_MIN_LEVEL <= ASYNC_LOG_INFO
+#define log_info(msg, ...)      ASYNC_LOG_AT(ASYNC_LOG_INFO, msg, ##__VA_ARGS__)
+#else
+#define log_info(msg, ...)      ASYNC_LOG_OFF(msg, ##__VA_ARGS__)
+#endif
+
+#if ASYNC_LOG_MIN_LEVEL <= ASYNC_LOG_WARNING
+#define log_warning(msg, ...)   ASYNC_LOG_AT(ASYNC_LOG_WARNING, msg, ##__VA_ARGS__)
+#else
+#define log_warning(msg, ...)   ASYNC_LOG_OFF(msg, ##__VA_ARGS__)
+#endif
+
+#define log_error(msg, ...)     ASYNC_LOG_AT(ASYNC_LOG_ERROR, msg, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ASYNC_LOG_H */
@@ -12,14 +12,16 @@
  */
 
 #include "cec_monitor.h"
+#include "metrics.h"
+#include "trace_ring.h"
+#include "vclock.h"
+#include "async_log.h"
 
 #ifndef TESTING
   #ifdef OPENWRT_BUILD
     #include <gaming-platform/platform_interface.h>
-    #include <gaming/logger.h>
   #else
     #include "../../gaming-platform/src/platform_interface.h"
-    #include "../../gaming-core/src/logger.h"
   #endif
 #endif
 
@@ -54,6 +56,7 @@ typedef struct {
     ps5_power_state_t last_state;
     time_t last_update_time;
     int consecutive_errors;
+    uint32_t poll_interval_ms;      // 以 __atomic 讀寫 (配置重新載入)
     
     // 回調函數
     ps5_state_callback_t state_callback;
@@ -67,6 +70,12 @@ typedef struct {
 
 static cec_monitor_context_t g_cec_ctx = {0};
 
+#ifdef TESTING
+/** 輪詢回報的電源狀態 (cec_monitor_test_set_power) */
+static ps5_power_state_t g_test_power = PS5_POWER_UNKNOWN;
+static bool g_test_power_set = false;
+#endif
+
 /* ============================================================
  *  Helper Functions
  * ============================================================ */
@@ -77,7 +86,10 @@ static cec_monitor_context_t g_cec_ctx = {0};
  */
 static ps5_power_state_t query_power_status(void) {
 #ifdef TESTING
-    // 測試模式: 返回當前狀態
+    // 測試模式: 返回 cec_monitor_test_set_power() 的設定,未設定時返回當前狀態
+    if (__atomic_load_n(&g_test_power_set, __ATOMIC_ACQUIRE)) {
+        return __atomic_load_n(&g_test_power, __ATOMIC_RELAXED);
+    }
     return g_cec_ctx.current_state;
 #else
     // ⭐ 使用 platform 接口查詢 PS5 電源狀態
@@ -109,14 +121,14 @@ static void change_ps5_state(ps5_power_state_t new_state) {
     ps5_power_state_t old_state = g_cec_ctx.current_state;
     g_cec_ctx.current_state = new_state;
     g_cec_ctx.last_state = old_state;
-    g_cec_ctx.last_update_time = time(NULL);
+    g_cec_ctx.last_update_time = vclock_time();
     
     pthread_mutex_unlock(&g_cec_ctx.mutex);
     
     #ifndef TESTING
-    logger_info("PS5 state changed: %s -> %s",
-               ps5_power_state_to_string(old_state),
-               ps5_power_state_to_string(new_state));
+    log_info("PS5 state changed: %s -> %s",
+            ps5_power_state_to_string(old_state),
+            ps5_power_state_to_string(new_state));
     #endif
     
     // 觸發回調
@@ -132,16 +144,21 @@ static void* monitor_thread_func(void *arg) {
     (void)arg;
     
     #ifndef TESTING
-    logger_info("CEC monitor thread started");
+    log_info("CEC monitor thread started");
     #endif
     
     while (g_cec_ctx.monitoring) {
         // 查詢PS5狀態
+        uint64_t start_us = metrics_now_us();
         ps5_power_state_t state = query_power_status();
+        uint64_t latency_us = metrics_now_us() - start_us;
+        metrics_observe(METRIC_CEC_QUERY_SECONDS, 0, latency_us);
         
         if (state != PS5_POWER_UNKNOWN) {
             // 查詢成功
+            metrics_inc(METRIC_CEC_QUERIES, METRICS_RESULT_OK);
             g_cec_ctx.consecutive_errors = 0;
+            metrics_set(METRIC_CEC_ERROR_STREAK, 0);
             
             // 狀態改變時更新
             if (state != g_cec_ctx.current_state) {
@@ -150,9 +167,12 @@ static void* monitor_thread_func(void *arg) {
         } else {
             // 查詢失敗
             g_cec_ctx.consecutive_errors++;
+            metrics_inc(METRIC_CEC_QUERIES, METRICS_RESULT_ERROR);
+            metrics_set(METRIC_CEC_ERROR_STREAK, g_cec_ctx.consecutive_errors);
+            metrics_set_max(METRIC_CEC_ERROR_STREAK_MAX, g_cec_ctx.consecutive_errors);
             
             #ifndef TESTING
-            logger_warning("Failed to query PS5 status (consecutive errors: %d)",
+            log_warning("Failed to query PS5 status (consecutive errors: %d)",
                        g_cec_ctx.consecutive_errors);
             #endif
             
@@ -164,12 +184,16 @@ static void* monitor_thread_func(void *arg) {
             }
         }
         
-        // 等待下次輪詢
-        usleep(CEC_POLL_INTERVAL_MS * 1000);
+        trace_ring_record(TRACE_CEC_POLL, (uint16_t)state, (uint32_t)latency_us,
+                          (uint32_t)g_cec_ctx.consecutive_errors);
+        
+        // 等待下次輪詢 (停止時由 vclock_wake_sleepers 提前喚醒)
+        uint32_t interval_ms = __atomic_load_n(&g_cec_ctx.poll_interval_ms, __ATOMIC_RELAXED);
+        vclock_sleep_us(interval_ms * VCLOCK_US_PER_MS);
     }
     
     #ifndef TESTING
-    logger_info("CEC monitor thread stopped");
+    log_info("CEC monitor thread stopped");
     #endif
     
     return NULL;
@@ -182,7 +206,7 @@ static void* monitor_thread_func(void *arg) {
 int cec_monitor_init(void) {
     if (g_cec_ctx.initialized) {
         #ifndef TESTING
-        logger_warning("CEC monitor already initialized");
+        log_warning("CEC monitor already initialized");
         #endif
         return 0;
     }
@@ -194,10 +218,11 @@ int cec_monitor_init(void) {
     g_cec_ctx.current_state = PS5_POWER_UNKNOWN;
     g_cec_ctx.last_state = PS5_POWER_UNKNOWN;
     g_cec_ctx.consecutive_errors = 0;
+    g_cec_ctx.poll_interval_ms = CEC_POLL_INTERVAL_MS;
     g_cec_ctx.initialized = true;
     
     #ifndef TESTING
-    logger_info("CEC monitor initialized (using platform interface)");
+    log_info("CEC monitor initialized (using platform interface)");
     #endif
     
     return 0;
@@ -218,7 +243,7 @@ void cec_monitor_cleanup(void) {
     g_cec_ctx.initialized = false;
     
     #ifndef TESTING
-    logger_info("CEC monitor cleaned up");
+    log_info("CEC monitor cleaned up");
     #endif
 }
 
@@ -237,14 +262,14 @@ int cec_monitor_start(void) {
     if (pthread_create(&g_cec_ctx.monitor_thread, NULL, 
                       monitor_thread_func, NULL) != 0) {
         #ifndef TESTING
-        logger_error("Failed to create monitor thread");
+        log_error("Failed to create monitor thread");
         #endif
         g_cec_ctx.monitoring = false;
         return -1;
     }
     
     #ifndef TESTING
-    logger_info("CEC monitoring started");
+    log_info("CEC monitoring started");
     #endif
     
     return 0;
@@ -256,12 +281,13 @@ void cec_monitor_stop(void) {
     }
     
     g_cec_ctx.monitoring = false;
+    vclock_wake_sleepers();
     
     // 等待執行緒結束
     pthread_join(g_cec_ctx.monitor_thread, NULL);
     
     #ifndef TESTING
-    logger_info("CEC monitoring stopped");
+    log_info("CEC monitoring stopped");
     #endif
 }
 
@@ -289,11 +315,30 @@ time_t cec_monitor_get_last_update_time(void) {
     return update_time;
 }
 
+void cec_monitor_restore(ps5_power_state_t state, time_t last_update_time) {
+    if (!g_cec_ctx.initialized || g_cec_ctx.monitoring) {
+        return;
+    }
+    
+    pthread_mutex_lock(&g_cec_ctx.mutex);
+    g_cec_ctx.current_state = state;
+    g_cec_ctx.last_state = state;
+    g_cec_ctx.last_update_time = last_update_time;
+    pthread_mutex_unlock(&g_cec_ctx.mutex);
+}
+
 void cec_monitor_set_callback(ps5_state_callback_t callback, void *user_data) {
     g_cec_ctx.state_callback = callback;
     g_cec_ctx.callback_data = user_data;
 }
 
+void cec_monitor_set_poll_interval(uint32_t interval_ms) {
+    if (interval_ms == 0) {
+        interval_ms = CEC_POLL_INTERVAL_MS;
+    }
+    __atomic_store_n(&g_cec_ctx.poll_interval_ms, interval_ms, __ATOMIC_RELAXED);
+}
+
 const char* ps5_power_state_to_string(ps5_power_state_t state) {
     switch (state) {
         case PS5_POWER_OFF:     return "OFF";
@@ -317,6 +362,14 @@ void cec_monitor_test_set_state(ps5_power_state_t state) {
     change_ps5_state(state);
 }
 
+/**
+ * @brief 設定之後輪詢回報的電源狀態 (測試用)
+ */
+void cec_monitor_test_set_power(ps5_power_state_t state) {
+    __atomic_store_n(&g_test_power, state, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_test_power_set, true, __ATOMIC_RELEASE);
+}
+
 /**
  * @brief 觸發狀態查詢 (測試用)
  */
@@ -99,6 +99,16 @@ ps5_power_state_t cec_monitor_get_state(void);
  */
 time_t cec_monitor_get_last_update_time(void);
 
+/**
+ * @brief Restore the power state from a previous process (before start)
+ * 
+ * The callback does not run; the first poll only reports a real change.
+ * 
+ * @param state Last known PS5 power state
+ * @param last_update_time When that state was observed
+ */
+void cec_monitor_restore(ps5_power_state_t state, time_t last_update_time);
+
 /**
  * @brief Set state change callback
  * 
@@ -107,6 +117,13 @@ time_t cec_monitor_get_last_update_time(void);
  */
 void cec_monitor_set_callback(ps5_state_callback_t callback, void *user_data);
 
+/**
+ * @brief Set the power poll interval (takes effect after the current wait)
+ * 
+ * @param interval_ms Poll interval in milliseconds (0 = default)
+ */
+void cec_monitor_set_poll_interval(uint32_t interval_ms);
+
 /**
  * @brief Convert PS5 power state to string
  * 
@@ -115,6 +132,29 @@ void cec_monitor_set_callback(ps5_state_callback_t callback, void *user_data);
  */
 const char* ps5_power_state_to_string(ps5_power_state_t state);
 
+#ifdef TESTING
+/* ============================================================
+ *  Test Helpers (TESTING only)
+ * ============================================================ */
+
+/**
+ * @brief Simulate a PS5 power state change (triggers the callback if changed)
+ */
+void cec_monitor_test_set_state(ps5_power_state_t state);
+
+/**
+ * @brief Set the power state reported by subsequent polls
+ * 
+ * PS5_POWER_UNKNOWN makes polls fail, as a CEC error would.
+ */
+void cec_monitor_test_set_power(ps5_power_state_t state);
+
+/**
+ * @brief Run one power query as the monitor thread would
+ */
+void cec_monitor_test_trigger_query(void);
+#endif // TESTING
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,224 @@
+/**
+ * @file input_journal.c
+ * @brief Input Journal Implementation
+ *
+ * 記錄寫入 stdio 緩衝區,主循環每次迭代呼叫 input_journal_flush(),
+ * 當機時最多遺失一個迭代 (約 100ms) 的輸入。
+ *
+ * 讀取時不完整的最後一筆 (寫入中當機) 視為檔案結束。
+ *
+ * @version 1.0.0
+ * @date 2025-12-01
+ */
+
+#include "input_journal.h"
+#include "vclock.h"
+
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct {
+    FILE *fp;                   // NULL 表示未記錄
+    uint64_t start_us;          // 開始記錄的單調時間
+    pthread_mutex_t mutex;
+} input_journal_context_t;
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+static input_journal_context_t g_journal = {
+    .fp = NULL,
+    .start_us = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static const char *const k_type_names[JOURNAL_TYPE_COUNT] = {
+    [JOURNAL_NONE]              = "none",
+    [JOURNAL_CEC_POWER]         = "cec_power",
+    [JOURNAL_DETECT]            = "detect",
+    [JOURNAL_CLIENT_CONNECT]    = "client_connect",
+    [JOURNAL_CLIENT_DISCONNECT] = "client_disconnect",
+    [JOURNAL_CLIENT_MESSAGE]    = "client_message",
+    [JOURNAL_TIMER]             = "timer",
+    [JOURNAL_WAKE_RESULT]       = "wake_result",
+};
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static int64_t realtime_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000LL + (int64_t)ts.tv_nsec / 1000;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int input_journal_start(const char *path) {
+    if (path == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_journal.mutex);
+
+    if (g_journal.fp != NULL) {
+        pthread_mutex_unlock(&g_journal.mutex);
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "wbe");
+    if (fp == NULL) {
+        pthread_mutex_unlock(&g_journal.mutex);
+        return -1;
+    }
+
+    journal_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_FILE_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_FILE_VERSION;
+    header.record_size = sizeof(journal_record_t);
+    header.start_realtime_us = realtime_us();
+
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 || fflush(fp) != 0) {
+        fclose(fp);
+        pthread_mutex_unlock(&g_journal.mutex);
+        return -1;
+    }
+
+    g_journal.start_us = vclock_now_us();
+    __atomic_store_n(&g_journal.fp, fp, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&g_journal.mutex);
+    return 0;
+}
+
+void input_journal_stop(void) {
+    pthread_mutex_lock(&g_journal.mutex);
+
+    if (g_journal.fp != NULL) {
+        fclose(g_journal.fp);
+        __atomic_store_n(&g_journal.fp, NULL, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&g_journal.mutex);
+}
+
+bool input_journal_active(void) {
+    return __atomic_load_n(&g_journal.fp, __ATOMIC_ACQUIRE) != NULL;
+}
+
+void input_journal_record(journal_type_t type, int32_t a0, int32_t a1,
+                          const void *payload, size_t len)
+{
+    if (!input_journal_active()) {
+        return;
+    }
+
+    if (payload == NULL) {
+        len = 0;
+    } else if (len > JOURNAL_MAX_PAYLOAD) {
+        len = JOURNAL_MAX_PAYLOAD;
+    }
+
+    journal_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.type = (uint16_t)type;
+    record.len = (uint16_t)len;
+    record.a0 = a0;
+    record.a1 = a1;
+
+    pthread_mutex_lock(&g_journal.mutex);
+
+    if (g_journal.fp != NULL) {
+        // 在鎖內取時間,檔案中的時間保持遞增
+        record.time_us = vclock_now_us() - g_journal.start_us;
+        fwrite(&record, sizeof(record), 1, g_journal.fp);
+        if (len > 0) {
+            fwrite(payload, 1, len, g_journal.fp);
+        }
+    }
+
+    pthread_mutex_unlock(&g_journal.mutex);
+}
+
+void input_journal_flush(void) {
+    if (!input_journal_active()) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_journal.mutex);
+    if (g_journal.fp != NULL) {
+        fflush(g_journal.fp);
+    }
+    pthread_mutex_unlock(&g_journal.mutex);
+}
+
+int input_journal_reader_open(input_journal_reader_t *reader, const char *path) {
+    if (reader == NULL || path == NULL) {
+        return -1;
+    }
+
+    memset(reader, 0, sizeof(*reader));
+    reader->fp = fopen(path, "rbe");
+    if (reader->fp == NULL) {
+        return -1;
+    }
+
+    if (fread(&reader->header, sizeof(reader->header), 1, reader->fp) != 1 ||
+        memcmp(reader->header.magic, JOURNAL_FILE_MAGIC, sizeof(reader->header.magic)) != 0 ||
+        reader->header.version != JOURNAL_FILE_VERSION ||
+        reader->header.record_size != sizeof(journal_record_t)) {
+        fclose(reader->fp);
+        reader->fp = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+int input_journal_reader_next(input_journal_reader_t *reader, journal_record_t *record,
+                              char *payload, size_t size)
+{
+    if (reader == NULL || reader->fp == NULL || record == NULL ||
+        payload == NULL || size == 0) {
+        return -1;
+    }
+
+    if (fread(record, sizeof(*record), 1, reader->fp) != 1) {
+        return 0;
+    }
+
+    if (record->len > JOURNAL_MAX_PAYLOAD || (size_t)record->len >= size) {
+        return -1;
+    }
+
+    if (record->len > 0 && fread(payload, 1, record->len, reader->fp) != record->len) {
+        return 0;
+    }
+    payload[record->len] = '\0';
+
+    return 1;
+}
+
+void input_journal_reader_close(input_journal_reader_t *reader) {
+    if (reader != NULL && reader->fp != NULL) {
+        fclose(reader->fp);
+        reader->fp = NULL;
+    }
+}
+
+const char* journal_type_to_string(journal_type_t type) {
+    if ((unsigned)type >= JOURNAL_TYPE_COUNT) {
+        return "unknown";
+    }
+    return k_type_names[type];
+}
@@ -0,0 +1,181 @@
+/**
+ * @file input_journal.h
+ * @brief Input Journal - 外部輸入的二進位記錄檔 (record/replay)
+ *
+ * 此模組提供:
+ * - 記錄所有影響 daemon 行為的外部輸入: CEC 電源回報、偵測結果、
+ *   客戶端連線/斷線/訊息、定時器觸發、喚醒結果
+ * - 每筆記錄附單調時鐘時間 (從開始記錄起算的微秒)
+ * - 讀取端逐筆讀出,供 TESTING 版本的 --replay 以虛擬時鐘全速重播
+ *
+ * 檔案格式 (本機位元組順序): journal_file_header_t 後接多筆
+ * journal_record_t + len bytes 的內容 (客戶端 IP、訊息 JSON)。
+ *
+ * 寫入端以 mutex 串接 (CEC、喚醒與主執行緒皆會記錄),由主循環
+ * 定期呼叫 input_journal_flush() 寫入檔案。
+ *
+ * 使用範例:
+ * @code
+ * input_journal_start("/tmp/gaming-server.journal");
+ * input_journal_record(JOURNAL_CLIENT_MESSAGE, client_id, msg_type, json, strlen(json));
+ *
+ * input_journal_reader_t reader;
+ * input_journal_reader_open(&reader, path);
+ * while (input_journal_reader_next(&reader, &record, payload, sizeof(payload)) > 0) {
+ *     ...
+ * }
+ * input_journal_reader_close(&reader);
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-01
+ * @version 1.0.0
+ */
+
+#ifndef INPUT_JOURNAL_H
+#define INPUT_JOURNAL_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 檔案標頭 magic */
+#define JOURNAL_FILE_MAGIC          "GSJRNL01"
+
+/** 檔案格式版本 */
+#define JOURNAL_FILE_VERSION        1
+
+/** 單筆內容上限 (與 WS_SERVER_MAX_MESSAGE_SIZE 相同) */
+#define JOURNAL_MAX_PAYLOAD         4096
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 輸入類型 (數值寫入檔案,已發佈的值不可更改)
+ */
+typedef enum {
+    JOURNAL_NONE = 0,
+    JOURNAL_CEC_POWER = 1,          /**< a0=ps5_power_state_t */
+    JOURNAL_DETECT = 2,             /**< a0=偵測結果碼, a1=是否在線 */
+    JOURNAL_CLIENT_CONNECT = 3,     /**< a0=客戶端 ID, 內容=IP */
+    JOURNAL_CLIENT_DISCONNECT = 4,  /**< a0=客戶端 ID */
+    JOURNAL_CLIENT_MESSAGE = 5,     /**< a0=客戶端 ID, a1=ws_message_type_t, 內容=訊息 */
+    JOURNAL_TIMER = 6,              /**< a0=journal_timer_t */
+    JOURNAL_WAKE_RESULT = 7,        /**< a0=是否成功 */
+    JOURNAL_TYPE_COUNT
+} journal_type_t;
+
+/**
+ * @brief 定時器 (JOURNAL_TIMER 的 a0)
+ */
+typedef enum {
+    JOURNAL_TIMER_STATS = 1,        /**< 主循環的定期統計廣播 */
+} journal_timer_t;
+
+/**
+ * @brief 一筆記錄 (24 bytes,後接 len bytes 內容)
+ */
+typedef struct {
+    uint64_t time_us;       /**< 從開始記錄起算的單調時間 (微秒) */
+    uint16_t type;          /**< journal_type_t */
+    uint16_t len;           /**< 內容長度 */
+    int32_t a0;
+    int32_t a1;
+    uint32_t reserved;
+} journal_record_t;
+
+/**
+ * @brief 檔案標頭
+ */
+typedef struct {
+    char magic[8];              /**< JOURNAL_FILE_MAGIC (不含 '\0') */
+    uint32_t version;           /**< JOURNAL_FILE_VERSION */
+    uint32_t record_size;       /**< sizeof(journal_record_t) */
+    int64_t start_realtime_us;  /**< 開始記錄時的 CLOCK_REALTIME */
+} journal_file_header_t;
+
+/**
+ * @brief 讀取端
+ */
+typedef struct {
+    FILE *fp;
+    journal_file_header_t header;
+} input_journal_reader_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 開始記錄 (建立或覆寫檔案)
+ *
+ * @return 0 成功, -1 已在記錄或無法建立檔案
+ */
+int input_journal_start(const char *path);
+
+/**
+ * @brief 停止記錄並關閉檔案
+ */
+void input_journal_stop(void);
+
+/**
+ * @brief 是否正在記錄
+ */
+bool input_journal_active(void);
+
+/**
+ * @brief 記錄一筆輸入 (任何執行緒;未記錄時直接返回)
+ *
+ * @param payload 內容 (可為 NULL),超過 JOURNAL_MAX_PAYLOAD 時截斷
+ */
+void input_journal_record(journal_type_t type, int32_t a0, int32_t a1,
+                          const void *payload, size_t len);
+
+/**
+ * @brief 將緩衝的記錄寫入檔案
+ */
+void input_journal_flush(void);
+
+/**
+ * @brief 開啟記錄檔
+ *
+ * @return 0 成功, -1 無法開啟或格式不符
+ */
+int input_journal_reader_open(input_journal_reader_t *reader, const char *path);
+
+/**
+ * @brief 讀取下一筆
+ *
+ * @param payload 內容輸出 (以 '\0' 結尾)
+ * @param size payload 大小 (至少 JOURNAL_MAX_PAYLOAD + 1)
+ * @return 1 讀到一筆, 0 檔案結束, -1 格式錯誤
+ */
+int input_journal_reader_next(input_journal_reader_t *reader, journal_record_t *record,
+                              char *payload, size_t size);
+
+/**
+ * @brief 關閉記錄檔
+ */
+void input_journal_reader_close(input_journal_reader_t *reader);
+
+/**
+ * @brief 輸入類型名稱 (例如 "client_message")
+ */
+const char* journal_type_to_string(journal_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INPUT_JOURNAL_H */
@@ -0,0 +1,251 @@
+/**
+ * @file json_writer.c
+ * @brief Streaming JSON Writer Implementation
+ *
+ * 所有輸出直接寫入呼叫者的緩衝區,不做任何動態配置。
+ * 任何一次寫入失敗都會設定 overflow,之後的寫入全部忽略,
+ * 因此呼叫者只需在最後檢查 json_writer_finish() 的結果。
+ *
+ * @version 1.0.0
+ * @date 2025-11-20
+ */
+
+#include "json_writer.h"
+
+#include <string.h>
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static const char g_hex_digits[] = "0123456789abcdef";
+
+/**
+ * @brief 寫入原始位元組 (保留 1 byte 給結尾 '\0')
+ */
+static void put_bytes(json_writer_t *w, const char *data, size_t len) {
+    if (w->overflow) {
+        return;
+    }
+
+    if (w->len + len + 1 > w->cap) {
+        w->overflow = true;
+        return;
+    }
+
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+static void put_char(json_writer_t *w, char c) {
+    if (w->overflow) {
+        return;
+    }
+
+    if (w->len + 2 > w->cap) {
+        w->overflow = true;
+        return;
+    }
+
+    w->buf[w->len++] = c;
+}
+
+/**
+ * @brief 寫入值之前的分隔符號
+ */
+static void begin_value(json_writer_t *w) {
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+
+    uint32_t bit = 1u << w->depth;
+    if (w->has_items & bit) {
+        put_char(w, ',');
+    }
+    w->has_items |= bit;
+}
+
+/**
+ * @brief 寫入跳脫後的字串 (含前後引號)
+ */
+static void put_escaped(json_writer_t *w, const char *s, size_t len) {
+    put_char(w, '"');
+
+    const char *run = s;
+    const char *end = s + len;
+    for (const char *p = s; p < end; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        // 先寫出不需跳脫的連續區段
+        put_bytes(w, run, (size_t)(p - run));
+        run = p + 1;
+
+        switch (c) {
+            case '"':  put_bytes(w, "\\\"", 2); break;
+            case '\\': put_bytes(w, "\\\\", 2); break;
+            case '\b': put_bytes(w, "\\b", 2);  break;
+            case '\f': put_bytes(w, "\\f", 2);  break;
+            case '\n': put_bytes(w, "\\n", 2);  break;
+            case '\r': put_bytes(w, "\\r", 2);  break;
+            case '\t': put_bytes(w, "\\t", 2);  break;
+            default: {
+                char esc[6] = { '\\', 'u', '0', '0',
+                                g_hex_digits[c >> 4], g_hex_digits[c & 0x0F] };
+                put_bytes(w, esc, sizeof(esc));
+                break;
+            }
+        }
+    }
+    put_bytes(w, run, (size_t)(end - run));
+
+    put_char(w, '"');
+}
+
+static void open_container(json_writer_t *w, char c) {
+    begin_value(w);
+
+    if (w->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        w->overflow = true;
+        return;
+    }
+
+    put_char(w, c);
+    w->depth++;
+    w->has_items &= ~(1u << w->depth);
+}
+
+static void close_container(json_writer_t *w, char c) {
+    if (w->depth <= 0) {
+        w->overflow = true;
+        return;
+    }
+
+    w->depth--;
+    put_char(w, c);
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap) {
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->cap = cap;
+    w->overflow = (buf == NULL || cap == 0);
+}
+
+void json_writer_begin_object(json_writer_t *w) {
+    open_container(w, '{');
+}
+
+void json_writer_end_object(json_writer_t *w) {
+    close_container(w, '}');
+}
+
+void json_writer_begin_array(json_writer_t *w) {
+    open_container(w, '[');
+}
+
+void json_writer_end_array(json_writer_t *w) {
+    close_container(w, ']');
+}
+
+void json_writer_key(json_writer_t *w, const char *key) {
+    key = key ? key : "";
+    json_writer_key_len(w, key, strlen(key));
+}
+
+void json_writer_key_len(json_writer_t *w, const char *key, size_t len) {
+    begin_value(w);
+    put_escaped(w, key, len);
+    put_char(w, ':');
+    w->after_key = true;
+}
+
+void json_writer_string(json_writer_t *w, const char *value) {
+    if (value == NULL) {
+        json_writer_null(w);
+        return;
+    }
+
+    json_writer_string_len(w, value, strlen(value));
+}
+
+void json_writer_string_len(json_writer_t *w, const char *value, size_t len) {
+    begin_value(w);
+    put_escaped(w, value, len);
+}
+
+void json_writer_int(json_writer_t *w, int64_t value) {
+    char digits[21];
+    int pos = sizeof(digits);
+
+    // 以無號數處理,避免 INT64_MIN 取負溢位
+    uint64_t v = (value < 0) ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    do {
+        digits[--pos] = (char)('0' + (v % 10));
+        v /= 10;
+    } while (v != 0);
+
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+
+    begin_value(w);
+    put_bytes(w, digits + pos, sizeof(digits) - (size_t)pos);
+}
+
+void json_writer_bool(json_writer_t *w, bool value) {
+    begin_value(w);
+    if (value) {
+        put_bytes(w, "true", 4);
+    } else {
+        put_bytes(w, "false", 5);
+    }
+}
+
+void json_writer_null(json_writer_t *w) {
+    begin_value(w);
+    put_bytes(w, "null", 4);
+}
+
+void json_writer_raw(json_writer_t *w, const char *json, size_t len) {
+    begin_value(w);
+    put_bytes(w, json, len);
+}
+
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value) {
+    json_writer_key(w, key);
+    json_writer_string(w, value);
+}
+
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value) {
+    json_writer_key(w, key);
+    json_writer_int(w, value);
+}
+
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value) {
+    json_writer_key(w, key);
+    json_writer_bool(w, value);
+}
+
+const char* json_writer_finish(json_writer_t *w) {
+    if (w->overflow || w->depth != 0 || w->after_key) {
+        if (w->buf != NULL && w->cap > 0) {
+            w->buf[0] = '\0';
+        }
+        return NULL;
+    }
+
+    w->buf[w->len] = '\0';
+    return w->buf;
+}
+
+size_t json_writer_length(const json_writer_t *w) {
+    return w->len;
+}
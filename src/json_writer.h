@@ -0,0 +1,175 @@
+/**
+ * @file json_writer.h
+ * @brief Streaming JSON Writer - 零配置 JSON 輸出
+ *
+ * 此模組直接將 JSON 寫入呼叫者提供的緩衝區:
+ * - 不建立中介樹狀結構 (不使用 cJSON 物件)
+ * - 不呼叫 malloc()
+ * - 自動處理逗號與字串跳脫 (RFC 8259)
+ * - 緩衝區不足時標記溢位,由 json_writer_finish() 回報
+ *
+ * 使用範例:
+ * @code
+ * char buf[128];
+ * json_writer_t w;
+ * json_writer_init(&w, buf, sizeof(buf));
+ * json_writer_begin_object(&w);
+ * json_writer_kv_string(&w, "type", "ps5_status");
+ * json_writer_kv_bool(&w, "online", true);
+ * json_writer_end_object(&w);
+ * const char *json = json_writer_finish(&w);  // NULL 表示溢位
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-20
+ * @version 1.0.0
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 最大巢狀深度 */
+#define JSON_WRITER_MAX_DEPTH   16
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief JSON Writer 狀態 (可放在堆疊上)
+ */
+typedef struct {
+    char *buf;                  /**< 輸出緩衝區 */
+    size_t cap;                 /**< 緩衝區容量 (含結尾 '\0') */
+    size_t len;                 /**< 已寫入長度 */
+    int depth;                  /**< 目前巢狀深度 */
+    uint32_t has_items;         /**< 每層是否已有元素 (決定是否需要逗號) */
+    bool after_key;             /**< 剛寫完 key,下一個值不需逗號 */
+    bool overflow;              /**< 緩衝區不足或巢狀過深 */
+} json_writer_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 初始化 Writer
+ *
+ * @param w Writer
+ * @param buf 輸出緩衝區
+ * @param cap 緩衝區大小 (bytes)
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t cap);
+
+/**
+ * @brief 開始物件 '{'
+ */
+void json_writer_begin_object(json_writer_t *w);
+
+/**
+ * @brief 結束物件 '}'
+ */
+void json_writer_end_object(json_writer_t *w);
+
+/**
+ * @brief 開始陣列 '['
+ */
+void json_writer_begin_array(json_writer_t *w);
+
+/**
+ * @brief 結束陣列 ']'
+ */
+void json_writer_end_array(json_writer_t *w);
+
+/**
+ * @brief 寫入物件的 key (之後必須接一個值)
+ *
+ * @param w Writer
+ * @param key Key 字串 (會進行跳脫)
+ */
+void json_writer_key(json_writer_t *w, const char *key);
+
+/**
+ * @brief 寫入指定長度的 key (不需以 '\0' 結尾)
+ */
+void json_writer_key_len(json_writer_t *w, const char *key, size_t len);
+
+/**
+ * @brief 寫入字串值 (NULL 寫成 null)
+ */
+void json_writer_string(json_writer_t *w, const char *value);
+
+/**
+ * @brief 寫入指定長度的字串值 (不需以 '\0' 結尾)
+ */
+void json_writer_string_len(json_writer_t *w, const char *value, size_t len);
+
+/**
+ * @brief 寫入整數值
+ */
+void json_writer_int(json_writer_t *w, int64_t value);
+
+/**
+ * @brief 寫入布林值
+ */
+void json_writer_bool(json_writer_t *w, bool value);
+
+/**
+ * @brief 寫入 null
+ */
+void json_writer_null(json_writer_t *w);
+
+/**
+ * @brief 寫入預先序列化的 JSON 片段 (不做跳脫)
+ *
+ * @param w Writer
+ * @param json 合法的 JSON 值
+ * @param len 長度
+ */
+void json_writer_raw(json_writer_t *w, const char *json, size_t len);
+
+/**
+ * @brief 寫入 "key":"value"
+ */
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value);
+
+/**
+ * @brief 寫入 "key":整數
+ */
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value);
+
+/**
+ * @brief 寫入 "key":true/false
+ */
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value);
+
+/**
+ * @brief 完成輸出並加上結尾 '\0'
+ *
+ * @param w Writer
+ * @return 緩衝區指標, NULL 表示溢位或物件/陣列未關閉
+ */
+const char* json_writer_finish(json_writer_t *w);
+
+/**
+ * @brief 取得目前輸出長度 (不含 '\0')
+ */
+size_t json_writer_length(const json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSON_WRITER_H */
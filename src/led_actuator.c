@@ -0,0 +1,176 @@
+/**
+ * @file led_actuator.c
+ * @brief LED Actuator Implementation
+ *
+ * 呼叫端只在 mutex 內更新目標狀態,背景執行緒在 mutex 外呼叫 apply,
+ * 因此狀態轉換不會等待 sysfs/GPIO。
+ *
+ * 間隔使用 CLOCK_MONOTONIC 的 pthread_cond_timedwait;等待期間
+ * 目標狀態可能再改變,醒來時一律取最新的目標。
+ *
+ * @version 1.0.0
+ * @date 2025-11-30
+ */
+
+#include "led_actuator.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct {
+    bool initialized;
+    bool running;
+    led_actuator_apply_t apply;
+    uint32_t min_dwell_ms;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+
+    int desired;                // 最新的目標狀態
+    bool pending;               // desired 尚未處理
+    int applied;                // 最後輸出的狀態
+    bool has_applied;           // 是否輸出過
+    uint64_t applied_ms;        // 最後輸出時間
+} led_actuator_context_t;
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+static led_actuator_context_t g_led_ctx = {0};
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+/**
+ * @brief 輸出目標狀態 (呼叫時持有 mutex,apply 期間釋放)
+ */
+static void apply_desired(void) {
+    int state = g_led_ctx.desired;
+    g_led_ctx.pending = false;
+
+    if (g_led_ctx.has_applied && state == g_led_ctx.applied) {
+        return;
+    }
+
+    pthread_mutex_unlock(&g_led_ctx.mutex);
+    g_led_ctx.apply(state);
+    pthread_mutex_lock(&g_led_ctx.mutex);
+
+    g_led_ctx.applied = state;
+    g_led_ctx.has_applied = true;
+    g_led_ctx.applied_ms = monotonic_ms();
+}
+
+static void* actuator_thread(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_led_ctx.mutex);
+
+    while (g_led_ctx.running) {
+        if (!g_led_ctx.pending) {
+            pthread_cond_wait(&g_led_ctx.cond, &g_led_ctx.mutex);
+            continue;
+        }
+
+        // 間隔未到: 等到期限 (期間的新要求會覆蓋 desired)
+        uint64_t ready_ms = g_led_ctx.applied_ms + g_led_ctx.min_dwell_ms;
+        if (g_led_ctx.has_applied && monotonic_ms() < ready_ms) {
+            struct timespec deadline = {
+                .tv_sec = (time_t)(ready_ms / 1000),
+                .tv_nsec = (long)(ready_ms % 1000) * 1000000L,
+            };
+            pthread_cond_timedwait(&g_led_ctx.cond, &g_led_ctx.mutex, &deadline);
+            continue;
+        }
+
+        apply_desired();
+    }
+
+    pthread_mutex_unlock(&g_led_ctx.mutex);
+    return NULL;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int led_actuator_init(led_actuator_apply_t apply, uint32_t min_dwell_ms) {
+    if (apply == NULL || g_led_ctx.initialized) {
+        return -1;
+    }
+
+    memset(&g_led_ctx, 0, sizeof(g_led_ctx));
+    g_led_ctx.apply = apply;
+    g_led_ctx.min_dwell_ms = min_dwell_ms;
+    g_led_ctx.running = true;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_led_ctx.cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&g_led_ctx.mutex, NULL);
+
+    if (pthread_create(&g_led_ctx.thread, NULL, actuator_thread, NULL) != 0) {
+        pthread_cond_destroy(&g_led_ctx.cond);
+        pthread_mutex_destroy(&g_led_ctx.mutex);
+        return -2;
+    }
+
+    __atomic_store_n(&g_led_ctx.initialized, true, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void led_actuator_cleanup(void) {
+    if (!g_led_ctx.initialized) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_led_ctx.mutex);
+    g_led_ctx.running = false;
+    pthread_cond_signal(&g_led_ctx.cond);
+    pthread_mutex_unlock(&g_led_ctx.mutex);
+
+    pthread_join(g_led_ctx.thread, NULL);
+
+    // 結束前輸出最後的目標狀態
+    pthread_mutex_lock(&g_led_ctx.mutex);
+    if (g_led_ctx.pending) {
+        apply_desired();
+    }
+    __atomic_store_n(&g_led_ctx.initialized, false, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_led_ctx.mutex);
+
+    pthread_cond_destroy(&g_led_ctx.cond);
+    pthread_mutex_destroy(&g_led_ctx.mutex);
+}
+
+void led_actuator_set(int state) {
+    if (!__atomic_load_n(&g_led_ctx.initialized, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_led_ctx.mutex);
+    g_led_ctx.desired = state;
+    if (!g_led_ctx.pending) {
+        g_led_ctx.pending = true;
+        pthread_cond_signal(&g_led_ctx.cond);
+    }
+    pthread_mutex_unlock(&g_led_ctx.mutex);
+}
+
@@ -0,0 +1,72 @@
+/**
+ * @file led_actuator.h
+ * @brief LED Actuator - 合併、去重並限速的背景 LED 輸出
+ *
+ * 此模組提供:
+ * - led_actuator_set() 只記錄目標狀態並喚醒背景執行緒,不做 I/O
+ * - 與目前輸出相同的狀態略過 (去重)
+ * - 兩次輸出至少間隔 min_dwell_ms;期間的多次要求只輸出最後一個 (合併)
+ * - 實際輸出由呼叫者提供的 apply 函數執行 (例如 platform_set_led_state)
+ *
+ * 狀態以 int 表示,模組本身不依賴 platform 定義。
+ *
+ * 使用範例:
+ * @code
+ * led_actuator_init(apply_led, 250);
+ * led_actuator_set(LED_STATE_WAKING);    // 立即返回
+ * led_actuator_cleanup();                // 輸出尚未套用的狀態後結束
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-30
+ * @version 1.0.0
+ */
+
+#ifndef LED_ACTUATOR_H
+#define LED_ACTUATOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 實際輸出 LED 狀態 (在背景執行緒呼叫)
+ */
+typedef void (*led_actuator_apply_t)(int state);
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 啟動背景執行緒
+ *
+ * @param apply 輸出函數
+ * @param min_dwell_ms 兩次輸出的最小間隔 (0 表示不限制)
+ * @return 0 成功, -1 參數錯誤或已啟動, -2 執行緒建立失敗
+ */
+int led_actuator_init(led_actuator_apply_t apply, uint32_t min_dwell_ms);
+
+/**
+ * @brief 停止背景執行緒,並輸出尚未套用的狀態 (不等待間隔)
+ */
+void led_actuator_cleanup(void);
+
+/**
+ * @brief 設定目標狀態 (任何執行緒,不等待 I/O)
+ *
+ * 尚未啟動時忽略。
+ */
+void led_actuator_set(int state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_ACTUATOR_H */
@@ -17,6 +17,18 @@
 #include "ps5_wake.h"
 #include "ps5_detector.h"
 #include "websocket_server.h"
+#include "json_writer.h"
+#include "status_snapshot.h"
+#include "ws_cbor.h"
+#include "metrics.h"
+#include "trace_ring.h"
+#include "input_journal.h"
+#include "vclock.h"
+#include "server_config.h"
+#include "upgrade_handoff.h"
+#include "state_store.h"
+#include "readiness.h"
+#include "async_log.h"
 
 #ifndef TESTING
   #ifdef OPENWRT_BUILD
@@ -37,6 +49,10 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <cjson/cJSON.h>
 
 /* ============================================================
  *  Constants
@@ -47,40 +63,191 @@
 
 // Default configuration values
 #define DEFAULT_WS_PORT             8080
+#define DEFAULT_WS_WORKERS          1
 #define DEFAULT_PS5_SUBNET          "192.168.1.0/24"
 #define DEFAULT_CACHE_PATH          "/var/run/gaming/ps5_cache.json"
+#define DEFAULT_CEC_POLL_MS         5000
+#define DEFAULT_NETWORK_REFRESH_S   10
+
+// Outbound message buffer size
+#define STATUS_MESSAGE_SIZE         256
+#define SUBSCRIBE_REPLY_SIZE        512
+
+// Request id (JSON 文字, 含引號與跳脫)
+#define REQUEST_ID_SIZE             80
+#define REQUEST_ID_MAX_STRING       64
+
+// 等待喚醒結果的請求數上限
+#define MAX_PENDING_WAKES           (WS_SERVER_MAX_CLIENTS * WS_SERVER_MAX_IN_FLIGHT)
+
+// 一頁 debug_dump 最多的記錄數 (每筆最多約 96 bytes,需放入一則訊息)
+#define DEBUG_DUMP_PAGE_RECORDS     32
+
+// 主循環最長的等待 (I/O、信號與定時器期限會提前喚醒)
+#define MAIN_LOOP_MAX_WAIT_US       (1000 * VCLOCK_US_PER_MS)
+
+// 平滑升級等待新程序回應時的檢查間隔
+#define UPGRADE_POLL_US             (10 * VCLOCK_US_PER_MS)
+
+// 執行狀態的最短寫入間隔 (期間的變動合併為一次寫入)
+#define STATE_SAVE_MIN_INTERVAL_US  (30 * VCLOCK_US_PER_SEC)
+
+// warm start 時跳過的快照版本 (上次寫入之後、異常結束之前可能已發佈的版本)
+#define WARM_START_VERSION_SKIP     1000
+
+// 程序啟動到開始 accept 的目標時間
+#define STARTUP_TARGET_MS           300
 
 /* ============================================================
  *  Global Variables
  * ============================================================ */
 
 static volatile sig_atomic_t g_running = 1;
+static volatile sig_atomic_t g_trace_dump_requested = 0;
+static volatile sig_atomic_t g_reload_requested = 0;
+static volatile sig_atomic_t g_upgrade_requested = 0;
+static volatile sig_atomic_t g_shutdown_signal = 0;     /**< 要求結束的信號 (主循環記錄) */
+static const char *g_trace_path = TRACE_DEFAULT_DUMP_PATH;
 static server_context_t *g_server_ctx = NULL;
 
+/** 命令列指定的配置 (SERVER_CONFIG_* 標示哪些欄位),優先於 UCI */
+static server_config_t g_cli_config;
+static uint32_t g_cli_options = 0;
+
+/** 定期網路檢查的 vclock 定時器 */
+static int g_refresh_timer = -1;
+
+/**
+ * @brief 平滑升級 (SIGUSR2) 的進度
+ *
+ * 舊程序: fd 為與新程序的交接通道,等待 HELLO 直到 deadline_ms。
+ * 新程序: fd 為繼承的交接通道,adopted 表示狀態已由舊程序交接。
+ */
+typedef struct {
+    int fd;
+    pid_t pid;
+    uint64_t deadline_ms;
+    bool adopted;
+    bool handed_off;            /**< 舊程序: 已交接給新程序 */
+    char exec_path[PATH_MAX];   /**< 啟動時解析的執行檔 (升級時已被替換) */
+    char **argv;
+} upgrade_context_t;
+
+static upgrade_context_t g_upgrade = { .fd = -1, .pid = -1 };
+
+/**
+ * @brief 啟動進度
+ *
+ * platform_init() (CEC/LED 硬體) 在背景執行緒進行,期間伺服器已開始
+ * accept,並以 warm start 快照與偵測快取回答查詢;完成後主循環才啟動
+ * 狀態機、LED 與 CEC 監控。
+ */
+typedef struct {
+    uint64_t start_us;          /**< 程序啟動時間 (metrics_now_us) */
+    uint64_t accept_us;         /**< 開始 accept 的時間 (相對 start_us) */
+    pthread_t platform_thread;
+    bool thread_started;
+    bool platform_done;         /**< platform_init() 已返回 (atomic) */
+    int platform_result;        /**< platform_init() 的結果 */
+    bool platform_checked;      /**< finish_platform_init() 已執行 */
+    bool platform_ok;           /**< platform 可用 (結束時需要 platform_cleanup) */
+    bool complete;              /**< 狀態機與 CEC 監控已啟動 */
+    bool failed;                /**< platform 無法使用,程序結束 */
+    bool state_recorded;        /**< 已記錄第一次確認狀態的時間 (atomic) */
+} startup_context_t;
+
+static startup_context_t g_startup;
+
+/**
+ * @brief stats 主題的統計值 (用於計算差異)
+ */
+typedef struct {
+    int clients;                /**< 連線客戶端數 */
+    uint64_t state_version;     /**< 狀態快照版本 */
+    unsigned int wake_requests; /**< 喚醒請求次數 */
+    unsigned int rate_limited;  /**< 超過速率被拒絕的訊息數 */
+} server_stats_t;
+
+static unsigned int g_wake_requests = 0;
+static server_stats_t g_last_stats = {0};
+
+/** 第一個尚未開機的喚醒請求時間 (metrics_now_us), 0 表示沒有 */
+static uint64_t g_wake_started_us = 0;
+
+/**
+ * 持久化的狀態有變動 (任何執行緒設定,主循環寫入)。喚醒次數不設定,
+ * 只在結束與升級交接時寫入。
+ */
+static bool g_state_dirty = false;
+
+/** 合併寫入的定時器, -1 表示沒有 */
+static int g_state_save_timer = -1;
+
+/** 上次寫入的時間 (vclock_now_us), 0 表示尚未寫入 */
+static uint64_t g_state_saved_us = 0;
+
+/** 最後寫入的執行狀態 (偵測快取暫時無效時沿用) */
+static state_store_record_t g_saved_state;
+
+/** 重播中: CEC 輸入全部來自記錄檔,不啟動監控執行緒 */
+static bool g_replaying = false;
+
+/**
+ * @brief 客戶端請求的 id (原樣回傳於回應中)
+ */
+typedef struct {
+    char json[REQUEST_ID_SIZE];     /**< id 的 JSON 表示, 空字串表示未提供 */
+} request_id_t;
+
+/**
+ * @brief 等待喚醒結果的請求
+ */
+typedef struct {
+    int client_id;
+    request_id_t id;
+} pending_wake_t;
+
+static pending_wake_t g_pending_wakes[MAX_PENDING_WAKES];
+static int g_pending_wake_count = 0;
+static pthread_mutex_t g_pending_wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* ============================================================
  *  Signal Handlers
  * ============================================================ */
 
 static void signal_handler(int signum) {
+    int saved_errno = errno;
+    
     switch (signum) {
         case SIGINT:
         case SIGTERM:
-            #ifndef TESTING
-            logger_info("Received signal %d, shutting down...", signum);
-            #endif
+            // 記錄在主循環輸出 (日誌會取鎖,不可在信號處理中執行)
+            g_shutdown_signal = signum;
             g_running = 0;
             break;
         
         case SIGHUP:
-            #ifndef TESTING
-            logger_info("Received SIGHUP, reloading configuration...");
-            #endif
-            // TODO: 重新載入配置
+            // 在主循環重新載入 (UCI 讀取與套用不可在信號處理中執行)
+            g_reload_requested = 1;
+            break;
+        
+        case SIGUSR1:
+            // 在主循環輸出 (檔案 I/O 不可在信號處理中執行)
+            g_trace_dump_requested = 1;
+            break;
+        
+        case SIGUSR2:
+            // 在主循環啟動新程序並交接
+            g_upgrade_requested = 1;
             break;
         
         default:
             break;
     }
+    
+    // 主循環可能正在等待 I/O: 立即處理旗標
+    ws_server_wake();
+    errno = saved_errno;
 }
 
 static void setup_signal_handlers(void) {
@@ -93,11 +260,796 @@ static void setup_signal_handlers(void) {
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
     sigaction(SIGHUP, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+    sigaction(SIGUSR2, &sa, NULL);
     
     // 忽略SIGPIPE
     signal(SIGPIPE, SIG_IGN);
 }
 
+/* ============================================================
+ *  Message Builders
+ * ============================================================ */
+
+/**
+ * @brief 解析請求 id
+ * 
+ * id 可為整數或長度不超過 REQUEST_ID_MAX_STRING 的字串
+ * 
+ * @return true 成功 (未提供 id 時 id->json 為空字串), false 格式不合法
+ */
+static bool parse_request_id(const cJSON *root, request_id_t *id) {
+    id->json[0] = '\0';
+    
+    cJSON *item = cJSON_GetObjectItem(root, "id");
+    if (item == NULL) {
+        return true;
+    }
+    
+    json_writer_t w;
+    json_writer_init(&w, id->json, sizeof(id->json));
+    if (cJSON_IsNumber(item) && item->valuedouble == (double)(int64_t)item->valuedouble) {
+        json_writer_int(&w, (int64_t)item->valuedouble);
+    } else if (cJSON_IsString(item) && strlen(item->valuestring) <= REQUEST_ID_MAX_STRING) {
+        json_writer_string(&w, item->valuestring);
+    } else {
+        return false;
+    }
+    
+    return json_writer_finish(&w) != NULL;
+}
+
+/**
+ * @brief 發送回應,帶有 request id 時附加於回應中
+ * 
+ * JSON 在 '{' 之後插入 "id";預先編碼的 CBOR 以 ws_cbor_append_field() 附加。
+ */
+static void send_reply(int client_id, const request_id_t *id, const ws_message_t *base) {
+    if (id == NULL || id->json[0] == '\0') {
+        ws_server_send_message(client_id, base);
+        return;
+    }
+    
+    size_t base_len = strlen(base->json);
+    size_t id_len = strlen(id->json);
+    if (base_len < 2 || base->json[0] != '{') {
+        return;
+    }
+    
+    char *json = (char*)malloc(base_len + id_len + 8);
+    if (json == NULL) {
+        return;
+    }
+    
+    // {"id":X,<原內容>
+    bool empty = (base->json[1] == '}');
+    int len = sprintf(json, "{\"id\":%s%s", id->json, empty ? "" : ",");
+    memcpy(json + len, base->json + 1, base_len);  // 含結尾 '\0'
+    
+    ws_message_t reply = { json, NULL, 0 };
+    uint8_t cbor[SUBSCRIBE_REPLY_SIZE];
+    if (base->cbor != NULL) {
+        uint8_t id_cbor[REQUEST_ID_SIZE];
+        size_t id_cbor_len = ws_cbor_from_json(id->json, id_len, id_cbor, sizeof(id_cbor));
+        reply.cbor_len = ws_cbor_append_field(base->cbor, base->cbor_len, "id",
+                                              id_cbor, id_cbor_len, cbor, sizeof(cbor));
+        reply.cbor = (id_cbor_len > 0 && reply.cbor_len > 0) ? cbor : NULL;
+    }
+    
+    ws_server_send_message(client_id, &reply);
+    free(json);
+}
+
+/**
+ * @brief 發送 JSON 回應 (CBOR 客戶端由傳輸層轉碼)
+ */
+static void send_json_reply(int client_id, const request_id_t *id, const char *json) {
+    ws_message_t message = { json, NULL, 0 };
+    send_reply(client_id, id, &message);
+}
+
+/**
+ * @brief 發送錯誤回應
+ * 
+ * {"type":"error","error":"too_many_requests"}
+ */
+static void send_error_reply(int client_id, const request_id_t *id, const char *error) {
+    char json[STATUS_MESSAGE_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, json, sizeof(json));
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "error");
+    json_writer_kv_string(&w, "error", error);
+    json_writer_end_object(&w);
+    if (json_writer_finish(&w)) {
+        send_json_reply(client_id, id, json);
+    }
+}
+
+/**
+ * @brief 發送 wake_result 訊息
+ * 
+ * CBOR 客戶端收到固定佈局 [WS_MSG_WAKE_RESULT, success]
+ */
+static void send_wake_result(int client_id, const request_id_t *id, bool success) {
+    char json[STATUS_MESSAGE_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, json, sizeof(json));
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "wake_result");
+    json_writer_kv_bool(&w, "success", success);
+    json_writer_end_object(&w);
+    if (json_writer_finish(&w) == NULL) {
+        return;
+    }
+    
+    uint8_t cbor[8];
+    cbor_writer_t c;
+    cbor_writer_init(&c, cbor, sizeof(cbor));
+    cbor_writer_array(&c, 2);
+    cbor_writer_int(&c, WS_MSG_WAKE_RESULT);
+    cbor_writer_bool(&c, success);
+    
+    ws_message_t message = { json, cbor, cbor_writer_finish(&c) };
+    send_reply(client_id, id, &message);
+}
+
+/**
+ * @brief 取得客戶端帶入的已知快照版本
+ * 
+ * @param root 已解析的客戶端訊息
+ * @return 版本號, 0 表示未提供
+ */
+static uint64_t parse_known_version(const cJSON *root) {
+    cJSON *item = cJSON_GetObjectItem(root, "version");
+    if (cJSON_IsNumber(item) && item->valuedouble > 0) {
+        return (uint64_t)item->valuedouble;
+    }
+    return 0;
+}
+
+/**
+ * @brief 登記等待喚醒結果的請求
+ * 
+ * @return true 成功
+ */
+static bool add_pending_wake(int client_id, const request_id_t *id) {
+    bool added = false;
+    
+    pthread_mutex_lock(&g_pending_wake_mutex);
+    if (g_pending_wake_count < MAX_PENDING_WAKES) {
+        g_pending_wakes[g_pending_wake_count].client_id = client_id;
+        g_pending_wakes[g_pending_wake_count].id = *id;
+        g_pending_wake_count++;
+        added = true;
+    }
+    pthread_mutex_unlock(&g_pending_wake_mutex);
+    
+    return added;
+}
+
+/**
+ * @brief 回覆所有等待喚醒結果的請求
+ * 
+ * 在喚醒執行緒中呼叫;先取出清單再發送,不在持有 mutex 時呼叫傳輸層
+ */
+static void complete_pending_wakes(bool success) {
+    pending_wake_t pending[MAX_PENDING_WAKES];
+    
+    pthread_mutex_lock(&g_pending_wake_mutex);
+    int count = g_pending_wake_count;
+    memcpy(pending, g_pending_wakes, (size_t)count * sizeof(pending_wake_t));
+    g_pending_wake_count = 0;
+    pthread_mutex_unlock(&g_pending_wake_mutex);
+    
+    for (int i = 0; i < count; i++) {
+        send_wake_result(pending[i].client_id, &pending[i].id, success);
+        ws_server_end_request(pending[i].client_id);
+    }
+}
+
+/**
+ * @brief 發送目前狀態快照給特定客戶端
+ */
+static void send_status_snapshot(int client_id, const request_id_t *id,
+                                 uint64_t known_version)
+{
+    const status_snapshot_t *snap = status_snapshot_acquire();
+    if (snap == NULL) {
+        return;
+    }
+    
+    // 客戶端已是最新版本時只回 not_modified
+    ws_message_t message = { snap->json, snap->cbor, snap->cbor_len };
+    if (known_version == snap->version) {
+        message.json = snap->not_modified;
+        message.cbor = snap->not_modified_cbor;
+        message.cbor_len = snap->not_modified_cbor_len;
+    }
+    
+    send_reply(client_id, id, &message);
+    status_snapshot_release(snap);
+}
+
+/**
+ * @brief 推送快照中單一主題的欄位差異
+ * 
+ * 訂閱者只收到改變的欄位:
+ * {"type":"ps5_delta","version":N,"power":"ON"}
+ * 尚未訂閱任何主題的舊版客戶端在電源改變時仍收到完整 ps5_status。
+ * HTTP 端點 (/status, /events, 長輪詢) 每次都更新為完整快照。
+ * 
+ * @param topic WS_TOPIC_POWER / WS_TOPIC_NETWORK / WS_TOPIC_SERVER_STATE
+ */
+static void publish_status_change(ws_topic_t topic) {
+    const status_snapshot_t *snap = status_snapshot_acquire();
+    if (snap == NULL) {
+        return;
+    }
+    
+    ws_server_set_http_status(snap->version, snap->json);
+    
+    if (topic == WS_TOPIC_POWER) {
+        ws_message_t message = { snap->json, snap->cbor, snap->cbor_len };
+        ws_server_publish_message(WS_TOPIC_STATUS_FULL, &message);
+    }
+    
+    const char *value = NULL;
+    switch (topic) {
+        case WS_TOPIC_POWER:
+            value = ps5_power_state_to_string(snap->power);
+            break;
+        case WS_TOPIC_NETWORK:
+            value = ps5_network_status_to_string(snap->network);
+            break;
+        case WS_TOPIC_SERVER_STATE:
+            value = server_state_to_string(snap->server_state);
+            break;
+        default:
+            break;
+    }
+    
+    // 沒有訂閱者時不必格式化
+    if (value && ws_server_get_subscriber_count(topic) > 0) {
+        char message[STATUS_MESSAGE_SIZE];
+        json_writer_t w;
+        json_writer_init(&w, message, sizeof(message));
+        json_writer_begin_object(&w);
+        json_writer_kv_string(&w, "type", "ps5_delta");
+        json_writer_kv_int(&w, "version", (int64_t)snap->version);
+        json_writer_kv_string(&w, ws_topic_to_string(topic), value);
+        json_writer_end_object(&w);
+        if (json_writer_finish(&w)) {
+            ws_server_publish(topic, message);
+        }
+    }
+    
+    status_snapshot_release(snap);
+}
+
+/**
+ * @brief 推送喚醒事件
+ * 
+ * @param stage "requested" 或 "completed"
+ * @param client_id 發出請求的客戶端 (<0 表示不包含)
+ * @param success 喚醒結果 (僅 completed 時包含)
+ */
+static void publish_wake_event(const char *stage, int client_id, bool success) {
+    if (ws_server_get_subscriber_count(WS_TOPIC_WAKE) == 0) {
+        return;
+    }
+    
+    char message[STATUS_MESSAGE_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, message, sizeof(message));
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "wake_event");
+    json_writer_kv_string(&w, "stage", stage);
+    if (client_id >= 0) {
+        json_writer_kv_int(&w, "client_id", client_id);
+    }
+    if (strcmp(stage, "completed") == 0) {
+        json_writer_kv_bool(&w, "success", success);
+    }
+    json_writer_end_object(&w);
+    if (json_writer_finish(&w)) {
+        ws_server_publish(WS_TOPIC_WAKE, message);
+    }
+}
+
+/**
+ * @brief 記錄喚醒開始 (flight recorder 事件;已有進行中的喚醒時保留較早的開始時間)
+ * 
+ * @param client_id 發出請求的客戶端 (0 表示狀態機)
+ */
+static void mark_wake_started(int client_id) {
+    trace_ring_record(TRACE_WAKE_REQUEST, 0, (uint32_t)client_id, 0);
+    
+    uint64_t none = 0;
+    __atomic_compare_exchange_n(&g_wake_started_us, &none, metrics_now_us(), false,
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 喚醒結束: 開機時記錄喚醒到開機的時間
+ * 
+ * @param powered_on CEC 回報開機 (false 表示喚醒失敗,捨棄開始時間)
+ */
+static void finish_wake(bool powered_on) {
+    uint64_t started_us = __atomic_exchange_n(&g_wake_started_us, 0, __ATOMIC_RELAXED);
+    if (powered_on && started_us != 0) {
+        metrics_observe(METRIC_WAKE_POWER_ON_SECONDS, 0, metrics_now_us() - started_us);
+    }
+}
+
+/**
+ * @brief 收集目前統計值
+ */
+static void collect_stats(server_stats_t *stats) {
+    stats->clients = ws_server_get_client_count();
+    stats->state_version = status_snapshot_get_version();
+    stats->wake_requests = g_wake_requests;
+    
+    stats->rate_limited = 0;
+    for (int type = 0; type < WS_SERVER_RATE_LIMIT_TYPES; type++) {
+        ws_rate_limit_stats_t rate_stats;
+        if (ws_server_get_rate_limit_stats((ws_message_type_t)type, &rate_stats) == 0) {
+            stats->rate_limited += rate_stats.limited;
+        }
+    }
+}
+
+/**
+ * @brief 寫入統計欄位
+ * 
+ * @param prev 上次推送的值, NULL 表示寫入全部欄位
+ * @return 寫入的欄位數
+ */
+static int write_stats_fields(json_writer_t *w, const server_stats_t *stats,
+                              const server_stats_t *prev)
+{
+    int fields = 0;
+    
+    if (prev == NULL || stats->clients != prev->clients) {
+        json_writer_kv_int(w, "clients", stats->clients);
+        fields++;
+    }
+    if (prev == NULL || stats->state_version != prev->state_version) {
+        json_writer_kv_int(w, "state_version", (int64_t)stats->state_version);
+        fields++;
+    }
+    if (prev == NULL || stats->wake_requests != prev->wake_requests) {
+        json_writer_kv_int(w, "wake_requests", stats->wake_requests);
+        fields++;
+    }
+    if (prev == NULL || stats->rate_limited != prev->rate_limited) {
+        json_writer_kv_int(w, "rate_limited", stats->rate_limited);
+        fields++;
+    }
+    
+    return fields;
+}
+
+/**
+ * @brief 推送統計差異 (只包含改變的欄位)
+ */
+static void publish_stats_delta(void) {
+    server_stats_t stats;
+    collect_stats(&stats);
+    
+    if (ws_server_get_subscriber_count(WS_TOPIC_STATS) == 0) {
+        g_last_stats = stats;
+        return;
+    }
+    
+    char message[STATUS_MESSAGE_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, message, sizeof(message));
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "stats");
+    int fields = write_stats_fields(&w, &stats, &g_last_stats);
+    json_writer_end_object(&w);
+    
+    if (fields > 0 && json_writer_finish(&w)) {
+        ws_server_publish(WS_TOPIC_STATS, message);
+    }
+    g_last_stats = stats;
+}
+
+/**
+ * @brief 解析 subscribe/unsubscribe 訊息中的主題
+ * 
+ * 支援 "topics":["power","network"] 或 "topic":"power"
+ * 
+ * @return 主題 bitmask (忽略未知主題)
+ */
+static uint32_t parse_topics(const cJSON *root) {
+    uint32_t topics = 0;
+    cJSON *item = cJSON_GetObjectItem(root, "topics");
+    if (cJSON_IsArray(item)) {
+        cJSON *topic;
+        cJSON_ArrayForEach(topic, item) {
+            if (cJSON_IsString(topic)) {
+                topics |= ws_topic_from_string(topic->valuestring);
+            }
+        }
+    } else {
+        item = cJSON_GetObjectItem(root, "topic");
+        if (cJSON_IsString(item)) {
+            topics = ws_topic_from_string(item->valuestring);
+        }
+    }
+    
+    return topics;
+}
+
+/**
+ * @brief 產生 subscribed 回應
+ * 
+ * 回應包含目前訂閱的主題;訂閱狀態主題時附上完整快照,
+ * 訂閱 stats 時附上完整統計,作為之後差異推送的基準。
+ * 
+ * @return malloc() 配置的訊息, NULL 表示失敗
+ */
+static char* build_subscribed_reply(uint32_t subscriptions) {
+    char *reply = (char*)malloc(SUBSCRIBE_REPLY_SIZE);
+    if (reply == NULL) {
+        return NULL;
+    }
+    
+    json_writer_t w;
+    json_writer_init(&w, reply, SUBSCRIBE_REPLY_SIZE);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "subscribed");
+    
+    json_writer_key(&w, "topics");
+    json_writer_begin_array(&w);
+    for (uint32_t bit = 1; bit & WS_TOPIC_ALL; bit <<= 1) {
+        if (subscriptions & bit) {
+            json_writer_string(&w, ws_topic_to_string((ws_topic_t)bit));
+        }
+    }
+    json_writer_end_array(&w);
+    
+    if (subscriptions & (WS_TOPIC_POWER | WS_TOPIC_NETWORK | WS_TOPIC_SERVER_STATE)) {
+        const status_snapshot_t *snap = status_snapshot_acquire();
+        if (snap) {
+            json_writer_key(&w, "status");
+            json_writer_raw(&w, snap->json, snap->json_len);
+            status_snapshot_release(snap);
+        }
+    }
+    
+    if (subscriptions & WS_TOPIC_STATS) {
+        server_stats_t stats;
+        collect_stats(&stats);
+        json_writer_key(&w, "stats");
+        json_writer_begin_object(&w);
+        write_stats_fields(&w, &stats, NULL);
+        json_writer_end_object(&w);
+    }
+    
+    json_writer_end_object(&w);
+    if (json_writer_finish(&w) == NULL) {
+        free(reply);
+        return NULL;
+    }
+    
+    return reply;
+}
+
+/**
+ * @brief 回覆一頁 flight recorder 記錄 (debug_dump)
+ * 
+ * {"type":"debug_dump","next":N,"records":[[seq,time_ns,"event",a0,a1,a2],...]}
+ * 
+ * 客戶端以 "since":next 讀取下一頁,records 為空表示已讀到最新。
+ */
+static void send_debug_dump(int client_id, const request_id_t *id, const cJSON *root) {
+    cJSON *item = cJSON_GetObjectItem(root, "since");
+    uint64_t since = (cJSON_IsNumber(item) && item->valuedouble > 0)
+                     ? (uint64_t)item->valuedouble : 0;
+    
+    trace_record_t records[DEBUG_DUMP_PAGE_RECORDS];
+    uint64_t next;
+    int count = trace_ring_read(since, records, DEBUG_DUMP_PAGE_RECORDS, &next);
+    
+    // 保留空間給 send_reply() 插入的 id
+    char json[WS_SERVER_MAX_MESSAGE_SIZE - REQUEST_ID_SIZE - 8];
+    json_writer_t w;
+    json_writer_init(&w, json, sizeof(json));
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "debug_dump");
+    json_writer_kv_int(&w, "next", (int64_t)next);
+    json_writer_key(&w, "records");
+    json_writer_begin_array(&w);
+    for (int i = 0; i < count; i++) {
+        json_writer_begin_array(&w);
+        json_writer_int(&w, (int64_t)records[i].seq);
+        json_writer_int(&w, (int64_t)records[i].time_ns);
+        json_writer_string(&w, trace_event_to_string((trace_event_t)records[i].event));
+        json_writer_int(&w, records[i].a0);
+        json_writer_int(&w, records[i].a1);
+        json_writer_int(&w, records[i].a2);
+        json_writer_end_array(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    
+    if (json_writer_finish(&w)) {
+        send_json_reply(client_id, id, json);
+    } else {
+        send_error_reply(client_id, id, "internal_error");
+    }
+}
+
+/**
+ * @brief 回覆狀態轉換歷史與各狀態停留時間 (server_state_history)
+ * 
+ * {"type":"server_state_history","state":"...","now_ms":N,"in_state_ms":N,
+ *  "transitions":N,"time_in_state_ms":{"INIT":N,...},
+ *  "history":[[time_ms,"from","to","event"],...]}
+ * 
+ * 時間為單調時鐘 (毫秒),history 由舊到新;
+ * 直接呼叫 server_sm_transition() 造成的轉換 event 為 "UNKNOWN"。
+ */
+static void send_state_history(int client_id, const request_id_t *id) {
+    server_sm_history_t history;
+    if (g_server_ctx == NULL || server_sm_get_history(g_server_ctx, &history) != 0) {
+        send_error_reply(client_id, id, "internal_error");
+        return;
+    }
+    
+    char json[WS_SERVER_MAX_MESSAGE_SIZE - REQUEST_ID_SIZE - 8];
+    json_writer_t w;
+    json_writer_init(&w, json, sizeof(json));
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "server_state_history");
+    json_writer_kv_string(&w, "state", server_state_to_string(history.state));
+    json_writer_kv_int(&w, "now_ms", (int64_t)(history.now_us / 1000));
+    json_writer_kv_int(&w, "in_state_ms",
+                       (int64_t)((history.now_us - history.state_entered_us) / 1000));
+    json_writer_kv_int(&w, "transitions", (int64_t)history.transitions);
+    json_writer_key(&w, "time_in_state_ms");
+    json_writer_begin_object(&w);
+    for (int s = 0; s < SERVER_STATE_COUNT; s++) {
+        json_writer_kv_int(&w, server_state_to_string((server_state_t)s),
+                           (int64_t)(history.time_in_state_us[s] / 1000));
+    }
+    json_writer_end_object(&w);
+    json_writer_key(&w, "history");
+    json_writer_begin_array(&w);
+    for (int i = 0; i < history.count; i++) {
+        const server_sm_history_entry_t *entry = &history.entries[i];
+        json_writer_begin_array(&w);
+        json_writer_int(&w, (int64_t)(entry->time_us / 1000));
+        json_writer_string(&w, server_state_to_string(entry->from));
+        json_writer_string(&w, server_state_to_string(entry->to));
+        json_writer_string(&w, server_event_to_string(entry->event));
+        json_writer_end_array(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    
+    if (json_writer_finish(&w)) {
+        send_json_reply(client_id, id, json);
+    } else {
+        send_error_reply(client_id, id, "internal_error");
+    }
+}
+
+/**
+ * @brief 輸出 flight recorder 到檔案 (SIGUSR1)
+ */
+static void dump_trace_file(void) {
+    int count = trace_ring_dump_file(g_trace_path);
+    
+    #ifndef TESTING
+    if (count < 0) {
+        log_error("Failed to write trace dump to %s", g_trace_path);
+    } else {
+        log_info("Wrote %d trace records to %s", count, g_trace_path);
+    }
+    #else
+    (void)count;
+    #endif
+}
+
+/**
+ * @brief 套用偵測結果 (重播時直接以記錄的結果呼叫)
+ */
+static void apply_detect_result(int detect_result, bool online) {
+    bool ps5_online = (detect_result == PS5_DETECT_OK && online);
+    ps5_network_status_t status = ps5_online ? PS5_NET_ONLINE : PS5_NET_OFFLINE;
+    
+    if (status_snapshot_set_network(status)) {
+        __atomic_store_n(&g_state_dirty, true, __ATOMIC_RELAXED);
+        if (g_server_ctx) {
+            server_sm_on_ps5_network_changed(g_server_ctx, status);
+        }
+        publish_status_change(WS_TOPIC_NETWORK);
+    }
+}
+
+/**
+ * @brief 從 detector cache 更新 PS5 網路狀態
+ */
+static void refresh_network_status(void) {
+    ps5_info_t ps5_info = {0};
+    int detect_result = ps5_detector_get_cached(&ps5_info);
+    
+    input_journal_record(JOURNAL_DETECT, detect_result, ps5_info.online ? 1 : 0, NULL, 0);
+    apply_detect_result(detect_result, ps5_info.online);
+}
+
+/* ============================================================
+ *  Startup
+ * ============================================================ */
+
+#ifndef TESTING
+/**
+ * @brief platform_init() 執行緒 (硬體初始化較慢,不阻塞 listen)
+ */
+static void* platform_init_thread(void *arg) {
+    (void)arg;
+    
+    g_startup.platform_result = platform_init();
+    __atomic_store_n(&g_startup.platform_done, true, __ATOMIC_RELEASE);
+    
+    // 主循環在 service_startup() 完成剩下的啟動
+    ws_server_wake();
+    return NULL;
+}
+#endif
+
+/**
+ * @brief 在背景開始 platform_init() (信號處理設定之後、初始化模組之前)
+ */
+static void start_platform_init(void) {
+    #ifndef TESTING
+    // 信號只由主執行緒處理
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int rc = pthread_create(&g_startup.platform_thread, NULL, platform_init_thread, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    
+    if (rc == 0) {
+        g_startup.thread_started = true;
+    } else {
+        log_warning("Cannot start platform thread, initializing in foreground");
+        platform_init_thread(NULL);
+    }
+    #else
+    __atomic_store_n(&g_startup.platform_done, true, __ATOMIC_RELEASE);
+    #endif
+}
+
+/**
+ * @brief 等待 platform_init() 並驗證設備類型必須為 "server" (可重複呼叫)
+ *
+ * @return 0 platform 可用, -1 失敗 (已記錄錯誤)
+ */
+static int finish_platform_init(void) {
+    if (g_startup.platform_checked) {
+        return g_startup.platform_ok ? 0 : -1;
+    }
+    g_startup.platform_checked = true;
+    
+    #ifndef TESTING
+    if (g_startup.thread_started) {
+        pthread_join(g_startup.platform_thread, NULL);
+        g_startup.thread_started = false;
+    }
+    
+    if (g_startup.platform_result != PLATFORM_OK) {
+        log_error("Failed to initialize platform: %d", g_startup.platform_result);
+        return -1;
+    }
+    g_startup.platform_ok = true;
+    
+    const char *device_type = platform_get_device_type();
+    if (strcmp(device_type, "server") != 0) {
+        log_error("This device is not a server (detected device type: %s)", device_type);
+        return -1;
+    }
+    
+    log_info("Platform: %s", platform_get_version());
+    log_info("Device type: %s", device_type);
+    #else
+    g_startup.platform_ok = true;
+    #endif
+    
+    return 0;
+}
+
+/**
+ * @brief 記錄第一次確認 PS5 電源狀態的時間 (CEC 回報或升級交接)
+ */
+static void record_first_state(void) {
+    if (__atomic_exchange_n(&g_startup.state_recorded, true, __ATOMIC_RELAXED)) {
+        return;
+    }
+    
+    uint64_t elapsed_us = metrics_now_us() - g_startup.start_us;
+    metrics_set(METRIC_STARTUP_STATE_US, (int64_t)elapsed_us);
+    
+    #ifndef TESTING
+    log_info("First confirmed PS5 state after %.1f ms", (double)elapsed_us / 1000.0);
+    #endif
+}
+
+/**
+ * @brief 記錄開始 accept 的時間並通知服務管理程式
+ */
+static void mark_serving(void) {
+    g_startup.accept_us = metrics_now_us() - g_startup.start_us;
+    metrics_set(METRIC_STARTUP_ACCEPT_US, (int64_t)g_startup.accept_us);
+    
+    if (readiness_notify_ready() != 0) {
+        #ifndef TESTING
+        log_warning("Failed to send readiness notification");
+        #endif
+    }
+    
+    #ifndef TESTING
+    // 升級時舊程序持續 accept,新程序等待 platform 不算在內
+    if (!g_upgrade.adopted && g_startup.accept_us > (uint64_t)STARTUP_TARGET_MS * 1000) {
+        log_warning("Accepting after %.1f ms (target %d ms)",
+                    (double)g_startup.accept_us / 1000.0, STARTUP_TARGET_MS);
+    } else {
+        log_info("Accepting after %.1f ms", (double)g_startup.accept_us / 1000.0);
+    }
+    #endif
+}
+
+/**
+ * @brief platform 完成後啟動依賴硬體的部分 (主循環每次呼叫,直到完成)
+ */
+static void service_startup(void) {
+    if (g_startup.complete || g_startup.failed ||
+        !__atomic_load_n(&g_startup.platform_done, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    
+    if (finish_platform_init() != 0) {
+        g_startup.failed = true;
+        g_running = 0;
+        return;
+    }
+    
+    server_sm_enable_led(g_server_ctx);
+    
+    // 啟動狀態機 (INIT -> MONITORING 或 CLIENT_CONNECTED),之後的轉換由事件直接觸發
+    // 升級時狀態已由 server_sm_restore() 接續
+    if (g_server_ctx && !g_upgrade.adopted) {
+        server_sm_start(g_server_ctx);
+    }
+    
+    // 啟動CEC Monitor (第一次查詢確認 warm start 的暫定狀態)
+    cec_monitor_start();
+    
+    g_startup.complete = true;
+    
+    #ifndef TESTING
+    log_info("Startup complete after %.1f ms",
+             (double)(metrics_now_us() - g_startup.start_us) / 1000.0);
+    #endif
+}
+
+/**
+ * @brief 結束 platform (主程式返回前)
+ */
+static void stop_platform(void) {
+    finish_platform_init();
+    
+    #ifndef TESTING
+    if (g_startup.platform_ok) {
+        platform_cleanup();
+    }
+    #endif
+}
+
 /* ============================================================
  *  Callback Functions
  * ============================================================ */
@@ -108,16 +1060,25 @@ static void setup_signal_handlers(void) {
 static void on_ps5_power_changed(ps5_power_state_t state, void *user_data) {
     (void)user_data;
     
+    input_journal_record(JOURNAL_CEC_POWER, (int32_t)state, 0, NULL, 0);
+    
+    if (state != PS5_POWER_UNKNOWN) {
+        record_first_state();
+    }
+    
+    if (state == PS5_POWER_ON) {
+        finish_wake(true);
+    }
+    
     if (g_server_ctx) {
         server_sm_on_ps5_power_changed(g_server_ctx, state);
     }
     
-    // 同時通知所有連線的客戶端
-    char message[128];
-    snprintf(message, sizeof(message), 
-            "{\"type\":\"ps5_status\",\"power\":\"%s\"}",
-            ps5_power_state_to_string(state));
-    ws_server_broadcast(message);
+    // 同時通知訂閱的客戶端 (第一次回報也確認 warm start 的暫定狀態)
+    if (status_snapshot_set_power(state)) {
+        __atomic_store_n(&g_state_dirty, true, __ATOMIC_RELAXED);
+        publish_status_change(WS_TOPIC_POWER);
+    }
 }
 
 /**
@@ -126,9 +1087,21 @@ static void on_ps5_power_changed(ps5_power_state_t state, void *user_data) {
 static void on_ps5_wake_completed(bool success, void *user_data) {
     (void)user_data;
     
+    trace_ring_record(TRACE_WAKE_COMPLETE, success ? 1 : 0, 0, 0);
+    input_journal_record(JOURNAL_WAKE_RESULT, success ? 1 : 0, 0, NULL, 0);
+    
+    if (!success) {
+        finish_wake(false);
+    }
+    
     if (g_server_ctx) {
         server_sm_on_wake_completed(g_server_ctx, success);
     }
+    
+    publish_wake_event("completed", -1, success);
+    
+    // 回覆等待中的 wake_ps5 請求
+    complete_pending_wakes(success);
 }
 
 /**
@@ -138,20 +1111,18 @@ static void on_client_connected(int client_id, const char *client_ip, void *user
     (void)user_data;
     
     #ifndef TESTING
-    logger_info("Client %d connected from %s", client_id, client_ip);
+    log_info("Client %d connected from %s", client_id, client_ip);
     #endif
     
+    input_journal_record(JOURNAL_CLIENT_CONNECT, client_id, 0,
+                         client_ip, client_ip ? strlen(client_ip) : 0);
+    
     if (g_server_ctx) {
         server_sm_on_client_connected(g_server_ctx, client_id);
     }
     
     // 發送當前PS5狀態給新連線的客戶端
-    ps5_power_state_t power = cec_monitor_get_state();
-    char message[128];
-    snprintf(message, sizeof(message),
-            "{\"type\":\"ps5_status\",\"power\":\"%s\"}",
-            ps5_power_state_to_string(power));
-    ws_server_send(client_id, message);
+    send_status_snapshot(client_id, NULL, 0);
 }
 
 /**
@@ -161,9 +1132,11 @@ static void on_client_disconnected(int client_id, void *user_data) {
     (void)user_data;
     
     #ifndef TESTING
-    logger_info("Client %d disconnected", client_id);
+    log_info("Client %d disconnected", client_id);
     #endif
     
+    input_journal_record(JOURNAL_CLIENT_DISCONNECT, client_id, 0, NULL, 0);
+    
     if (g_server_ctx) {
         server_sm_on_client_disconnected(g_server_ctx, client_id);
     }
@@ -178,67 +1151,107 @@ static char* handle_client_message(int client_id, ws_message_type_t msg_type,
     (void)user_data;
     
     #ifndef TESTING
-    logger_debug("Received message from client %d: %s", client_id, message);
+    log_debug("Received %s from client %d", ws_message_type_to_string(msg_type), client_id);
     #endif
     
-    char *response = NULL;
+    input_journal_record(JOURNAL_CLIENT_MESSAGE, client_id, (int32_t)msg_type,
+                         message, strlen(message));
+    
+    // 每則訊息只解析一次
+    cJSON *root = cJSON_Parse(message);
+    request_id_t id = { "" };
+    if (root == NULL || !parse_request_id(root, &id)) {
+        send_error_reply(client_id, &id, "invalid_request");
+        cJSON_Delete(root);
+        return NULL;
+    }
     
     switch (msg_type) {
-        case WS_MSG_QUERY_PS5: {
-            // 查詢PS5電源狀態
-            ps5_power_state_t power = cec_monitor_get_state();
-            
-            // 查詢PS5網路狀態
-            ps5_info_t ps5_info = {0};
-            int detect_result = ps5_detector_get_cached(&ps5_info);
-            bool ps5_online = (detect_result == PS5_DETECT_OK && ps5_info.online);
-            
-            response = (char*)malloc(256);
-            if (response) {
-                snprintf(response, 256,
-                        "{\"type\":\"ps5_status\",\"power\":\"%s\",\"network\":\"%s\"}",
-                        ps5_power_state_to_string(power),
-                        ps5_online ? "online" : "offline");
-            }
+        case WS_MSG_QUERY_PS5:
+            // 直接回傳預先序列化的快照
+            send_status_snapshot(client_id, &id, parse_known_version(root));
             break;
-        }
         
         case WS_MSG_WAKE_PS5: {
-            // 喚醒PS5
+            // 喚醒PS5 (非同步: 結果在 on_ps5_wake_completed 回覆,
+            // 期間同一連線的其他請求可先完成)
             #ifndef TESTING
-            logger_info("Client %d requested PS5 wake", client_id);
+            log_info("Client %d requested PS5 wake", client_id);
             #endif
             
+            // platform 尚未完成初始化,無法送出 CEC 命令
+            if (!g_startup.complete) {
+                send_error_reply(client_id, &id, "starting");
+                break;
+            }
+            if (ws_server_begin_request(client_id) != 0) {
+                send_error_reply(client_id, &id, "too_many_requests");
+                break;
+            }
+            if (!add_pending_wake(client_id, &id)) {
+                ws_server_end_request(client_id);
+                send_error_reply(client_id, &id, "too_many_requests");
+                break;
+            }
+            
             if (g_server_ctx) {
                 server_sm_on_wake_requested(g_server_ctx);
             }
+            g_wake_requests++;
+            mark_wake_started(client_id);
+            publish_wake_event("requested", client_id, false);
             
-            // 執行喚醒
-            int result = ps5_wake_send();
-            
-            response = (char*)malloc(128);
-            if (response) {
-                snprintf(response, 128,
-                        "{\"type\":\"wake_result\",\"success\":%s}",
-                        result == 0 ? "true" : "false");
+            // 執行喚醒 (進行中時併入同一次喚醒)
+            if (ps5_wake_send_async() < 0) {
+                complete_pending_wakes(false);
+            }
+            break;
+        }
+        
+        case WS_MSG_SUBSCRIBE:
+        case WS_MSG_UNSUBSCRIBE: {
+            // 訂閱/取消訂閱主題
+            uint32_t topics = parse_topics(root);
+            int64_t subscriptions = (msg_type == WS_MSG_SUBSCRIBE)
+                                    ? ws_server_subscribe(client_id, topics)
+                                    : ws_server_unsubscribe(client_id, topics);
+            if (subscriptions >= 0) {
+                char *reply = build_subscribed_reply((uint32_t)subscriptions);
+                if (reply) {
+                    send_json_reply(client_id, &id, reply);
+                    free(reply);
+                }
             }
             break;
         }
         
         case WS_MSG_PING: {
             // Ping回應
-            response = strdup("{\"type\":\"pong\"}");
+            send_json_reply(client_id, &id, "{\"type\":\"pong\"}");
             break;
         }
         
+        case WS_MSG_DEBUG_DUMP:
+            // 分頁讀取 flight recorder
+            send_debug_dump(client_id, &id, root);
+            break;
+        
+        case WS_MSG_SERVER_STATE_HISTORY:
+            // 狀態轉換歷史與停留時間
+            send_state_history(client_id, &id);
+            break;
+        
         default:
             #ifndef TESTING
-            logger_warning("Unknown message type from client %d", client_id);
+            log_warning("Unknown message type from client %d", client_id);
             #endif
             break;
     }
     
-    return response;
+    cJSON_Delete(root);
+    
+    // 回應皆已透過 send_reply() 發送
+    return NULL;
 }
 
 /**
@@ -247,16 +1260,23 @@ static char* handle_client_message(int client_id, ws_message_type_t msg_type,
 static void on_state_enter(server_state_t state, void *user_data) {
     (void)user_data;
     
+    if (status_snapshot_set_server_state(state)) {
+        publish_status_change(WS_TOPIC_SERVER_STATE);
+    }
+    
     // 根據狀態執行相應動作
     switch (state) {
         case SERVER_STATE_MONITORING:
-            // 開始CEC監控
-            cec_monitor_start();
+            // 開始CEC監控 (重播時輪詢睡眠會自行推進模擬時鐘)
+            if (!g_replaying) {
+                cec_monitor_start();
+            }
             break;
         
         case SERVER_STATE_WAKING_PS5:
-            // 執行喚醒
-            ps5_wake_send();
+            // 執行喚醒 (與客戶端請求的喚醒合併)
+            mark_wake_started(0);
+            ps5_wake_send_async();
             break;
         
         default:
@@ -265,102 +1285,719 @@ static void on_state_enter(server_state_t state, void *user_data) {
 }
 
 /* ============================================================
- *  Initialization & Cleanup
+ *  Initialization & Cleanup
+ * ============================================================ */
+
+/**
+ * @brief 套用訊息速率限制設定
+ *
+ * 格式: "type=rate[/burst],..." (例如 "wake_ps5=1/3,query_ps5=10"),
+ * burst 省略時等於 rate,rate 為 0 表示不限制。無效項目只記錄警告。
+ */
+static void apply_rate_limits(const char *spec) {
+    char buf[sizeof(((server_config_t *)0)->rate_limits)];
+    strncpy(buf, spec, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    
+    char *entry = buf;
+    while (entry != NULL && *entry != '\0') {
+        char *next = strchr(entry, ',');
+        if (next) {
+            *next++ = '\0';
+        }
+        
+        char *value = strchr(entry, '=');
+        ws_message_type_t type = WS_MSG_UNKNOWN;
+        ws_rate_limit_t limit;
+        char *end = NULL;
+        bool valid = false;
+        
+        if (value) {
+            *value++ = '\0';
+            type = (strcmp(entry, "unknown") == 0) ?
+                WS_MSG_UNKNOWN : ws_message_type_from_string(entry);
+            valid = (type != WS_MSG_UNKNOWN || strcmp(entry, "unknown") == 0);
+            
+            limit.rate = (uint32_t)strtoul(value, &end, 10);
+            limit.burst = limit.rate;
+            if (end == value) {
+                valid = false;
+            } else if (*end == '/') {
+                char *burst = end + 1;
+                limit.burst = (uint32_t)strtoul(burst, &end, 10);
+                valid = valid && end != burst;
+            }
+            valid = valid && *end == '\0';
+        }
+        
+        if (!valid || ws_server_set_rate_limit(type, &limit) != 0) {
+            #ifndef TESTING
+            log_warning("Ignoring invalid rate limit '%s'", entry);
+            #endif
+        }
+        
+        entry = next;
+    }
+}
+
+/**
+ * @brief 初始化所有模組
+ */
+static int initialize_modules(const server_config_t *config) {
+    int ret;
+    
+    // 0. 初始化狀態快照
+    ret = status_snapshot_init();
+    if (ret != 0) {
+        #ifndef TESTING
+        log_error("Failed to initialize status snapshot");
+        #endif
+        return -1;
+    }
+    
+    // 1. 初始化CEC Monitor
+    ret = cec_monitor_init();
+    if (ret != 0) {
+        #ifndef TESTING
+        log_error("Failed to initialize CEC monitor");
+        #endif
+        status_snapshot_cleanup();
+        return -1;
+    }
+    cec_monitor_set_callback(on_ps5_power_changed, NULL);
+    cec_monitor_set_poll_interval((uint32_t)config->cec_poll_ms);
+    
+    // 2. 初始化PS5 Wake Controller
+    ret = ps5_wake_init();
+    if (ret != 0) {
+        #ifndef TESTING
+        log_error("Failed to initialize PS5 wake controller");
+        #endif
+        cec_monitor_cleanup();
+        status_snapshot_cleanup();
+        return -1;
+    }
+    ps5_wake_set_callback(on_ps5_wake_completed, NULL);
+    
+    // 3. 初始化PS5 Detector
+    ret = ps5_detector_init(config->ps5_subnet, config->cache_path);
+    if (ret != 0) {
+        #ifndef TESTING
+        log_error("Failed to initialize PS5 detector");
+        #endif
+        ps5_wake_cleanup();
+        cec_monitor_cleanup();
+        status_snapshot_cleanup();
+        return -1;
+    }
+    
+    // 4. 初始化WebSocket Server
+    ret = ws_server_init(config->ws_port);
+    if (ret != 0) {
+        #ifndef TESTING
+        log_error("Failed to initialize WebSocket server");
+        #endif
+        ps5_detector_cleanup();
+        ps5_wake_cleanup();
+        cec_monitor_cleanup();
+        status_snapshot_cleanup();
+        return -1;
+    }
+    
+    // 多 worker 模式: 回調仍在主循環的執行緒執行
+    if (ws_server_set_workers(config->ws_workers) != 0) {
+        #ifndef TESTING
+        log_warning("Invalid WebSocket worker count %d, using 1",
+                    config->ws_workers);
+        #endif
+    }
+    
+    if (config->rate_limits[0] != '\0') {
+        apply_rate_limits(config->rate_limits);
+    }
+    
+    // 本機 IPC (LuCI、LED/按鍵 daemon) 不經過 TCP 與 WebSocket 握手
+    if (ws_server_set_local_path(config->local_path) != 0) {
+        #ifndef TESTING
+        log_warning("Invalid local socket path '%s', local IPC disabled",
+                    config->local_path);
+        #endif
+        ws_server_set_local_path(NULL);
+    }
+    
+    // SIGUSR1 輸出 flight recorder 的檔案
+    if (config->trace_path[0] != '\0') {
+        g_trace_path = config->trace_path;
+    }
+    
+    // HTTP 端點的初始快照
+    const status_snapshot_t *snap = status_snapshot_acquire();
+    if (snap) {
+        ws_server_set_http_status(snap->version, snap->json);
+        status_snapshot_release(snap);
+    }
+    
+    ws_server_set_connect_callback(on_client_connected, NULL);
+    ws_server_set_disconnect_callback(on_client_disconnected, NULL);
+    ws_server_set_message_handler(handle_client_message, NULL);
+    
+    // 5. 創建State Machine
+    g_server_ctx = server_sm_create(config);
+    if (g_server_ctx == NULL) {
+        #ifndef TESTING
+        log_error("Failed to create state machine");
+        #endif
+        ws_server_cleanup();
+        ps5_detector_cleanup();
+        ps5_wake_cleanup();
+        cec_monitor_cleanup();
+        status_snapshot_cleanup();
+        return -1;
+    }
+    
+    server_sm_set_state_callback(g_server_ctx, on_state_enter, NULL);
+    
+    #ifndef TESTING
+    log_info("All modules initialized successfully");
+    #endif
+    
+    return 0;
+}
+
+/**
+ * @brief 清理所有模組
+ */
+static void cleanup_modules(void) {
+    if (g_server_ctx) {
+        server_sm_destroy(g_server_ctx);
+        g_server_ctx = NULL;
+    }
+    
+    ws_server_cleanup();
+    ps5_detector_cleanup();
+    ps5_wake_cleanup();
+    cec_monitor_cleanup();
+    status_snapshot_cleanup();
+    
+    #ifndef TESTING
+    log_info("All modules cleaned up");
+    #endif
+}
+
+static void on_network_refresh_timer(void *arg);
+
+/**
+ * @brief 依目前配置排程下一次網路檢查
+ */
+static void schedule_network_refresh(void) {
+    const server_config_snapshot_t *snap = server_config_current();
+    int interval_s = snap ? snap->config.network_refresh_s : DEFAULT_NETWORK_REFRESH_S;
+    
+    g_refresh_timer = vclock_schedule((uint64_t)interval_s * VCLOCK_US_PER_SEC,
+                                      on_network_refresh_timer, NULL);
+}
+
+/**
+ * @brief 定期檢查PS5網路狀態並廣播統計 (vclock 定時器,觸發後重新排程)
+ */
+static void on_network_refresh_timer(void *arg) {
+    (void)arg;
+    
+    refresh_network_status();
+    input_journal_record(JOURNAL_TIMER, JOURNAL_TIMER_STATS, 0, NULL, 0);
+    publish_stats_delta();
+    
+    if (g_running) {
+        schedule_network_refresh();
+    }
+}
+
+/**
+ * @brief 以上次的執行狀態暫時回答查詢 (warm start,主循環之前)
+ *
+ * 電源與網路狀態標示為 stale,直到第一次 CEC 回報;狀態機仍從 INIT
+ * 開始,LED 與喚醒只依確認過的狀態動作。偵測快取只在目前沒有有效
+ * 快取時寫回,快取本身的期限照常檢查。
+ */
+static void load_warm_state(const server_config_t *config) {
+    state_store_record_t record;
+    if (state_store_load(config->state_path, &record) != 0) {
+        return;
+    }
+    
+    g_saved_state = record;
+    g_wake_requests = record.wake_requests;
+    
+    ps5_info_t current;
+    if (record.ps5_info.ip[0] != '\0' &&
+        ps5_detector_get_cached(&current) == PS5_DETECT_ERROR_CACHE_INVALID) {
+        ps5_detector_save_cache(&record.ps5_info);
+    }
+    
+    if (status_snapshot_set_provisional(record.power, record.network,
+                                        record.status_version + WARM_START_VERSION_SKIP) == 0) {
+        const status_snapshot_t *snap = status_snapshot_acquire();
+        if (snap) {
+            ws_server_set_http_status(snap->version, snap->json);
+            status_snapshot_release(snap);
+        }
+    }
+    
+    #ifndef TESTING
+    log_info("Warm start from %s: power %s, network %s (stale until confirmed)",
+             config->state_path, ps5_power_state_to_string(record.power),
+             ps5_network_status_to_string(record.network));
+    #endif
+}
+
+/**
+ * @brief 寫入目前的執行狀態 (在主循環執行)
+ */
+static void save_runtime_state(void) {
+    g_state_saved_us = vclock_now_us();
+    
+
+    const server_config_snapshot_t *config = server_config_current();
+    const status_snapshot_t *snap = status_snapshot_acquire();
+    if (config == NULL || config->config.state_path[0] == '\0' || snap == NULL) {
+        status_snapshot_release(snap);
+        return;
+    }
+    
+    state_store_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.saved_time = vclock_time();
+    record.status_version = snap->version;
+    record.power = snap->power;
+    record.network = snap->network;
+    record.wake_requests = g_wake_requests;
+    status_snapshot_release(snap);
+    
+    if (ps5_detector_get_cached(&record.ps5_info) != PS5_DETECT_OK) {
+        record.ps5_info = g_saved_state.ps5_info;
+    }
+    
+    if (state_store_save(config->config.state_path, &record) == 0) {
+        g_saved_state = record;
+    } else {
+        #ifndef TESTING
+        log_warning("Failed to save runtime state to %s", config->config.state_path);
+        #endif
+    }
+}
+
+static void on_state_save_timer(void *arg) {
+    (void)arg;
+    g_state_save_timer = -1;
+    save_runtime_state();
+}
+
+/**
+ * @brief 狀態改變時寫入: 距上次寫入未滿 STATE_SAVE_MIN_INTERVAL_US 時
+ *        延到期限,期間的變動合併為一次
+ */
+static void schedule_state_save(void) {
+    if (g_state_save_timer >= 0) {
+        return;  // 到期時寫入最新的狀態
+    }
+    
+    uint64_t now = vclock_now_us();
+    uint64_t due = g_state_saved_us + STATE_SAVE_MIN_INTERVAL_US;
+    if (g_state_saved_us == 0 || now >= due) {
+        save_runtime_state();
+        return;
+    }
+    
+    g_state_save_timer = vclock_schedule(due - now, on_state_save_timer, NULL);
+}
+
+/**
+ * @brief 預設配置
+ */
+static void set_default_config(server_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->ws_port = DEFAULT_WS_PORT;
+    config->ws_workers = DEFAULT_WS_WORKERS;
+    strncpy(config->ps5_subnet, DEFAULT_PS5_SUBNET, sizeof(config->ps5_subnet) - 1);
+    strncpy(config->cache_path, DEFAULT_CACHE_PATH, sizeof(config->cache_path) - 1);
+    strncpy(config->local_path, WS_SERVER_LOCAL_PATH, sizeof(config->local_path) - 1);
+    strncpy(config->trace_path, TRACE_DEFAULT_DUMP_PATH, sizeof(config->trace_path) - 1);
+    strncpy(config->state_path, STATE_STORE_DEFAULT_PATH, sizeof(config->state_path) - 1);
+    config->cec_poll_ms = DEFAULT_CEC_POLL_MS;
+    config->network_refresh_s = DEFAULT_NETWORK_REFRESH_S;
+}
+
+/**
+ * @brief 組合配置: 預設值 < UCI < 命令列
+ * 
+ * 啟動與 SIGHUP 使用相同的順序,重新載入不會蓋掉命令列指定的值。
+ * 
+ * @return 0 成功, -1 UCI 選項無效或配置值無效
+ */
+static int build_config(server_config_t *config) {
+    set_default_config(config);
+    
+    if (server_config_load_uci(SERVER_CONFIG_UCI_PACKAGE, config) == -2) {
+        return -1;
+    }
+    
+    server_config_overlay(config, &g_cli_config, g_cli_options);
+    return server_config_validate(config);
+}
+
+/**
+ * @brief 重新載入配置 (SIGHUP,在主循環執行)
+ * 
+ * 先組合並檢查完整的新配置;唯一可能失敗的步驟 (綁定新端口) 成功後
+ * 才發佈新快照並套用其餘欄位,任何失敗都保留目前配置。
+ * 需要重新啟動的欄位 (worker 數、本機 IPC 路徑) 維持原值。
+ */
+static void reload_configuration(void) {
+    const server_config_snapshot_t *current = server_config_current();
+    if (current == NULL) {
+        return;
+    }
+    
+    #ifndef TESTING
+    log_info("Received SIGHUP, reloading configuration...");
+    #endif
+    
+    server_config_t next;
+    if (build_config(&next) != 0) {
+        #ifndef TESTING
+        log_error("Invalid configuration in /etc/config/%s, keeping current",
+                  SERVER_CONFIG_UCI_PACKAGE);
+        #endif
+        return;
+    }
+    
+    uint32_t changed = server_config_diff(&current->config, &next);
+    uint32_t fixed = changed & ~SERVER_CONFIG_RELOADABLE;
+    if (fixed != 0) {
+        #ifndef TESTING
+        log_warning("Worker count and local socket changes require a restart");
+        #endif
+        server_config_overlay(&next, &current->config, fixed);
+        changed &= SERVER_CONFIG_RELOADABLE;
+    }
+    
+    if (changed == 0) {
+        #ifndef TESTING
+        log_info("Configuration unchanged");
+        #endif
+        return;
+    }
+    
+    if ((changed & SERVER_CONFIG_PORT) && ws_server_set_port(next.ws_port) != 0) {
+        #ifndef TESTING
+        log_error("Cannot listen on port %d, keeping current configuration",
+                  next.ws_port);
+        #endif
+        return;
+    }
+    
+    uint64_t generation = server_config_publish(&next);
+    
+    if (changed & SERVER_CONFIG_RATE_LIMITS) {
+        ws_server_reset_rate_limits();
+        if (next.rate_limits[0] != '\0') {
+            apply_rate_limits(next.rate_limits);
+        }
+    }
+    
+    if (changed & SERVER_CONFIG_CEC_POLL) {
+        cec_monitor_set_poll_interval((uint32_t)next.cec_poll_ms);
+    }
+    
+    if (changed & SERVER_CONFIG_NETWORK_REFRESH) {
+        vclock_cancel(g_refresh_timer);
+        schedule_network_refresh();
+    }
+    
+    if (changed & (SERVER_CONFIG_SUBNET | SERVER_CONFIG_CACHE_PATH)) {
+        ps5_detector_set_config(next.ps5_subnet, next.cache_path);
+        refresh_network_status();
+    }
+    
+    #ifndef TESTING
+    log_info("Configuration reloaded (generation %llu, port %d, subnet %s)",
+             (unsigned long long)generation, next.ws_port, next.ps5_subnet);
+    #else
+    (void)generation;
+    #endif
+}
+
+/* ============================================================
+ *  Graceful Upgrade
  * ============================================================ */
 
 /**
- * @brief 初始化所有模組
+ * @brief 放棄交接 (舊程序): 結束新程序
  */
-static int initialize_modules(const server_config_t *config) {
-    int ret;
+static void abort_upgrade(const char *reason) {
+    #ifndef TESTING
+    log_error("Upgrade aborted: %s", reason);
+    #else
+    (void)reason;
+    #endif
     
-    // 1. 初始化CEC Monitor
-    ret = cec_monitor_init();
-    if (ret != 0) {
+    upgrade_handoff_send(g_upgrade.fd, UPGRADE_MSG_ABORT, NULL, 0, NULL, 0);
+    close(g_upgrade.fd);
+    g_upgrade.fd = -1;
+    
+    if (g_upgrade.pid > 0) {
+        kill(g_upgrade.pid, SIGKILL);
+        waitpid(g_upgrade.pid, NULL, 0);
+        g_upgrade.pid = -1;
+    }
+}
+
+/**
+ * @brief 啟動新程序 (SIGUSR2,在主循環執行)
+ */
+static void begin_upgrade(void) {
+    if (g_upgrade.exec_path[0] == '\0' || g_upgrade.argv == NULL) {
         #ifndef TESTING
-        logger_error("Failed to initialize CEC monitor");
+        log_error("Upgrade unavailable: executable path unknown");
         #endif
-        return -1;
+        return;
     }
-    cec_monitor_set_callback(on_ps5_power_changed, NULL);
     
-    // 2. 初始化PS5 Wake Controller
-    ret = ps5_wake_init();
-    if (ret != 0) {
+    #ifndef TESTING
+    log_info("Received SIGUSR2, starting %s for upgrade...", g_upgrade.exec_path);
+    #endif
+    
+    g_upgrade.fd = upgrade_handoff_spawn(g_upgrade.exec_path, g_upgrade.argv, &g_upgrade.pid);
+    if (g_upgrade.fd < 0) {
         #ifndef TESTING
-        logger_error("Failed to initialize PS5 wake controller");
+        log_error("Failed to start %s: %s", g_upgrade.exec_path, strerror(errno));
         #endif
-        cec_monitor_cleanup();
-        return -1;
+        return;
     }
-    ps5_wake_set_callback(on_ps5_wake_completed, NULL);
     
-    // 3. 初始化PS5 Detector
-    ret = ps5_detector_init(config->ps5_subnet, config->cache_path);
-    if (ret != 0) {
-        #ifndef TESTING
-        logger_error("Failed to initialize PS5 detector");
-        #endif
-        ps5_wake_cleanup();
-        cec_monitor_cleanup();
-        return -1;
+    g_upgrade.deadline_ms = vclock_now_ms() + UPGRADE_HELLO_TIMEOUT_MS;
+}
+
+/**
+ * @brief 凍結並交接給已初始化的新程序 (舊程序)
+ *
+ * 從匯出到收到 READY 之間伺服器不處理任何連線 (通常數毫秒),
+ * 新的連線留在 listen backlog 由新程序 accept。
+ * 失敗時解除凍結,繼續以本程序服務。
+ */
+static void hand_off_upgrade(void) {
+    upgrade_state_t *state = calloc(1, sizeof(*state));
+    if (state == NULL) {
+        abort_upgrade("out of memory");
+        return;
     }
     
-    // 4. 初始化WebSocket Server
-    ret = ws_server_init(config->ws_port);
-    if (ret != 0) {
-        #ifndef TESTING
-        logger_error("Failed to initialize WebSocket server");
-        #endif
-        ps5_detector_cleanup();
-        ps5_wake_cleanup();
-        cec_monitor_cleanup();
+    // CEC 執行緒停止後電源狀態不再變動
+    cec_monitor_stop();
+    
+    // 包含喚醒次數;新程序接手後由它寫入,本程序結束時不再寫
+    save_runtime_state();
+    
+    int fds[WS_SERVER_HANDOFF_MAX_FDS];
+    int fd_count = ws_server_export(&state->ws, fds, WS_SERVER_HANDOFF_MAX_FDS);
+    if (fd_count < 0) {
+        cec_monitor_start();
+        free(state);
+        abort_upgrade("server not running");
+        return;
+    }
+    
+    state->cec_power = cec_monitor_get_state();
+    state->cec_update_time = cec_monitor_get_last_update_time();
+    ps5_detector_export_cache(&state->ps5_info, &state->ps5_cache_time);
+    server_sm_snapshot(g_server_ctx, &state->sm);
+    state->status_version = status_snapshot_get_version();
+    state->wake_requests = g_wake_requests;
+    
+    bool ready =
+        upgrade_handoff_send(g_upgrade.fd, UPGRADE_MSG_STATE, state, sizeof(*state),
+                             fds, fd_count) == 0 &&
+        upgrade_handoff_recv(g_upgrade.fd, UPGRADE_MSG_READY, NULL, 0, NULL, 0, NULL,
+                             UPGRADE_READY_TIMEOUT_MS) == 1;
+    
+    if (!ready) {
+        // 新程序結束前可能已開始 accept;結束後本程序照常服務
+        abort_upgrade("new process did not take over");
+        ws_server_resume();
+        cec_monitor_start();
+        free(state);
+        return;
+    }
+    
+    #ifndef TESTING
+    log_info("Upgrade handed off to pid %d (%d clients), exiting",
+             (int)g_upgrade.pid, state->ws.client_count);
+    #endif
+    
+    ws_server_release();
+    close(g_upgrade.fd);
+    g_upgrade.fd = -1;
+    g_upgrade.handed_off = true;
+    g_running = 0;
+    free(state);
+}
+
+/**
+ * @brief 推進進行中的升級 (舊程序,主循環每次呼叫)
+ *
+ * 喚醒進行中時延後: 等待結果的請求與重試只存在於本程序。
+ */
+static void service_upgrade(void) {
+    bool waking = __atomic_load_n(&g_wake_started_us, __ATOMIC_RELAXED) != 0 ||
+                  (g_server_ctx && server_sm_get_state(g_server_ctx) == SERVER_STATE_WAKING_PS5);
+    
+    if (g_upgrade.fd < 0) {
+        if (g_upgrade_requested && !waking) {
+            g_upgrade_requested = 0;
+            begin_upgrade();
+        }
+        return;
+    }
+    
+    g_upgrade_requested = 0;
+    
+    int rc = upgrade_handoff_recv(g_upgrade.fd, UPGRADE_MSG_HELLO, NULL, 0, NULL, 0, NULL, 0);
+    if (rc < 0) {
+        abort_upgrade("new process exited during startup");
+    } else if (vclock_now_ms() >= g_upgrade.deadline_ms) {
+        abort_upgrade("new process did not start in time");
+    } else if (rc == 1) {
+        if (waking) {
+            abort_upgrade("wake in progress");
+        } else {
+            hand_off_upgrade();
+        }
+    }
+}
+
+/**
+ * @brief 接收舊程序的狀態 (新程序,initialize_modules 之後、主循環之前)
+ *
+ * 先等待 platform 完成: 交接之後舊程序即結束,新程序不能再失敗。
+ *
+ * @return 0 成功 (伺服器啟動後以 finish_adoption() 回覆), -1 失敗 (已通知舊程序)
+ */
+static int adopt_upgrade(int fd) {
+    if (finish_platform_init() != 0) {
+        close(fd);
         return -1;
     }
     
-    ws_server_set_connect_callback(on_client_connected, NULL);
-    ws_server_set_disconnect_callback(on_client_disconnected, NULL);
-    ws_server_set_message_handler(handle_client_message, NULL);
+    g_upgrade.fd = fd;
     
-    // 5. 創建State Machine
-    g_server_ctx = server_sm_create(config);
-    if (g_server_ctx == NULL) {
+    upgrade_state_t *state = calloc(1, sizeof(*state));
+    int fds[WS_SERVER_HANDOFF_MAX_FDS];
+    int fd_count = 0;
+    
+    if (state == NULL ||
+        upgrade_handoff_send(fd, UPGRADE_MSG_HELLO, NULL, 0, NULL, 0) != 0 ||
+        upgrade_handoff_recv(fd, UPGRADE_MSG_STATE, state, sizeof(*state),
+                             fds, WS_SERVER_HANDOFF_MAX_FDS, &fd_count,
+                             UPGRADE_STATE_TIMEOUT_MS) != 1) {
+        free(state);
+        close(fd);
+        g_upgrade.fd = -1;
+        return -1;
+    }
+    
+    if (ws_server_adopt(&state->ws, fds, fd_count) != 0) {
         #ifndef TESTING
-        logger_error("Failed to create state machine");
+        log_error("Cannot adopt sockets (worker count must match the running server)");
         #endif
-        ws_server_cleanup();
-        ps5_detector_cleanup();
-        ps5_wake_cleanup();
-        cec_monitor_cleanup();
+        for (int i = 0; i < fd_count; i++) {
+            close(fds[i]);
+        }
+        upgrade_handoff_send(fd, UPGRADE_MSG_ABORT, NULL, 0, NULL, 0);
+        free(state);
+        close(fd);
+        g_upgrade.fd = -1;
         return -1;
     }
     
-    server_sm_set_state_callback(g_server_ctx, on_state_enter, NULL);
+    status_snapshot_restore(state->sm.ps5_power, state->sm.ps5_network, state->sm.state,
+                            state->status_version);
+    cec_monitor_restore(state->cec_power, state->cec_update_time);
+    g_wake_requests = state->wake_requests;
+    if (state->ps5_cache_time != 0) {
+        ps5_detector_restore_cache(&state->ps5_info, state->ps5_cache_time);
+    }
+    server_sm_restore(g_server_ctx, &state->sm);
+    
+    const status_snapshot_t *snap = status_snapshot_acquire();
+    if (snap) {
+        ws_server_set_http_status(snap->version, snap->json);
+        status_snapshot_release(snap);
+    }
     
     #ifndef TESTING
-    logger_info("All modules initialized successfully");
+    log_info("Adopted %d clients from previous process (state %s)",
+             state->ws.client_count, server_state_to_string(state->sm.state));
     #endif
     
+    g_upgrade.adopted = true;
+    free(state);
     return 0;
 }
 
 /**
- * @brief 清理所有模組
+ * @brief 回覆舊程序 (新程序,伺服器啟動後)
+ *
+ * @param start_result ws_server_start() 的回傳值
+ * @param port 配置的端口 (與交接的不同時改為監聽新端口)
  */
-static void cleanup_modules(void) {
-    if (g_server_ctx) {
-        server_sm_destroy(g_server_ctx);
-        g_server_ctx = NULL;
+static void finish_adoption(int start_result, int port) {
+    if (start_result != 0) {
+        #ifndef TESTING
+        log_error("Failed to start with adopted sockets: %d", start_result);
+        #endif
+        upgrade_handoff_send(g_upgrade.fd, UPGRADE_MSG_ABORT, NULL, 0, NULL, 0);
+        g_running = 0;
+    } else if (upgrade_handoff_send(g_upgrade.fd, UPGRADE_MSG_READY, NULL, 0, NULL, 0) != 0) {
+        // 舊程序已放棄 (逾時),它會繼續服務
+        g_running = 0;
+    } else if (ws_server_get_port() != port && ws_server_set_port(port) != 0) {
+        #ifndef TESTING
+        log_warning("Cannot listen on port %d, keeping port %d",
+                    port, ws_server_get_port());
+        #endif
     }
     
-    ws_server_cleanup();
-    ps5_detector_cleanup();
-    ps5_wake_cleanup();
-    cec_monitor_cleanup();
+    close(g_upgrade.fd);
+    g_upgrade.fd = -1;
+}
+
+/**
+ * @brief 等待 I/O 或下一個定時器期限,再觸發到期的定時器
+ *
+ * 主循環與重播唯一的等待點: 等待時間取自 vclock 最近的定時器期限
+ * (最多 limit_us),信號與其他執行緒以 ws_server_wake() 提前喚醒。
+ * 模擬時鐘下不阻塞: I/O 只檢查一次,時間直接跳到該期限。
+ *
+ * @param limit_us 最長等待 (微秒)
+ */
+static void wait_for_events(uint64_t limit_us) {
+    int64_t next_us = vclock_next_timeout_us();
+    uint64_t wait_us = (next_us >= 0 && (uint64_t)next_us < limit_us)
+                     ? (uint64_t)next_us : limit_us;
     
-    #ifndef TESTING
-    logger_info("All modules cleaned up");
-    #endif
+    if (vclock_is_simulated()) {
+        ws_server_service(0);
+        vclock_advance(wait_us);    // 途中到期的定時器在此觸發
+        return;
+    }
+    
+    int timeout_ms = (int)((wait_us + VCLOCK_US_PER_MS - 1) / VCLOCK_US_PER_MS);
+    if (ws_server_service(timeout_ms) != 0) {
+        // 伺服器未執行 (無法監聽或交接中): 只等待定時器
+        vclock_sleep_us(wait_us);
+    }
+    
+    vclock_run_due();
 }
 
 /**
@@ -368,57 +2005,261 @@ static void cleanup_modules(void) {
  */
 static void run_main_loop(void) {
     #ifndef TESTING
-    logger_info("Entering main event loop");
+    log_info("Entering main event loop");
     #endif
     
-    // 啟動WebSocket Server
-    ws_server_start();
+    // 啟動WebSocket Server (platform 可能仍在初始化)
+    int start_result = ws_server_start();
+    if (start_result == 0) {
+        mark_serving();
+    }
     
-    // 啟動CEC Monitor
-    cec_monitor_start();
+    // 平滑升級: 伺服器已沿用舊程序的 socket,通知舊程序結束
+    if (g_upgrade.adopted) {
+        const server_config_snapshot_t *snap = server_config_current();
+        finish_adoption(start_result, snap ? snap->config.ws_port : DEFAULT_WS_PORT);
+    }
+    
+    // 先取得一次網路狀態,讓第一個查詢就有完整快照 (偵測快取不需要 platform)
+    refresh_network_status();
+    schedule_network_refresh();
     
     while (g_running) {
-        // 更新狀態機
-        if (g_server_ctx) {
-            server_sm_update(g_server_ctx);
+        service_startup();
+        
+        // 服務WebSocket 與到期的定時器 (每10秒的網路檢查);
+        // 等待新程序回應時需要定期檢查交接 socket
+        wait_for_events(g_upgrade.fd >= 0 ? UPGRADE_POLL_US : MAIN_LOOP_MAX_WAIT_US);
+        
+        if (g_trace_dump_requested) {
+            g_trace_dump_requested = 0;
+            dump_trace_file();
         }
         
-        // 服務WebSocket
-        ws_server_service(100);  // 100ms timeout
+        if (g_reload_requested) {
+            g_reload_requested = 0;
+            reload_configuration();
+        }
         
-        // 定期檢查PS5網路狀態
-        static int check_counter = 0;
-        if (++check_counter >= 100) {  // 每10秒檢查一次
-            check_counter = 0;
-            
-            // 查詢PS5網路狀態
-            ps5_info_t ps5_info = {0};
-            int detect_result = ps5_detector_get_cached(&ps5_info);
-            bool ps5_online = (detect_result == PS5_DETECT_OK && ps5_info.online);
-            
-            if (g_server_ctx) {
-                // 注意: server_sm_on_ps5_network_changed 可能需要修改參數類型
-                // 暫時使用 bool，如果需要可以轉換為其他類型
-                // server_sm_on_ps5_network_changed(g_server_ctx, ps5_online);
-                
-                // 或者直接更新狀態，不調用這個函數
-                // 因為 PS5 網路狀態變化會在 CEC 狀態變化時一起處理
-            }
+        // 啟動完成前不交接 (新程序無法接續未啟動的狀態機)
+        if (g_startup.complete) {
+            service_upgrade();
+        }
+        
+        if (__atomic_exchange_n(&g_state_dirty, false, __ATOMIC_RELAXED)) {
+            schedule_state_save();
         }
         
-        // 小延遲避免CPU過載
-        usleep(100000);  // 100ms
+        input_journal_flush();
     }
     
+    #ifndef TESTING
+    if (g_shutdown_signal != 0) {
+        log_info("Received signal %d, shutting down...", (int)g_shutdown_signal);
+    }
+    #endif
+    
+    vclock_cancel(g_refresh_timer);
+    vclock_cancel(g_state_save_timer);
+    g_state_save_timer = -1;
+    
     // 停止服務
     ws_server_stop();
     cec_monitor_stop();
     
+    // 下次啟動的暫定狀態 (交接時已在匯出前寫入,新程序接著寫)
+    if (!g_upgrade.handed_off) {
+        save_runtime_state();
+    }
+    
     #ifndef TESTING
-    logger_info("Exiting main event loop");
+    log_info("Exiting main event loop");
     #endif
 }
 
+#ifdef TESTING
+/* ============================================================
+ *  Journal Replay (TESTING only)
+ * ============================================================ */
+
+/**
+ * @brief 錄製時的客戶端 ID 與重播時分配的 ID
+ */
+typedef struct {
+    int recorded;
+    int replayed;
+} replay_client_t;
+
+static replay_client_t g_replay_clients[WS_SERVER_MAX_CLIENTS];
+static int g_replay_client_count = 0;
+
+static int replay_find_client(int recorded) {
+    for (int i = 0; i < g_replay_client_count; i++) {
+        if (g_replay_clients[i].recorded == recorded) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 重播一筆輸入
+ * 
+ * @return 0 成功, -1 無法對應 (例如客戶端不存在)
+ */
+static int replay_record(const journal_record_t *record, const char *payload) {
+    int idx;
+    
+    switch ((journal_type_t)record->type) {
+        case JOURNAL_CEC_POWER:
+            cec_monitor_test_set_state((ps5_power_state_t)record->a0);
+            return 0;
+        
+        case JOURNAL_DETECT:
+            apply_detect_result(record->a0, record->a1 != 0);
+            return 0;
+        
+        case JOURNAL_CLIENT_CONNECT: {
+            if (g_replay_client_count >= WS_SERVER_MAX_CLIENTS) {
+                return -1;
+            }
+            int client_id = ws_server_test_add_client(payload, 0);
+            if (client_id < 0) {
+                return -1;
+            }
+            g_replay_clients[g_replay_client_count].recorded = record->a0;
+            g_replay_clients[g_replay_client_count].replayed = client_id;
+            g_replay_client_count++;
+            return 0;
+        }
+        
+        case JOURNAL_CLIENT_DISCONNECT:
+            idx = replay_find_client(record->a0);
+            if (idx < 0) {
+                return -1;
+            }
+            ws_server_test_remove_client(g_replay_clients[idx].replayed);
+            g_replay_clients[idx] = g_replay_clients[--g_replay_client_count];
+            return 0;
+        
+        case JOURNAL_CLIENT_MESSAGE:
+            idx = replay_find_client(record->a0);
+            if (idx < 0) {
+                return -1;
+            }
+            free(ws_server_test_handle_message(g_replay_clients[idx].replayed, payload));
+            return 0;
+        
+        case JOURNAL_TIMER:
+            if (record->a0 == JOURNAL_TIMER_STATS) {
+                publish_stats_delta();
+            }
+            return 0;
+        
+        case JOURNAL_WAKE_RESULT:
+            ps5_wake_test_set_result(record->a0 != 0);
+            return 0;
+        
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief 全速重播輸入記錄檔,輸出狀態轉換序列
+ * 
+ * 輸入依記錄順序送入測試輔助函數,每筆之前把模擬時鐘推進到記錄的
+ * 時間 (不等待實際時間),因此狀態歷史、metrics 與快取逾時看到的都是
+ * 錄製時的時間軸。模擬的牆上時間從錄製開始的時間起算。非同步喚醒的
+ * 結果改由記錄中的 wake_result 提供。
+ * 
+ * 輸出狀態轉換後接 flight recorder 的記錄 (相對重播開始的時間)。
+ * 同一份記錄檔每次重播的輸出相同,可直接與預期結果比對
+ * (tests/replay)。
+ * 
+ * @return 0 成功, -1 無法開啟、模組初始化失敗或格式錯誤
+ */
+static int run_replay(const char *path, const server_config_t *config) {
+    input_journal_reader_t reader;
+    if (input_journal_reader_open(&reader, path) != 0) {
+        fprintf(stderr, "ERROR: Cannot read journal %s\n", path);
+        return -1;
+    }
+    
+    vclock_use_simulated((time_t)(reader.header.start_realtime_us / (int64_t)VCLOCK_US_PER_SEC));
+    vclock_set_auto_advance(true);
+    if (initialize_modules(config) != 0) {
+        input_journal_reader_close(&reader);
+        return -1;
+    }
+    
+    ps5_wake_test_set_deferred(true);
+    g_replaying = true;
+    uint64_t start_us = vclock_now_us();
+    
+    // 重播不使用 platform,喚醒請求直接執行
+    ws_server_start();
+    server_sm_start(g_server_ctx);
+    g_startup.complete = true;
+    
+    journal_record_t record;
+    static char payload[JOURNAL_MAX_PAYLOAD + 1];
+    int count = 0;
+    int skipped = 0;
+    int rc;
+    
+    while ((rc = input_journal_reader_next(&reader, &record, payload, sizeof(payload))) > 0) {
+        // 與主循環相同的排程: 逐一跳到定時器期限,直到記錄的時間
+        uint64_t due_us = start_us + record.time_us;
+        while (vclock_now_us() < due_us) {
+            wait_for_events(due_us - vclock_now_us());
+        }
+        if (replay_record(&record, payload) != 0) {
+            fprintf(stderr, "replay: skipped %s at %.6f s\n",
+                    journal_type_to_string((journal_type_t)record.type),
+                    (double)record.time_us / 1e6);
+            skipped++;
+        }
+        count++;
+    }
+    input_journal_reader_close(&reader);
+    
+    server_sm_history_t history;
+    server_sm_get_history(g_server_ctx, &history);
+    
+    printf("replay: %d records (%d skipped), %.6f s virtual\n",
+           count, skipped, (double)(vclock_now_us() - start_us) / 1e6);
+    for (int i = 0; i < history.count; i++) {
+        printf("  %s -> %s (%s)\n",
+               server_state_to_string(history.entries[i].from),
+               server_state_to_string(history.entries[i].to),
+               server_event_to_string(history.entries[i].event));
+    }
+    printf("final state: %s\n", server_state_to_string(history.state));
+    
+    trace_record_t records[32];
+    uint64_t since = 0;
+    int n;
+    printf("trace:\n");
+    while ((n = trace_ring_read(since, records, 32, &since)) > 0) {
+        for (int i = 0; i < n; i++) {
+            char line[160];
+            if (trace_record_format(&records[i], line, sizeof(line)) < 0) {
+                snprintf(line, sizeof(line), "event=%u", records[i].event);
+            }
+            printf("  %10.6f %s\n",
+                   (double)((int64_t)(records[i].time_ns / 1000) - (int64_t)start_us) / 1e6,
+                   line);
+        }
+    }
+    
+    ws_server_stop();
+    cec_monitor_stop();
+    cleanup_modules();
+    return (rc < 0) ? -1 : 0;
+}
+#endif // TESTING
+
 /* ============================================================
  *  Main Entry Point
  * ============================================================ */
@@ -429,12 +2270,35 @@ static void print_usage(const char *program_name) {
     printf("  -d, --daemon        Run as daemon\n");
     printf("  -p, --port PORT     WebSocket server port (default: %d)\n", 
            DEFAULT_WS_PORT);
+    printf("  -w, --workers N     WebSocket worker threads (default: %d, max: %d)\n",
+           DEFAULT_WS_WORKERS, WS_SERVER_MAX_WORKERS);
     printf("  -s, --subnet CIDR   PS5 subnet for detection (default: %s)\n", 
            DEFAULT_PS5_SUBNET);
     printf("  -c, --cache PATH    Cache file path (default: %s)\n", 
            DEFAULT_CACHE_PATH);
+    printf("  -l, --local PATH    Local IPC socket, @name = abstract, \"\" = off\n");
+    printf("                      (default: %s)\n", WS_SERVER_LOCAL_PATH);
+    printf("  -t, --trace-file PATH\n");
+    printf("                      Flight recorder dump on SIGUSR1 (default: %s)\n",
+           TRACE_DEFAULT_DUMP_PATH);
+    printf("  -r, --rate-limit SPEC\n");
+    printf("                      Message rate limits, type=rate[/burst],...\n");
+    printf("                      (e.g. wake_ps5=1/3,query_ps5=10)\n");
+    printf("  -j, --journal PATH  Record external inputs to a replay journal\n");
+    printf("  -S, --state-file PATH\n");
+    printf("                      Runtime snapshot for a warm restart, written at most every\n");
+    printf("                      %d s and on exit; keep it on tmpfs, \"\" = off (default: %s)\n",
+           (int)(STATE_SAVE_MIN_INTERVAL_US / VCLOCK_US_PER_SEC), STATE_STORE_DEFAULT_PATH);
+    printf("  -N, --ready-fd FD   Write \"READY=1\" to FD once accepting connections\n");
+    #ifdef TESTING
+    printf("  -R, --replay PATH   Replay a journal at full speed and print transitions\n");
+    #endif
+    printf("  -g, --state-graph   Print state machine transitions (Graphviz DOT) and exit\n");
     printf("  -v, --version       Print version and exit\n");
     printf("  -h, --help          Print this help and exit\n");
+    printf("\nOptions override /etc/config/%s, which is re-read on SIGHUP.\n",
+           SERVER_CONFIG_UCI_PACKAGE);
+    printf("SIGUSR2 starts the installed binary and hands over sockets and clients.\n");
     printf("\nExamples:\n");
     printf("  %s                  # Run in foreground\n", program_name);
     printf("  %s --daemon         # Run as daemon\n", program_name);
@@ -446,37 +2310,83 @@ static void print_version(void) {
 }
 
 int main(int argc, char *argv[]) {
+    g_startup.start_us = metrics_now_us();
+    
     bool daemon_mode = false;
-    server_config_t config = {0};
-    config.ws_port = DEFAULT_WS_PORT;
-    strncpy(config.ps5_subnet, DEFAULT_PS5_SUBNET, sizeof(config.ps5_subnet) - 1);
-    strncpy(config.cache_path, DEFAULT_CACHE_PATH, sizeof(config.cache_path) - 1);
+    const char *replay_path = NULL;
+    int ready_fd = -1;
+    server_config_t config;
+    set_default_config(&g_cli_config);
     
     // 解析命令列參數
     static struct option long_options[] = {
         {"daemon",  no_argument,       0, 'd'},
         {"port",    required_argument, 0, 'p'},
+        {"workers", required_argument, 0, 'w'},
         {"subnet",  required_argument, 0, 's'},
         {"cache",   required_argument, 0, 'c'},
+        {"local",   required_argument, 0, 'l'},
+        {"rate-limit", required_argument, 0, 'r'},
+        {"trace-file", required_argument, 0, 't'},
+        {"state-graph", no_argument,   0, 'g'},
+        {"journal", required_argument, 0, 'j'},
+        {"state-file", required_argument, 0, 'S'},
+        {"ready-fd", required_argument, 0, 'N'},
+        {"replay",  required_argument, 0, 'R'},
         {"version", no_argument,       0, 'v'},
         {"help",    no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
     
     int opt;
-    while ((opt = getopt_long(argc, argv, "dp:s:c:vh", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "dp:w:s:c:l:r:t:gj:S:N:R:vh", long_options, NULL)) != -1) {
         switch (opt) {
             case 'd':
                 daemon_mode = true;
                 break;
             case 'p':
-                config.ws_port = atoi(optarg);
+                g_cli_config.ws_port = atoi(optarg);
+                g_cli_options |= SERVER_CONFIG_PORT;
+                break;
+            case 'w':
+                g_cli_config.ws_workers = atoi(optarg);
+                g_cli_options |= SERVER_CONFIG_WORKERS;
                 break;
             case 's':
-                strncpy(config.ps5_subnet, optarg, sizeof(config.ps5_subnet) - 1);
+                strncpy(g_cli_config.ps5_subnet, optarg, sizeof(g_cli_config.ps5_subnet) - 1);
+                g_cli_options |= SERVER_CONFIG_SUBNET;
                 break;
             case 'c':
-                strncpy(config.cache_path, optarg, sizeof(config.cache_path) - 1);
+                strncpy(g_cli_config.cache_path, optarg, sizeof(g_cli_config.cache_path) - 1);
+                g_cli_options |= SERVER_CONFIG_CACHE_PATH;
+                break;
+            case 'l':
+                strncpy(g_cli_config.local_path, optarg, sizeof(g_cli_config.local_path) - 1);
+                g_cli_options |= SERVER_CONFIG_LOCAL_PATH;
+                break;
+            case 'r':
+                strncpy(g_cli_config.rate_limits, optarg, sizeof(g_cli_config.rate_limits) - 1);
+                g_cli_options |= SERVER_CONFIG_RATE_LIMITS;
+                break;
+            case 't':
+                strncpy(g_cli_config.trace_path, optarg, sizeof(g_cli_config.trace_path) - 1);
+                g_cli_options |= SERVER_CONFIG_TRACE_PATH;
+                break;
+            case 'g':
+                return (server_sm_write_graph(stdout) == 0) ? 0 : 1;
+            case 'j':
+                strncpy(g_cli_config.journal_path, optarg, sizeof(g_cli_config.journal_path) - 1);
+                g_cli_options |= SERVER_CONFIG_JOURNAL_PATH;
+                break;
+            case 'S':
+                strncpy(g_cli_config.state_path, optarg, sizeof(g_cli_config.state_path) - 1);
+                g_cli_options |= SERVER_CONFIG_STATE_PATH;
+                break;
+            case 'N':
+                ready_fd = atoi(optarg);
+                break;
+            case 'R':
+                replay_path = optarg;
                 break;
             case 'v':
                 print_version();
@@ -490,39 +2400,48 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    // ⭐⭐⭐ STEP 1: 初始化 Platform (最重要!)
-    #ifndef TESTING
-    printf("Initializing gaming platform...\n");
+    // 平滑升級: 由舊程序啟動,已在背景執行
+    int upgrade_fd = upgrade_handoff_inherited();
+    if (upgrade_fd >= 0) {
+        daemon_mode = false;
+    }
     
-    int result = platform_init();
-    if (result != PLATFORM_OK) {
-        fprintf(stderr, "ERROR: Failed to initialize platform: %d\n", result);
-        return 1;
+    // 開始服務時通知 (NOTIFY_SOCKET 或 --ready-fd)
+    // 升級時舊程序已通知過,命令列上的 fd 也已關閉
+    if (readiness_init(upgrade_fd >= 0 ? -1 : ready_fd) != 0) {
+        fprintf(stderr, "WARNING: Invalid ready fd %d, readiness notification disabled\n",
+                ready_fd);
     }
     
-    // ⭐⭐⭐ STEP 2: 驗證設備類型必須為 "server"
-    const char *device_type = platform_get_device_type();
-    if (strcmp(device_type, "server") != 0) {
-        fprintf(stderr, "ERROR: This device is not a server!\n");
-        fprintf(stderr, "Detected device type: %s\n", device_type);
-        fprintf(stderr, "Expected device type: server\n");
-        platform_cleanup();
+    // SIGUSR2 時重新執行同一路徑 (套件更新後為新的執行檔)
+    ssize_t path_len = readlink("/proc/self/exe", g_upgrade.exec_path,
+                                sizeof(g_upgrade.exec_path) - 1);
+    g_upgrade.exec_path[path_len > 0 ? path_len : 0] = '\0';
+    g_upgrade.argv = argv;
+    
+    // 預設值 < /etc/config/gaming-server < 命令列
+    if (build_config(&config) != 0 || server_config_init(&config) != 0) {
+        fprintf(stderr, "ERROR: Invalid configuration (/etc/config/%s or command line)\n",
+                SERVER_CONFIG_UCI_PACKAGE);
         return 1;
     }
     
-    const char *platform_version = platform_get_version();
-    printf("Platform initialized successfully\n");
-    printf("  Version: %s\n", platform_version);
-    printf("  Device type: %s\n", device_type);
-    #endif
+    // 重播模式: 不使用 platform,以模擬時鐘重播後離開
+    if (replay_path != NULL) {
+        #ifdef TESTING
+        int replay_result = run_replay(replay_path, &config);
+        server_config_cleanup();
+        return (replay_result == 0) ? 0 : 1;
+        #else
+        fprintf(stderr, "ERROR: --replay requires a TESTING build\n");
+        return 1;
+        #endif
+    }
     
-    // Daemon模式
+    // Daemon模式 (在建立任何執行緒之前)
     if (daemon_mode) {
         if (daemon(0, 0) != 0) {
             perror("Failed to daemonize");
-            #ifndef TESTING
-            platform_cleanup();
-            #endif
             return 1;
         }
     }
@@ -531,40 +2450,96 @@ int main(int argc, char *argv[]) {
     #ifndef TESTING
     logger_init(PROGRAM_NAME, daemon_mode ? LOG_LEVEL_INFO : LOG_LEVEL_DEBUG,
                 daemon_mode);
-    logger_info("=== %s v%s starting ===", PROGRAM_NAME, PROGRAM_VERSION);
-    logger_info("Platform: %s", platform_version);
-    logger_info("Device type: %s", device_type);
-    logger_info("WebSocket port: %d", config.ws_port);
-    logger_info("PS5 subnet: %s", config.ps5_subnet);
-    logger_info("Cache path: %s", config.cache_path);
+    
+    // 日誌由背景執行緒寫入 (syslog 阻塞時不影響主循環與 CEC 執行緒)
+    if (async_log_start(daemon_mode ? ASYNC_LOG_INFO : ASYNC_LOG_DEBUG) != 0) {
+        log_warning("Cannot start log thread, logging synchronously");
+    }
+    log_info("=== %s v%s starting ===", PROGRAM_NAME, PROGRAM_VERSION);
+    log_info("WebSocket port: %d", config.ws_port);
+    log_info("WebSocket workers: %d", config.ws_workers);
+    log_info("PS5 subnet: %s", config.ps5_subnet);
+    log_info("Cache path: %s", config.cache_path);
+    log_info("Local socket: %s",
+             config.local_path[0] != '\0' ? config.local_path : "(disabled)");
+    if (config.rate_limits[0] != '\0') {
+        log_info("Rate limits: %s", config.rate_limits);
+    }
     #endif
     
     // 設定信號處理
     setup_signal_handlers();
     
-    // 初始化所有模組
+    // ⭐⭐⭐ STEP 1: 在背景初始化 Platform,同時初始化其他模組並開始 listen
+    // 設備類型 (必須為 "server") 在 platform 完成後驗證
+    start_platform_init();
+    
+    // 初始化所有模組 (狀態機在 platform 完成前不控制 LED)
     if (initialize_modules(&config) != 0) {
         #ifndef TESTING
-        logger_error("Failed to initialize modules");
+        log_error("Failed to initialize modules");
+        #endif
+        stop_platform();
+        #ifndef TESTING
+        async_log_stop();
+        logger_cleanup();
+        #endif
+        return 1;
+    }
+    
+    // 平滑升級: 接收舊程序的 socket 與狀態
+    if (upgrade_fd >= 0 && adopt_upgrade(upgrade_fd) != 0) {
+        #ifndef TESTING
+        log_error("Upgrade handoff failed, previous process keeps running");
+        #endif
+        cleanup_modules();
+        server_config_cleanup();
+        stop_platform();
+        #ifndef TESTING
+        async_log_stop();
         logger_cleanup();
-        platform_cleanup();
         #endif
         return 1;
     }
     
+    if (g_upgrade.adopted) {
+        // 交接的電源狀態已由舊程序確認
+        record_first_state();
+    } else {
+        // 上次的執行狀態,在 CEC 第一次回報前暫時回答查詢
+        load_warm_state(&config);
+    }
+    
+    // 記錄外部輸入 (供 TESTING 版本 --replay 重播)
+    // 升級接續的狀態無法從檔案開頭重播,新程序不記錄
+    if (config.journal_path[0] != '\0' && !g_upgrade.adopted) {
+        if (input_journal_start(config.journal_path) != 0) {
+            #ifndef TESTING
+            log_error("Failed to open input journal %s", config.journal_path);
+            #endif
+        } else {
+            #ifndef TESTING
+            log_info("Recording inputs to %s", config.journal_path);
+            #endif
+        }
+    }
+    
     // 執行主循環
     run_main_loop();
     
     // 清理
     cleanup_modules();
+    input_journal_stop();
+    server_config_cleanup();
+    
+    // ⭐⭐⭐ STEP 2: 清理 Platform (仍在初始化時先等待完成)
+    stop_platform();
     
     #ifndef TESTING
-    logger_info("=== %s shutdown complete ===", PROGRAM_NAME);
+    log_info("=== %s shutdown complete ===", PROGRAM_NAME);
+    async_log_stop();
     logger_cleanup();
-    
-    // ⭐⭐⭐ STEP 3: 清理 Platform
-    platform_cleanup();
     #endif
     
-    return 0;
+    return g_startup.failed ? 1 : 0;
 }
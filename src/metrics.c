@@ -0,0 +1,333 @@
+/**
+ * @file metrics.c
+ * @brief Metrics Registry Implementation
+ *
+ * 所有數值存放在靜態陣列,記錄時只做 relaxed atomic 加法;
+ * 輸出時逐一讀取,不需要與記錄端同步 (各數值各自單調)。
+ * 直方圖區間存放非累積計數,輸出時再累加,因此 _count 一定等於 +Inf 區間。
+ *
+ * @version 1.0.0
+ * @date 2025-11-27
+ */
+
+#include "metrics.h"
+#include "vclock.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 指標描述 (編譯期固定)
+ */
+typedef struct {
+    const char *name;
+    const char *help;
+    const char *const *labels;  // 完整標籤字串, NULL 表示無標籤
+    int label_count;
+    bool seconds;               // 計數器數值為微秒,以秒輸出
+} metrics_desc_t;
+
+/**
+ * @brief 一個標籤組合的直方圖
+ */
+typedef struct {
+    uint64_t buckets[METRICS_HISTOGRAM_BUCKETS + 1];    // 最後一個為 +Inf
+    uint64_t sum_us;
+} metrics_histogram_data_t;
+
+/**
+ * @brief 輸出緩衝區
+ */
+typedef struct {
+    char *out;
+    size_t size;
+    size_t len;
+    bool overflow;
+} metrics_writer_t;
+
+/* ============================================================
+ *  Metric Definitions
+ * ============================================================ */
+
+/** 依 ws_message_type_t 排列 (客戶端送出的類型) */
+static const char *const k_message_labels[] = {
+    "type=\"unknown\"", "type=\"query_ps5\"", "type=\"wake_ps5\"", "type=\"ping\"",
+    "type=\"pong\"", "type=\"subscribe\"", "type=\"unsubscribe\"", "type=\"debug_dump\"",
+    "type=\"server_state_history\"",
+};
+
+static const char *const k_result_labels[] = {
+    "result=\"ok\"", "result=\"error\"",
+};
+
+/** 依 metrics_detector_label() 排列 */
+static const char *const k_detector_check_labels[] = {
+    "method=\"cache\",result=\"hit\"", "method=\"cache\",result=\"miss\"",
+    "method=\"arp\",result=\"hit\"",   "method=\"arp\",result=\"miss\"",
+    "method=\"scan\",result=\"hit\"",  "method=\"scan\",result=\"miss\"",
+    "method=\"ping\",result=\"hit\"",  "method=\"ping\",result=\"miss\"",
+};
+
+/** 依 detect_method_t 排列 */
+static const char *const k_detector_labels[] = {
+    "method=\"cache\"", "method=\"arp\"", "method=\"scan\"", "method=\"ping\"",
+};
+
+/** 依 server_state_t 排列 (與 server_state_to_string() 相同) */
+static const char *const k_state_labels[] = {
+    "to=\"INIT\"", "to=\"MONITORING\"", "to=\"PS5_DETECTED\"",
+    "to=\"CLIENT_CONNECTED\"", "to=\"WAKING_PS5\"", "to=\"ERROR\"",
+};
+
+/** 依 server_state_t 排列 (停留時間) */
+static const char *const k_state_time_labels[] = {
+    "state=\"INIT\"", "state=\"MONITORING\"", "state=\"PS5_DETECTED\"",
+    "state=\"CLIENT_CONNECTED\"", "state=\"WAKING_PS5\"", "state=\"ERROR\"",
+};
+
+#define LABELS(array)   array, (int)(sizeof(array) / sizeof(array[0]))
+#define NO_LABELS       NULL, 1
+
+static const metrics_desc_t k_counters[METRIC_COUNTER_COUNT] = {
+    [METRIC_WS_MESSAGES] = { "gaming_ws_messages_total",
+        "WebSocket messages received by type", LABELS(k_message_labels) },
+    [METRIC_CEC_QUERIES] = { "gaming_cec_queries_total",
+        "CEC power queries by result", LABELS(k_result_labels) },
+    [METRIC_DETECTOR_CHECKS] = { "gaming_detector_checks_total",
+        "PS5 detection attempts by method and result", LABELS(k_detector_check_labels) },
+    [METRIC_WAKE_ATTEMPTS] = { "gaming_wake_attempts_total",
+        "PS5 wake commands sent by result", LABELS(k_result_labels) },
+    [METRIC_WAKE_RETRIES] = { "gaming_wake_retries_total",
+        "PS5 wake command retries", NO_LABELS },
+    [METRIC_STATE_TRANSITIONS] = { "gaming_state_transitions_total",
+        "Server state machine transitions by target state", LABELS(k_state_labels) },
+    [METRIC_STATE_SECONDS] = { "gaming_state_seconds_total",
+        "Time spent in each server state (completed stays)", LABELS(k_state_time_labels), true },
+};
+
+static const metrics_desc_t k_gauges[METRIC_GAUGE_COUNT] = {
+    [METRIC_CEC_ERROR_STREAK] = { "gaming_cec_error_streak",
+        "Current consecutive CEC query failures", NO_LABELS },
+    [METRIC_CEC_ERROR_STREAK_MAX] = { "gaming_cec_error_streak_max",
+        "Longest run of consecutive CEC query failures", NO_LABELS },
+    [METRIC_STARTUP_ACCEPT_US] = { "gaming_startup_accept_microseconds",
+        "Time from process start until the listeners accept connections", NO_LABELS },
+    [METRIC_STARTUP_STATE_US] = { "gaming_startup_valid_state_microseconds",
+        "Time from process start until the first confirmed PS5 power state", NO_LABELS },
+};
+
+static const metrics_desc_t k_histograms[METRIC_HISTOGRAM_COUNT] = {
+    [METRIC_WS_HANDLER_SECONDS] = { "gaming_ws_handler_seconds",
+        "Time spent in the WebSocket message handler", NO_LABELS },
+    [METRIC_WS_FANOUT_SECONDS] = { "gaming_ws_fanout_seconds",
+        "Time to send one broadcast to all clients of a worker", NO_LABELS },
+    [METRIC_CEC_QUERY_SECONDS] = { "gaming_cec_query_seconds",
+        "CEC power query latency", NO_LABELS },
+    [METRIC_DETECTOR_SECONDS] = { "gaming_detector_seconds",
+        "PS5 detection latency by method", LABELS(k_detector_labels) },
+    [METRIC_WAKE_POWER_ON_SECONDS] = { "gaming_wake_power_on_seconds",
+        "Time from wake request to PS5 reported powered on", NO_LABELS },
+    [METRIC_WAKING_SECONDS] = { "gaming_state_waking_seconds",
+        "Time spent in WAKING_PS5 per wake", NO_LABELS },
+};
+
+/** 直方圖區間上限 (微秒) 與輸出字串 (秒) */
+static const uint64_t k_bucket_us[METRICS_HISTOGRAM_BUCKETS] = {
+    100, 500, 1000, 5000, 10000, 50000,
+    100000, 500000, 1000000, 5000000, 15000000, 60000000,
+};
+
+static const char *const k_bucket_le[METRICS_HISTOGRAM_BUCKETS] = {
+    "0.0001", "0.0005", "0.001", "0.005", "0.01", "0.05",
+    "0.1", "0.5", "1", "5", "15", "60",
+};
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+static uint64_t g_counters[METRIC_COUNTER_COUNT][METRICS_MAX_LABELS];
+static int64_t g_gauges[METRIC_GAUGE_COUNT];
+static metrics_histogram_data_t g_histograms[METRIC_HISTOGRAM_COUNT][METRICS_MAX_LABELS];
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static void writer_append(metrics_writer_t *w, const char *fmt, ...) {
+    if (w->overflow) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(w->out + w->len, w->size - w->len, fmt, args);
+    va_end(args);
+
+    if (n < 0 || (size_t)n >= w->size - w->len) {
+        w->overflow = true;
+        return;
+    }
+    w->len += (size_t)n;
+}
+
+static void write_header(metrics_writer_t *w, const metrics_desc_t *desc, const char *type) {
+    writer_append(w, "# HELP %s %s\n# TYPE %s %s\n", desc->name, desc->help, desc->name, type);
+}
+
+/**
+ * @brief 標籤前綴: 無標籤時為空字串
+ */
+static const char* label_at(const metrics_desc_t *desc, int label) {
+    return desc->labels ? desc->labels[label] : "";
+}
+
+static void write_histogram(metrics_writer_t *w, const metrics_desc_t *desc,
+                            const metrics_histogram_data_t *data, int label)
+{
+    const char *labels = label_at(desc, label);
+    const char *sep = desc->labels ? "," : "";
+    uint64_t cumulative = 0;
+
+    for (int b = 0; b <= METRICS_HISTOGRAM_BUCKETS; b++) {
+        cumulative += __atomic_load_n(&data->buckets[b], __ATOMIC_RELAXED);
+        writer_append(w, "%s_bucket{%s%sle=\"%s\"} %" PRIu64 "\n", desc->name, labels, sep,
+                      (b < METRICS_HISTOGRAM_BUCKETS) ? k_bucket_le[b] : "+Inf", cumulative);
+    }
+
+    uint64_t sum_us = __atomic_load_n(&data->sum_us, __ATOMIC_RELAXED);
+    const char *open = desc->labels ? "{" : "";
+    const char *close = desc->labels ? "}" : "";
+    writer_append(w, "%s_sum%s%s%s %" PRIu64 ".%06" PRIu64 "\n", desc->name,
+                  open, labels, close, sum_us / 1000000, sum_us % 1000000);
+    writer_append(w, "%s_count%s%s%s %" PRIu64 "\n", desc->name,
+                  open, labels, close, cumulative);
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+uint64_t metrics_now_us(void) {
+    return vclock_now_us();
+}
+
+void metrics_inc(metrics_counter_t counter, int label) {
+    if ((unsigned)counter >= METRIC_COUNTER_COUNT ||
+        label < 0 || label >= k_counters[counter].label_count) {
+        return;
+    }
+    __atomic_add_fetch(&g_counters[counter][label], 1, __ATOMIC_RELAXED);
+}
+
+void metrics_add(metrics_counter_t counter, int label, uint64_t value) {
+    if ((unsigned)counter >= METRIC_COUNTER_COUNT ||
+        label < 0 || label >= k_counters[counter].label_count) {
+        return;
+    }
+    __atomic_add_fetch(&g_counters[counter][label], value, __ATOMIC_RELAXED);
+}
+
+void metrics_set(metrics_gauge_t gauge, int64_t value) {
+    if ((unsigned)gauge < METRIC_GAUGE_COUNT) {
+        __atomic_store_n(&g_gauges[gauge], value, __ATOMIC_RELAXED);
+    }
+}
+
+void metrics_set_max(metrics_gauge_t gauge, int64_t value) {
+    if ((unsigned)gauge >= METRIC_GAUGE_COUNT) {
+        return;
+    }
+
+    int64_t current = __atomic_load_n(&g_gauges[gauge], __ATOMIC_RELAXED);
+    while (value > current &&
+           !__atomic_compare_exchange_n(&g_gauges[gauge], &current, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        // current 已更新為最新值,重試
+    }
+}
+
+void metrics_observe(metrics_histogram_t histogram, int label, uint64_t value_us) {
+    if ((unsigned)histogram >= METRIC_HISTOGRAM_COUNT ||
+        label < 0 || label >= k_histograms[histogram].label_count) {
+        return;
+    }
+
+    int bucket = 0;
+    while (bucket < METRICS_HISTOGRAM_BUCKETS && value_us > k_bucket_us[bucket]) {
+        bucket++;
+    }
+
+    metrics_histogram_data_t *data = &g_histograms[histogram][label];
+    __atomic_add_fetch(&data->buckets[bucket], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&data->sum_us, value_us, __ATOMIC_RELAXED);
+}
+
+int metrics_detector_label(int method, int hit) {
+    return method * 2 + (hit ? 0 : 1);
+}
+
+int metrics_render(char *out, size_t size) {
+    if (out == NULL || size == 0) {
+        return -1;
+    }
+
+    metrics_writer_t w = { out, size, 0, false };
+    out[0] = '\0';
+
+    for (int m = 0; m < METRIC_COUNTER_COUNT; m++) {
+        const metrics_desc_t *desc = &k_counters[m];
+        write_header(&w, desc, "counter");
+        for (int l = 0; l < desc->label_count; l++) {
+            uint64_t value = __atomic_load_n(&g_counters[m][l], __ATOMIC_RELAXED);
+            const char *open = desc->labels ? "{" : "";
+            const char *close = desc->labels ? "}" : "";
+            if (desc->seconds) {
+                writer_append(&w, "%s%s%s%s %" PRIu64 ".%06" PRIu64 "\n", desc->name,
+                              open, label_at(desc, l), close, value / 1000000, value % 1000000);
+            } else {
+                writer_append(&w, "%s%s%s%s %" PRIu64 "\n", desc->name,
+                              open, label_at(desc, l), close, value);
+            }
+        }
+    }
+
+    for (int m = 0; m < METRIC_GAUGE_COUNT; m++) {
+        const metrics_desc_t *desc = &k_gauges[m];
+        write_header(&w, desc, "gauge");
+        writer_append(&w, "%s %" PRId64 "\n", desc->name,
+                      __atomic_load_n(&g_gauges[m], __ATOMIC_RELAXED));
+    }
+
+    for (int m = 0; m < METRIC_HISTOGRAM_COUNT; m++) {
+        const metrics_desc_t *desc = &k_histograms[m];
+        write_header(&w, desc, "histogram");
+        for (int l = 0; l < desc->label_count; l++) {
+            const metrics_histogram_data_t *data = &g_histograms[m][l];
+            bool observed = false;
+            for (int b = 0; b <= METRICS_HISTOGRAM_BUCKETS && !observed; b++) {
+                observed = __atomic_load_n(&data->buckets[b], __ATOMIC_RELAXED) != 0;
+            }
+            // 無標籤的直方圖一律輸出,有標籤的只輸出有樣本的組合
+            if (observed || desc->labels == NULL) {
+                write_histogram(&w, desc, data, l);
+            }
+        }
+    }
+
+    return w.overflow ? -1 : (int)w.len;
+}
+
+void metrics_reset(void) {
+    memset(g_counters, 0, sizeof(g_counters));
+    memset(g_gauges, 0, sizeof(g_gauges));
+    memset(g_histograms, 0, sizeof(g_histograms));
+}
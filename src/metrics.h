@@ -0,0 +1,163 @@
+/**
+ * @file metrics.h
+ * @brief Metrics Registry - 無鎖計數器與固定區間直方圖
+ *
+ * 此模組提供:
+ * - 計數器 (counter)、量測值 (gauge) 與直方圖 (histogram)
+ * - 所有指標在編譯期固定 (名稱、說明、標籤),記錄時不配置記憶體
+ * - 記錄只使用 relaxed atomic 操作,任何執行緒皆可呼叫
+ * - 以 Prometheus 文字格式輸出 (websocket_server 的 GET /metrics)
+ *
+ * 直方圖使用同一組固定區間 (秒),從 100us 到 60s,
+ * 涵蓋訊息處理 (微秒級) 到 PS5 開機 (數十秒)。
+ *
+ * 使用範例:
+ * @code
+ * uint64_t start = metrics_now_us();
+ * handle();
+ * metrics_observe(METRIC_WS_HANDLER_SECONDS, 0, metrics_now_us() - start);
+ * metrics_inc(METRIC_WS_MESSAGES, msg_type);
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-27
+ * @version 1.0.0
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 每個指標最多的標籤組合數 */
+#define METRICS_MAX_LABELS          16
+
+/** 直方圖區間數 (不含 +Inf) */
+#define METRICS_HISTOGRAM_BUCKETS   12
+
+/** metrics_render() 輸出上限 (需放入單一 HTTP 回應) */
+#define METRICS_RENDER_MAX          12288
+
+/** CEC 查詢結果標籤 */
+#define METRICS_RESULT_OK           0
+#define METRICS_RESULT_ERROR        1
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 計數器
+ */
+typedef enum {
+    METRIC_WS_MESSAGES = 0,     /**< 收到的訊息 {type} (標籤為 ws_message_type_t) */
+    METRIC_CEC_QUERIES,         /**< CEC 電源查詢 {result} */
+    METRIC_DETECTOR_CHECKS,     /**< 偵測方法結果 {method,result} (metrics_detector_label) */
+    METRIC_WAKE_ATTEMPTS,       /**< 喚醒命令 {result} */
+    METRIC_WAKE_RETRIES,        /**< 喚醒重試 */
+    METRIC_STATE_TRANSITIONS,   /**< 狀態轉換 {to} (標籤為 server_state_t) */
+    METRIC_STATE_SECONDS,       /**< 離開狀態時累計的停留時間 {state} (微秒,以秒輸出) */
+    METRIC_COUNTER_COUNT
+} metrics_counter_t;
+
+/**
+ * @brief 量測值
+ */
+typedef enum {
+    METRIC_CEC_ERROR_STREAK = 0,    /**< 目前連續 CEC 查詢失敗次數 */
+    METRIC_CEC_ERROR_STREAK_MAX,    /**< 最長連續失敗次數 */
+    METRIC_STARTUP_ACCEPT_US,       /**< 程序啟動到開始 accept 的時間 (微秒) */
+    METRIC_STARTUP_STATE_US,        /**< 程序啟動到第一次確認 PS5 狀態的時間 (微秒) */
+    METRIC_GAUGE_COUNT
+} metrics_gauge_t;
+
+/**
+ * @brief 直方圖
+ */
+typedef enum {
+    METRIC_WS_HANDLER_SECONDS = 0,  /**< 訊息處理器執行時間 */
+    METRIC_WS_FANOUT_SECONDS,       /**< 廣播發送給一個 worker 所有客戶端的時間 */
+    METRIC_CEC_QUERY_SECONDS,       /**< CEC 電源查詢時間 */
+    METRIC_DETECTOR_SECONDS,        /**< 偵測方法時間 {method} (標籤為 detect_method_t) */
+    METRIC_WAKE_POWER_ON_SECONDS,   /**< 喚醒請求到 CEC 回報開機的時間 */
+    METRIC_WAKING_SECONDS,          /**< 每次停留在 WAKING_PS5 的時間 */
+    METRIC_HISTOGRAM_COUNT
+} metrics_histogram_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 目前的單調時間 (微秒),用於計算延遲
+ */
+uint64_t metrics_now_us(void);
+
+/**
+ * @brief 計數器加 1
+ *
+ * @param label 標籤索引 (無標籤的指標為 0),超出範圍時忽略
+ */
+void metrics_inc(metrics_counter_t counter, int label);
+
+/**
+ * @brief 計數器加上 value (例如累計微秒)
+ *
+ * @param label 標籤索引 (無標籤的指標為 0),超出範圍時忽略
+ */
+void metrics_add(metrics_counter_t counter, int label, uint64_t value);
+
+/**
+ * @brief 設定量測值
+ */
+void metrics_set(metrics_gauge_t gauge, int64_t value);
+
+/**
+ * @brief 量測值只在更大時更新 (例如最長連續失敗)
+ */
+void metrics_set_max(metrics_gauge_t gauge, int64_t value);
+
+/**
+ * @brief 記錄一筆直方圖樣本
+ *
+ * @param label 標籤索引 (無標籤的指標為 0),超出範圍時忽略
+ * @param value_us 數值 (微秒)
+ */
+void metrics_observe(metrics_histogram_t histogram, int label, uint64_t value_us);
+
+/**
+ * @brief 偵測方法結果的標籤索引
+ *
+ * @param method detect_method_t
+ * @param hit 是否找到 PS5
+ */
+int metrics_detector_label(int method, int hit);
+
+/**
+ * @brief 以 Prometheus 文字格式 (0.0.4) 輸出所有指標
+ *
+ * 計數器與量測值一律輸出;直方圖只輸出有樣本的標籤組合。
+ *
+ * @return 輸出長度, <0 表示緩衝區不足
+ */
+int metrics_render(char *out, size_t size);
+
+/**
+ * @brief 清除所有指標 (測試用)
+ */
+void metrics_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_H */
@@ -0,0 +1,92 @@
+/**
+ * @file mpsc_queue.c
+ * @brief Bounded Lock-free Queue Implementation
+ *
+ * 每個格子記錄輪次 (sequence):
+ * - sequence == pos     : 格子空著,可寫入位置 pos
+ * - sequence == pos + 1 : 位置 pos 已寫入,可讀取
+ * 生產者以 CAS 搶下 head 後寫入格子,再以 release 發佈 sequence;
+ * 消費者看到 sequence 更新後才讀取項目,因此不需要鎖。
+ *
+ * @version 1.0.0
+ * @date 2025-11-23
+ */
+
+#include "mpsc_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int mpsc_queue_init(mpsc_queue_t *queue, size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    memset(queue, 0, sizeof(*queue));
+    queue->cells = calloc(size, sizeof(mpsc_cell_t));
+    if (queue->cells == NULL) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        queue->cells[i].sequence = i;
+    }
+    queue->mask = size - 1;
+
+    return 0;
+}
+
+void mpsc_queue_destroy(mpsc_queue_t *queue) {
+    free(queue->cells);
+    memset(queue, 0, sizeof(*queue));
+}
+
+bool mpsc_queue_push(mpsc_queue_t *queue, void *item) {
+    size_t pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    mpsc_cell_t *cell;
+
+    for (;;) {
+        cell = &queue->cells[pos & queue->mask];
+        size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        long diff = (long)(seq - pos);
+
+        if (diff == 0) {
+            // 格子空著: 搶下此位置 (失敗時 pos 會更新為最新的 head)
+            if (__atomic_compare_exchange_n(&queue->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // 消費者尚未讀取上一輪: 佇列已滿
+        } else {
+            pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->item = item;
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void* mpsc_queue_pop(mpsc_queue_t *queue) {
+    mpsc_cell_t *cell = &queue->cells[queue->tail & queue->mask];
+    size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+
+    if (seq != queue->tail + 1) {
+        return NULL;  // 空的,或生產者尚未完成寫入
+    }
+
+    void *item = cell->item;
+    cell->item = NULL;
+
+    // 格子留給下一輪 (pos + 容量) 使用
+    __atomic_store_n(&cell->sequence, queue->tail + queue->mask + 1, __ATOMIC_RELEASE);
+    queue->tail++;
+
+    return item;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file mpsc_queue.h
+ * @brief Bounded Lock-free Queue - 多生產者 / 單一消費者
+ *
+ * 此模組提供:
+ * - 固定容量的環狀佇列 (容量向上取整為 2 的次方)
+ * - 多個執行緒可同時 push,只有一個執行緒 pop
+ * - push/pop 皆不持有鎖,也不呼叫 malloc()
+ *
+ * 佇列只保存指標,項目的生命週期由呼叫者管理。
+ *
+ * 使用範例:
+ * @code
+ * mpsc_queue_t queue;
+ * mpsc_queue_init(&queue, 256);
+ *
+ * // 任意執行緒
+ * if (!mpsc_queue_push(&queue, item)) {
+ *     free(item);  // 佇列已滿
+ * }
+ *
+ * // 消費者執行緒
+ * void *item;
+ * while ((item = mpsc_queue_pop(&queue)) != NULL) {
+ *     handle(item);
+ * }
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-23
+ * @version 1.0.0
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 佇列格子
+ */
+typedef struct {
+    size_t sequence;            /**< 格子的輪次 (以 __atomic 存取) */
+    void *item;                 /**< 項目 */
+} mpsc_cell_t;
+
+/**
+ * @brief 佇列
+ */
+typedef struct {
+    mpsc_cell_t *cells;         /**< 格子陣列 */
+    size_t mask;                /**< 容量 - 1 */
+    size_t head;                /**< 下一個寫入位置 (生產者共用) */
+    size_t tail;                /**< 下一個讀取位置 (僅消費者) */
+} mpsc_queue_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 初始化佇列
+ *
+ * @param queue 佇列
+ * @param capacity 容量 (向上取整為 2 的次方, 最小 2)
+ * @return 0 成功, -1 記憶體不足
+ */
+int mpsc_queue_init(mpsc_queue_t *queue, size_t capacity);
+
+/**
+ * @brief 釋放佇列 (不釋放仍在佇列中的項目)
+ */
+void mpsc_queue_destroy(mpsc_queue_t *queue);
+
+/**
+ * @brief 加入項目 (任意執行緒)
+ *
+ * @param queue 佇列
+ * @param item 項目 (不可為 NULL)
+ * @return true 成功, false 佇列已滿
+ */
+bool mpsc_queue_push(mpsc_queue_t *queue, void *item);
+
+/**
+ * @brief 取出項目 (僅消費者執行緒)
+ *
+ * @return 項目, NULL 表示佇列為空
+ */
+void* mpsc_queue_pop(mpsc_queue_t *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPSC_QUEUE_H */
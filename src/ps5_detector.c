@@ -11,6 +11,10 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "ps5_detector.h"
+#include "metrics.h"
+#include "trace_ring.h"
+#include "vclock.h"
+#include "async_log.h"
 
 // Standard C library
 #include <stdio.h>
@@ -260,7 +264,7 @@ static int load_cache_from_file(ps5_info_t *info) {
     cJSON_Delete(root);
     
     // Validate cache age
-    time_t now = time(NULL);
+    time_t now = vclock_time();
     if (now - info->last_seen > PS5_CACHE_MAX_AGE) {
         return PS5_DETECT_ERROR_CACHE_INVALID;
     }
@@ -313,6 +317,16 @@ static int save_cache_to_file(const ps5_info_t *info) {
  *  Helper Functions - Detection Methods
  * ============================================================ */
 
+/**
+ * @brief Record latency and hit/miss of one detection method
+ */
+static void record_detection(detect_method_t method, uint64_t start_us, bool hit) {
+    uint64_t latency_us = metrics_now_us() - start_us;
+    metrics_observe(METRIC_DETECTOR_SECONDS, (int)method, latency_us);
+    metrics_inc(METRIC_DETECTOR_CHECKS, metrics_detector_label((int)method, hit));
+    trace_ring_record(TRACE_DETECT_PROBE, (uint16_t)method, hit ? 1 : 0, (uint32_t)latency_us);
+}
+
 /**
  * @brief Check ARP table for PS5
  */
@@ -347,7 +361,7 @@ static int check_arp_table(ps5_info_t *info) {
                 // For now, accept any valid entry in our subnet
                 snprintf(info->ip, PS5_IP_MAX_LEN, "%s", ip);
                 snprintf(info->mac, PS5_MAC_MAX_LEN, "%s", mac);
-                info->last_seen = time(NULL);
+                info->last_seen = vclock_time();
                 info->online = true;
                 return PS5_DETECT_OK;
             }
@@ -395,7 +409,7 @@ static int scan_network_nmap(ps5_info_t *info) {
                 ip_start++; // Skip space
                 if (ps5_detector_validate_ip(ip_start)) {
                     snprintf(info->ip, PS5_IP_MAX_LEN, "%s", ip_start);
-                    info->last_seen = time(NULL);
+                    info->last_seen = vclock_time();
                     info->online = true;
                     // MAC will be empty, need ARP lookup
                     info->mac[0] = '\0';
@@ -441,6 +455,31 @@ int ps5_detector_init(const char *subnet, const char *cache_path) {
     return PS5_DETECT_OK;
 }
 
+int ps5_detector_set_config(const char *subnet, const char *cache_path) {
+    if (!g_detector_ctx.initialized) {
+        return PS5_DETECT_ERROR_NOT_INIT;
+    }
+    
+    if (subnet == NULL || cache_path == NULL ||
+        strlen(subnet) >= sizeof(g_detector_ctx.subnet) ||
+        strlen(cache_path) >= sizeof(g_detector_ctx.cache_path)) {
+        return PS5_DETECT_ERROR_INVALID_PARAM;
+    }
+    
+    snprintf(g_detector_ctx.subnet, sizeof(g_detector_ctx.subnet), "%s", subnet);
+    snprintf(g_detector_ctx.cache_path, sizeof(g_detector_ctx.cache_path), "%s", cache_path);
+    
+    // 舊子網路 / 舊快取檔案的結果不再適用,下次查詢重新讀取
+    memset(&g_detector_ctx.cached_info, 0, sizeof(ps5_info_t));
+    g_detector_ctx.cache_timestamp = 0;
+    
+    #ifndef TESTING
+    log_info("PS5 detector reconfigured: subnet=%s, cache=%s", subnet, cache_path);
+    #endif
+    
+    return PS5_DETECT_OK;
+}
+
 int ps5_detector_get_cached(ps5_info_t *info) {
     if (!g_detector_ctx.initialized) {
         return PS5_DETECT_ERROR_NOT_INIT;
@@ -464,7 +503,7 @@ int ps5_detector_save_cache(const ps5_info_t *info) {
     
     // Update internal cache
     memcpy(&g_detector_ctx.cached_info, info, sizeof(ps5_info_t));
-    g_detector_ctx.cache_timestamp = time(NULL);
+    g_detector_ctx.cache_timestamp = vclock_time();
     
     return save_cache_to_file(info);
 }
@@ -507,7 +546,9 @@ int ps5_detector_scan(ps5_info_t *info) {
     #endif
     
     // Try nmap scan
+    uint64_t start_us = metrics_now_us();
     int result = scan_network_nmap(info);
+    record_detection(DETECT_METHOD_SCAN, start_us, result == PS5_DETECT_OK);
     
     if (result == PS5_DETECT_OK) {
         // If we found IP, try to get MAC from ARP
@@ -535,17 +576,29 @@ int ps5_detector_quick_check(const char *cached_ip, ps5_info_t *info) {
     }
     
     // Step 1: Try cache
-    if (ps5_detector_get_cached(info) == PS5_DETECT_OK) {
+    uint64_t start_us = metrics_now_us();
+    bool cached = (ps5_detector_get_cached(info) == PS5_DETECT_OK);
+    record_detection(DETECT_METHOD_CACHE, start_us, cached);
+    
+    if (cached) {
         // Verify with ping
-        if (ps5_detector_ping(info->ip)) {
+        start_us = metrics_now_us();
+        bool alive = ps5_detector_ping(info->ip);
+        record_detection(DETECT_METHOD_PING, start_us, alive);
+        
+        if (alive) {
             info->online = true;
-            info->last_seen = time(NULL);
+            info->last_seen = vclock_time();
             return PS5_DETECT_OK;
         }
     }
     
     // Step 2: Try ARP table
-    if (check_arp_table(info) == PS5_DETECT_OK) {
+    start_us = metrics_now_us();
+    bool found = (check_arp_table(info) == PS5_DETECT_OK);
+    record_detection(DETECT_METHOD_ARP, start_us, found);
+    
+    if (found) {
         ps5_detector_save_cache(info);
         return PS5_DETECT_OK;
     }
@@ -569,13 +622,43 @@ int ps5_detector_clear_cache(void) {
     return PS5_DETECT_OK;
 }
 
+int ps5_detector_export_cache(ps5_info_t *info, time_t *timestamp) {
+    if (!g_detector_ctx.initialized) {
+        return PS5_DETECT_ERROR_NOT_INIT;
+    }
+    
+    if (info == NULL || timestamp == NULL) {
+        return PS5_DETECT_ERROR_INVALID_PARAM;
+    }
+    
+    memcpy(info, &g_detector_ctx.cached_info, sizeof(ps5_info_t));
+    *timestamp = g_detector_ctx.cache_timestamp;
+    return PS5_DETECT_OK;
+}
+
+int ps5_detector_restore_cache(const ps5_info_t *info, time_t timestamp) {
+    if (!g_detector_ctx.initialized) {
+        return PS5_DETECT_ERROR_NOT_INIT;
+    }
+    
+    if (info == NULL) {
+        return PS5_DETECT_ERROR_INVALID_PARAM;
+    }
+    
+    memcpy(&g_detector_ctx.cached_info, info, sizeof(ps5_info_t));
+    g_detector_ctx.cached_info.ip[PS5_IP_MAX_LEN - 1] = '\0';
+    g_detector_ctx.cached_info.mac[PS5_MAC_MAX_LEN - 1] = '\0';
+    g_detector_ctx.cache_timestamp = timestamp;
+    return PS5_DETECT_OK;
+}
+
 time_t ps5_detector_get_cache_age(void) {
     struct stat st;
     if (stat(g_detector_ctx.cache_path, &st) != 0) {
         return -1;
     }
     
-    time_t now = time(NULL);
+    time_t now = vclock_time();
     return now - st.st_mtime;
 }
 
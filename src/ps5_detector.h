@@ -81,6 +81,15 @@ typedef enum {
  */
 int ps5_detector_init(const char *subnet, const char *cache_path);
 
+/**
+ * @brief Replace subnet and cache path (drops the in-memory cache)
+ * 
+ * @param subnet Network subnet (e.g., "192.168.1.0/24")
+ * @param cache_path Path to cache file
+ * @return PS5_DETECT_OK on success, negative error code on failure
+ */
+int ps5_detector_set_config(const char *subnet, const char *cache_path);
+
 /**
  * @brief Perform full network scan (slow, comprehensive)
  * 
@@ -158,6 +167,24 @@ int ps5_detector_clear_cache(void);
  */
 time_t ps5_detector_get_cache_age(void);
 
+/**
+ * @brief Copy the in-memory cache (handed to a new process on graceful upgrade)
+ * 
+ * @param info Output PS5 information
+ * @param timestamp Output cache time (0 = empty)
+ * @return PS5_DETECT_OK on success, negative error code on failure
+ */
+int ps5_detector_export_cache(ps5_info_t *info, time_t *timestamp);
+
+/**
+ * @brief Restore the in-memory cache from a previous process
+ * 
+ * @param info PS5 information
+ * @param timestamp Cache time from ps5_detector_export_cache()
+ * @return PS5_DETECT_OK on success, negative error code on failure
+ */
+int ps5_detector_restore_cache(const ps5_info_t *info, time_t timestamp);
+
 /**
  * @brief Clean up detector resources
  */
@@ -12,14 +12,16 @@
  */
 
 #include "ps5_wake.h"
+#include "metrics.h"
+#include "trace_ring.h"
+#include "vclock.h"
+#include "async_log.h"
 
 #ifndef TESTING
   #ifdef OPENWRT_BUILD
     #include <gaming-platform/platform_interface.h>
-    #include <gaming/logger.h>
   #else
     #include "../../gaming-platform/src/platform_interface.h"
-    #include "../../gaming-core/src/logger.h"
   #endif
 #endif
 
@@ -28,6 +30,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <pthread.h>
 
 /* ============================================================
  *  Constants
@@ -49,6 +52,12 @@ typedef struct {
     ps5_wake_callback_t wake_callback;
     void *callback_data;
     
+    // 背景喚醒
+    pthread_mutex_t async_mutex;
+    pthread_t async_thread;
+    bool async_started;         // async_thread 尚未 join
+    bool async_busy;            // 喚醒進行中
+    
 } ps5_wake_context_t;
 
 /* ============================================================
@@ -57,6 +66,14 @@ typedef struct {
 
 static ps5_wake_context_t g_wake_ctx = {0};
 
+#ifdef TESTING
+/** 非同步喚醒的結果由 ps5_wake_test_set_result() 提供 (重播) */
+static bool g_wake_test_deferred = false;
+
+/** 接下來失敗的喚醒命令次數 (ps5_wake_test_fail_attempts) */
+static int g_wake_test_failures = 0;
+#endif
+
 /* ============================================================
  *  Helper Functions
  * ============================================================ */
@@ -67,17 +84,21 @@ static ps5_wake_context_t g_wake_ctx = {0};
  */
 static int execute_wake_command(void) {
 #ifdef TESTING
-    // 測試模式: 模擬喚醒成功
+    // 測試模式: 模擬喚醒成功 (ps5_wake_test_fail_attempts 指定的次數除外)
+    if (g_wake_test_failures > 0) {
+        g_wake_test_failures--;
+        return -1;
+    }
     return 0;
 #else
     // ⭐ 使用 platform 接口發送喚醒命令
     int result = platform_send_ps5_wake();
     
     if (result == PLATFORM_OK) {
-        logger_info("PS5 wake command sent successfully");
+        log_info("PS5 wake command sent successfully");
         return 0;
     } else {
-        logger_error("Failed to send PS5 wake command: %d", result);
+        log_error("Failed to send PS5 wake command: %d", result);
         return -1;
     }
 #endif
@@ -90,7 +111,7 @@ static int execute_wake_command(void) {
 int ps5_wake_init(void) {
     if (g_wake_ctx.initialized) {
         #ifndef TESTING
-        logger_warning("PS5 wake controller already initialized");
+        log_warning("PS5 wake controller already initialized");
         #endif
         return 0;
     }
@@ -98,10 +119,11 @@ int ps5_wake_init(void) {
     // 初始化context
     memset(&g_wake_ctx, 0, sizeof(g_wake_ctx));
     g_wake_ctx.retry_count = 0;
+    pthread_mutex_init(&g_wake_ctx.async_mutex, NULL);
     g_wake_ctx.initialized = true;
     
     #ifndef TESTING
-    logger_info("PS5 wake controller initialized (using platform interface)");
+    log_info("PS5 wake controller initialized (using platform interface)");
     #endif
     
     return 0;
@@ -112,11 +134,17 @@ void ps5_wake_cleanup(void) {
         return;
     }
     
+    // 等待背景喚醒結束
+    if (g_wake_ctx.async_started) {
+        pthread_join(g_wake_ctx.async_thread, NULL);
+    }
+    pthread_mutex_destroy(&g_wake_ctx.async_mutex);
+    
     memset(&g_wake_ctx, 0, sizeof(g_wake_ctx));
     g_wake_ctx.initialized = false;
     
     #ifndef TESTING
-    logger_info("PS5 wake controller cleaned up");
+    log_info("PS5 wake controller cleaned up");
     #endif
 }
 
@@ -126,7 +154,7 @@ int ps5_wake_send(void) {
     }
     
     #ifndef TESTING
-    logger_info("Attempting to wake PS5...");
+    log_info("Attempting to wake PS5...");
     #endif
     
     int retry = 0;
@@ -134,15 +162,20 @@ int ps5_wake_send(void) {
     
     while (retry < WAKE_MAX_RETRIES) {
         // 執行喚醒命令
+        uint64_t start_us = metrics_now_us();
         result = execute_wake_command();
+        metrics_inc(METRIC_WAKE_ATTEMPTS,
+                    (result == 0) ? METRICS_RESULT_OK : METRICS_RESULT_ERROR);
+        trace_ring_record(TRACE_WAKE_ATTEMPT, (uint16_t)(retry + 1), (result == 0) ? 0 : 1,
+                          (uint32_t)(metrics_now_us() - start_us));
         
         if (result == 0) {
             // 喚醒成功
-            g_wake_ctx.last_wake_time = time(NULL);
+            g_wake_ctx.last_wake_time = vclock_time();
             g_wake_ctx.retry_count = 0;
             
             #ifndef TESTING
-            logger_info("PS5 wake command sent successfully");
+            log_info("PS5 wake command sent successfully");
             #endif
             
             // 觸發成功回調
@@ -158,18 +191,19 @@ int ps5_wake_send(void) {
         g_wake_ctx.retry_count = retry;
         
         #ifndef TESTING
-        logger_warning("PS5 wake attempt %d/%d failed, retrying...", 
+        log_warning("PS5 wake attempt %d/%d failed, retrying...", 
                    retry, WAKE_MAX_RETRIES);
         #endif
         
         if (retry < WAKE_MAX_RETRIES) {
-            usleep(1000000);  // 等待1秒後重試
+            metrics_inc(METRIC_WAKE_RETRIES, 0);
+            vclock_sleep_us(VCLOCK_US_PER_SEC);  // 等待1秒後重試
         }
     }
     
     // 喚醒失敗
     #ifndef TESTING
-    logger_error("Failed to wake PS5 after %d attempts", WAKE_MAX_RETRIES);
+    log_error("Failed to wake PS5 after %d attempts", WAKE_MAX_RETRIES);
     #endif
     
     // 觸發失敗回調
@@ -180,6 +214,63 @@ int ps5_wake_send(void) {
     return -1;
 }
 
+#ifndef TESTING
+/**
+ * @brief 背景喚醒執行緒
+ */
+static void* async_wake_thread(void *arg) {
+    (void)arg;
+    
+    ps5_wake_send();
+    
+    pthread_mutex_lock(&g_wake_ctx.async_mutex);
+    g_wake_ctx.async_busy = false;
+    pthread_mutex_unlock(&g_wake_ctx.async_mutex);
+    
+    return NULL;
+}
+#endif
+
+int ps5_wake_send_async(void) {
+    if (!g_wake_ctx.initialized) {
+        return -1;
+    }
+    
+#ifdef TESTING
+    if (g_wake_test_deferred) {
+        return 0;
+    }
+    
+    // 測試模式: 同步執行,結果可預期
+    return ps5_wake_send() == 0 ? 0 : -1;
+#else
+    pthread_mutex_lock(&g_wake_ctx.async_mutex);
+    
+    if (g_wake_ctx.async_busy) {
+        pthread_mutex_unlock(&g_wake_ctx.async_mutex);
+        return 1;  // 併入進行中的喚醒
+    }
+    
+    // 回收上一次已結束的執行緒
+    if (g_wake_ctx.async_started) {
+        pthread_join(g_wake_ctx.async_thread, NULL);
+        g_wake_ctx.async_started = false;
+    }
+    
+    if (pthread_create(&g_wake_ctx.async_thread, NULL, async_wake_thread, NULL) != 0) {
+        pthread_mutex_unlock(&g_wake_ctx.async_mutex);
+        log_error("Failed to create PS5 wake thread");
+        return -1;
+    }
+    
+    g_wake_ctx.async_started = true;
+    g_wake_ctx.async_busy = true;
+    pthread_mutex_unlock(&g_wake_ctx.async_mutex);
+    
+    return 0;
+#endif
+}
+
 int ps5_wake_verify(ps5_power_state_t *state) {
     if (!g_wake_ctx.initialized || state == NULL) {
         return -1;
@@ -187,11 +278,11 @@ int ps5_wake_verify(ps5_power_state_t *state) {
     
     // 等待PS5啟動
     #ifndef TESTING
-    logger_info("Waiting %d seconds to verify PS5 power state...", 
-               WAKE_VERIFY_DELAY_MS / 1000);
+    log_info("Waiting %d seconds to verify PS5 power state...", 
+            WAKE_VERIFY_DELAY_MS / 1000);
     #endif
     
-    usleep(WAKE_VERIFY_DELAY_MS * 1000);
+    vclock_sleep_us(WAKE_VERIFY_DELAY_MS * VCLOCK_US_PER_MS);
     
     // 查詢電源狀態
 #ifdef TESTING
@@ -205,22 +296,22 @@ int ps5_wake_verify(ps5_power_state_t *state) {
     switch (power) {
         case PLATFORM_PS5_ON:
             *state = PS5_POWER_ON;
-            logger_info("PS5 verified as powered ON");
+            log_info("PS5 verified as powered ON");
             return 0;
         
         case PLATFORM_PS5_STANDBY:
             *state = PS5_POWER_STANDBY;
-            logger_warning("PS5 in STANDBY mode");
+            log_warning("PS5 in STANDBY mode");
             return 0;
         
         case PLATFORM_PS5_OFF:
             *state = PS5_POWER_OFF;
-            logger_error("PS5 still OFF after wake attempt");
+            log_error("PS5 still OFF after wake attempt");
             return -1;
         
         default:
             *state = PS5_POWER_UNKNOWN;
-            logger_error("Unable to verify PS5 power state");
+            log_error("Unable to verify PS5 power state");
             return -1;
     }
 #endif
@@ -261,4 +352,18 @@ void ps5_wake_test_reset_retry_count(void) {
     g_wake_ctx.retry_count = 0;
 }
 
+/**
+ * @brief 接下來 count 次喚醒命令失敗 (測試用)
+ */
+void ps5_wake_test_fail_attempts(int count) {
+    g_wake_test_failures = count;
+}
+
+/**
+ * @brief 延後非同步喚醒結果 (測試用)
+ */
+void ps5_wake_test_set_deferred(bool deferred) {
+    g_wake_test_deferred = deferred;
+}
+
 #endif // TESTING
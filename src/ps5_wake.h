@@ -61,6 +61,18 @@ void ps5_wake_cleanup(void);
  */
 int ps5_wake_send(void);
 
+/**
+ * @brief Send wake command to PS5 on a background thread
+ * 
+ * Returns immediately; the result is reported through the wake callback
+ * (called from the background thread). Requests made while a wake is
+ * already running are merged into it.
+ * 
+ * @return 0 if started, 1 if a wake is already in progress,
+ *         negative error code on failure
+ */
+int ps5_wake_send_async(void);
+
 /**
  * @brief Verify PS5 power state after wake
  * 
@@ -93,6 +105,35 @@ int ps5_wake_get_retry_count(void);
  */
 void ps5_wake_set_callback(ps5_wake_callback_t callback, void *user_data);
 
+#ifdef TESTING
+/* ============================================================
+ *  Test Helpers (TESTING only)
+ * ============================================================ */
+
+/**
+ * @brief Report a wake result through the wake callback
+ */
+void ps5_wake_test_set_result(bool success);
+
+/**
+ * @brief Reset the retry counter
+ */
+void ps5_wake_test_reset_retry_count(void);
+
+/**
+ * @brief Make the next count wake commands fail
+ */
+void ps5_wake_test_fail_attempts(int count);
+
+/**
+ * @brief Defer async wake results
+ * 
+ * When deferred, ps5_wake_send_async() returns without completing;
+ * the result is supplied later with ps5_wake_test_set_result() (replay).
+ */
+void ps5_wake_test_set_deferred(bool deferred);
+#endif // TESTING
+
 #ifdef __cplusplus
 }
 #endif
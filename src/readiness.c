@@ -0,0 +1,116 @@
+/**
+ * @file readiness.c
+ * @brief Readiness Implementation
+ *
+ * NOTIFY_SOCKET 是 AF_UNIX datagram socket 的路徑,以 '@' 開頭表示
+ * abstract namespace。通知只有一則 datagram,不等待回應。
+ *
+ * @version 1.0.0
+ * @date 2025-12-06
+ */
+
+#include "readiness.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* ============================================================
+ *  Static Variables
+ * ============================================================ */
+
+static int g_ready_fd = -1;
+static struct sockaddr_un g_notify_addr;
+static socklen_t g_notify_len = 0;
+static bool g_notified = false;
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static int notify_socket(const char *message) {
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ssize_t sent = sendto(fd, message, strlen(message), MSG_NOSIGNAL,
+                          (const struct sockaddr *)&g_notify_addr, g_notify_len);
+    close(fd);
+
+    return (sent == (ssize_t)strlen(message)) ? 0 : -1;
+}
+
+static int notify_fd(const char *message) {
+    size_t len = strlen(message);
+    ssize_t written;
+    do {
+        written = write(g_ready_fd, message, len);
+    } while (written < 0 && errno == EINTR);
+
+    close(g_ready_fd);
+    g_ready_fd = -1;
+
+    return (written == (ssize_t)len) ? 0 : -1;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int readiness_init(int ready_fd) {
+    const char *path = getenv(READINESS_NOTIFY_ENV);
+    size_t path_len = (path != NULL) ? strlen(path) : 0;
+
+    if (path_len > 0 && path_len < sizeof(g_notify_addr.sun_path) &&
+        (path[0] == '/' || path[0] == '@')) {
+        memset(&g_notify_addr, 0, sizeof(g_notify_addr));
+        g_notify_addr.sun_family = AF_UNIX;
+        memcpy(g_notify_addr.sun_path, path, path_len);
+        if (path[0] == '@') {
+            g_notify_addr.sun_path[0] = '\0';
+        }
+        g_notify_len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + path_len);
+    }
+    unsetenv(READINESS_NOTIFY_ENV);
+
+    if (ready_fd < 0) {
+        return 0;
+    }
+    if (fcntl(ready_fd, F_SETFD, FD_CLOEXEC) != 0) {
+        return -1;
+    }
+
+    g_ready_fd = ready_fd;
+    return 0;
+}
+
+int readiness_notify_ready(void) {
+    if (g_notified) {
+        return 0;
+    }
+    g_notified = true;
+
+    int rc = 0;
+
+    if (g_notify_len > 0) {
+        char message[64];
+        snprintf(message, sizeof(message), "READY=1\nMAINPID=%ld", (long)getpid());
+        if (notify_socket(message) != 0) {
+            rc = -1;
+        }
+    }
+
+    if (g_ready_fd >= 0 && notify_fd("READY=1\n") != 0) {
+        rc = -1;
+    }
+
+    return rc;
+}
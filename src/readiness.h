@@ -0,0 +1,64 @@
+/**
+ * @file readiness.h
+ * @brief Readiness - 通知服務管理程式 daemon 已開始服務
+ *
+ * 此模組提供:
+ * - sd_notify 相容通知: NOTIFY_SOCKET 環境變數存在時送出 "READY=1"
+ * - ready fd: 啟動腳本傳入的 pipe,開始服務時寫入 "READY=1\n" 後關閉
+ *   (procd 沒有 readiness 協定,init 腳本可以讀取此 pipe 等待)
+ *
+ * 兩種方式都只通知一次;沒有設定時不做任何事。
+ *
+ * 使用範例:
+ * @code
+ * readiness_init(ready_fd);       // 解析參數後
+ * ...
+ * readiness_notify_ready();       // listen socket 開始 accept 後
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-06
+ * @version 1.0.0
+ */
+
+#ifndef READINESS_H
+#define READINESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** sd_notify socket 路徑的環境變數 */
+#define READINESS_NOTIFY_ENV        "NOTIFY_SOCKET"
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 設定通知目標
+ *
+ * 讀取後清除 READINESS_NOTIFY_ENV,之後啟動的程序 (升級) 不會重複通知。
+ * ready_fd 設定 close-on-exec。
+ *
+ * @param ready_fd 寫入 "READY=1\n" 的 fd (-1 = 不使用)
+ * @return 0 成功, -1 ready_fd 無效 (不使用)
+ */
+int readiness_init(int ready_fd);
+
+/**
+ * @brief 通知已開始服務 (只有第一次呼叫有效)
+ *
+ * @return 0 成功或沒有設定通知目標, -1 任一通知失敗
+ */
+int readiness_notify_ready(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* READINESS_H */
@@ -0,0 +1,340 @@
+/**
+ * @file server_config.c
+ * @brief Server Config Implementation
+ *
+ * 目前快照以 __atomic 指標發佈 (release/acquire),讀取端看到的
+ * 快照內容一定完整。發佈者以 mutex 串接,被取代的快照串在
+ * retired 清單,cleanup 時才釋放,因此讀取端不需要參考計數。
+ *
+ * TESTING 版本沒有 libuci,server_config_load_uci() 一律回傳 -1。
+ *
+ * @version 1.0.0
+ * @date 2025-12-03
+ */
+
+#include "server_config.h"
+#include "vclock.h"
+
+#ifndef TESTING
+#include <uci.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct config_node {
+    server_config_snapshot_t snap;  // 必須為第一個成員
+    struct config_node *retired;    // 下一個被取代的快照
+} config_node_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    config_node_t *current;         // 以 __atomic 讀寫
+    config_node_t *retired;         // 被取代的快照 (cleanup 時釋放)
+    uint64_t generation;
+} server_config_context_t;
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+static server_config_context_t g_config_ctx = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .current = NULL,
+    .retired = NULL,
+    .generation = 0,
+};
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+/**
+ * @brief 建立並發佈快照 (呼叫時持有 mutex)
+ */
+static uint64_t publish_locked(const server_config_t *config) {
+    config_node_t *node = calloc(1, sizeof(*node));
+    if (node == NULL) {
+        return 0;
+    }
+
+    node->snap.generation = ++g_config_ctx.generation;
+    node->snap.published_time = vclock_time();
+    node->snap.config = *config;
+
+    config_node_t *old = g_config_ctx.current;
+    __atomic_store_n(&g_config_ctx.current, node, __ATOMIC_RELEASE);
+
+    if (old != NULL) {
+        old->retired = g_config_ctx.retired;
+        g_config_ctx.retired = old;
+    }
+
+    return node->snap.generation;
+}
+
+#ifndef TESTING
+/**
+ * @brief 解析整數選項 (未設定時不變)
+ * @return 0 成功, -1 無效
+ */
+static int parse_int_option(const char *value, int min, int max, int *out) {
+    if (value == NULL) {
+        return 0;
+    }
+
+    char *end = NULL;
+    long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || parsed < min || parsed > max) {
+        return -1;
+    }
+
+    *out = (int)parsed;
+    return 0;
+}
+
+/**
+ * @brief 複製字串選項 (未設定時不變)
+ * @return 0 成功, -1 超過長度
+ */
+static int copy_string_option(const char *value, char *dst, size_t size) {
+    if (value == NULL) {
+        return 0;
+    }
+
+    if (strlen(value) >= size) {
+        return -1;
+    }
+
+    memcpy(dst, value, strlen(value) + 1);
+    return 0;
+}
+
+/**
+ * @brief 找出第一個 SERVER_CONFIG_UCI_SECTION 類型的 section
+ */
+static struct uci_section* find_server_section(struct uci_package *package) {
+    struct uci_element *e;
+
+    uci_foreach_element(&package->sections, e) {
+        struct uci_section *s = uci_to_section(e);
+        if (strcmp(s->type, SERVER_CONFIG_UCI_SECTION) == 0) {
+            return s;
+        }
+    }
+
+    return NULL;
+}
+#endif
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int server_config_init(const server_config_t *config) {
+    if (config == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_config_ctx.mutex);
+
+    int rc = -1;
+    if (g_config_ctx.current == NULL && publish_locked(config) != 0) {
+        rc = 0;
+    }
+
+    pthread_mutex_unlock(&g_config_ctx.mutex);
+    return rc;
+}
+
+void server_config_cleanup(void) {
+    pthread_mutex_lock(&g_config_ctx.mutex);
+
+    config_node_t *node = g_config_ctx.retired;
+    while (node != NULL) {
+        config_node_t *next = node->retired;
+        free(node);
+        node = next;
+    }
+
+    free(g_config_ctx.current);
+    __atomic_store_n(&g_config_ctx.current, NULL, __ATOMIC_RELEASE);
+    g_config_ctx.retired = NULL;
+    g_config_ctx.generation = 0;
+
+    pthread_mutex_unlock(&g_config_ctx.mutex);
+}
+
+const server_config_snapshot_t* server_config_current(void) {
+    config_node_t *node = __atomic_load_n(&g_config_ctx.current, __ATOMIC_ACQUIRE);
+    return (node != NULL) ? &node->snap : NULL;
+}
+
+uint64_t server_config_publish(const server_config_t *config) {
+    if (config == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_config_ctx.mutex);
+
+    uint64_t generation = 0;
+    if (g_config_ctx.current != NULL) {
+        generation = publish_locked(config);
+    }
+
+    pthread_mutex_unlock(&g_config_ctx.mutex);
+    return generation;
+}
+
+int server_config_load_uci(const char *package, server_config_t *config) {
+    if (package == NULL || config == NULL) {
+        return -1;
+    }
+
+#ifdef TESTING
+    return -1;
+#else
+    struct uci_context *uci = uci_alloc_context();
+    if (uci == NULL) {
+        return -1;
+    }
+
+    struct uci_package *pkg = NULL;
+    if (uci_load(uci, package, &pkg) != UCI_OK || pkg == NULL) {
+        uci_free_context(uci);
+        return -1;
+    }
+
+    int rc = -1;
+    struct uci_section *s = find_server_section(pkg);
+
+    if (s != NULL) {
+        // 先寫入副本,全部有效才套用
+        server_config_t loaded = *config;
+        bool valid =
+            parse_int_option(uci_lookup_option_string(uci, s, "port"),
+                             1, 65535, &loaded.ws_port) == 0 &&
+            parse_int_option(uci_lookup_option_string(uci, s, "workers"),
+                             1, INT_MAX, &loaded.ws_workers) == 0 &&
+            copy_string_option(uci_lookup_option_string(uci, s, "subnet"),
+                               loaded.ps5_subnet, sizeof(loaded.ps5_subnet)) == 0 &&
+            copy_string_option(uci_lookup_option_string(uci, s, "cache_path"),
+                               loaded.cache_path, sizeof(loaded.cache_path)) == 0 &&
+            copy_string_option(uci_lookup_option_string(uci, s, "rate_limits"),
+                               loaded.rate_limits, sizeof(loaded.rate_limits)) == 0 &&
+            copy_string_option(uci_lookup_option_string(uci, s, "local_path"),
+                               loaded.local_path, sizeof(loaded.local_path)) == 0 &&
+            parse_int_option(uci_lookup_option_string(uci, s, "cec_poll_interval"),
+                             SERVER_CONFIG_MIN_CEC_POLL_MS, INT_MAX, &loaded.cec_poll_ms) == 0 &&
+            parse_int_option(uci_lookup_option_string(uci, s, "network_refresh_interval"),
+                             1, INT_MAX, &loaded.network_refresh_s) == 0 &&
+            copy_string_option(uci_lookup_option_string(uci, s, "state_path"),
+                               loaded.state_path, sizeof(loaded.state_path)) == 0;
+
+        if (valid) {
+            *config = loaded;
+            rc = 0;
+        } else {
+            rc = -2;
+        }
+    }
+
+    uci_unload(uci, pkg);
+    uci_free_context(uci);
+    return rc;
+#endif
+}
+
+int server_config_validate(const server_config_t *config) {
+    if (config == NULL ||
+        config->ws_port < 1 || config->ws_port > 65535 ||
+        config->ps5_subnet[0] == '\0' ||
+        config->cache_path[0] == '\0' ||
+        config->cec_poll_ms < SERVER_CONFIG_MIN_CEC_POLL_MS ||
+        config->network_refresh_s < 1) {
+        return -1;
+    }
+    return 0;
+}
+
+uint32_t server_config_diff(const server_config_t *a, const server_config_t *b) {
+    uint32_t changed = 0;
+
+    if (a->ws_port != b->ws_port) {
+        changed |= SERVER_CONFIG_PORT;
+    }
+    if (a->ws_workers != b->ws_workers) {
+        changed |= SERVER_CONFIG_WORKERS;
+    }
+    if (strcmp(a->ps5_subnet, b->ps5_subnet) != 0) {
+        changed |= SERVER_CONFIG_SUBNET;
+    }
+    if (strcmp(a->cache_path, b->cache_path) != 0) {
+        changed |= SERVER_CONFIG_CACHE_PATH;
+    }
+    if (strcmp(a->rate_limits, b->rate_limits) != 0) {
+        changed |= SERVER_CONFIG_RATE_LIMITS;
+    }
+    if (strcmp(a->local_path, b->local_path) != 0) {
+        changed |= SERVER_CONFIG_LOCAL_PATH;
+    }
+    if (strcmp(a->trace_path, b->trace_path) != 0) {
+        changed |= SERVER_CONFIG_TRACE_PATH;
+    }
+    if (strcmp(a->journal_path, b->journal_path) != 0) {
+        changed |= SERVER_CONFIG_JOURNAL_PATH;
+    }
+    if (a->cec_poll_ms != b->cec_poll_ms) {
+        changed |= SERVER_CONFIG_CEC_POLL;
+    }
+    if (a->network_refresh_s != b->network_refresh_s) {
+        changed |= SERVER_CONFIG_NETWORK_REFRESH;
+    }
+    if (strcmp(a->state_path, b->state_path) != 0) {
+        changed |= SERVER_CONFIG_STATE_PATH;
+    }
+
+    return changed;
+}
+
+void server_config_overlay(server_config_t *dst, const server_config_t *src, uint32_t mask) {
+    if (mask & SERVER_CONFIG_PORT) {
+        dst->ws_port = src->ws_port;
+    }
+    if (mask & SERVER_CONFIG_WORKERS) {
+        dst->ws_workers = src->ws_workers;
+    }
+    if (mask & SERVER_CONFIG_SUBNET) {
+        memcpy(dst->ps5_subnet, src->ps5_subnet, sizeof(dst->ps5_subnet));
+    }
+    if (mask & SERVER_CONFIG_CACHE_PATH) {
+        memcpy(dst->cache_path, src->cache_path, sizeof(dst->cache_path));
+    }
+    if (mask & SERVER_CONFIG_RATE_LIMITS) {
+        memcpy(dst->rate_limits, src->rate_limits, sizeof(dst->rate_limits));
+    }
+    if (mask & SERVER_CONFIG_LOCAL_PATH) {
+        memcpy(dst->local_path, src->local_path, sizeof(dst->local_path));
+    }
+    if (mask & SERVER_CONFIG_TRACE_PATH) {
+        memcpy(dst->trace_path, src->trace_path, sizeof(dst->trace_path));
+    }
+    if (mask & SERVER_CONFIG_JOURNAL_PATH) {
+        memcpy(dst->journal_path, src->journal_path, sizeof(dst->journal_path));
+    }
+    if (mask & SERVER_CONFIG_CEC_POLL) {
+        dst->cec_poll_ms = src->cec_poll_ms;
+    }
+    if (mask & SERVER_CONFIG_NETWORK_REFRESH) {
+        dst->network_refresh_s = src->network_refresh_s;
+    }
+    if (mask & SERVER_CONFIG_STATE_PATH) {
+        memcpy(dst->state_path, src->state_path, sizeof(dst->state_path));
+    }
+}
@@ -0,0 +1,156 @@
+/**
+ * @file server_config.h
+ * @brief Server Config - 不可變的配置快照與 UCI 載入
+ *
+ * 此模組提供:
+ * - 從 /etc/config/gaming-server (libuci) 載入配置
+ * - 以不可變快照發佈配置,讀取端以單一 atomic 載入取得目前快照 (不加鎖)
+ * - 比較兩份配置,回傳改變的欄位 (SIGHUP 重新載入時只套用有變動的部分)
+ *
+ * 被取代的快照保留到 server_config_cleanup(),讀取端取得的指標在
+ * 程序結束前都有效,不需要釋放。配置只在啟動與 SIGHUP 時發佈,
+ * 保留的記憶體與重新載入次數成正比。
+ *
+ * UCI 格式 (未設定的選項使用預設值):
+ * @code
+ * config server 'main'
+ *     option port '8080'
+ *     option subnet '192.168.1.0/24'
+ *     option cache_path '/var/run/gaming/ps5_cache.json'
+ *     option rate_limits 'wake_ps5=1/3,query_ps5=10'
+ *     option cec_poll_interval '5000'
+ *     option network_refresh_interval '10'
+ *     option state_path '/var/run/gaming-server.state'
+ * @endcode
+ *
+ * 使用範例:
+ * @code
+ * const server_config_snapshot_t *snap = server_config_current();
+ * vclock_schedule(snap->config.network_refresh_s * VCLOCK_US_PER_SEC, fn, NULL);
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-03
+ * @version 1.0.0
+ */
+
+#ifndef SERVER_CONFIG_H
+#define SERVER_CONFIG_H
+
+#include <stdint.h>
+#include <time.h>
+#include "server_state_machine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** UCI package 名稱 (/etc/config/gaming-server) */
+#define SERVER_CONFIG_UCI_PACKAGE       "gaming-server"
+
+/** UCI section 類型 (使用第一個此類型的 section) */
+#define SERVER_CONFIG_UCI_SECTION       "server"
+
+/** 配置欄位 (server_config_diff 的回傳值與 server_config_overlay 的 mask) */
+#define SERVER_CONFIG_PORT              (1u << 0)
+#define SERVER_CONFIG_WORKERS           (1u << 1)
+#define SERVER_CONFIG_SUBNET            (1u << 2)
+#define SERVER_CONFIG_CACHE_PATH        (1u << 3)
+#define SERVER_CONFIG_RATE_LIMITS       (1u << 4)
+#define SERVER_CONFIG_LOCAL_PATH        (1u << 5)
+#define SERVER_CONFIG_TRACE_PATH        (1u << 6)
+#define SERVER_CONFIG_JOURNAL_PATH      (1u << 7)
+#define SERVER_CONFIG_CEC_POLL          (1u << 8)
+#define SERVER_CONFIG_NETWORK_REFRESH   (1u << 9)
+#define SERVER_CONFIG_STATE_PATH        (1u << 10)
+
+/** 執行中可套用的欄位 (其他欄位需要重新啟動) */
+#define SERVER_CONFIG_RELOADABLE        (SERVER_CONFIG_PORT | SERVER_CONFIG_SUBNET | \
+                                         SERVER_CONFIG_CACHE_PATH | SERVER_CONFIG_RATE_LIMITS | \
+                                         SERVER_CONFIG_CEC_POLL | SERVER_CONFIG_NETWORK_REFRESH | \
+                                         SERVER_CONFIG_STATE_PATH)
+
+/** 輪詢間隔下限 */
+#define SERVER_CONFIG_MIN_CEC_POLL_MS   100
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 配置快照 (發佈後不可修改)
+ */
+typedef struct {
+    uint64_t generation;            /**< 發佈序號 (1 = 啟動時的配置) */
+    time_t published_time;          /**< 發佈時間 */
+    server_config_t config;
+} server_config_snapshot_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 發佈第一份配置
+ *
+ * @return 0 成功, -1 已初始化或記憶體不足
+ */
+int server_config_init(const server_config_t *config);
+
+/**
+ * @brief 釋放所有快照 (之後不可再使用取得的指標)
+ */
+void server_config_cleanup(void);
+
+/**
+ * @brief 取得目前快照 (任何執行緒,不加鎖)
+ *
+ * @return 快照, NULL 表示未初始化
+ */
+const server_config_snapshot_t* server_config_current(void);
+
+/**
+ * @brief 發佈新配置 (取代目前快照)
+ *
+ * @return 新的 generation, 0 表示未初始化或記憶體不足
+ */
+uint64_t server_config_publish(const server_config_t *config);
+
+/**
+ * @brief 從 UCI 載入配置,覆蓋 config 中有設定的選項
+ *
+ * 任何選項無效時 config 不變。
+ *
+ * @param package UCI package 名稱 (通常為 SERVER_CONFIG_UCI_PACKAGE)
+ * @return 0 成功, -1 沒有 package 或 section (config 不變), -2 選項無效
+ */
+int server_config_load_uci(const char *package, server_config_t *config);
+
+/**
+ * @brief 檢查配置值
+ *
+ * @return 0 有效, -1 無效
+ */
+int server_config_validate(const server_config_t *config);
+
+/**
+ * @brief 比較兩份配置
+ *
+ * @return 不同的欄位 (SERVER_CONFIG_* 的組合), 0 表示相同
+ */
+uint32_t server_config_diff(const server_config_t *a, const server_config_t *b);
+
+/**
+ * @brief 將 src 中 mask 指定的欄位複製到 dst
+ */
+void server_config_overlay(server_config_t *dst, const server_config_t *src, uint32_t mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERVER_CONFIG_H */
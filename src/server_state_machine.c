@@ -7,29 +7,102 @@
  * 2. ⭐ 使用 platform_set_led_state() 接口
  * 3. LED狀態映射到platform定義的狀態
  * 
- * @version 2.0.0
- * @date 2024-11-17
+ * 事件驅動 (2.1.0):
+ * - SERVER_SM_TRANSITIONS 是唯一的轉換定義,編譯期展開成轉換表
+ * - 事件先更新 context 欄位 (apply_event),再查 (狀態, 事件) 對應的列,
+ *   依序檢查 guard,第一個成立者執行 action 並轉換
+ * - (狀態, 事件) → 第一列的索引在第一次建立 context 時由轉換表算出,
+ *   每個事件的查表為 O(1)
+ * 
+ * LED (2.2.0):
+ * - 轉換只把目標 LED 狀態交給 led_actuator,不等待 platform LED I/O
+ * - 相同狀態略過,兩次輸出至少間隔 SM_LED_MIN_DWELL_MS (快速來回只顯示最後狀態)
+ * 
+ * @version 2.2.0
+ * @date 2025-11-30
  */
 
 #include "server_state_machine.h"
+#include "metrics.h"
+#include "trace_ring.h"
+#include "led_actuator.h"
+#include "async_log.h"
 
 #ifndef TESTING
   #ifdef OPENWRT_BUILD
     #include <gaming-platform/platform_interface.h>
-    #include <gaming/logger.h>
   #else
     #include "../../gaming-platform/src/platform_interface.h"
-    #include "../../gaming-core/src/logger.h"
   #endif
 #endif
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* ============================================================
+ *  Transition Table
+ * ============================================================ */
+
+/*
+ * 轉換定義: X(目前狀態, 事件, guard, action, 下一狀態)
+ *
+ * - guard/action 對應 guard_xxx()/action_xxx(),always/none 表示無條件/無動作
+ * - 同一個 (狀態, 事件) 的列必須相鄰,依序檢查 guard
+ * - 沒有對應列的事件只更新 context 欄位
+ * - RESET 事件在查表前已把狀態設回 INIT
+ */
+#define SERVER_SM_TRANSITIONS(X) \
+    X(INIT,             START,               has_clients,         none,       CLIENT_CONNECTED) \
+    X(INIT,             START,               always,              none,       MONITORING)       \
+    X(INIT,             RESET,               always,              none,       MONITORING)       \
+    X(MONITORING,       POWER_CHANGED,       ps5_on,              none,       PS5_DETECTED)     \
+    X(MONITORING,       CLIENT_CONNECTED,    always,              none,       CLIENT_CONNECTED) \
+    X(MONITORING,       WAKE_COMPLETED,      too_many_errors,     none,       ERROR)            \
+    X(MONITORING,       ERROR,               too_many_errors,     none,       ERROR)            \
+    X(PS5_DETECTED,     POWER_CHANGED,       ps5_off_has_clients, none,       CLIENT_CONNECTED) \
+    X(PS5_DETECTED,     POWER_CHANGED,       ps5_off,             none,       MONITORING)       \
+    X(PS5_DETECTED,     CLIENT_CONNECTED,    always,              none,       CLIENT_CONNECTED) \
+    X(CLIENT_CONNECTED, WAKE_REQUESTED,      ps5_off,             none,       WAKING_PS5)       \
+    X(CLIENT_CONNECTED, CLIENT_DISCONNECTED, no_clients_ps5_on,   none,       PS5_DETECTED)     \
+    X(CLIENT_CONNECTED, CLIENT_DISCONNECTED, no_clients,          none,       MONITORING)       \
+    X(WAKING_PS5,       WAKE_COMPLETED,      wake_failed_too_often, clear_wake, ERROR)          \
+    X(WAKING_PS5,       WAKE_COMPLETED,      has_clients,         clear_wake, CLIENT_CONNECTED) \
+    X(WAKING_PS5,       WAKE_COMPLETED,      ps5_on,              clear_wake, PS5_DETECTED)     \
+    X(WAKING_PS5,       WAKE_COMPLETED,      always,              clear_wake, MONITORING)       \
+    X(WAKING_PS5,       ERROR,               wake_failed_too_often, clear_wake, ERROR)
+
+/** MONITORING 允許的錯誤次數 */
+#define SM_MAX_MONITOR_ERRORS   5
+
+/** WAKING_PS5 允許的錯誤次數 */
+#define SM_MAX_WAKE_ERRORS      3
+
+/** LED 兩次輸出的最小間隔 (毫秒) */
+#define SM_LED_MIN_DWELL_MS     250
+
+typedef bool (*sm_guard_fn)(const server_context_t *ctx);
+typedef void (*sm_action_fn)(server_context_t *ctx);
+
+/**
+ * @brief 轉換表的一列
+ */
+typedef struct {
+    server_state_t from;
+    server_event_t event;
+    sm_guard_fn guard;
+    sm_action_fn action;
+    server_state_t to;
+    const char *guard_name;
+    const char *action_name;
+} sm_transition_t;
 
 /* ============================================================
  *  Helper Functions
  * ============================================================ */
 
+#ifndef TESTING
 /**
  * @brief Server狀態轉換為Platform LED狀態
  */
@@ -58,33 +131,332 @@ static platform_led_state_t map_server_state_to_led(server_state_t state) {
     }
 }
 
+/** led_actuator 未啟動時直接輸出 */
+static bool g_led_async = false;
+
+/** server_sm_enable_led() 之前 platform 尚未初始化,不輸出 LED */
+static bool g_led_enabled = false;
+
 /**
- * @brief 更新LED顯示
+ * @brief 實際輸出LED (led_actuator 背景執行緒)
+ */
+static void apply_platform_led(int led_state) {
+    // ⭐ 使用 platform 接口設定LED
+    platform_set_led_state((platform_led_state_t)led_state);
+}
+#endif
+
+/**
+ * @brief 更新LED顯示 (不等待 I/O)
  */
 static void update_led_for_state(server_state_t state) {
 #ifdef TESTING
     // 測試模式: 不實際控制LED
     (void)state;
 #else
-    // ⭐ 使用 platform 接口設定LED
+    if (!__atomic_load_n(&g_led_enabled, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    
     platform_led_state_t led_state = map_server_state_to_led(state);
-    platform_set_led_state(led_state);
+    if (g_led_async) {
+        led_actuator_set((int)led_state);
+    } else {
+        apply_platform_led((int)led_state);
+    }
 #endif
 }
 
+/* ---- Guards ---- */
+
+static bool guard_always(const server_context_t *ctx) {
+    (void)ctx;
+    return true;
+}
+
+static bool guard_ps5_on(const server_context_t *ctx) {
+    return ctx->ps5_power == PS5_POWER_ON;
+}
+
+static bool guard_ps5_off(const server_context_t *ctx) {
+    return ctx->ps5_power != PS5_POWER_ON;
+}
+
+static bool guard_has_clients(const server_context_t *ctx) {
+    return __atomic_load_n(&ctx->client_count, __ATOMIC_RELAXED) > 0;
+}
+
+static bool guard_no_clients(const server_context_t *ctx) {
+    return __atomic_load_n(&ctx->client_count, __ATOMIC_RELAXED) == 0;
+}
+
+static bool guard_ps5_off_has_clients(const server_context_t *ctx) {
+    return guard_ps5_off(ctx) && guard_has_clients(ctx);
+}
+
+static bool guard_no_clients_ps5_on(const server_context_t *ctx) {
+    return guard_no_clients(ctx) && guard_ps5_on(ctx);
+}
+
+static bool guard_too_many_errors(const server_context_t *ctx) {
+    return ctx->error_count > SM_MAX_MONITOR_ERRORS;
+}
+
+static bool guard_wake_failed_too_often(const server_context_t *ctx) {
+    return !ctx->wake_completed && ctx->error_count > SM_MAX_WAKE_ERRORS;
+}
+
+/* ---- Actions ---- */
+
+static void action_none(server_context_t *ctx) {
+    (void)ctx;
+}
+
+static void action_clear_wake(server_context_t *ctx) {
+    ctx->wake_completed = false;
+    ctx->wake_requested = false;
+}
+
+/* ---- Table ---- */
+
+#define SM_TRANSITION_ROW(from, event, guard, action, to)               \
+    { SERVER_STATE_##from, SERVER_EVENT_##event, guard_##guard,         \
+      action_##action, SERVER_STATE_##to, #guard, #action },
+
+static const sm_transition_t k_transitions[] = {
+    SERVER_SM_TRANSITIONS(SM_TRANSITION_ROW)
+};
+
+#undef SM_TRANSITION_ROW
+
+#define SM_TRANSITION_COUNT ((int)(sizeof(k_transitions) / sizeof(k_transitions[0])))
+
+/** (狀態, 事件) → 第一列索引, -1 表示沒有轉換 */
+static int8_t g_first_transition[SERVER_STATE_COUNT][SERVER_EVENT_COUNT];
+static pthread_once_t g_index_once = PTHREAD_ONCE_INIT;
+
+static const char *const k_event_names[SERVER_EVENT_COUNT] = {
+#define SERVER_SM_EVENT_NAME(name) #name,
+    SERVER_SM_EVENTS(SERVER_SM_EVENT_NAME)
+#undef SERVER_SM_EVENT_NAME
+};
+
+static void build_transition_index(void) {
+    memset(g_first_transition, -1, sizeof(g_first_transition));
+    for (int i = SM_TRANSITION_COUNT - 1; i >= 0; i--) {
+        g_first_transition[k_transitions[i].from][k_transitions[i].event] = (int8_t)i;
+    }
+}
+
 /**
- * @brief 狀態轉換為字串
+ * @brief 記錄一次狀態改變: 累計舊狀態停留時間並寫入歷史
  */
-static const char* state_to_string(server_state_t state) {
-    switch (state) {
-        case SERVER_STATE_INIT:              return "INIT";
-        case SERVER_STATE_MONITORING:        return "MONITORING";
-        case SERVER_STATE_PS5_DETECTED:      return "PS5_DETECTED";
-        case SERVER_STATE_CLIENT_CONNECTED:  return "CLIENT_CONNECTED";
-        case SERVER_STATE_WAKING_PS5:        return "WAKING_PS5";
-        case SERVER_STATE_ERROR:             return "ERROR";
-        default:                             return "UNKNOWN";
+static void record_state_change(server_context_t *ctx, server_state_t from,
+                                server_state_t to, server_event_t event)
+{
+    uint64_t now = metrics_now_us();
+    
+    pthread_mutex_lock(&ctx->history_lock);
+    
+    uint64_t stayed = now - ctx->state_entered_us;
+    if ((unsigned)from < SERVER_STATE_COUNT) {
+        ctx->time_in_state_us[from] += stayed;
     }
+    ctx->state_entered_us = now;
+    
+    server_sm_history_entry_t *entry = &ctx->history[ctx->history_total % SERVER_SM_HISTORY_SIZE];
+    entry->time_us = now;
+    entry->from = from;
+    entry->to = to;
+    entry->event = event;
+    ctx->history_total++;
+    
+    pthread_mutex_unlock(&ctx->history_lock);
+    
+    metrics_add(METRIC_STATE_SECONDS, (int)from, stayed);
+    if (from == SERVER_STATE_WAKING_PS5) {
+        metrics_observe(METRIC_WAKING_SECONDS, 0, stayed);
+    }
+}
+
+/**
+ * @brief 依事件更新 context 欄位 (與目前狀態無關)
+ */
+static void apply_event(server_context_t *ctx, const server_sm_event_t *ev) {
+    switch (ev->event) {
+        case SERVER_EVENT_RESET:
+            if (ctx->current_state != SERVER_STATE_INIT) {
+                record_state_change(ctx, ctx->current_state, SERVER_STATE_INIT, ev->event);
+            }
+            __atomic_store_n(&ctx->current_state, SERVER_STATE_INIT, __ATOMIC_RELEASE);
+            ctx->last_state = SERVER_STATE_INIT;
+            ctx->error_count = 0;
+            ctx->ps5_power = PS5_POWER_UNKNOWN;
+            ctx->ps5_network = PS5_NET_UNKNOWN;
+            ctx->wake_requested = false;
+            ctx->wake_completed = false;
+            update_led_for_state(SERVER_STATE_INIT);
+            #ifndef TESTING
+            log_info("Server state machine reset");
+            #endif
+            break;
+        
+        case SERVER_EVENT_POWER_CHANGED:
+            ctx->ps5_power = (ps5_power_state_t)ev->arg;
+            #ifndef TESTING
+            log_info("PS5 power state changed: %s", ps5_power_state_to_string(ctx->ps5_power));
+            #endif
+            break;
+        
+        case SERVER_EVENT_NETWORK_CHANGED:
+            ctx->ps5_network = (ps5_network_status_t)ev->arg;
+            #ifndef TESTING
+            log_info("PS5 network status changed: %s",
+                    ps5_network_status_to_string(ctx->ps5_network));
+            #endif
+            break;
+        
+        // client_count 已在 server_sm_post() 更新
+        case SERVER_EVENT_CLIENT_CONNECTED:
+            #ifndef TESTING
+            log_info("Client %d connected (total: %d)", ev->arg,
+                    __atomic_load_n(&ctx->client_count, __ATOMIC_RELAXED));
+            #endif
+            break;
+        
+        case SERVER_EVENT_CLIENT_DISCONNECTED:
+            #ifndef TESTING
+            log_info("Client %d disconnected (remaining: %d)", ev->arg,
+                    __atomic_load_n(&ctx->client_count, __ATOMIC_RELAXED));
+            #endif
+            break;
+        
+        case SERVER_EVENT_WAKE_REQUESTED:
+            ctx->wake_requested = true;
+            #ifndef TESTING
+            log_info("PS5 wake requested");
+            #endif
+            break;
+        
+        case SERVER_EVENT_WAKE_COMPLETED:
+            ctx->wake_completed = (ev->arg != 0);
+            if (!ctx->wake_completed) {
+                ctx->error_count++;
+            }
+            #ifndef TESTING
+            log_info("PS5 wake completed: %s", ctx->wake_completed ? "success" : "failed");
+            #endif
+            break;
+        
+        case SERVER_EVENT_ERROR:
+            ctx->error_count++;
+            #ifndef TESTING
+            log_error("Error occurred (count: %d)", ctx->error_count);
+            #endif
+            break;
+        
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 送出時立即套用的計數 (呼叫者持有 queue_lock)
+ * 
+ * 佇列滿時事件會被丟棄;若連線數也在處理時才更新,丟掉一個
+ * CLIENT_DISCONNECTED 就會讓 client_count 永遠多 1,狀態機停在
+ * CLIENT_CONNECTED。計數在入佇列前更新,被丟棄的客戶端事件則在
+ * 佇列清空後補送一次 (見 drain_queue()),以正確的計數查表。
+ */
+static void apply_counters(server_context_t *ctx, server_event_t event) {
+    switch (event) {
+        case SERVER_EVENT_RESET:
+            __atomic_store_n(&ctx->client_count, 0, __ATOMIC_RELAXED);
+            break;
+        
+        case SERVER_EVENT_CLIENT_CONNECTED:
+            __atomic_add_fetch(&ctx->client_count, 1, __ATOMIC_RELAXED);
+            break;
+        
+        case SERVER_EVENT_CLIENT_DISCONNECTED:
+            if (ctx->client_count > 0) {
+                __atomic_sub_fetch(&ctx->client_count, 1, __ATOMIC_RELAXED);
+            }
+            break;
+        
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 處理一個事件: 更新欄位後查表轉換
+ */
+static void dispatch_event(server_context_t *ctx, const server_sm_event_t *ev) {
+    apply_event(ctx, ev);
+    
+    server_state_t state = ctx->current_state;
+    if ((unsigned)state >= SERVER_STATE_COUNT) {
+        server_sm_transition(ctx, SERVER_STATE_ERROR);
+        return;
+    }
+    
+    for (int i = g_first_transition[state][ev->event];
+         i >= 0 && i < SM_TRANSITION_COUNT &&
+         k_transitions[i].from == state && k_transitions[i].event == ev->event;
+         i++)
+    {
+        const sm_transition_t *t = &k_transitions[i];
+        if (!t->guard(ctx)) {
+            continue;
+        }
+        
+        t->action(ctx);
+        if (t->to != state) {
+            server_sm_transition(ctx, t->to);
+        }
+        return;
+    }
+}
+
+/**
+ * @brief 處理佇列中的事件
+ * 
+ * 已有執行緒在處理時直接返回,事件由該執行緒依序處理
+ * (包含 on_state_enter 回調中同步送出的事件)。
+ */
+static void drain_queue(server_context_t *ctx) {
+    pthread_mutex_lock(&ctx->queue_lock);
+    
+    if (ctx->dispatching) {
+        pthread_mutex_unlock(&ctx->queue_lock);
+        return;
+    }
+    ctx->dispatching = true;
+    
+    for (;;) {
+        server_sm_event_t ev;
+        if (ctx->queue_count > 0) {
+            ev = ctx->queue[ctx->queue_head];
+            ctx->queue_head = (ctx->queue_head + 1) % SERVER_SM_QUEUE_SIZE;
+            ctx->queue_count--;
+        } else if (ctx->overflowed) {
+            // 佇列滿時丟棄的客戶端事件: 計數已套用,只需重新查表
+            ev = ctx->overflow;
+            ctx->overflowed = false;
+        } else {
+            break;
+        }
+        ctx->current_event = ev.event;
+        
+        pthread_mutex_unlock(&ctx->queue_lock);
+        dispatch_event(ctx, &ev);
+        pthread_mutex_lock(&ctx->queue_lock);
+    }
+    
+    ctx->dispatching = false;
+    ctx->current_event = SERVER_EVENT_COUNT;
+    pthread_mutex_unlock(&ctx->queue_lock);
 }
 
 /* ============================================================
@@ -96,11 +468,23 @@ server_context_t* server_sm_create(const server_config_t *config) {
         return NULL;
     }
     
+    pthread_once(&g_index_once, build_transition_index);
+    
     server_context_t *ctx = (server_context_t*)calloc(1, sizeof(server_context_t));
     if (ctx == NULL) {
         return NULL;
     }
     
+    if (pthread_mutex_init(&ctx->queue_lock, NULL) != 0) {
+        free(ctx);
+        return NULL;
+    }
+    if (pthread_mutex_init(&ctx->history_lock, NULL) != 0) {
+        pthread_mutex_destroy(&ctx->queue_lock);
+        free(ctx);
+        return NULL;
+    }
+    
     // 複製配置
     ctx->config = *config;
     
@@ -112,12 +496,11 @@ server_context_t* server_sm_create(const server_config_t *config) {
     ctx->ps5_power = PS5_POWER_UNKNOWN;
     ctx->ps5_network = PS5_NET_UNKNOWN;
     ctx->wake_requested = false;
-    
-    // 更新LED
-    update_led_for_state(ctx->current_state);
+    ctx->current_event = SERVER_EVENT_COUNT;
+    ctx->state_entered_us = metrics_now_us();
     
     #ifndef TESTING
-    logger_info("Server state machine created");
+    log_info("Server state machine created");
     #endif
     
     return ctx;
@@ -129,96 +512,89 @@ void server_sm_destroy(server_context_t *ctx) {
     }
     
     #ifndef TESTING
-    logger_info("Server state machine destroyed");
+    log_info("Server state machine destroyed");
+    #endif
+    
+    #ifndef TESTING
+    __atomic_store_n(&g_led_enabled, false, __ATOMIC_RELEASE);
+    if (g_led_async) {
+        led_actuator_cleanup();
+        g_led_async = false;
+    }
     #endif
     
+    pthread_mutex_destroy(&ctx->history_lock);
+    pthread_mutex_destroy(&ctx->queue_lock);
     free(ctx);
 }
 
-void server_sm_update(server_context_t *ctx) {
+void server_sm_enable_led(server_context_t *ctx) {
     if (ctx == NULL) {
         return;
     }
     
-    server_state_t next_state = ctx->current_state;
+    #ifndef TESTING
+    if (__atomic_load_n(&g_led_enabled, __ATOMIC_ACQUIRE)) {
+        return;
+    }
     
-    // 狀態機邏輯
-    switch (ctx->current_state) {
-        case SERVER_STATE_INIT:
-            // 初始化完成後,進入監控狀態
-            next_state = SERVER_STATE_MONITORING;
-            break;
-        
-        case SERVER_STATE_MONITORING:
-            // PS5開機 -> 檢測到PS5
-            if (ctx->ps5_power == PS5_POWER_ON) {
-                next_state = SERVER_STATE_PS5_DETECTED;
-            }
-            // 有客戶端連線 -> 客戶端已連線
-            else if (ctx->client_count > 0) {
-                next_state = SERVER_STATE_CLIENT_CONNECTED;
-            }
-            // 錯誤累積過多
-            else if (ctx->error_count > 5) {
-                next_state = SERVER_STATE_ERROR;
-            }
-            break;
-        
-        case SERVER_STATE_PS5_DETECTED:
-            // PS5關機 -> 返回監控
-            if (ctx->ps5_power != PS5_POWER_ON) {
-                next_state = SERVER_STATE_MONITORING;
-            }
-            // 有客戶端連線 -> 客戶端已連線
-            else if (ctx->client_count > 0) {
-                next_state = SERVER_STATE_CLIENT_CONNECTED;
-            }
-            break;
-        
-        case SERVER_STATE_CLIENT_CONNECTED:
-            // 收到喚醒請求 -> 喚醒PS5
-            if (ctx->wake_requested && ctx->ps5_power != PS5_POWER_ON) {
-                next_state = SERVER_STATE_WAKING_PS5;
-            }
-            // 所有客戶端斷線 -> 返回適當狀態
-            else if (ctx->client_count == 0) {
-                if (ctx->ps5_power == PS5_POWER_ON) {
-                    next_state = SERVER_STATE_PS5_DETECTED;
-                } else {
-                    next_state = SERVER_STATE_MONITORING;
-                }
-            }
-            break;
-        
-        case SERVER_STATE_WAKING_PS5:
-            // 喚醒完成 -> 返回客戶端連線狀態
-            if (ctx->wake_completed) {
-                next_state = SERVER_STATE_CLIENT_CONNECTED;
-                ctx->wake_completed = false;
-                ctx->wake_requested = false;
-            }
-            // 喚醒失敗
-            else if (ctx->error_count > 3) {
-                next_state = SERVER_STATE_ERROR;
-            }
-            break;
-        
-        case SERVER_STATE_ERROR:
-            // 錯誤恢復: 重置狀態
-            if (ctx->error_count == 0) {
-                next_state = SERVER_STATE_INIT;
-            }
-            break;
-        
-        default:
-            next_state = SERVER_STATE_ERROR;
-            break;
+    g_led_async = (led_actuator_init(apply_platform_led, SM_LED_MIN_DWELL_MS) == 0);
+    if (!g_led_async) {
+        log_warning("LED actuator unavailable, updating LED synchronously");
     }
+    __atomic_store_n(&g_led_enabled, true, __ATOMIC_RELEASE);
+    #endif
     
-    // 狀態轉換
-    if (next_state != ctx->current_state) {
-        server_sm_transition(ctx, next_state);
+    // 顯示目前狀態
+    update_led_for_state(server_sm_get_state(ctx));
+}
+
+void server_sm_start(server_context_t *ctx) {
+    server_sm_post(ctx, SERVER_EVENT_START, 0);
+}
+
+int server_sm_post(server_context_t *ctx, server_event_t event, int arg) {
+    if (ctx == NULL || (unsigned)event >= SERVER_EVENT_COUNT) {
+        return -1;
     }
+    
+    pthread_mutex_lock(&ctx->queue_lock);
+    
+    apply_counters(ctx, event);
+    
+    if (ctx->queue_count == SERVER_SM_QUEUE_SIZE) {
+        if (event == SERVER_EVENT_CLIENT_CONNECTED || event == SERVER_EVENT_CLIENT_DISCONNECTED) {
+            ctx->overflow.event = event;
+            ctx->overflow.arg = arg;
+            ctx->overflowed = true;
+            pthread_mutex_unlock(&ctx->queue_lock);
+            drain_queue(ctx);
+            return 0;
+        }
+        pthread_mutex_unlock(&ctx->queue_lock);
+        #ifndef TESTING
+        log_error("State machine queue full, dropping %s", server_event_to_string(event));
+        #endif
+        return -1;
+    }
+    
+    int tail = (ctx->queue_head + ctx->queue_count) % SERVER_SM_QUEUE_SIZE;
+    ctx->queue[tail].event = event;
+    ctx->queue[tail].arg = arg;
+    ctx->queue_count++;
+    
+    pthread_mutex_unlock(&ctx->queue_lock);
+    
+    drain_queue(ctx);
+    return 0;
+}
+
+void server_sm_update(server_context_t *ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+    
+    drain_queue(ctx);
 }
 
 void server_sm_transition(server_context_t *ctx, server_state_t new_state) {
@@ -228,17 +604,22 @@ void server_sm_transition(server_context_t *ctx, server_state_t new_state) {
     
     server_state_t old_state = ctx->current_state;
     
+    // 直接呼叫 (不在事件處理中) 時 current_event 為 SERVER_EVENT_COUNT
+    record_state_change(ctx, old_state, new_state, ctx->current_event);
+    
     // 狀態轉換邏輯
     ctx->last_state = old_state;
-    ctx->current_state = new_state;
+    __atomic_store_n(&ctx->current_state, new_state, __ATOMIC_RELEASE);
+    metrics_inc(METRIC_STATE_TRANSITIONS, (int)new_state);
+    trace_ring_record(TRACE_STATE_TRANSITION, (uint16_t)old_state, (uint32_t)new_state, 0);
     
     // ⭐ 更新LED顯示
     update_led_for_state(new_state);
     
     #ifndef TESTING
-    logger_info("State transition: %s -> %s",
-               state_to_string(old_state),
-               state_to_string(new_state));
+    log_info("State transition: %s -> %s",
+            server_state_to_string(old_state),
+            server_state_to_string(new_state));
     #endif
     
     // 觸發進入回調
@@ -251,121 +632,107 @@ server_state_t server_sm_get_state(const server_context_t *ctx) {
     if (ctx == NULL) {
         return SERVER_STATE_ERROR;
     }
-    return ctx->current_state;
+    return __atomic_load_n(&ctx->current_state, __ATOMIC_ACQUIRE);
 }
 
-void server_sm_on_ps5_power_changed(server_context_t *ctx, ps5_power_state_t power) {
-    if (ctx == NULL) {
-        return;
+int server_sm_get_history(server_context_t *ctx, server_sm_history_t *out) {
+    if (ctx == NULL || out == NULL) {
+        return -1;
     }
     
-    ctx->ps5_power = power;
+    pthread_mutex_lock(&ctx->history_lock);
     
-    #ifndef TESTING
-    logger_info("PS5 power state changed: %s", ps5_power_state_to_string(power));
-    #endif
-}
-
-void server_sm_on_ps5_network_changed(server_context_t *ctx, ps5_network_status_t status) {
-    if (ctx == NULL) {
-        return;
+    out->state = server_sm_get_state(ctx);
+    out->now_us = metrics_now_us();
+    out->state_entered_us = ctx->state_entered_us;
+    out->transitions = ctx->history_total;
+    memcpy(out->time_in_state_us, ctx->time_in_state_us, sizeof(out->time_in_state_us));
+    if ((unsigned)out->state < SERVER_STATE_COUNT) {
+        out->time_in_state_us[out->state] += out->now_us - ctx->state_entered_us;
     }
     
-    ctx->ps5_network = status;
+    // 由舊到新複製
+    uint64_t first = (ctx->history_total > SERVER_SM_HISTORY_SIZE)
+                     ? ctx->history_total - SERVER_SM_HISTORY_SIZE : 0;
+    out->count = (int)(ctx->history_total - first);
+    for (int i = 0; i < out->count; i++) {
+        out->entries[i] = ctx->history[(first + (uint64_t)i) % SERVER_SM_HISTORY_SIZE];
+    }
     
-    #ifndef TESTING
-    logger_info("PS5 network status changed: %s", 
-               ps5_network_status_to_string(status));
-    #endif
+    pthread_mutex_unlock(&ctx->history_lock);
+    return 0;
 }
 
-void server_sm_on_client_connected(server_context_t *ctx, int client_id) {
-    if (ctx == NULL) {
-        return;
+int server_sm_snapshot(const server_context_t *ctx, server_sm_snapshot_t *out) {
+    if (ctx == NULL || out == NULL) {
+        return -1;
     }
     
-    ctx->client_count++;
-    
-    #ifndef TESTING
-    logger_info("Client %d connected (total: %d)", client_id, ctx->client_count);
-    #endif
+    out->state = server_sm_get_state(ctx);
+    out->ps5_power = ctx->ps5_power;
+    out->ps5_network = ctx->ps5_network;
+    out->client_count = __atomic_load_n(&ctx->client_count, __ATOMIC_RELAXED);
+    out->error_count = ctx->error_count;
+    return 0;
 }
 
-void server_sm_on_client_disconnected(server_context_t *ctx, int client_id) {
-    if (ctx == NULL) {
-        return;
+int server_sm_restore(server_context_t *ctx, const server_sm_snapshot_t *snap) {
+    if (ctx == NULL || snap == NULL || (unsigned)snap->state >= SERVER_STATE_COUNT ||
+        server_sm_get_state(ctx) != SERVER_STATE_INIT) {
+        return -1;
     }
     
-    if (ctx->client_count > 0) {
-        ctx->client_count--;
-    }
+    ctx->ps5_power = snap->ps5_power;
+    ctx->ps5_network = snap->ps5_network;
+    __atomic_store_n(&ctx->client_count, snap->client_count, __ATOMIC_RELAXED);
+    ctx->error_count = snap->error_count;
+    ctx->wake_requested = false;
+    ctx->wake_completed = false;
+    
+    // 與 RESET 相同,直接改變狀態而不經過轉換表
+    record_state_change(ctx, SERVER_STATE_INIT, snap->state, SERVER_EVENT_COUNT);
+    ctx->last_state = SERVER_STATE_INIT;
+    __atomic_store_n(&ctx->current_state, snap->state, __ATOMIC_RELEASE);
+    update_led_for_state(snap->state);
     
     #ifndef TESTING
-    logger_info("Client %d disconnected (remaining: %d)", 
-               client_id, ctx->client_count);
+    log_info("Server state machine restored: %s (%d clients)",
+            server_state_to_string(snap->state), snap->client_count);
     #endif
+    
+    return 0;
+}
+
+void server_sm_on_ps5_power_changed(server_context_t *ctx, ps5_power_state_t power) {
+    server_sm_post(ctx, SERVER_EVENT_POWER_CHANGED, (int)power);
+}
+
+void server_sm_on_ps5_network_changed(server_context_t *ctx, ps5_network_status_t status) {
+    server_sm_post(ctx, SERVER_EVENT_NETWORK_CHANGED, (int)status);
+}
+
+void server_sm_on_client_connected(server_context_t *ctx, int client_id) {
+    server_sm_post(ctx, SERVER_EVENT_CLIENT_CONNECTED, client_id);
+}
+
+void server_sm_on_client_disconnected(server_context_t *ctx, int client_id) {
+    server_sm_post(ctx, SERVER_EVENT_CLIENT_DISCONNECTED, client_id);
 }
 
 void server_sm_on_wake_requested(server_context_t *ctx) {
-    if (ctx == NULL) {
-        return;
-    }
-    
-    ctx->wake_requested = true;
-    
-    #ifndef TESTING
-    logger_info("PS5 wake requested");
-    #endif
+    server_sm_post(ctx, SERVER_EVENT_WAKE_REQUESTED, 0);
 }
 
 void server_sm_on_wake_completed(server_context_t *ctx, bool success) {
-    if (ctx == NULL) {
-        return;
-    }
-    
-    ctx->wake_completed = success;
-    
-    if (!success) {
-        ctx->error_count++;
-    }
-    
-    #ifndef TESTING
-    logger_info("PS5 wake completed: %s", success ? "success" : "failed");
-    #endif
+    server_sm_post(ctx, SERVER_EVENT_WAKE_COMPLETED, success ? 1 : 0);
 }
 
 void server_sm_on_error(server_context_t *ctx) {
-    if (ctx == NULL) {
-        return;
-    }
-    
-    ctx->error_count++;
-    
-    #ifndef TESTING
-    logger_error("Error occurred (count: %d)", ctx->error_count);
-    #endif
+    server_sm_post(ctx, SERVER_EVENT_ERROR, 0);
 }
 
 void server_sm_reset(server_context_t *ctx) {
-    if (ctx == NULL) {
-        return;
-    }
-    
-    ctx->current_state = SERVER_STATE_INIT;
-    ctx->last_state = SERVER_STATE_INIT;
-    ctx->error_count = 0;
-    ctx->client_count = 0;
-    ctx->ps5_power = PS5_POWER_UNKNOWN;
-    ctx->ps5_network = PS5_NET_UNKNOWN;
-    ctx->wake_requested = false;
-    ctx->wake_completed = false;
-    
-    // 更新LED
-    update_led_for_state(ctx->current_state);
-    
-    #ifndef TESTING
-    logger_info("Server state machine reset");
-    #endif
+    server_sm_post(ctx, SERVER_EVENT_RESET, 0);
 }
 
 void server_sm_set_state_callback(server_context_t *ctx,
@@ -380,10 +747,58 @@ void server_sm_set_state_callback(server_context_t *ctx,
     ctx->user_data = user_data;
 }
 
+int server_sm_write_graph(FILE *fp) {
+    if (fp == NULL) {
+        return -1;
+    }
+    
+    fprintf(fp, "digraph server_sm {\n");
+    fprintf(fp, "    rankdir=LR;\n");
+    fprintf(fp, "    node [shape=box];\n");
+    
+    for (int i = 0; i < SM_TRANSITION_COUNT; i++) {
+        const sm_transition_t *t = &k_transitions[i];
+        
+        fprintf(fp, "    %s -> %s [label=\"%s",
+                server_state_to_string(t->from),
+                server_state_to_string(t->to),
+                server_event_to_string(t->event));
+        if (t->guard != guard_always) {
+            fprintf(fp, " [%s]", t->guard_name);
+        }
+        if (t->action != action_none) {
+            fprintf(fp, " / %s", t->action_name);
+        }
+        fprintf(fp, "\"];\n");
+    }
+    
+    fprintf(fp, "}\n");
+    return ferror(fp) ? -1 : 0;
+}
+
 /* ============================================================
  *  Utility Functions
  * ============================================================ */
 
+const char* server_event_to_string(server_event_t event) {
+    if ((unsigned)event >= SERVER_EVENT_COUNT) {
+        return "UNKNOWN";
+    }
+    return k_event_names[event];
+}
+
+const char* server_state_to_string(server_state_t state) {
+    switch (state) {
+        case SERVER_STATE_INIT:              return "INIT";
+        case SERVER_STATE_MONITORING:        return "MONITORING";
+        case SERVER_STATE_PS5_DETECTED:      return "PS5_DETECTED";
+        case SERVER_STATE_CLIENT_CONNECTED:  return "CLIENT_CONNECTED";
+        case SERVER_STATE_WAKING_PS5:        return "WAKING_PS5";
+        case SERVER_STATE_ERROR:             return "ERROR";
+        default:                             return "UNKNOWN";
+    }
+}
+
 const char* ps5_network_status_to_string(ps5_network_status_t status) {
     switch (status) {
         case PS5_NET_OFFLINE:   return "offline";
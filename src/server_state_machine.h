@@ -7,21 +7,45 @@
  * 2. 移除直接的 led_controller 依賴
  * 3. 保持狀態機邏輯不變
  * 
+ * 事件驅動:
+ * - 轉換由 server_state_machine.c 的轉換表 (狀態 × 事件 → guard, action, 下一狀態)
+ *   定義,編譯期產生,查表為 O(1)
+ * - 事件放入佇列後立即處理 (不等待主循環),任何執行緒皆可送出;
+ *   同一時間只有一個執行緒處理佇列,處理中送出的事件依序排在後面
+ * - server_sm_write_graph() 以 Graphviz DOT 輸出轉換表
+ * 
+ * 歷史記錄:
+ * - 最近 SERVER_SM_HISTORY_SIZE 次轉換 (時間、來源、目標、觸發事件)
+ * - 每個狀態累計停留時間,以 server_sm_get_history() 一次取得
+ * 
  * @author Gaming System Development Team
  * @date 2025-11-18
- * @version 2.0.0
+ * @version 2.1.0
  */
 
 #ifndef SERVER_STATE_MACHINE_H
 #define SERVER_STATE_MACHINE_H
 
+#include <stdio.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
 #include "cec_monitor.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 等待處理的事件上限 */
+#define SERVER_SM_QUEUE_SIZE    32
+
+/** 保留的轉換記錄筆數 */
+#define SERVER_SM_HISTORY_SIZE  32
+
 /* ============================================================
  *  Type Definitions
  * ============================================================ */
@@ -36,6 +60,7 @@ typedef enum {
     SERVER_STATE_CLIENT_CONNECTED,  /**< Client connected */
     SERVER_STATE_WAKING_PS5,        /**< Waking PS5 */
     SERVER_STATE_ERROR,             /**< Error state */
+    SERVER_STATE_COUNT
 } server_state_t;
 
 /**
@@ -47,13 +72,87 @@ typedef enum {
     PS5_NET_ONLINE,                 /**< Online */
 } ps5_network_status_t;
 
+/**
+ * @brief State machine events (X-macro, 產生 server_event_t 與事件名稱)
+ */
+#define SERVER_SM_EVENTS(X)     \
+    X(START)                    \
+    X(RESET)                    \
+    X(POWER_CHANGED)            \
+    X(NETWORK_CHANGED)          \
+    X(CLIENT_CONNECTED)         \
+    X(CLIENT_DISCONNECTED)      \
+    X(WAKE_REQUESTED)           \
+    X(WAKE_COMPLETED)           \
+    X(ERROR)
+
+/**
+ * @brief State machine events
+ */
+typedef enum {
+#define SERVER_SM_EVENT_ENUM(name) SERVER_EVENT_##name,
+    SERVER_SM_EVENTS(SERVER_SM_EVENT_ENUM)
+#undef SERVER_SM_EVENT_ENUM
+    SERVER_EVENT_COUNT
+} server_event_t;
+
+/**
+ * @brief Queued event
+ */
+typedef struct {
+    server_event_t event;           /**< Event */
+    int arg;                        /**< Power/network state, client ID or wake result */
+} server_sm_event_t;
+
+/**
+ * @brief Transition record
+ */
+typedef struct {
+    uint64_t time_us;               /**< Monotonic time (metrics_now_us) */
+    server_state_t from;            /**< Previous state */
+    server_state_t to;              /**< New state */
+    server_event_t event;           /**< Triggering event, SERVER_EVENT_COUNT = server_sm_transition() */
+} server_sm_history_entry_t;
+
+/**
+ * @brief Transition history and time-in-state snapshot
+ */
+typedef struct {
+    server_state_t state;           /**< Current state */
+    uint64_t now_us;                /**< Snapshot time */
+    uint64_t state_entered_us;      /**< When the current state was entered */
+    uint64_t transitions;           /**< Total transitions since creation */
+    uint64_t time_in_state_us[SERVER_STATE_COUNT]; /**< Including the current state up to now_us */
+    int count;                      /**< Valid entries (oldest first) */
+    server_sm_history_entry_t entries[SERVER_SM_HISTORY_SIZE];
+} server_sm_history_t;
+
+/**
+ * @brief Restorable state (handed to a new process on graceful upgrade)
+ */
+typedef struct {
+    server_state_t state;           /**< Current state */
+    ps5_power_state_t ps5_power;    /**< PS5 power state */
+    ps5_network_status_t ps5_network; /**< PS5 network status */
+    int client_count;               /**< Connected client count */
+    int error_count;                /**< Error counter */
+} server_sm_snapshot_t;
+
 /**
  * @brief Server configuration
  */
 typedef struct {
     int ws_port;                    /**< WebSocket port */
+    int ws_workers;                 /**< WebSocket worker threads (1 = single-threaded) */
     char ps5_subnet[32];            /**< PS5 subnet for detection */
     char cache_path[256];           /**< Cache file path */
+    char rate_limits[128];          /**< Message rate limit overrides ("type=rate[/burst],...") */
+    char local_path[108];           /**< Local IPC socket ("@name" = abstract, "" = disabled) */
+    char trace_path[128];           /**< Flight recorder dump file (SIGUSR1) */
+    char journal_path[128];         /**< Input journal for replay ("" = disabled) */
+    char state_path[128];           /**< Persisted runtime snapshot for warm start ("" = disabled) */
+    int cec_poll_ms;                /**< CEC power poll interval (ms) */
+    int network_refresh_s;          /**< PS5 network check interval (s) */
 } server_config_t;
 
 /**
@@ -69,7 +168,7 @@ typedef struct {
     ps5_network_status_t ps5_network; /**< PS5 network status */
     
     // Client status
-    int client_count;               /**< Connected client count */
+    int client_count;               /**< Connected client count (atomic, updated when posted) */
     
     // Flags
     bool wake_requested;            /**< Wake request pending */
@@ -79,6 +178,23 @@ typedef struct {
     // Callbacks
     void (*on_state_enter)(server_state_t state, void *user_data);
     void *user_data;
+    
+    // Event queue
+    pthread_mutex_t queue_lock;     /**< Protects queue and dispatching */
+    server_sm_event_t queue[SERVER_SM_QUEUE_SIZE];
+    int queue_head;                 /**< Next event to dispatch */
+    int queue_count;                /**< Pending events */
+    bool dispatching;               /**< A thread is draining the queue */
+    server_sm_event_t overflow;     /**< Last client event that found the queue full */
+    bool overflowed;                /**< overflow is pending */
+    server_event_t current_event;   /**< Event being dispatched (for history) */
+    
+    // History
+    pthread_mutex_t history_lock;   /**< Protects the fields below */
+    server_sm_history_entry_t history[SERVER_SM_HISTORY_SIZE];
+    uint64_t history_total;         /**< Total transitions recorded */
+    uint64_t state_entered_us;      /**< When current_state was entered */
+    uint64_t time_in_state_us[SERVER_STATE_COUNT]; /**< Completed stays only */
 } server_context_t;
 
 /**
@@ -109,7 +225,47 @@ server_context_t* server_sm_create(const server_config_t *config);
 void server_sm_destroy(server_context_t *ctx);
 
 /**
- * @brief Update state machine (call in main loop)
+ * @brief Start driving the LED (after platform_init())
+ * 
+ * The state machine runs without an LED until this is called, so it can
+ * be created while the platform is still initializing. Shows the current
+ * state immediately.
+ * 
+ * @param ctx State machine context
+ */
+void server_sm_enable_led(server_context_t *ctx);
+
+/**
+ * @brief Start state machine (INIT -> MONITORING, or CLIENT_CONNECTED
+ *        when clients connected before the start)
+ * 
+ * Call after server_sm_set_state_callback() so the MONITORING enter
+ * callback runs.
+ * 
+ * @param ctx State machine context
+ */
+void server_sm_start(server_context_t *ctx);
+
+/**
+ * @brief Post an event (dispatched immediately unless another thread is dispatching)
+ * 
+ * Client connect/disconnect and RESET update client_count before the
+ * event is queued. A client event that finds the queue full is kept
+ * (the latest one only) and dispatched once the queue drains, so the
+ * count and the state stay in step.
+ * 
+ * @param ctx State machine context
+ * @param event Event
+ * @param arg Event argument (see server_sm_event_t)
+ * @return 0 on success, -1 if the queue is full (other events are dropped)
+ */
+int server_sm_post(server_context_t *ctx, server_event_t event, int arg);
+
+/**
+ * @brief Dispatch pending events
+ * 
+ * Events are dispatched when posted; this only drains events left by a
+ * full queue race and is safe to call from the main loop.
  * 
  * @param ctx State machine context
  */
@@ -131,6 +287,37 @@ void server_sm_transition(server_context_t *ctx, server_state_t new_state);
  */
 server_state_t server_sm_get_state(const server_context_t *ctx);
 
+/**
+ * @brief Copy transition history and time-in-state counters
+ * 
+ * @param ctx State machine context
+ * @param out Output snapshot
+ * @return 0 on success, -1 on invalid argument
+ */
+int server_sm_get_history(server_context_t *ctx, server_sm_history_t *out);
+
+/**
+ * @brief Copy the restorable state
+ * 
+ * @param ctx State machine context
+ * @param out Output snapshot
+ * @return 0 on success, -1 on invalid argument
+ */
+int server_sm_snapshot(const server_context_t *ctx, server_sm_snapshot_t *out);
+
+/**
+ * @brief Continue from a snapshot instead of server_sm_start()
+ * 
+ * Only valid in INIT. The transition is recorded in the history and the
+ * LED is updated, but the state enter callback does not run (the previous
+ * process already performed its actions).
+ * 
+ * @param ctx State machine context
+ * @param snap Snapshot from server_sm_snapshot()
+ * @return 0 on success, -1 on invalid argument or not in INIT
+ */
+int server_sm_restore(server_context_t *ctx, const server_sm_snapshot_t *snap);
+
 /**
  * @brief PS5 power state changed event
  * 
@@ -203,6 +390,30 @@ void server_sm_set_state_callback(server_context_t *ctx,
                                   server_state_callback_t callback,
                                   void *user_data);
 
+/**
+ * @brief Write the transition table as a Graphviz DOT graph
+ * 
+ * @param fp Output stream
+ * @return 0 on success, -1 on write error
+ */
+int server_sm_write_graph(FILE *fp);
+
+/**
+ * @brief Convert event to string
+ * 
+ * @param event Event
+ * @return String representation
+ */
+const char* server_event_to_string(server_event_t event);
+
+/**
+ * @brief Convert server state to string
+ * 
+ * @param state Server state
+ * @return String representation
+ */
+const char* server_state_to_string(server_state_t state);
+
 /**
  * @brief Convert network status to string
  * 
@@ -0,0 +1,119 @@
+/**
+ * @file state_store.c
+ * @brief State Store Implementation
+ *
+ * 快照只有一百多 bytes,每次整份重寫。寫入後先 fsync 再 rename,
+ * rename 之後新內容才會被讀取端看到。
+ *
+ * @version 1.0.0
+ * @date 2025-12-05
+ */
+
+#include "state_store.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct {
+    char magic[8];                  // STATE_STORE_MAGIC
+    uint32_t version;               // STATE_STORE_VERSION
+    uint32_t size;                  // sizeof(state_store_record_t)
+    uint32_t crc;                   // 內容的 CRC32
+    uint32_t reserved;
+} state_store_header_t;
+
+typedef struct {
+    state_store_header_t header;
+    state_store_record_t record;
+} state_store_file_t;
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static uint32_t record_crc(const state_store_record_t *record) {
+    return (uint32_t)crc32(0L, (const Bytef *)record, sizeof(*record));
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int state_store_save(const char *path, const state_store_record_t *record) {
+    if (path == NULL || path[0] == '\0' || record == NULL) {
+        return -1;
+    }
+
+    char tmp_path[256];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        return -1;
+    }
+
+    state_store_file_t file;
+    memset(&file, 0, sizeof(file));
+    memcpy(file.header.magic, STATE_STORE_MAGIC, sizeof(file.header.magic));
+    file.header.version = STATE_STORE_VERSION;
+    file.header.size = sizeof(state_store_record_t);
+    file.record = *record;
+    file.header.crc = record_crc(&file.record);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int rc = (write(fd, &file, sizeof(file)) == (ssize_t)sizeof(file)) ? 0 : -1;
+    if (rc == 0 && fsync(fd) != 0) {
+        rc = -1;
+    }
+    if (close(fd) != 0) {
+        rc = -1;
+    }
+    if (rc == 0 && rename(tmp_path, path) != 0) {
+        rc = -1;
+    }
+    if (rc != 0) {
+        unlink(tmp_path);
+    }
+
+    return rc;
+}
+
+int state_store_load(const char *path, state_store_record_t *record) {
+    if (path == NULL || path[0] == '\0' || record == NULL) {
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    state_store_file_t file;
+    uint8_t extra;
+    ssize_t n = read(fd, &file, sizeof(file));
+    bool trailing = (n == (ssize_t)sizeof(file) && read(fd, &extra, 1) != 0);
+    close(fd);
+
+    if (n != (ssize_t)sizeof(file) || trailing ||
+        memcmp(file.header.magic, STATE_STORE_MAGIC, sizeof(file.header.magic)) != 0 ||
+        file.header.version != STATE_STORE_VERSION ||
+        file.header.size != sizeof(state_store_record_t) ||
+        file.header.crc != record_crc(&file.record)) {
+        return -1;
+    }
+
+    // 字串欄位一律以 '\0' 結尾
+    file.record.ps5_info.ip[sizeof(file.record.ps5_info.ip) - 1] = '\0';
+    file.record.ps5_info.mac[sizeof(file.record.ps5_info.mac) - 1] = '\0';
+
+    *record = file.record;
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file state_store.h
+ * @brief State Store - 執行狀態的持久化快照 (warm start)
+ *
+ * 此模組提供:
+ * - 將最後已知的執行狀態 (PS5 電源、網路、偵測快取、喚醒統計、
+ *   狀態快照版本) 寫入小型二進位檔
+ * - 啟動時讀回,作為暫定狀態 (stale) 在第一次 CEC 回報前提供給客戶端
+ *
+ * 檔案先寫入 "<path>.tmp" 再 rename,斷電時只會留下舊檔或新檔。
+ * 標頭含 CRC32,內容損壞或格式版本不同時視為沒有快照。
+ * 檔案以本機位元組順序寫入,只供同一台設備讀回。
+ *
+ * 使用範例:
+ * @code
+ * state_store_record_t record;
+ * if (state_store_load(STATE_STORE_DEFAULT_PATH, &record) == 0) {
+ *     status_snapshot_set_provisional(record.power, record.network, record.status_version);
+ * }
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-05
+ * @version 1.0.0
+ */
+
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "cec_monitor.h"
+#include "ps5_detector.h"
+#include "server_state_machine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 檔案標頭 magic */
+#define STATE_STORE_MAGIC           "GSSTATE1"
+
+/** 檔案格式版本 (state_store_record_t 改變時遞增) */
+#define STATE_STORE_VERSION         1
+
+/**
+ * 預設路徑: tmpfs,避免狀態變動時寫入 flash。重新啟動程序 (crash、
+ * procd 重啟) 時可 warm start,重新開機後則從 CEC 重新確認。
+ */
+#define STATE_STORE_DEFAULT_PATH    "/var/run/gaming-server.state"
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 持久化的執行狀態
+ */
+typedef struct {
+    time_t saved_time;                  /**< 寫入時間 */
+    uint64_t status_version;            /**< 狀態快照版本 (重新啟動後接續) */
+    ps5_power_state_t power;            /**< 最後確認的電源狀態 */
+    ps5_network_status_t network;       /**< 最後的網路狀態 */
+    ps5_info_t ps5_info;                /**< 偵測快取 (ip 為空表示沒有) */
+    uint32_t wake_requests;             /**< 累計喚醒請求次數 */
+} state_store_record_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 寫入快照 (取代舊檔)
+ *
+ * @return 0 成功, -1 失敗 (舊檔不變)
+ */
+int state_store_save(const char *path, const state_store_record_t *record);
+
+/**
+ * @brief 讀取快照
+ *
+ * @return 0 成功, -1 沒有檔案、格式版本不同或內容損壞 (record 不變)
+ */
+int state_store_load(const char *path, state_store_record_t *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATE_STORE_H */
@@ -0,0 +1,299 @@
+/**
+ * @file status_snapshot.c
+ * @brief Status Snapshot Implementation
+ *
+ * 每份快照在發佈後不再修改。目前快照本身持有一個參考,
+ * 讀取者各自再持有一個參考;被替換的快照在最後一個參考
+ * 釋放時才會被回收,因此讀取者永遠不會看到半更新的內容。
+ *
+ * @version 1.0.0
+ * @date 2025-11-20
+ */
+
+#include "status_snapshot.h"
+#include "json_writer.h"
+#include "ws_cbor.h"
+#include "websocket_server.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct {
+    status_snapshot_t snap;     // 必須為第一個成員 (release 時反向轉換)
+    int refs;
+} snapshot_node_t;
+
+typedef struct {
+    bool initialized;
+    pthread_mutex_t mutex;
+
+    // 最新輸入狀態
+    ps5_power_state_t power;
+    ps5_network_status_t network;
+    server_state_t server_state;
+    bool stale;
+
+    uint64_t version;
+    snapshot_node_t *current;
+} status_snapshot_context_t;
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+static status_snapshot_context_t g_snapshot_ctx = {0};
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static void node_unref(snapshot_node_t *node) {
+    if (node != NULL && __atomic_sub_fetch(&node->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(node);
+    }
+}
+
+/**
+ * @brief 序列化快照內容
+ */
+static bool render_snapshot(status_snapshot_t *snap) {
+    json_writer_t w;
+
+    json_writer_init(&w, snap->json, sizeof(snap->json));
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "ps5_status");
+    json_writer_kv_int(&w, "version", (int64_t)snap->version);
+    json_writer_kv_string(&w, "power", ps5_power_state_to_string(snap->power));
+    json_writer_kv_string(&w, "network", ps5_network_status_to_string(snap->network));
+    json_writer_kv_string(&w, "server_state", server_state_to_string(snap->server_state));
+    if (snap->stale) {
+        json_writer_kv_bool(&w, "stale", true);
+    }
+    json_writer_end_object(&w);
+    if (json_writer_finish(&w) == NULL) {
+        return false;
+    }
+    snap->json_len = json_writer_length(&w);
+
+    json_writer_init(&w, snap->not_modified, sizeof(snap->not_modified));
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "not_modified");
+    json_writer_kv_int(&w, "version", (int64_t)snap->version);
+    json_writer_end_object(&w);
+    if (json_writer_finish(&w) == NULL) {
+        return false;
+    }
+
+    // CBOR 固定佈局: 列舉值直接以整數傳送,stale 一律在索引 5,
+    // 附加的 id 因此固定在索引 6
+    cbor_writer_t c;
+    cbor_writer_init(&c, snap->cbor, sizeof(snap->cbor));
+    cbor_writer_array(&c, 6);
+    cbor_writer_int(&c, WS_MSG_PS5_STATUS);
+    cbor_writer_int(&c, (int64_t)snap->version);
+    cbor_writer_int(&c, snap->power);
+    cbor_writer_int(&c, snap->network);
+    cbor_writer_int(&c, snap->server_state);
+    cbor_writer_bool(&c, snap->stale);
+    snap->cbor_len = cbor_writer_finish(&c);
+
+    cbor_writer_init(&c, snap->not_modified_cbor, sizeof(snap->not_modified_cbor));
+    cbor_writer_array(&c, 2);
+    cbor_writer_int(&c, WS_MSG_NOT_MODIFIED);
+    cbor_writer_int(&c, (int64_t)snap->version);
+    snap->not_modified_cbor_len = cbor_writer_finish(&c);
+
+    return snap->cbor_len > 0 && snap->not_modified_cbor_len > 0;
+}
+
+/**
+ * @brief 依目前輸入重建並發佈新快照 (呼叫者須持有 mutex)
+ */
+static bool rebuild_locked(void) {
+    snapshot_node_t *node = (snapshot_node_t*)calloc(1, sizeof(snapshot_node_t));
+    if (node == NULL) {
+        return false;
+    }
+
+    node->snap.version = g_snapshot_ctx.version + 1;
+    node->snap.power = g_snapshot_ctx.power;
+    node->snap.network = g_snapshot_ctx.network;
+    node->snap.server_state = g_snapshot_ctx.server_state;
+    node->snap.stale = g_snapshot_ctx.stale;
+    node->refs = 1;  // 由 current 持有
+
+    if (!render_snapshot(&node->snap)) {
+        free(node);
+        return false;
+    }
+
+    snapshot_node_t *old = g_snapshot_ctx.current;
+    g_snapshot_ctx.version = node->snap.version;
+    g_snapshot_ctx.current = node;
+    node_unref(old);
+
+    return true;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int status_snapshot_init(void) {
+    if (g_snapshot_ctx.initialized) {
+        return 0;
+    }
+
+    memset(&g_snapshot_ctx, 0, sizeof(g_snapshot_ctx));
+    pthread_mutex_init(&g_snapshot_ctx.mutex, NULL);
+
+    g_snapshot_ctx.power = PS5_POWER_UNKNOWN;
+    g_snapshot_ctx.network = PS5_NET_UNKNOWN;
+    g_snapshot_ctx.server_state = SERVER_STATE_INIT;
+
+    if (!rebuild_locked()) {
+        pthread_mutex_destroy(&g_snapshot_ctx.mutex);
+        return -1;
+    }
+
+    g_snapshot_ctx.initialized = true;
+    return 0;
+}
+
+void status_snapshot_cleanup(void) {
+    if (!g_snapshot_ctx.initialized) {
+        return;
+    }
+
+    node_unref(g_snapshot_ctx.current);
+    pthread_mutex_destroy(&g_snapshot_ctx.mutex);
+    memset(&g_snapshot_ctx, 0, sizeof(g_snapshot_ctx));
+}
+
+bool status_snapshot_set_power(ps5_power_state_t power) {
+    if (!g_snapshot_ctx.initialized) {
+        return false;
+    }
+
+    bool rebuilt = false;
+    pthread_mutex_lock(&g_snapshot_ctx.mutex);
+    if (g_snapshot_ctx.power != power || g_snapshot_ctx.stale) {
+        g_snapshot_ctx.power = power;
+        g_snapshot_ctx.stale = false;
+        rebuilt = rebuild_locked();
+    }
+    pthread_mutex_unlock(&g_snapshot_ctx.mutex);
+
+    return rebuilt;
+}
+
+bool status_snapshot_set_network(ps5_network_status_t network) {
+    if (!g_snapshot_ctx.initialized) {
+        return false;
+    }
+
+    bool rebuilt = false;
+    pthread_mutex_lock(&g_snapshot_ctx.mutex);
+    if (g_snapshot_ctx.network != network) {
+        g_snapshot_ctx.network = network;
+        rebuilt = rebuild_locked();
+    }
+    pthread_mutex_unlock(&g_snapshot_ctx.mutex);
+
+    return rebuilt;
+}
+
+bool status_snapshot_set_server_state(server_state_t state) {
+    if (!g_snapshot_ctx.initialized) {
+        return false;
+    }
+
+    bool rebuilt = false;
+    pthread_mutex_lock(&g_snapshot_ctx.mutex);
+    if (g_snapshot_ctx.server_state != state) {
+        g_snapshot_ctx.server_state = state;
+        rebuilt = rebuild_locked();
+    }
+    pthread_mutex_unlock(&g_snapshot_ctx.mutex);
+
+    return rebuilt;
+}
+
+int status_snapshot_set_provisional(ps5_power_state_t power, ps5_network_status_t network,
+                                    uint64_t version)
+{
+    if (!g_snapshot_ctx.initialized) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_snapshot_ctx.mutex);
+    g_snapshot_ctx.power = power;
+    g_snapshot_ctx.network = network;
+    g_snapshot_ctx.stale = true;
+    if (version > g_snapshot_ctx.version) {
+        g_snapshot_ctx.version = version;
+    }
+    bool rebuilt = rebuild_locked();
+    pthread_mutex_unlock(&g_snapshot_ctx.mutex);
+
+    return rebuilt ? 0 : -1;
+}
+
+int status_snapshot_restore(ps5_power_state_t power, ps5_network_status_t network,
+                            server_state_t state, uint64_t version)
+{
+    if (!g_snapshot_ctx.initialized) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_snapshot_ctx.mutex);
+    g_snapshot_ctx.power = power;
+    g_snapshot_ctx.network = network;
+    g_snapshot_ctx.server_state = state;
+    if (version > g_snapshot_ctx.version) {
+        g_snapshot_ctx.version = version;
+    }
+    bool rebuilt = rebuild_locked();
+    pthread_mutex_unlock(&g_snapshot_ctx.mutex);
+
+    return rebuilt ? 0 : -1;
+}
+
+const status_snapshot_t* status_snapshot_acquire(void) {
+    if (!g_snapshot_ctx.initialized) {
+        return NULL;
+    }
+
+    // 在 mutex 內取參考,確保 current 不會在增加計數前被回收
+    pthread_mutex_lock(&g_snapshot_ctx.mutex);
+    snapshot_node_t *node = g_snapshot_ctx.current;
+    __atomic_add_fetch(&node->refs, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&g_snapshot_ctx.mutex);
+
+    return &node->snap;
+}
+
+void status_snapshot_release(const status_snapshot_t *snapshot) {
+    if (snapshot == NULL) {
+        return;
+    }
+
+    node_unref((snapshot_node_t*)snapshot);
+}
+
+uint64_t status_snapshot_get_version(void) {
+    if (!g_snapshot_ctx.initialized) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_snapshot_ctx.mutex);
+    uint64_t version = g_snapshot_ctx.version;
+    pthread_mutex_unlock(&g_snapshot_ctx.mutex);
+
+    return version;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file status_snapshot.h
+ * @brief Status Snapshot - 預先序列化的 PS5 狀態快照
+ *
+ * 此模組維護一份不可變、已序列化的狀態快照:
+ * - 只有在 CEC 電源、網路狀態或狀態機狀態改變時才重建
+ * - 每次重建 version 單調遞增
+ * - 查詢時以參考 (reference count) 方式取得,不重新格式化
+ * - 同時預先產生 not_modified 回應,供輪詢客戶端使用
+ * - 同時預先產生 CBOR 固定佈局,供 gaming.v1.cbor 客戶端使用
+ *
+ * 啟動時可先以持久化的最後狀態建立暫定快照 (stale),JSON 加上
+ * "stale":true,CBOR 陣列索引 5 的 stale 為 true;第一次 CEC 電源回報
+ * (status_snapshot_set_power) 確認後清除。
+ *
+ * CBOR 佈局 (ws_cbor.h) 的元素數固定,請求帶有 id 時附加在索引 6:
+ * @code
+ * [WS_MSG_PS5_STATUS, version, power, network, server_state, stale]
+ * [WS_MSG_PS5_STATUS, version, power, network, server_state, stale, id]
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-20
+ * @version 1.0.0
+ */
+
+#ifndef STATUS_SNAPSHOT_H
+#define STATUS_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "cec_monitor.h"
+#include "server_state_machine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 快照 JSON 最大長度 */
+#define STATUS_SNAPSHOT_MAX_SIZE        256
+
+/** not_modified 回應最大長度 */
+#define STATUS_SNAPSHOT_NOT_MODIFIED_SIZE 64
+
+/** CBOR 固定佈局最大長度 */
+#define STATUS_SNAPSHOT_CBOR_SIZE       32
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 狀態快照 (發佈後不可修改)
+ */
+typedef struct {
+    uint64_t version;                   /**< 快照版本 (單調遞增) */
+    ps5_power_state_t power;            /**< PS5 電源狀態 */
+    ps5_network_status_t network;       /**< PS5 網路狀態 */
+    server_state_t server_state;        /**< 狀態機狀態 */
+    bool stale;                         /**< 暫定狀態 (尚未經 CEC 確認) */
+    size_t json_len;                    /**< json 長度 */
+    char json[STATUS_SNAPSHOT_MAX_SIZE];                    /**< ps5_status 訊息 */
+    char not_modified[STATUS_SNAPSHOT_NOT_MODIFIED_SIZE];   /**< not_modified 訊息 */
+    
+    /** [WS_MSG_PS5_STATUS, version, power, network, server_state, stale] (一律 6 個元素) */
+    uint8_t cbor[STATUS_SNAPSHOT_CBOR_SIZE];
+    size_t cbor_len;                    /**< cbor 長度 */
+    
+    /** [WS_MSG_NOT_MODIFIED, version] */
+    uint8_t not_modified_cbor[STATUS_SNAPSHOT_CBOR_SIZE];
+    size_t not_modified_cbor_len;       /**< not_modified_cbor 長度 */
+} status_snapshot_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 初始化狀態快照 (建立 version 1)
+ *
+ * @return 0 成功, <0 失敗
+ */
+int status_snapshot_init(void);
+
+/**
+ * @brief 清理資源
+ *
+ * 呼叫前所有取得的快照都必須已釋放
+ */
+void status_snapshot_cleanup(void);
+
+/**
+ * @brief 更新 PS5 電源狀態
+ *
+ * 電源狀態來自 CEC,同時確認暫定快照 (清除 stale)。
+ *
+ * @param power 新電源狀態
+ * @return true 表示狀態改變 (或 stale 已清除) 且快照已重建
+ */
+bool status_snapshot_set_power(ps5_power_state_t power);
+
+/**
+ * @brief 更新 PS5 網路狀態
+ *
+ * @param network 新網路狀態
+ * @return true 表示狀態改變且快照已重建
+ */
+bool status_snapshot_set_network(ps5_network_status_t network);
+
+/**
+ * @brief 更新狀態機狀態
+ *
+ * @param state 新狀態
+ * @return true 表示狀態改變且快照已重建
+ */
+bool status_snapshot_set_server_state(server_state_t state);
+
+/**
+ * @brief 以持久化的最後狀態建立暫定快照 (warm start,啟動時)
+ *
+ * 快照標示為 stale,直到 status_snapshot_set_power() 確認。
+ * 版本接在 version 之後,與重新啟動前客戶端已知的版本不會混淆。
+ *
+ * @param version 持久化時的快照版本
+ * @return 0 成功, -1 未初始化或記憶體不足
+ */
+int status_snapshot_set_provisional(ps5_power_state_t power, ps5_network_status_t network,
+                                    uint64_t version);
+
+/**
+ * @brief 以前一個程序的狀態重建快照 (平滑升級)
+ *
+ * 新快照的版本接在 version 之後,客戶端已知的舊版本不會與新內容混淆。
+ *
+ * @param version 前一個程序的快照版本
+ * @return 0 成功, -1 未初始化或記憶體不足
+ */
+int status_snapshot_restore(ps5_power_state_t power, ps5_network_status_t network,
+                            server_state_t state, uint64_t version);
+
+/**
+ * @brief 取得目前快照 (增加參考計數)
+ *
+ * 可由任何執行緒呼叫,使用完畢後必須呼叫 status_snapshot_release()
+ *
+ * @return 快照指標, NULL 表示未初始化
+ */
+const status_snapshot_t* status_snapshot_acquire(void);
+
+/**
+ * @brief 釋放快照參考
+ *
+ * @param snapshot status_snapshot_acquire() 取得的快照
+ */
+void status_snapshot_release(const status_snapshot_t *snapshot);
+
+/**
+ * @brief 取得目前快照版本
+ *
+ * @return 版本號, 0 表示未初始化
+ */
+uint64_t status_snapshot_get_version(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATUS_SNAPSHOT_H */
@@ -0,0 +1,201 @@
+/**
+ * @file timer_wheel.c
+ * @brief Hierarchical Timer Wheel Implementation
+ *
+ * 第 L 層每格代表 64^L 個 tick。計時器依距離到期的 tick 數放入
+ * 能容納的最低層;當低層轉完一圈時,將上一層對應格子的計時器
+ * 重新插入 (cascade),最終都會落在第 0 層並在到期的 tick 觸發。
+ *
+ * @version 1.0.0
+ * @date 2025-11-22
+ */
+
+#include "timer_wheel.h"
+
+#include <string.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define SLOT_MASK       (TIMER_WHEEL_SLOTS - 1)
+
+/** 最遠可排程的 tick 數 (超過時以此為上限) */
+#define MAX_DELTA       ((1ull << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static void list_init(tw_link_t *head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static bool list_empty(const tw_link_t *head) {
+    return head->next == head;
+}
+
+static void list_add_tail(tw_link_t *head, tw_link_t *link) {
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
+}
+
+static void list_del(tw_link_t *link) {
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->next = NULL;
+    link->prev = NULL;
+}
+
+/**
+ * @brief 將整個格子移到 dst (dst 須為空的 sentinel)
+ */
+static void list_splice(tw_link_t *src, tw_link_t *dst) {
+    list_init(dst);
+    if (list_empty(src)) {
+        return;
+    }
+
+    dst->next = src->next;
+    dst->prev = src->prev;
+    dst->next->prev = dst;
+    dst->prev->next = dst;
+    list_init(src);
+}
+
+/**
+ * @brief 依到期 tick 放入對應的格子 (expires >= current)
+ */
+static void insert_timer(timer_wheel_t *wheel, tw_timer_t *timer) {
+    uint64_t expires = timer->expires;
+    uint64_t delta = expires - wheel->current;
+    if (delta > MAX_DELTA) {
+        delta = MAX_DELTA;
+        expires = wheel->current + delta;
+    }
+    timer->expires = expires;
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1ull << (TIMER_WHEEL_SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+
+    size_t slot = (size_t)(expires >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+    list_add_tail(&wheel->slots[level][slot], &timer->link);
+}
+
+/**
+ * @brief 將第 level 層目前的格子重新分配到較低層
+ */
+static void cascade(timer_wheel_t *wheel, int level) {
+    size_t slot = (size_t)(wheel->current >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+
+    tw_link_t pending;
+    list_splice(&wheel->slots[level][slot], &pending);
+
+    while (!list_empty(&pending)) {
+        tw_timer_t *timer = (tw_timer_t*)pending.next;
+        list_del(&timer->link);
+        insert_timer(wheel, timer);
+    }
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now_ms, uint32_t tick_ms) {
+    memset(wheel, 0, sizeof(*wheel));
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (size_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            list_init(&wheel->slots[level][slot]);
+        }
+    }
+
+    wheel->tick_ms = (tick_ms > 0) ? tick_ms : 1;
+    wheel->base_ms = now_ms;
+}
+
+void tw_timer_init(tw_timer_t *timer, tw_callback_t callback, void *user_data) {
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = callback;
+    timer->user_data = user_data;
+}
+
+bool tw_timer_pending(const tw_timer_t *timer) {
+    return timer->link.next != NULL;
+}
+
+void timer_wheel_schedule(timer_wheel_t *wheel, tw_timer_t *timer, uint64_t expires_ms) {
+    timer_wheel_cancel(wheel, timer);
+
+    // 向上取整: 不會比要求的時間提早觸發
+    uint64_t offset = (expires_ms > wheel->base_ms) ? expires_ms - wheel->base_ms : 0;
+    timer->expires = (offset + wheel->tick_ms - 1) / wheel->tick_ms;
+
+    // 目前 tick 已處理過: 已到期的計時器在下一個 tick 觸發
+    if (timer->expires <= wheel->current) {
+        timer->expires = wheel->current + 1;
+    }
+
+    insert_timer(wheel, timer);
+    wheel->count++;
+}
+
+void timer_wheel_cancel(timer_wheel_t *wheel, tw_timer_t *timer) {
+    if (!tw_timer_pending(timer)) {
+        return;
+    }
+
+    list_del(&timer->link);
+    wheel->count--;
+}
+
+int timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_ms) {
+    if (now_ms < wheel->base_ms) {
+        return 0;
+    }
+
+    uint64_t target = (now_ms - wheel->base_ms) / wheel->tick_ms;
+    int fired = 0;
+
+    while (wheel->current < target) {
+        wheel->current++;
+
+        // 低層轉完一圈時,從上一層補充計時器
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if ((wheel->current & ((1ull << (TIMER_WHEEL_SLOT_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            cascade(wheel, level);
+        }
+
+        // 沒有任何計時器時直接跳到目標 tick
+        if (wheel->count == 0) {
+            wheel->current = target;
+            break;
+        }
+
+        tw_link_t expired;
+        list_splice(&wheel->slots[0][wheel->current & SLOT_MASK], &expired);
+
+        // 回調可能取消 expired 中的其他計時器,每次都從頭取
+        while (!list_empty(&expired)) {
+            tw_timer_t *timer = (tw_timer_t*)expired.next;
+            list_del(&timer->link);
+            wheel->count--;
+            fired++;
+
+            if (timer->callback) {
+                timer->callback(timer, timer->user_data);
+            }
+        }
+    }
+
+    return fired;
+}
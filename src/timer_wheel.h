@@ -0,0 +1,148 @@
+/**
+ * @file timer_wheel.h
+ * @brief Hierarchical Timer Wheel - O(1) 新增/取消的計時器
+ *
+ * 此模組提供:
+ * - 4 層、每層 64 格的階層式時間輪
+ * - 計時器嵌入在使用者結構中 (不呼叫 malloc())
+ * - 新增、取消皆為 O(1);每個 tick 的成本與計時器數量無關
+ *   (只有到期或需要下移一層的計時器才會被處理)
+ *
+ * 時間以毫秒表示,由呼叫者傳入 (例如 CLOCK_MONOTONIC),
+ * 到期時間會向上取整到 tick。
+ *
+ * 使用範例:
+ * @code
+ * timer_wheel_t wheel;
+ * timer_wheel_init(&wheel, now_ms(), 100);
+ *
+ * tw_timer_init(&client->keepalive, on_keepalive, client);
+ * timer_wheel_schedule(&wheel, &client->keepalive, now_ms() + 30000);
+ *
+ * // timerfd 觸發時
+ * timer_wheel_advance(&wheel, now_ms());
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-22
+ * @version 1.0.0
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 層數 */
+#define TIMER_WHEEL_LEVELS      4
+
+/** 每層格數 (2^TIMER_WHEEL_SLOT_BITS) */
+#define TIMER_WHEEL_SLOT_BITS   6
+#define TIMER_WHEEL_SLOTS       (1u << TIMER_WHEEL_SLOT_BITS)
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 雙向鏈結 (格子的 sentinel 與計時器共用)
+ */
+typedef struct tw_link {
+    struct tw_link *next;
+    struct tw_link *prev;
+} tw_link_t;
+
+struct tw_timer;
+
+/**
+ * @brief 到期回調
+ *
+ * 回調中可以重新排程或取消任何計時器 (包含自己)
+ *
+ * @param timer 到期的計時器
+ * @param user_data 使用者資料
+ */
+typedef void (*tw_callback_t)(struct tw_timer *timer, void *user_data);
+
+/**
+ * @brief 計時器 (嵌入在使用者結構中)
+ */
+typedef struct tw_timer {
+    tw_link_t link;             /**< 必須為第一個成員 */
+    uint64_t expires;           /**< 到期 tick */
+    tw_callback_t callback;     /**< 到期回調 */
+    void *user_data;            /**< 使用者資料 */
+} tw_timer_t;
+
+/**
+ * @brief 時間輪
+ */
+typedef struct {
+    tw_link_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t current;           /**< 目前 tick */
+    uint64_t base_ms;           /**< tick 0 對應的時間 */
+    uint32_t tick_ms;           /**< tick 長度 (毫秒) */
+    size_t count;               /**< 排程中的計時器數量 */
+} timer_wheel_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 初始化時間輪
+ *
+ * @param wheel 時間輪
+ * @param now_ms 目前時間 (毫秒)
+ * @param tick_ms tick 長度 (毫秒, >0)
+ */
+void timer_wheel_init(timer_wheel_t *wheel, uint64_t now_ms, uint32_t tick_ms);
+
+/**
+ * @brief 初始化計時器 (未排程)
+ */
+void tw_timer_init(tw_timer_t *timer, tw_callback_t callback, void *user_data);
+
+/**
+ * @brief 計時器是否已排程
+ */
+bool tw_timer_pending(const tw_timer_t *timer);
+
+/**
+ * @brief 排程計時器 (已排程時先取消)
+ *
+ * @param wheel 時間輪
+ * @param timer 計時器
+ * @param expires_ms 到期時間 (毫秒, 已過去的時間會在下一個 tick 觸發)
+ */
+void timer_wheel_schedule(timer_wheel_t *wheel, tw_timer_t *timer, uint64_t expires_ms);
+
+/**
+ * @brief 取消計時器 (未排程時不做任何事)
+ */
+void timer_wheel_cancel(timer_wheel_t *wheel, tw_timer_t *timer);
+
+/**
+ * @brief 推進時間並觸發到期的計時器
+ *
+ * @param wheel 時間輪
+ * @param now_ms 目前時間 (毫秒)
+ * @return 觸發的計時器數量
+ */
+int timer_wheel_advance(timer_wheel_t *wheel, uint64_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMER_WHEEL_H */
@@ -0,0 +1,64 @@
+/**
+ * @file token_bucket.c
+ * @brief Token Bucket Implementation
+ *
+ * 每經過 1 毫秒補充 rate / 1000 個令牌,即 rate 個 1/1000 token,
+ * 因此補充量只需要一次整數乘法。
+ *
+ * @version 1.0.0
+ * @date 2025-11-25
+ */
+
+#include "token_bucket.h"
+
+/** 一個令牌 (1/1000 token 單位) */
+#define TOKEN_UNIT      1000u
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+void token_bucket_init(token_bucket_t *bucket, uint32_t burst, uint64_t now_ms) {
+    uint64_t capacity = (uint64_t)burst * TOKEN_UNIT;
+    bucket->tokens = (capacity > UINT32_MAX) ? UINT32_MAX : (uint32_t)capacity;
+    bucket->last_ms = now_ms;
+}
+
+bool token_bucket_take(token_bucket_t *bucket, uint32_t rate, uint32_t burst,
+                       uint64_t now_ms)
+{
+    if (rate == 0) {
+        return true;
+    }
+
+    uint64_t capacity = (uint64_t)burst * TOKEN_UNIT;
+    if (capacity > UINT32_MAX) {
+        capacity = UINT32_MAX;
+    }
+
+    // 時間倒退 (例如虛擬時鐘重設) 時不補充,只重新對齊
+    if (now_ms > bucket->last_ms) {
+        uint64_t elapsed = now_ms - bucket->last_ms;
+        uint64_t tokens = bucket->tokens;
+
+        // 長時間閒置: 直接補滿,避免乘法溢位
+        if (elapsed >= capacity / rate + 1) {
+            tokens = capacity;
+        } else {
+            tokens += elapsed * rate;
+            if (tokens > capacity) {
+                tokens = capacity;
+            }
+        }
+
+        bucket->tokens = (uint32_t)tokens;
+    }
+    bucket->last_ms = now_ms;
+
+    if (bucket->tokens < TOKEN_UNIT) {
+        return false;
+    }
+
+    bucket->tokens -= TOKEN_UNIT;
+    return true;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file token_bucket.h
+ * @brief Token Bucket - 整數運算的速率限制
+ *
+ * 此模組提供:
+ * - 以 1/1000 token 為單位的令牌桶 (不使用浮點數)
+ * - 速率與容量在每次取用時傳入,設定變更後立即生效
+ *
+ * 時間以毫秒表示,由呼叫者傳入 (例如 CLOCK_MONOTONIC)。
+ *
+ * 使用範例:
+ * @code
+ * token_bucket_t bucket;
+ * token_bucket_init(&bucket, 10, now_ms());
+ *
+ * // 每秒 5 個,最多累積 10 個
+ * if (!token_bucket_take(&bucket, 5, 10, now_ms())) {
+ *     reject();
+ * }
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-25
+ * @version 1.0.0
+ */
+
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 令牌桶
+ */
+typedef struct {
+    uint32_t tokens;            /**< 剩餘令牌 (1/1000 token) */
+    uint64_t last_ms;           /**< 上次補充的時間 */
+} token_bucket_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 初始化為滿的令牌桶
+ *
+ * @param bucket 令牌桶
+ * @param burst 容量 (token)
+ * @param now_ms 目前時間
+ */
+void token_bucket_init(token_bucket_t *bucket, uint32_t burst, uint64_t now_ms);
+
+/**
+ * @brief 補充令牌後取用一個
+ *
+ * @param bucket 令牌桶
+ * @param rate 每秒補充的令牌數, 0 表示不限制
+ * @param burst 容量 (token)
+ * @param now_ms 目前時間
+ * @return true 取得令牌, false 超過速率
+ */
+bool token_bucket_take(token_bucket_t *bucket, uint32_t rate, uint32_t burst,
+                       uint64_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOKEN_BUCKET_H */
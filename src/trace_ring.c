@@ -0,0 +1,255 @@
+/**
+ * @file trace_ring.c
+ * @brief Flight Recorder Implementation
+ *
+ * 每個槽位以序號當作 seqlock: 寫入前把 seq 設為 0,寫完欄位後
+ * 以 release 寫入實際序號;讀取端前後兩次讀到相同且符合預期的序號
+ * 才採用,因此讀取不會阻擋寫入端。
+ *
+ * 時間取自 vclock (真實時鐘下為 CLOCK_MONOTONIC,vDSO,不進入核心),
+ * 模擬時鐘下與狀態歷史、metrics 使用同一條時間軸。
+ *
+ * @version 1.0.0
+ * @date 2025-11-28
+ */
+
+#include "trace_ring.h"
+#include "vclock.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define TRACE_RING_MASK     (TRACE_RING_SIZE - 1)
+
+/** 輸出檔案時每次讀取的筆數 */
+#define TRACE_DUMP_CHUNK    64
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct {
+    uint64_t head;                              // 最後一筆的序號
+    trace_record_t records[TRACE_RING_SIZE];
+} trace_ring_t;
+
+/**
+ * @brief 事件名稱與參數名稱 (NULL 表示不輸出)
+ */
+typedef struct {
+    const char *name;
+    const char *args[3];
+} trace_event_desc_t;
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+static trace_ring_t g_trace_ring;
+
+static const trace_event_desc_t k_events[TRACE_EVENT_COUNT] = {
+    [TRACE_NONE]              = { "none",              { NULL, NULL, NULL } },
+    [TRACE_CEC_POLL]          = { "cec_poll",          { "power", "latency_us", "errors" } },
+    [TRACE_STATE_TRANSITION]  = { "state_transition",  { "from", "to", NULL } },
+    [TRACE_MSG_IN]            = { "msg_in",            { "type", "client", "len" } },
+    [TRACE_MSG_OUT]           = { "msg_out",           { NULL, "client", "len" } },
+    [TRACE_PUBLISH]           = { "publish",           { "clients", "topics", "len" } },
+    [TRACE_WAKE_REQUEST]      = { "wake_request",      { NULL, "client", NULL } },
+    [TRACE_WAKE_ATTEMPT]      = { "wake_attempt",      { "attempt", "result", "latency_us" } },
+    [TRACE_WAKE_COMPLETE]     = { "wake_complete",     { "success", NULL, NULL } },
+    [TRACE_DETECT_PROBE]      = { "detect_probe",      { "method", "hit", "latency_us" } },
+    [TRACE_CLIENT_CONNECT]    = { "client_connect",    { NULL, "client", NULL } },
+    [TRACE_CLIENT_DISCONNECT] = { "client_disconnect", { NULL, "client", NULL } },
+};
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+/**
+ * @brief 讀取指定序號的記錄
+ * @return true 記錄完整且未被覆蓋
+ */
+static bool read_slot(uint64_t seq, trace_record_t *out) {
+    const trace_record_t *slot = &g_trace_ring.records[(seq - 1) & TRACE_RING_MASK];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq) {
+        return false;
+    }
+
+    out->seq = seq;
+    out->time_ns = __atomic_load_n(&slot->time_ns, __ATOMIC_RELAXED);
+    out->event = __atomic_load_n(&slot->event, __ATOMIC_RELAXED);
+    out->a0 = __atomic_load_n(&slot->a0, __ATOMIC_RELAXED);
+    out->a1 = __atomic_load_n(&slot->a1, __ATOMIC_RELAXED);
+    out->a2 = __atomic_load_n(&slot->a2, __ATOMIC_RELAXED);
+    out->reserved = 0;
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq;
+}
+
+static int write_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+void trace_ring_record(trace_event_t event, uint16_t a0, uint32_t a1, uint32_t a2) {
+    uint64_t seq = __atomic_add_fetch(&g_trace_ring.head, 1, __ATOMIC_RELAXED);
+    trace_record_t *slot = &g_trace_ring.records[(seq - 1) & TRACE_RING_MASK];
+
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&slot->time_ns, vclock_now_ns(), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event, (uint16_t)event, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->a0, a0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->a1, a1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->a2, a2, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+}
+
+uint64_t trace_ring_next_seq(void) {
+    return __atomic_load_n(&g_trace_ring.head, __ATOMIC_ACQUIRE) + 1;
+}
+
+int trace_ring_read(uint64_t since, trace_record_t *out, int max, uint64_t *next) {
+    uint64_t head = __atomic_load_n(&g_trace_ring.head, __ATOMIC_ACQUIRE);
+    uint64_t oldest = (head > TRACE_RING_SIZE) ? head - TRACE_RING_SIZE + 1 : 1;
+    uint64_t seq = (since < oldest) ? oldest : since;
+    int count = 0;
+
+    if (out == NULL) {
+        max = 0;
+    }
+
+    for (; seq <= head && count < max; seq++) {
+        if (read_slot(seq, &out[count])) {
+            count++;
+        }
+    }
+
+    if (next) {
+        *next = seq;
+    }
+    return count;
+}
+
+int trace_ring_dump_file(const char *path) {
+    if (path == NULL) {
+        return -1;
+    }
+
+    char tmp_path[256];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        return -1;
+    }
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // 標頭最後才寫入 (筆數在讀完之後才知道)
+    trace_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_FILE_VERSION;
+    header.record_size = sizeof(trace_record_t);
+    header.realtime_offset_ns = vclock_realtime_offset_ns();
+
+    int rc = (lseek(fd, sizeof(header), SEEK_SET) < 0) ? -1 : 0;
+
+    // 只輸出開始時已存在的記錄,避免與寫入端無止盡競爭
+    uint64_t end = trace_ring_next_seq();
+    uint64_t seq = 0;
+    trace_record_t chunk[TRACE_DUMP_CHUNK];
+
+    while (rc == 0 && seq < end) {
+        uint64_t next;
+        int n = trace_ring_read(seq, chunk, TRACE_DUMP_CHUNK, &next);
+        while (n > 0 && chunk[n - 1].seq >= end) {
+            n--;
+        }
+        if (n > 0) {
+            if (header.count == 0) {
+                header.first_seq = chunk[0].seq;
+            }
+            rc = write_all(fd, chunk, (size_t)n * sizeof(trace_record_t));
+            header.count += (uint64_t)n;
+        }
+        if (next == seq) {
+            break;
+        }
+        seq = next;
+    }
+
+    if (rc == 0) {
+        rc = (pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header)) ? 0 : -1;
+    }
+    if (close(fd) != 0) {
+        rc = -1;
+    }
+    if (rc == 0 && rename(tmp_path, path) != 0) {
+        rc = -1;
+    }
+    if (rc != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+
+    return (int)header.count;
+}
+
+const char* trace_event_to_string(trace_event_t event) {
+    if ((unsigned)event >= TRACE_EVENT_COUNT) {
+        return "unknown";
+    }
+    return k_events[event].name;
+}
+
+int trace_record_format(const trace_record_t *record, char *out, size_t size) {
+    if (record == NULL || out == NULL || size == 0) {
+        return -1;
+    }
+
+    uint32_t values[3] = { record->a0, record->a1, record->a2 };
+    int len = snprintf(out, size, "%s", trace_event_to_string((trace_event_t)record->event));
+
+    for (int i = 0; i < 3 && len >= 0 && (size_t)len < size; i++) {
+        const char *arg = ((unsigned)record->event < TRACE_EVENT_COUNT)
+                          ? k_events[record->event].args[i] : "arg";
+        if (arg == NULL) {
+            continue;
+        }
+        int n = snprintf(out + len, size - (size_t)len, " %s=%" PRIu32, arg, values[i]);
+        len = (n < 0) ? -1 : len + n;
+    }
+
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+    return len;
+}
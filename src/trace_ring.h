@@ -0,0 +1,153 @@
+/**
+ * @file trace_ring.h
+ * @brief Flight Recorder - 固定大小的二進位事件環形緩衝區
+ *
+ * 此模組提供:
+ * - 常駐開啟的事件記錄 (CEC 輪詢、狀態轉換、訊息進出、喚醒、偵測)
+ * - 寫入端不加鎖: 一次 atomic fetch_add 取得槽位,再以序號發佈
+ * - 固定 TRACE_RING_SIZE 筆,新記錄覆蓋最舊的記錄
+ * - 以序號分頁讀取 (WebSocket debug_dump) 或輸出成檔案 (SIGUSR1)
+ *
+ * 檔案格式 (本機位元組順序): trace_file_header_t 後接 count 筆
+ * trace_record_t,由舊到新。tools/trace_decode.c 將檔案轉成時間軸。
+ *
+ * 使用範例:
+ * @code
+ * trace_ring_record(TRACE_STATE_TRANSITION, old_state, new_state, 0);
+ *
+ * trace_record_t records[32];
+ * uint64_t next;
+ * int n = trace_ring_read(since, records, 32, &next);
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-28
+ * @version 1.0.0
+ */
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 環形緩衝區筆數 (2 的次方) */
+#define TRACE_RING_SIZE             2048
+
+/** 檔案標頭 magic */
+#define TRACE_FILE_MAGIC            "GSTRACE1"
+
+/** 檔案格式版本 */
+#define TRACE_FILE_VERSION          1
+
+/** SIGUSR1 輸出的預設路徑 */
+#define TRACE_DEFAULT_DUMP_PATH     "/tmp/gaming-server.trace"
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 事件類型 (數值寫入檔案,已發佈的值不可更改)
+ */
+typedef enum {
+    TRACE_NONE = 0,
+    TRACE_CEC_POLL = 1,             /**< a0=電源狀態, a1=延遲(us), a2=連續失敗次數 */
+    TRACE_STATE_TRANSITION = 2,     /**< a0=舊狀態, a1=新狀態 */
+    TRACE_MSG_IN = 3,               /**< a0=訊息類型, a1=客戶端 ID, a2=長度 */
+    TRACE_MSG_OUT = 4,              /**< a1=客戶端 ID, a2=長度 */
+    TRACE_PUBLISH = 5,              /**< a0=收到的客戶端數, a1=主題, a2=長度 */
+    TRACE_WAKE_REQUEST = 6,         /**< a1=客戶端 ID (0 表示狀態機) */
+    TRACE_WAKE_ATTEMPT = 7,         /**< a0=第幾次, a1=結果 (0=成功), a2=延遲(us) */
+    TRACE_WAKE_COMPLETE = 8,        /**< a0=是否成功 */
+    TRACE_DETECT_PROBE = 9,         /**< a0=偵測方法, a1=是否找到, a2=延遲(us) */
+    TRACE_CLIENT_CONNECT = 10,      /**< a1=客戶端 ID */
+    TRACE_CLIENT_DISCONNECT = 11,   /**< a1=客戶端 ID */
+    TRACE_EVENT_COUNT
+} trace_event_t;
+
+/**
+ * @brief 一筆記錄 (32 bytes)
+ */
+typedef struct {
+    uint64_t seq;           /**< 序號 (從 1 開始), 0 表示寫入中 */
+    uint64_t time_ns;       /**< CLOCK_MONOTONIC (奈秒) */
+    uint16_t event;         /**< trace_event_t */
+    uint16_t a0;
+    uint32_t a1;
+    uint32_t a2;
+    uint32_t reserved;
+} trace_record_t;
+
+/**
+ * @brief 檔案標頭
+ */
+typedef struct {
+    char magic[8];              /**< TRACE_FILE_MAGIC (不含 '\0') */
+    uint32_t version;           /**< TRACE_FILE_VERSION */
+    uint32_t record_size;       /**< sizeof(trace_record_t) */
+    uint64_t count;             /**< 記錄筆數 */
+    uint64_t first_seq;         /**< 最舊記錄應有的序號 (之前的已被覆蓋) */
+    int64_t realtime_offset_ns; /**< CLOCK_REALTIME - CLOCK_MONOTONIC (轉換為牆上時間) */
+} trace_file_header_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 記錄一個事件 (任何執行緒,不加鎖、不配置記憶體)
+ */
+void trace_ring_record(trace_event_t event, uint16_t a0, uint32_t a1, uint32_t a2);
+
+/**
+ * @brief 下一筆記錄的序號
+ */
+uint64_t trace_ring_next_seq(void);
+
+/**
+ * @brief 讀取序號 since 之後的記錄
+ *
+ * since 之後的記錄已被覆蓋時從最舊的一筆開始;寫入中或讀取時
+ * 被覆蓋的記錄略過。
+ *
+ * @param since 從此序號開始 (0 表示最舊的一筆)
+ * @param out 輸出陣列
+ * @param max 最多讀取筆數
+ * @param next 輸出下次讀取的序號
+ * @return 讀取的筆數
+ */
+int trace_ring_read(uint64_t since, trace_record_t *out, int max, uint64_t *next);
+
+/**
+ * @brief 將所有記錄寫入檔案 (先寫暫存檔再 rename)
+ *
+ * @return 寫入的筆數, <0 表示失敗
+ */
+int trace_ring_dump_file(const char *path);
+
+/**
+ * @brief 事件類型名稱 (例如 "cec_poll")
+ */
+const char* trace_event_to_string(trace_event_t event);
+
+/**
+ * @brief 將記錄格式化為 "event key=value ..." (供解碼工具使用)
+ *
+ * @return 輸出長度, <0 表示緩衝區不足
+ */
+int trace_record_format(const trace_record_t *record, char *out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_RING_H */
@@ -0,0 +1,285 @@
+/**
+ * @file upgrade_handoff.c
+ * @brief Upgrade Handoff Implementation
+ *
+ * 每則訊息是一個 SEQPACKET 封包: upgrade_msg_header_t 後接內容,
+ * fd 附在同一個封包的 SCM_RIGHTS 中,不會與其他訊息混在一起。
+ * 接收端以 MSG_CMSG_CLOEXEC 取得 fd,之後 exec 的程序不會繼承。
+ *
+ * @version 1.0.0
+ * @date 2025-12-04
+ */
+
+#include "upgrade_handoff.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+extern char **environ;
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct {
+    uint32_t magic;                 // UPGRADE_HANDOFF_MAGIC
+    uint32_t version;               // UPGRADE_HANDOFF_VERSION
+    uint32_t type;                  // upgrade_msg_type_t
+    uint32_t length;                // 內容長度
+} upgrade_msg_header_t;
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static void close_fds(const int *fds, int count) {
+    for (int i = 0; i < count; i++) {
+        close(fds[i]);
+    }
+}
+
+/**
+ * @brief 目前的環境加上 UPGRADE_HANDOFF_ENV=fd (取代繼承的同名變數)
+ *
+ * @param entry 存放新變數的緩衝區 (須存活到 exec)
+ * @return 以 NULL 結尾的陣列 (呼叫者 free,字串屬於 environ 與 entry), NULL 失敗
+ */
+static char **build_envp(char *entry, size_t size, int fd) {
+    static const char prefix[] = UPGRADE_HANDOFF_ENV "=";
+    int n = snprintf(entry, size, "%s%d", prefix, fd);
+    if (n < 0 || (size_t)n >= size) {
+        return NULL;
+    }
+
+    size_t count = 0;
+    while (environ[count] != NULL) {
+        count++;
+    }
+
+    char **envp = malloc((count + 2) * sizeof(char *));
+    if (envp == NULL) {
+        return NULL;
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (strncmp(environ[i], prefix, sizeof(prefix) - 1) != 0) {
+            envp[out++] = environ[i];
+        }
+    }
+    envp[out++] = entry;
+    envp[out] = NULL;
+    return envp;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int upgrade_handoff_spawn(const char *path, char *const argv[], pid_t *pid) {
+    if (path == NULL || argv == NULL || pid == NULL) {
+        return -1;
+    }
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) != 0) {
+        return -1;
+    }
+
+    // 環境在 fork 之前建好: 子程序只剩 async-signal-safe 的呼叫,
+    // 其他執行緒在 fork 時持有的 malloc 鎖不會讓它卡住
+    char handoff_env[sizeof(UPGRADE_HANDOFF_ENV) + 16];
+    char **envp = build_envp(handoff_env, sizeof(handoff_env), sv[1]);
+    if (envp == NULL) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+
+    pid_t child = fork();
+    if (child == 0) {
+        // 新程序: 只有交接 fd 需要跨越 exec
+        if (fcntl(sv[1], F_SETFD, 0) == 0) {
+            execve(path, argv, envp);
+        }
+        _exit(127);
+    }
+
+    free(envp);
+    close(sv[1]);
+    if (child < 0) {
+        close(sv[0]);
+        return -1;
+    }
+
+    fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+    *pid = child;
+    return sv[0];
+}
+
+int upgrade_handoff_inherited(void) {
+    const char *value = getenv(UPGRADE_HANDOFF_ENV);
+    if (value == NULL) {
+        return -1;
+    }
+
+    char *end = NULL;
+    long fd = strtol(value, &end, 10);
+    unsetenv(UPGRADE_HANDOFF_ENV);
+
+    if (end == value || *end != '\0' || fd < 0 || fd > INT32_MAX ||
+        fcntl((int)fd, F_SETFD, FD_CLOEXEC) != 0) {
+        return -1;
+    }
+
+    return (int)fd;
+}
+
+int upgrade_handoff_send(int fd, upgrade_msg_type_t type, const void *payload, size_t len,
+                         const int *fds, int fd_count) {
+    if (fd < 0 || (payload == NULL && len > 0) || fd_count < 0 ||
+        (fds == NULL && fd_count > 0) || fd_count > WS_SERVER_HANDOFF_MAX_FDS) {
+        return -1;
+    }
+
+    upgrade_msg_header_t header = {
+        .magic = UPGRADE_HANDOFF_MAGIC,
+        .version = UPGRADE_HANDOFF_VERSION,
+        .type = (uint32_t)type,
+        .length = (uint32_t)len,
+    };
+
+    struct iovec iov[2] = {
+        { .iov_base = &header, .iov_len = sizeof(header) },
+        { .iov_base = (void *)payload, .iov_len = len },
+    };
+
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * WS_SERVER_HANDOFF_MAX_FDS)];
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = (len > 0) ? 2 : 1;
+
+    if (fd_count > 0) {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)fd_count);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)fd_count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * (size_t)fd_count);
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    // SEQPACKET 不會部分傳送
+    return (sent == (ssize_t)(sizeof(header) + len)) ? 0 : -1;
+}
+
+int upgrade_handoff_recv(int fd, upgrade_msg_type_t type, void *payload, size_t len,
+                         int *fds, int max_fds, int *fd_count, int timeout_ms) {
+    if (fd_count != NULL) {
+        *fd_count = 0;
+    }
+    if (fd < 0 || (payload == NULL && len > 0) || max_fds < 0 ||
+        max_fds > WS_SERVER_HANDOFF_MAX_FDS || (fds == NULL && max_fds > 0)) {
+        return -1;
+    }
+
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int ready;
+    do {
+        ready = poll(&pfd, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+
+    if (ready < 0) {
+        return -1;
+    }
+    if (ready == 0) {
+        return 0;
+    }
+
+    upgrade_msg_header_t header;
+    uint8_t extra;  // 偵測過長的內容
+    struct iovec iov[3] = {
+        { .iov_base = &header, .iov_len = sizeof(header) },
+        { .iov_base = payload, .iov_len = len },
+        { .iov_base = &extra, .iov_len = sizeof(extra) },
+    };
+
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * WS_SERVER_HANDOFF_MAX_FDS)];
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 3;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t received;
+    do {
+        received = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    } while (received < 0 && errno == EINTR);
+
+    if (received < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    if (received == 0) {
+        return -1;  // 對方關閉
+    }
+
+    // 先收下所有 fd,之後任何檢查失敗都要關閉
+    int received_fds[WS_SERVER_HANDOFF_MAX_FDS];
+    int received_count = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            if (count > WS_SERVER_HANDOFF_MAX_FDS - received_count) {
+                count = WS_SERVER_HANDOFF_MAX_FDS - received_count;
+            }
+            memcpy(&received_fds[received_count], CMSG_DATA(cmsg), sizeof(int) * (size_t)count);
+            received_count += count;
+        }
+    }
+
+    bool valid = !(msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) &&
+                 received == (ssize_t)(sizeof(header) + len) &&
+                 header.magic == UPGRADE_HANDOFF_MAGIC &&
+                 header.version == UPGRADE_HANDOFF_VERSION &&
+                 header.type == (uint32_t)type &&
+                 header.length == (uint32_t)len &&
+                 received_count <= max_fds;
+
+    if (!valid) {
+        close_fds(received_fds, received_count);
+        return -1;
+    }
+
+    if (received_count > 0) {
+        memcpy(fds, received_fds, sizeof(int) * (size_t)received_count);
+    }
+    if (fd_count != NULL) {
+        *fd_count = received_count;
+    }
+    return 1;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file upgrade_handoff.h
+ * @brief Upgrade Handoff - 平滑升級時新舊程序之間的交接通道
+ *
+ * 此模組提供:
+ * - 啟動新程序 (新的執行檔),以 UPGRADE_HANDOFF_ENV 環境變數傳入
+ *   socketpair 的一端
+ * - 在 AF_UNIX SOCK_SEQPACKET 上交換固定格式的訊息,fd 以 SCM_RIGHTS 傳遞
+ *
+ * 交接流程 (SIGUSR2 觸發):
+ * @code
+ * 舊程序                              新程序
+ * upgrade_handoff_spawn()  ------->   upgrade_handoff_inherited()
+ *                          <-------   HELLO (初始化完成)
+ * 凍結並匯出狀態
+ *                          ------->   STATE (upgrade_state_t + fd)
+ *                                     接手 socket 並開始服務
+ *                          <-------   READY (或 ABORT)
+ * 關閉自己的 fd 並結束                 繼續服務
+ * @endcode
+ *
+ * 任何一步失敗或逾時,舊程序解除凍結並繼續服務,新程序結束。
+ * 兩個執行檔必須使用相同的 UPGRADE_HANDOFF_VERSION,否則 HELLO 即被拒絕。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-04
+ * @version 1.0.0
+ */
+
+#ifndef UPGRADE_HANDOFF_H
+#define UPGRADE_HANDOFF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include "server_state_machine.h"
+#include "cec_monitor.h"
+#include "ps5_detector.h"
+#include "websocket_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 新程序繼承的交接 fd (十進位) */
+#define UPGRADE_HANDOFF_ENV             "GAMING_SERVER_UPGRADE_FD"
+
+/** 訊息標頭 magic ("GSUP") */
+#define UPGRADE_HANDOFF_MAGIC           0x50555347u
+
+/** 交接格式版本 (upgrade_state_t 或 ws_server_handoff_t 改變時遞增) */
+#define UPGRADE_HANDOFF_VERSION         2
+
+/** 等待新程序初始化 (HELLO) 的時間 */
+#define UPGRADE_HELLO_TIMEOUT_MS        5000
+
+/** 等待新程序接手 (READY) 的時間 */
+#define UPGRADE_READY_TIMEOUT_MS        3000
+
+/** 等待舊程序匯出狀態 (STATE) 的時間 */
+#define UPGRADE_STATE_TIMEOUT_MS        3000
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 訊息類型
+ */
+typedef enum {
+    UPGRADE_MSG_HELLO = 1,          /**< 新程序 -> 舊程序: 已初始化 */
+    UPGRADE_MSG_STATE,              /**< 舊程序 -> 新程序: upgrade_state_t + fd */
+    UPGRADE_MSG_READY,              /**< 新程序 -> 舊程序: 已接手 */
+    UPGRADE_MSG_ABORT               /**< 任一方: 放棄交接 */
+} upgrade_msg_type_t;
+
+/**
+ * @brief 交接給新程序的狀態
+ */
+typedef struct {
+    ps5_power_state_t cec_power;    /**< CEC 最後回報的電源狀態 */
+    time_t cec_update_time;         /**< 回報時間 */
+    ps5_info_t ps5_info;            /**< 偵測快取 */
+    time_t ps5_cache_time;          /**< 快取時間 (0 = 空) */
+    server_sm_snapshot_t sm;        /**< 狀態機 */
+    uint64_t status_version;        /**< 狀態快照版本 */
+    uint32_t wake_requests;         /**< 累計喚醒請求次數 */
+    ws_server_handoff_t ws;         /**< listen socket 與連線 */
+} upgrade_state_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 啟動新程序並建立交接通道
+ *
+ * 新程序以相同的命令列參數執行 path,交接 fd 透過 UPGRADE_HANDOFF_ENV 傳入。
+ *
+ * @param path 新的執行檔
+ * @param argv 命令列參數 (argv[0] 起, NULL 結尾)
+ * @param pid 輸出新程序的 PID
+ * @return 本程序端的交接 fd (非阻塞), -1 失敗
+ */
+int upgrade_handoff_spawn(const char *path, char *const argv[], pid_t *pid);
+
+/**
+ * @brief 取得繼承的交接 fd (新程序)
+ *
+ * 讀取後清除 UPGRADE_HANDOFF_ENV,之後再啟動的程序不會誤用。
+ *
+ * @return 交接 fd, -1 不是以升級方式啟動
+ */
+int upgrade_handoff_inherited(void);
+
+/**
+ * @brief 傳送訊息
+ *
+ * @param payload 內容 (可為 NULL)
+ * @param fds 一併傳送的 fd (可為 NULL)
+ * @return 0 成功, -1 失敗
+ */
+int upgrade_handoff_send(int fd, upgrade_msg_type_t type, const void *payload, size_t len,
+                         const int *fds, int fd_count);
+
+/**
+ * @brief 接收指定類型的訊息
+ *
+ * 內容長度必須等於 len;收到的 fd 已設定 close-on-exec,
+ * 不符合時 (類型、長度、版本) 會關閉收到的 fd。
+ *
+ * @param fds 接收 fd 的陣列 (可為 NULL)
+ * @param fd_count 輸出收到的 fd 數量
+ * @param timeout_ms 等待時間 (0 = 不等待)
+ * @return 1 收到, 0 逾時, -1 錯誤、對方關閉或 ABORT
+ */
+int upgrade_handoff_recv(int fd, upgrade_msg_type_t type, void *payload, size_t len,
+                         int *fds, int max_fds, int *fd_count, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPGRADE_HANDOFF_H */
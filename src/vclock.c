@@ -0,0 +1,372 @@
+/**
+ * @file vclock.c
+ * @brief Virtual Clock Implementation
+ *
+ * 讀取時間是熱路徑 (metrics、trace),只有一次 atomic 載入判斷模式,
+ * 真實時鐘下直接呼叫 clock_gettime (vDSO)。
+ *
+ * 睡眠與定時器共用一組 mutex/condvar: 真實時鐘以 CLOCK_MONOTONIC 的
+ * pthread_cond_timedwait 等待,模擬時鐘則等待 vclock_advance() 廣播。
+ * 世代計數 (wake_generation) 讓 vclock_wake_sleepers() 能一次喚醒
+ * 所有睡眠者,停止執行緒時不必等完整的輪詢間隔。
+ *
+ * 定時器回調一律在鎖外執行,回調內可再次排程或取消。
+ *
+ * @version 1.0.0
+ * @date 2025-12-02
+ */
+
+#include "vclock.h"
+
+#include <string.h>
+#include <pthread.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 模擬時鐘的單調時間起點 (避開以 0 表示「從未」的欄位) */
+#define VCLOCK_SIM_START_NS     1000000000ULL
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef struct {
+    int id;                     // 0 表示空槽
+    uint64_t deadline_ns;
+    vclock_timer_fn fn;
+    void *arg;
+} vclock_timer_t;
+
+typedef struct {
+    bool simulated;
+    bool auto_advance;          // 模擬睡眠直接推進時間
+    uint64_t sim_now_ns;        // 模擬的單調時間
+    int64_t sim_offset_ns;      // 模擬的牆上時間 - 單調時間
+
+    pthread_once_t once;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint64_t wake_generation;
+    int sleepers;               // 阻塞在 vclock_sleep_us 的執行緒數
+
+    vclock_timer_t timers[VCLOCK_MAX_TIMERS];
+    int next_id;
+} vclock_context_t;
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+static vclock_context_t g_vclock = {
+    .simulated = false,
+    .once = PTHREAD_ONCE_INIT,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .next_id = 1,
+};
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 建立使用 CLOCK_MONOTONIC 的 condvar (只執行一次)
+ */
+static void init_cond(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_vclock.cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void lock_clock(void) {
+    pthread_once(&g_vclock.once, init_cond);
+    pthread_mutex_lock(&g_vclock.mutex);
+}
+
+/**
+ * @brief 目前時間 (呼叫時持有 mutex)
+ */
+static uint64_t now_locked(void) {
+    return g_vclock.simulated ? g_vclock.sim_now_ns : clock_ns(CLOCK_MONOTONIC);
+}
+
+/**
+ * @brief 取出最早到期 (<= limit_ns) 的定時器 (呼叫時持有 mutex)
+ *
+ * @return true 取出一個 (槽位已釋放), false 沒有到期的
+ */
+static bool take_due_timer(uint64_t limit_ns, vclock_timer_t *out) {
+    vclock_timer_t *earliest = NULL;
+
+    for (int i = 0; i < VCLOCK_MAX_TIMERS; i++) {
+        vclock_timer_t *timer = &g_vclock.timers[i];
+        if (timer->id != 0 && timer->deadline_ns <= limit_ns &&
+            (earliest == NULL || timer->deadline_ns < earliest->deadline_ns)) {
+            earliest = timer;
+        }
+    }
+
+    if (earliest == NULL) {
+        return false;
+    }
+
+    *out = *earliest;
+    earliest->id = 0;
+    return true;
+}
+
+/* ============================================================
+ *  Public API Implementation - Time
+ * ============================================================ */
+
+uint64_t vclock_now_ns(void) {
+    if (__atomic_load_n(&g_vclock.simulated, __ATOMIC_ACQUIRE)) {
+        return __atomic_load_n(&g_vclock.sim_now_ns, __ATOMIC_ACQUIRE);
+    }
+    return clock_ns(CLOCK_MONOTONIC);
+}
+
+uint64_t vclock_now_us(void) {
+    return vclock_now_ns() / 1000ULL;
+}
+
+uint64_t vclock_now_ms(void) {
+    return vclock_now_ns() / 1000000ULL;
+}
+
+time_t vclock_time(void) {
+    if (__atomic_load_n(&g_vclock.simulated, __ATOMIC_ACQUIRE)) {
+        int64_t wall_ns = (int64_t)__atomic_load_n(&g_vclock.sim_now_ns, __ATOMIC_ACQUIRE) +
+                          __atomic_load_n(&g_vclock.sim_offset_ns, __ATOMIC_RELAXED);
+        return (time_t)(wall_ns / 1000000000LL);
+    }
+    return time(NULL);
+}
+
+int64_t vclock_realtime_offset_ns(void) {
+    if (__atomic_load_n(&g_vclock.simulated, __ATOMIC_ACQUIRE)) {
+        return __atomic_load_n(&g_vclock.sim_offset_ns, __ATOMIC_RELAXED);
+    }
+    return (int64_t)(clock_ns(CLOCK_REALTIME) - clock_ns(CLOCK_MONOTONIC));
+}
+
+/* ============================================================
+ *  Public API Implementation - Sleep
+ * ============================================================ */
+
+int vclock_sleep_us(uint64_t us) {
+    lock_clock();
+
+    uint64_t generation = g_vclock.wake_generation;
+    uint64_t deadline_ns = now_locked() + us * 1000ULL;
+
+    if (g_vclock.simulated && g_vclock.auto_advance) {
+        pthread_mutex_unlock(&g_vclock.mutex);
+        vclock_advance_to(deadline_ns / 1000ULL);
+        return 0;
+    }
+
+    g_vclock.sleepers++;
+    while (g_vclock.wake_generation == generation && now_locked() < deadline_ns) {
+        if (g_vclock.simulated) {
+            pthread_cond_wait(&g_vclock.cond, &g_vclock.mutex);
+        } else {
+            struct timespec ts = {
+                .tv_sec = (time_t)(deadline_ns / 1000000000ULL),
+                .tv_nsec = (long)(deadline_ns % 1000000000ULL),
+            };
+            pthread_cond_timedwait(&g_vclock.cond, &g_vclock.mutex, &ts);
+        }
+    }
+
+    g_vclock.sleepers--;
+    int interrupted = (g_vclock.wake_generation != generation) ? 1 : 0;
+    pthread_mutex_unlock(&g_vclock.mutex);
+    return interrupted;
+}
+
+void vclock_wake_sleepers(void) {
+    lock_clock();
+    g_vclock.wake_generation++;
+    pthread_cond_broadcast(&g_vclock.cond);
+    pthread_mutex_unlock(&g_vclock.mutex);
+}
+
+/* ============================================================
+ *  Public API Implementation - Timers
+ * ============================================================ */
+
+int vclock_schedule(uint64_t delay_us, vclock_timer_fn fn, void *arg) {
+    if (fn == NULL) {
+        return -1;
+    }
+
+    lock_clock();
+
+    int timer_id = -1;
+    for (int i = 0; i < VCLOCK_MAX_TIMERS; i++) {
+        vclock_timer_t *timer = &g_vclock.timers[i];
+        if (timer->id == 0) {
+            timer_id = g_vclock.next_id++;
+            if (g_vclock.next_id <= 0) {
+                g_vclock.next_id = 1;
+            }
+            timer->id = timer_id;
+            timer->deadline_ns = now_locked() + delay_us * 1000ULL;
+            timer->fn = fn;
+            timer->arg = arg;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&g_vclock.mutex);
+    return timer_id;
+}
+
+int vclock_cancel(int timer_id) {
+    if (timer_id <= 0) {
+        return -1;
+    }
+
+    lock_clock();
+
+    int rc = -1;
+    for (int i = 0; i < VCLOCK_MAX_TIMERS; i++) {
+        if (g_vclock.timers[i].id == timer_id) {
+            g_vclock.timers[i].id = 0;
+            rc = 0;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&g_vclock.mutex);
+    return rc;
+}
+
+int vclock_run_due(void) {
+    int fired = 0;
+    vclock_timer_t timer;
+
+    lock_clock();
+    uint64_t now_ns = now_locked();
+
+    // 只觸發呼叫時已到期的定時器,回調內新排的 0 延遲定時器留到下次
+    while (take_due_timer(now_ns, &timer)) {
+        pthread_mutex_unlock(&g_vclock.mutex);
+        timer.fn(timer.arg);
+        fired++;
+        pthread_mutex_lock(&g_vclock.mutex);
+    }
+
+    pthread_mutex_unlock(&g_vclock.mutex);
+    return fired;
+}
+
+int64_t vclock_next_timeout_us(void) {
+    lock_clock();
+
+    uint64_t now_ns = now_locked();
+    int64_t timeout_us = -1;
+
+    for (int i = 0; i < VCLOCK_MAX_TIMERS; i++) {
+        const vclock_timer_t *timer = &g_vclock.timers[i];
+        if (timer->id == 0) {
+            continue;
+        }
+        int64_t remaining = (timer->deadline_ns > now_ns)
+                          ? (int64_t)((timer->deadline_ns - now_ns + 999ULL) / 1000ULL)
+                          : 0;
+        if (timeout_us < 0 || remaining < timeout_us) {
+            timeout_us = remaining;
+        }
+    }
+
+    pthread_mutex_unlock(&g_vclock.mutex);
+    return timeout_us;
+}
+
+/* ============================================================
+ *  Public API Implementation - Simulation
+ * ============================================================ */
+
+void vclock_use_simulated(time_t start_realtime) {
+    lock_clock();
+
+    if (start_realtime == 0) {
+        start_realtime = time(NULL);
+    }
+
+    memset(g_vclock.timers, 0, sizeof(g_vclock.timers));
+    __atomic_store_n(&g_vclock.sim_now_ns, VCLOCK_SIM_START_NS, __ATOMIC_RELEASE);
+    __atomic_store_n(&g_vclock.sim_offset_ns,
+                     (int64_t)start_realtime * 1000000000LL - (int64_t)VCLOCK_SIM_START_NS,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&g_vclock.simulated, true, __ATOMIC_RELEASE);
+
+    // 真實時鐘下的睡眠者改為等待模擬時間
+    pthread_cond_broadcast(&g_vclock.cond);
+    pthread_mutex_unlock(&g_vclock.mutex);
+}
+
+void vclock_set_auto_advance(bool enable) {
+    lock_clock();
+    g_vclock.auto_advance = enable;
+    pthread_mutex_unlock(&g_vclock.mutex);
+}
+
+bool vclock_is_simulated(void) {
+    return __atomic_load_n(&g_vclock.simulated, __ATOMIC_ACQUIRE);
+}
+
+int vclock_sleepers(void) {
+    lock_clock();
+    int count = g_vclock.sleepers;
+    pthread_mutex_unlock(&g_vclock.mutex);
+    return count;
+}
+
+void vclock_advance(uint64_t us) {
+    if (!vclock_is_simulated()) {
+        return;
+    }
+    vclock_advance_to(vclock_now_us() + us);
+}
+
+void vclock_advance_to(uint64_t now_us) {
+    lock_clock();
+
+    if (!g_vclock.simulated) {
+        pthread_mutex_unlock(&g_vclock.mutex);
+        return;
+    }
+
+    uint64_t target_ns = now_us * 1000ULL;
+    vclock_timer_t timer;
+
+    // 逐一停在每個到期時間,回調看到的是自己的到期時間
+    while (take_due_timer(target_ns, &timer)) {
+        if (timer.deadline_ns > g_vclock.sim_now_ns) {
+            __atomic_store_n(&g_vclock.sim_now_ns, timer.deadline_ns, __ATOMIC_RELEASE);
+            pthread_cond_broadcast(&g_vclock.cond);
+        }
+        pthread_mutex_unlock(&g_vclock.mutex);
+        timer.fn(timer.arg);
+        pthread_mutex_lock(&g_vclock.mutex);
+    }
+
+    if (target_ns > g_vclock.sim_now_ns) {
+        __atomic_store_n(&g_vclock.sim_now_ns, target_ns, __ATOMIC_RELEASE);
+    }
+    pthread_cond_broadcast(&g_vclock.cond);
+
+    pthread_mutex_unlock(&g_vclock.mutex);
+}
@@ -0,0 +1,177 @@
+/**
+ * @file vclock.h
+ * @brief Virtual Clock - 可替換的時鐘與定時器介面
+ *
+ * 此模組提供:
+ * - 單調時間 (vclock_now_us) 與牆上時間 (vclock_time),取代各模組
+ *   直接呼叫的 clock_gettime()/time(NULL)
+ * - 可中斷的睡眠 (vclock_sleep_us),取代 usleep()
+ * - 單次定時器 (vclock_schedule/vclock_cancel),到期後由
+ *   vclock_run_due() 在呼叫者的執行緒觸發
+ *
+ * 兩種實作:
+ * - 真實時鐘 (預設): CLOCK_MONOTONIC / CLOCK_REALTIME
+ * - 模擬時鐘 (vclock_use_simulated): 時間只在 vclock_advance() 時前進,
+ *   途中依序觸發到期的定時器並喚醒睡眠中的執行緒,幾小時的逾時、
+ *   重試與輪詢可以瞬間跑完且每次結果相同
+ *
+ * 模擬時鐘下的睡眠預設阻塞到其他執行緒推進時間;單執行緒的測試
+ * (例如同步的喚醒重試) 可開啟 auto_advance,讓睡眠直接把時間推進到期限。
+ *
+ * 使用範例:
+ * @code
+ * vclock_use_simulated(0);
+ * int id = vclock_schedule(10 * VCLOCK_US_PER_SEC, on_stats_timer, NULL);
+ * vclock_advance(10 * VCLOCK_US_PER_SEC);    // 立即觸發 on_stats_timer
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-02
+ * @version 1.0.0
+ */
+
+#ifndef VCLOCK_H
+#define VCLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define VCLOCK_US_PER_MS            1000ULL
+#define VCLOCK_US_PER_SEC           1000000ULL
+
+/** 同時存在的定時器上限 */
+#define VCLOCK_MAX_TIMERS           16
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 定時器回調 (由 vclock_run_due 或 vclock_advance 的呼叫者執行)
+ */
+typedef void (*vclock_timer_fn)(void *arg);
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 單調時間 (奈秒)
+ */
+uint64_t vclock_now_ns(void);
+
+/**
+ * @brief 單調時間 (微秒)
+ */
+uint64_t vclock_now_us(void);
+
+/**
+ * @brief 單調時間 (毫秒)
+ */
+uint64_t vclock_now_ms(void);
+
+/**
+ * @brief 牆上時間 (秒),取代 time(NULL)
+ */
+time_t vclock_time(void);
+
+/**
+ * @brief 牆上時間減單調時間 (奈秒),用於換算記錄中的時間
+ */
+int64_t vclock_realtime_offset_ns(void);
+
+/**
+ * @brief 睡眠指定時間
+ *
+ * 模擬時鐘下會一直阻塞到其他執行緒以 vclock_advance() 推進時間;
+ * 開啟 auto_advance 時則直接推進到期限並立即返回。
+ *
+ * @return 0 睡滿, 1 被 vclock_wake_sleepers() 提前喚醒
+ */
+int vclock_sleep_us(uint64_t us);
+
+/**
+ * @brief 喚醒所有睡眠中的執行緒 (停止背景執行緒時使用)
+ */
+void vclock_wake_sleepers(void);
+
+/**
+ * @brief 排程單次定時器
+ *
+ * @return 定時器 ID (> 0), -1 參數錯誤或定時器已滿
+ */
+int vclock_schedule(uint64_t delay_us, vclock_timer_fn fn, void *arg);
+
+/**
+ * @brief 取消定時器
+ *
+ * @return 0 成功, -1 不存在或已觸發
+ */
+int vclock_cancel(int timer_id);
+
+/**
+ * @brief 觸發所有已到期的定時器 (依到期順序)
+ *
+ * @return 觸發的數量
+ */
+int vclock_run_due(void);
+
+/**
+ * @brief 距離下一個定時器到期的時間
+ *
+ * @return 微秒 (已到期為 0), -1 沒有定時器
+ */
+int64_t vclock_next_timeout_us(void);
+
+/**
+ * @brief 切換為模擬時鐘 (清除所有定時器)
+ *
+ * @param start_realtime 模擬的牆上時間起點 (0 表示使用目前時間)
+ */
+void vclock_use_simulated(time_t start_realtime);
+
+/**
+ * @brief 模擬時鐘下睡眠是否自行推進時間 (預設關閉)
+ */
+void vclock_set_auto_advance(bool enable);
+
+/**
+ * @brief 是否使用模擬時鐘
+ */
+bool vclock_is_simulated(void);
+
+/**
+ * @brief 目前阻塞在 vclock_sleep_us() 的執行緒數
+ *
+ * 測試在推進模擬時鐘前確認背景執行緒已進入睡眠,
+ * 睡眠期限才會從預期的時間起算。
+ */
+int vclock_sleepers(void);
+
+/**
+ * @brief 推進模擬時鐘 (真實時鐘下無作用)
+ *
+ * 時間逐一推進到每個到期的定時器並在呼叫者執行緒觸發,
+ * 最後停在 now + us 並喚醒期限已到的睡眠者。
+ */
+void vclock_advance(uint64_t us);
+
+/**
+ * @brief 將模擬時鐘推進到指定的單調時間 (不會倒退)
+ */
+void vclock_advance_to(uint64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VCLOCK_H */
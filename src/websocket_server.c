@@ -1,25 +1,161 @@
 /**
  * @file websocket_server.c
  * @brief WebSocket Server Implementation
- * 
- * 注意: 此為簡化版實作,用於測試環境
- * 生產環境應使用 libwebsockets 實作完整功能
+ *
+ * 生產環境: 內建 epoll 傳輸層 (RFC 6455 握手與訊框),
+ *           支援 permessage-deflate (RFC 7692) 與 gaming.v1.cbor 子協定
+ * 測試環境 (TESTING): 不開啟 socket,以 ws_server_test_* 模擬客戶端
+ *
+ * 客戶端分散在一個或多個 worker (shard) 中,每個 worker 有自己的
+ * listen socket (SO_REUSEPORT)、epoll、keepalive 時間輪、lock 與緩衝區。
+ * 單一 worker 時由 ws_server_service() 直接服務;多個 worker 時各自
+ * 在獨立執行緒中運行,以 lock-free 佇列與擁有者執行緒交換訊息。
+ *
+ * 定義 WS_USE_IO_URING 時,worker 優先使用 io_uring 取代 epoll
+ * (multishot accept/recv、provided buffer ring、批次提交 send);
+ * 核心不支援時自動退回 epoll。
+ *
+ * 本機 IPC: worker 0 另外監聽 AF_UNIX SOCK_SEQPACKET socket,每個封包即
+ * 一則 JSON 訊息 (無 HTTP 握手、訊框與 mask),與 WebSocket 客戶端共用
+ * 訊息分派、速率限制與訂閱。
+ *
+ * HTTP 端點 (ws_http.h): 同一個端口上不升級的 GET 請求提供狀態快照、
+ * SSE 與長輪詢,回應在狀態變更時預先組裝一次,由同一個事件迴圈送出;
+ * GET /metrics 輸出 metrics.h 的 Prometheus 指標。
+ *
+ * 平滑升級: ws_server_export() 凍結 worker 後匯出 listen socket 與閒置客戶端,
+ * 新程序以 ws_server_adopt() 接收,ws_server_start() 時放回原本的 worker。
+ * 凍結期間到達的資料留在核心的 socket 緩衝區,由新程序讀取。
+ *
+ * 注意: 不支援分段訊息 (fragmentation),訊息大小上限為
+ *       WS_SERVER_MAX_MESSAGE_SIZE
  */
 
-// POSIX headers for strncmp and other functions
-#define _POSIX_C_SOURCE 200809L
+// GNU extensions for accept4()
+#define _GNU_SOURCE
 
 #include "websocket_server.h"
+#include "ws_frame.h"
+#include "ws_handshake.h"
+#include "ws_deflate.h"
+#include "ws_cbor.h"
+#include "ws_http.h"
+#include "metrics.h"
+#include "trace_ring.h"
+#include "vclock.h"
+#include "timer_wheel.h"
+#include "mpsc_queue.h"
+#include "token_bucket.h"
+#include "json_writer.h"
+#include "ws_uring.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
 #include <cjson/cJSON.h>
 
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 接收緩衝區 (一個完整訊框) */
+#define WS_RX_BUFFER_SIZE       (WS_SERVER_MAX_MESSAGE_SIZE + 16)
+
+/** 傳送緩衝區 (socket 寫不完時暫存) */
+#define WS_TX_BUFFER_SIZE       16384
+
+/** 訊框緩衝區 (標頭 + payload) */
+#define WS_FRAME_BUFFER_SIZE    (WS_FRAME_MAX_HEADER + WS_SERVER_MAX_MESSAGE_SIZE)
+
+/**
+ * listen backlog: 重連風暴時所有客戶端同時連線,佇列容不下的連線
+ * 要等 SYN 重傳 (200 ms - 1 s) 才能建立,因此至少容納 WS_SERVER_MAX_CLIENTS
+ */
+#define WS_LISTEN_BACKLOG       (WS_SERVER_MAX_CLIENTS > 64 ? WS_SERVER_MAX_CLIENTS : 64)
+#define WS_MAX_EVENTS           16
+
+/** 每次 listen 事件最多接受的連線數 (其餘由下一次事件處理) */
+#define WS_ACCEPT_BATCH         32
+
+/** 來源 IP 速率限制表的大小與探測範圍 */
+#define WS_ACCEPT_LIMIT_SLOTS   64
+#define WS_ACCEPT_LIMIT_PROBE   4
+
+/** epoll data 中代表 listen socket / timerfd / 佇列 eventfd 的值 */
+#define WS_LISTEN_TAG           UINT32_MAX
+#define WS_TIMER_TAG            (UINT32_MAX - 1)
+#define WS_QUEUE_TAG            (UINT32_MAX - 2)
+#define WS_LOCAL_TAG            (UINT32_MAX - 3)
+
+/** keepalive 時間輪的 tick (毫秒) */
+#define WS_KEEPALIVE_TICK_MS    100
+
+/** 每個 worker 待發送訊息佇列的容量 */
+#define WS_WORKER_QUEUE_SIZE    256
+
+/** 交給擁有者執行緒的事件佇列容量 */
+#define WS_EVENT_QUEUE_SIZE     1024
+
+/** worker 執行緒檢查停止旗標的間隔 (毫秒) */
+#define WS_WORKER_POLL_MS       1000
+
+#ifdef WS_USE_IO_URING
+/** 每個 worker 的 io_uring SQ 大小 (CQ 為 4 倍) */
+#define WS_URING_ENTRIES        256
+
+/** multishot recv 使用的 provided buffer ring */
+#define WS_URING_BUFFER_GROUP   0
+#define WS_URING_BUFFER_COUNT   64
+#define WS_URING_BUFFER_SIZE    4096
+
+/** 凍結時等待 accept 取消完成的時間 (毫秒) */
+#define WS_URING_CANCEL_WAIT_MS 100
+#endif
+
 /* ============================================================
  *  Internal Structures
  * ============================================================ */
 
+typedef struct ws_worker ws_worker_t;
+
+#ifdef WS_USE_IO_URING
+/**
+ * @brief io_uring 請求類型 (user_data 的低 8 位元)
+ */
+typedef enum {
+    WS_URING_OP_ACCEPT = 1,
+    WS_URING_OP_RECV,
+    WS_URING_OP_SEND,
+    WS_URING_OP_TIMER,
+    WS_URING_OP_QUEUE,
+    WS_URING_OP_LOCAL_ACCEPT,
+    WS_URING_OP_POLL,
+    WS_URING_OP_CANCEL,
+} ws_uring_op_t;
+#endif
+
+/**
+ * @brief 未升級為 WebSocket 的 HTTP 連線狀態
+ */
+typedef enum {
+    WS_HTTP_IDLE = 0,        // 等待請求 (WebSocket 握手或 HTTP 端點)
+    WS_HTTP_STREAMING,       // GET /events
+    WS_HTTP_WAITING,         // GET /status?version=N 等待版本變更
+} ws_http_mode_t;
+
 /**
  * @brief 客戶端連線結構
  */
@@ -28,26 +164,193 @@ typedef struct {
     char ip[16];
     uint16_t port;
     time_t connect_time;
-    bool active;
-    void *ws_handle;  // libwebsockets wsi pointer (生產環境用)
+    bool active;             // 槽位使用中
+    bool upgraded;           // 已完成 WebSocket 握手
+    bool local;              // 本機 IPC (SOCK_SEQPACKET), 沒有握手與訊框
+    uint32_t subscriptions;  // 訂閱主題 bitmask
+    ws_encoding_t encoding;  // 協商的訊息編碼
+    int in_flight;           // 處理中的非同步請求數
+    token_bucket_t rate_buckets[WS_SERVER_RATE_LIMIT_TYPES];  // 依訊息類型的速率
+
+    // HTTP 端點
+    ws_http_mode_t http;
+    bool http_close;         // 回應後關閉 (Connection: close)
+    uint64_t http_version;   // 客戶端已收到 (長輪詢: 已知) 的版本
+
+    ws_worker_t *worker;     // 所屬 worker
+    int fd;                  // socket, -1 表示測試用虛擬連線
+    bool want_write;         // 已註冊 EPOLLOUT
+#ifdef WS_USE_IO_URING
+    bool tx_inflight;        // 已提交 send 請求,tx_buf 前段由核心讀取中
+#endif
+
+    // Keepalive
+    tw_timer_t keepalive;    // 握手逾時 / ping / pong 逾時
+    uint64_t last_rx_ms;     // 最後收到資料的時間 (CLOCK_MONOTONIC)
+    uint64_t ping_sent_ms;   // 送出 ping 的時間, 0 表示未等待 pong
+
+    // 接收
+    uint8_t rx_buf[WS_RX_BUFFER_SIZE];
+    size_t rx_len;
+
+    // 傳送
+    uint8_t tx_buf[WS_TX_BUFFER_SIZE];
+    size_t tx_len;
+
+    // permessage-deflate
+    ws_deflate_params_t deflate;
+    ws_inflater_t *inflater;
 } client_connection_t;
 
+/**
+ * @brief 來源 IP 的連線速率
+ */
+typedef struct {
+    uint32_t addr;           // IPv4 (network order), 0 表示空
+    token_bucket_t bucket;
+} ws_accept_limit_t;
+
+/**
+ * @brief Worker (一組客戶端與服務它們的 I/O 資源)
+ */
+struct ws_worker {
+    int index;
+
+    // Socket
+    int listen_fd;
+    int epoll_fd;
+    int timer_fd;
+    int queue_fd;            // eventfd: inbound 有新訊息
+    int local_fd;            // 本機 IPC listen socket (只有 worker 0)
+    int pending_listen_fd;   // ws_server_set_port() 建立、待 worker 換上的 listen socket
+
+#ifdef WS_USE_IO_URING
+    // io_uring 後端 (use_ring 為 false 時使用 epoll)
+    ws_uring_t ring;
+    bool use_ring;
+#endif
+
+    // 所有連線的 keepalive 計時器
+    timer_wheel_t timers;
+
+    // 已推送給 SSE / 長輪詢客戶端的 HTTP 狀態版本
+    uint64_t http_version;
+
+    // 來源 IP 連線速率 (每個 worker 各自計算)
+    ws_accept_limit_t accept_limits[WS_ACCEPT_LIMIT_SLOTS];
+
+    // 客戶端表可能被其他執行緒 (CEC 監控回調、擁有者執行緒) 存取
+    pthread_mutex_t lock;
+
+    // 客戶端管理 (ID = seq * worker_count + index + 1)
+    client_connection_t clients[WS_SERVER_MAX_CLIENTS];
+    int next_seq;
+
+    // 多 worker 模式
+    pthread_t thread;
+    bool threaded;           // 由獨立執行緒服務,回調交給擁有者執行緒
+    mpsc_queue_t inbound;    // 待發送的 ws_outbound_t
+
+    // 訊框組裝緩衝區 (持有 lock 時使用)
+    uint8_t frame_buf[WS_FRAME_BUFFER_SIZE];
+    uint8_t deflate_frame_buf[WS_FRAME_BUFFER_SIZE];
+
+    // 收到的訊息 (解壓縮/加上 '\0' 後)
+    char message_buf[WS_SERVER_MAX_MESSAGE_SIZE + 1];
+
+    // CBOR 訊息 (轉碼前後)
+    uint8_t cbor_buf[WS_SERVER_MAX_MESSAGE_SIZE];
+
+    // GET /metrics 輸出 (持有 lock 時使用)
+    char metrics_buf[METRICS_RENDER_MAX];
+};
+
+/**
+ * @brief 排入 worker 佇列的外送訊息 (所有 worker 共用一份)
+ */
+typedef struct {
+    int refs;                // 尚未處理的 worker 數
+    int client_id;           // >0 表示單一客戶端, 否則依 topics 發佈
+    uint32_t topics;         // 0 表示所有客戶端
+    const uint8_t *cbor;     // 指向 data 內, NULL 表示由 worker 轉碼
+    size_t cbor_len;
+    char json[];             // JSON 文字 (後接 CBOR)
+} ws_outbound_t;
+
+/**
+ * @brief HTTP 端點的預先組裝回應 (發佈後不可修改,以參考計數共用)
+ */
+typedef struct {
+    int refs;
+    uint64_t version;
+    const char *response;    // 200 OK + JSON
+    size_t response_len;
+    const char *not_modified;  // 304 Not Modified
+    size_t not_modified_len;
+    const char *event;       // SSE 事件
+    size_t event_len;
+    char data[];
+} ws_http_status_t;
+
+/**
+ * @brief worker 交給擁有者執行緒的事件類型
+ */
+typedef enum {
+    WS_EVENT_CONNECT = 0,
+    WS_EVENT_DISCONNECT,
+    WS_EVENT_MESSAGE,
+} ws_event_kind_t;
+
+/**
+ * @brief worker 交給擁有者執行緒的事件
+ */
+typedef struct {
+    ws_event_kind_t kind;
+    int client_id;
+    ws_message_type_t msg_type;
+    char ip[16];
+    char message[];          // WS_EVENT_MESSAGE 的 JSON 文字
+} ws_event_t;
+
 /**
  * @brief WebSocket Server 上下文
  */
 typedef struct {
     // 配置
     int port;
-    
-    // 狀態
+    char local_path[WS_SERVER_LOCAL_PATH_MAX];  // 空字串表示不監聽本機 IPC
+
+    // 狀態 (worker 執行緒以 __atomic 讀取)
     ws_server_state_t state;
     bool initialized;
-    
-    // 客戶端管理
-    client_connection_t clients[WS_SERVER_MAX_CLIENTS];
-    int client_count;
-    int next_client_id;
-    
+
+    // Worker
+    ws_worker_t *workers;
+    int worker_count;
+
+    // 計數 (各 worker 以 __atomic 更新)
+    int client_count;        // 已完成握手的連線
+    int connection_count;    // 使用中的槽位 (含握手中)
+
+    // 擁有者執行緒的事件佇列
+    mpsc_queue_t events;
+    int event_fd;
+    int wake_fd;             // ws_server_wake() 寫入的 eventfd (-1 = 未執行, atomic)
+
+    // HTTP 端點的目前回應 (http_lock 保護指標, http_version 以 __atomic 讀取)
+    pthread_mutex_t http_lock;
+    ws_http_status_t *http_status;
+    uint64_t http_version;
+
+    // 訊息速率限制 (各執行緒以 __atomic 存取)
+    ws_rate_limit_t rate_limits[WS_SERVER_RATE_LIMIT_TYPES];
+    ws_rate_limit_stats_t rate_stats[WS_SERVER_RATE_LIMIT_TYPES];
+
+    // 平滑升級
+    bool handed_off;         // fd 已交給新程序: 不移除本機 socket 檔案
+    ws_server_handoff_t *adopted;   // ws_server_adopt() 接收、ws_server_start() 放回的客戶端
+    int adopted_fds[WS_SERVER_MAX_CLIENTS];
+
     // 回調
     ws_message_handler_t message_handler;
     void *message_handler_data;
@@ -55,14 +358,39 @@ typedef struct {
     void *connect_callback_data;
     ws_disconnect_callback_t disconnect_callback;
     void *disconnect_callback_data;
-    
+
 } ws_server_context_t;
 
 /* ============================================================
  *  Static Variables
  * ============================================================ */
 
-static ws_server_context_t g_server_ctx = {0};
+static ws_server_context_t g_server_ctx = { .wake_fd = -1 };
+
+/**
+ * 預設速率限制
+ * - wake_ps5 每次都會送出 CEC 命令,限制最嚴
+ * - query_ps5 讀取快照,允許客戶端畫面刷新時連續查詢
+ */
+static const ws_rate_limit_t g_default_rate_limits[WS_SERVER_RATE_LIMIT_TYPES] = {
+    [WS_MSG_UNKNOWN]     = { 5, 10 },
+    [WS_MSG_QUERY_PS5]   = { 10, 20 },
+    [WS_MSG_WAKE_PS5]    = { 1, 3 },
+    [WS_MSG_PING]        = { 5, 10 },
+    [WS_MSG_PONG]        = { 5, 10 },
+    [WS_MSG_SUBSCRIBE]   = { 5, 10 },
+    [WS_MSG_UNSUBSCRIBE] = { 5, 10 },
+    [WS_MSG_DEBUG_DUMP]  = { 10, 64 },
+    [WS_MSG_SERVER_STATE_HISTORY] = { 5, 10 },
+};
+
+#ifndef TESTING
+/** 支援的子協定 (索引對應 ws_encoding_t) */
+static const char *const g_subprotocols[] = {
+    WS_SUBPROTOCOL_JSON,
+    WS_SUBPROTOCOL_CBOR,
+};
+#endif
 
 /* ============================================================
  *  Internal Helper Functions
@@ -71,9 +399,9 @@ static ws_server_context_t g_server_ctx = {0};
 /**
  * @brief 查找空閒客戶端槽位
  */
-static int find_free_client_slot(void) {
+static int find_free_client_slot(const ws_worker_t *worker) {
     for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
-        if (!g_server_ctx.clients[i].active) {
+        if (!worker->clients[i].active) {
             return i;
         }
     }
@@ -81,18 +409,91 @@ static int find_free_client_slot(void) {
 }
 
 /**
- * @brief 查找客戶端索引
+ * @brief 查找客戶端索引 (僅已完成握手的連線)
  */
-static int find_client_by_id(int client_id) {
+static int find_client_by_id(const ws_worker_t *worker, int client_id) {
     for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
-        if (g_server_ctx.clients[i].active && 
-            g_server_ctx.clients[i].id == client_id) {
+        if (worker->clients[i].active &&
+            worker->clients[i].upgraded &&
+            worker->clients[i].id == client_id) {
             return i;
         }
     }
     return -1;
 }
 
+/**
+ * @brief 取得客戶端所屬的 worker
+ */
+static ws_worker_t* worker_for_client(int client_id) {
+    if (client_id <= 0 || g_server_ctx.workers == NULL) {
+        return NULL;
+    }
+    return &g_server_ctx.workers[(client_id - 1) % g_server_ctx.worker_count];
+}
+
+/**
+ * @brief 配置新的客戶端 ID
+ */
+static int next_client_id(ws_worker_t *worker) {
+    return worker->next_seq++ * g_server_ctx.worker_count + worker->index + 1;
+}
+
+/**
+ * @brief 是否為已建立的 WebSocket 連線
+ */
+static bool is_established(const client_connection_t *client) {
+    return client->active && client->upgraded;
+}
+
+/**
+ * @brief 計算發佈時會收到訊息的客戶端數量
+ *
+ * @param topics 主題 bitmask, 0 表示所有客戶端
+ */
+static int count_subscribers(uint32_t topics) {
+    int count = 0;
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        const ws_worker_t *worker = &g_server_ctx.workers[w];
+        for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+            if (is_established(&worker->clients[i]) &&
+                (topics == 0 || (worker->clients[i].subscriptions & topics) != 0)) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief 是否為多 worker 模式 (I/O 在 worker 執行緒中)
+ */
+static bool is_threaded(void) {
+    return g_server_ctx.worker_count > 1;
+}
+
+/**
+ * @brief 更新 ws_server_wake() 的目標 (state 變更之後呼叫)
+ *
+ * 單一 worker 時擁有者執行緒在 worker 的 epoll 等待,寫入其 queue_fd;
+ * 多 worker 與 TESTING 時等待 event_fd。
+ */
+static void update_wake_fd(void) {
+    int fd = -1;
+
+    if (__atomic_load_n(&g_server_ctx.state, __ATOMIC_ACQUIRE) == WS_SERVER_RUNNING) {
+#ifdef TESTING
+        fd = g_server_ctx.event_fd;
+#else
+        fd = is_threaded() ? g_server_ctx.event_fd : g_server_ctx.workers[0].queue_fd;
+#endif
+    }
+
+    __atomic_store_n(&g_server_ctx.wake_fd, fd, __ATOMIC_RELEASE);
+}
+
 /**
  * @brief 解析 JSON 訊息類型
  */
@@ -100,31 +501,25 @@ static ws_message_type_t parse_message_type(const char *json_str) {
     if (json_str == NULL) {
         return WS_MSG_UNKNOWN;
     }
-    
+
     cJSON *root = cJSON_Parse(json_str);
     if (root == NULL) {
         return WS_MSG_UNKNOWN;
     }
-    
+
     cJSON *type = cJSON_GetObjectItem(root, "type");
     if (!cJSON_IsString(type)) {
         cJSON_Delete(root);
         return WS_MSG_UNKNOWN;
     }
-    
-    ws_message_type_t msg_type = WS_MSG_UNKNOWN;
-    const char *type_str = type->valuestring;
-    
-    if (strncmp(type_str, "query_ps5", 9) == 0) {
-        msg_type = WS_MSG_QUERY_PS5;
-    } else if (strncmp(type_str, "wake_ps5", 8) == 0) {
-        msg_type = WS_MSG_WAKE_PS5;
-    } else if (strncmp(type_str, "ping", 4) == 0) {
-        msg_type = WS_MSG_PING;
-    } else if (strncmp(type_str, "pong", 4) == 0) {
-        msg_type = WS_MSG_PONG;
-    }
-    
+
+    // 與 CBOR 轉碼共用 ws_message_type_from_string() 的名稱表 (完整比對);
+    // 伺服器送出的類型不是請求,與未知名稱相同
+    ws_message_type_t msg_type = ws_message_type_from_string(type->valuestring);
+    if ((unsigned)msg_type >= WS_SERVER_RATE_LIMIT_TYPES) {
+        msg_type = WS_MSG_UNKNOWN;
+    }
+
     cJSON_Delete(root);
     return msg_type;
 }
@@ -140,184 +535,3192 @@ static char* create_response(const char *type, const char *status, const char *m
     if (message) {
         cJSON_AddStringToObject(root, "message", message);
     }
-    cJSON_AddNumberToObject(root, "timestamp", (double)time(NULL));
-    
+    cJSON_AddNumberToObject(root, "timestamp", (double)vclock_time());
+
     char *json_str = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
-    
+
     return json_str;
 }
 
 /* ============================================================
- *  Public Function Implementations
+ *  Internal Helper Functions - Owner Thread Events
  * ============================================================ */
 
 /**
- * @brief 初始化 WebSocket Server
+ * @brief 喚醒等待中的執行緒 (eventfd)
  */
-int ws_server_init(int port) {
-    if (g_server_ctx.initialized) {
-        return -1;  // 已經初始化
+static void signal_fd(int fd) {
+    uint64_t one = 1;
+    if (fd >= 0 && write(fd, &one, sizeof(one)) < 0) {
+        // 計數已達上限時對方必然會醒來,可忽略
     }
-    
-    // 初始化上下文
-    memset(&g_server_ctx, 0, sizeof(ws_server_context_t));
-    
-    g_server_ctx.port = (port > 0) ? port : WS_SERVER_DEFAULT_PORT;
-    g_server_ctx.state = WS_SERVER_STOPPED;
-    g_server_ctx.initialized = true;
-    g_server_ctx.next_client_id = 1;
-    
+}
+
+/**
+ * @brief 將事件交給擁有者執行緒
+ *
+ * 佇列已滿時等待擁有者消化 (停止中則放棄),避免遺失斷線事件
+ */
+static void post_event(ws_event_kind_t kind, const client_connection_t *client,
+                       ws_message_type_t msg_type, const char *message)
+{
+    size_t message_len = message ? strlen(message) : 0;
+    ws_event_t *event = malloc(sizeof(ws_event_t) + message_len + 1);
+    if (event == NULL) {
+        return;
+    }
+
+    event->kind = kind;
+    event->client_id = client->id;
+    event->msg_type = msg_type;
+    memcpy(event->ip, client->ip, sizeof(event->ip));
+    memcpy(event->message, message ? message : "", message_len + 1);
+
+    while (!mpsc_queue_push(&g_server_ctx.events, event)) {
+        if (__atomic_load_n(&g_server_ctx.state, __ATOMIC_ACQUIRE) != WS_SERVER_RUNNING) {
+            free(event);
+            return;
+        }
+        sched_yield();
+    }
+
+    signal_fd(g_server_ctx.event_fd);
+}
+
+/**
+ * @brief 在擁有者執行緒執行所有等待中的回調
+ */
+static void deliver_events(void) {
+    ws_event_t *event;
+
+    while ((event = mpsc_queue_pop(&g_server_ctx.events)) != NULL) {
+        switch (event->kind) {
+            case WS_EVENT_CONNECT:
+                if (g_server_ctx.connect_callback) {
+                    g_server_ctx.connect_callback(event->client_id, event->ip,
+                                                  g_server_ctx.connect_callback_data);
+                }
+                break;
+
+            case WS_EVENT_DISCONNECT:
+                if (g_server_ctx.disconnect_callback) {
+                    g_server_ctx.disconnect_callback(event->client_id,
+                                                     g_server_ctx.disconnect_callback_data);
+                }
+                break;
+
+            case WS_EVENT_MESSAGE:
+                if (g_server_ctx.message_handler) {
+                    uint64_t start_us = metrics_now_us();
+                    char *response = g_server_ctx.message_handler(
+                        event->client_id, event->msg_type, event->message,
+                        g_server_ctx.message_handler_data);
+                    metrics_observe(METRIC_WS_HANDLER_SECONDS, 0,
+                                    metrics_now_us() - start_us);
+                    if (response) {
+                        ws_server_send(event->client_id, response);
+                        free(response);
+                    }
+                }
+                break;
+        }
+
+        free(event);
+    }
+}
+
+#ifndef TESTING
+/**
+ * @brief 通知連線建立
+ */
+static void notify_connect(const client_connection_t *client) {
+    trace_ring_record(TRACE_CLIENT_CONNECT, 0, (uint32_t)client->id, 0);
+
+    if (client->worker->threaded) {
+        post_event(WS_EVENT_CONNECT, client, WS_MSG_UNKNOWN, NULL);
+        return;
+    }
+
+    if (g_server_ctx.connect_callback) {
+        g_server_ctx.connect_callback(client->id, client->ip,
+                                      g_server_ctx.connect_callback_data);
+    }
+}
+#endif
+
+/**
+ * @brief 通知連線中斷
+ */
+static void notify_disconnect(const client_connection_t *client) {
+    trace_ring_record(TRACE_CLIENT_DISCONNECT, 0, (uint32_t)client->id, 0);
+
+    if (client->worker->threaded) {
+        post_event(WS_EVENT_DISCONNECT, client, WS_MSG_UNKNOWN, NULL);
+        return;
+    }
+
+    if (g_server_ctx.disconnect_callback) {
+        g_server_ctx.disconnect_callback(client->id,
+                                         g_server_ctx.disconnect_callback_data);
+    }
+}
+
+/* ============================================================
+ *  Internal Helper Functions - Transport
+ * ============================================================ */
+
+/**
+ * @brief 取得單調遞增時間 (毫秒)
+ */
+static uint64_t monotonic_ms(void) {
+    return vclock_now_ms();
+}
+
+#ifdef WS_USE_IO_URING
+/**
+ * @brief 組合 user_data: 客戶端 ID (高 32 位元)、槽位與請求類型
+ *
+ * 連線關閉後仍可能收到舊請求的 CQE,處理時以 ID 比對後忽略
+ */
+static uint64_t ring_user_data(const client_connection_t *client, ws_uring_op_t op) {
+    if (client == NULL) {
+        return (uint64_t)op;
+    }
+
+    uint32_t slot = (uint32_t)(client - client->worker->clients);
+    return ((uint64_t)(uint32_t)client->id << 32) | ((uint64_t)slot << 8) | (uint64_t)op;
+}
+
+/**
+ * @brief 準備 send 請求,送出 tx_buf 中的資料 (每個連線同時只有一個)
+ */
+static int ring_start_send(client_connection_t *client) {
+    struct io_uring_sqe *sqe = ws_uring_get_sqe(&client->worker->ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = client->fd;
+    sqe->addr = (uint64_t)(uintptr_t)client->tx_buf;
+    sqe->len = (uint32_t)client->tx_len;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = ring_user_data(client, WS_URING_OP_SEND);
+
+    client->tx_inflight = true;
     return 0;
 }
 
+#ifndef TESTING
 /**
- * @brief 設定訊息處理回調
+ * @brief 準備 multishot recv (緩衝區由核心從 buffer ring 挑選)
  */
-void ws_server_set_message_handler(ws_message_handler_t handler, 
-                                    void *user_data) {
-    g_server_ctx.message_handler = handler;
-    g_server_ctx.message_handler_data = user_data;
+static int ring_arm_recv(client_connection_t *client) {
+    ws_worker_t *worker = client->worker;
+    struct io_uring_sqe *sqe = ws_uring_get_sqe(&worker->ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = client->fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->buf_group = WS_URING_BUFFER_GROUP;
+    sqe->user_data = ring_user_data(client, WS_URING_OP_RECV);
+    return 0;
 }
+#endif
 
 /**
- * @brief 設定連線回調
+ * @brief 準備 multishot accept
+ *
+ * @param op WS_URING_OP_ACCEPT (TCP) 或 WS_URING_OP_LOCAL_ACCEPT (本機 IPC)
  */
-void ws_server_set_connect_callback(ws_connect_callback_t handler,
-                                     void *user_data) {
-    g_server_ctx.connect_callback = handler;
-    g_server_ctx.connect_callback_data = user_data;
+static int ring_arm_accept(ws_worker_t *worker, ws_uring_op_t op) {
+    struct io_uring_sqe *sqe = ws_uring_get_sqe(&worker->ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = (op == WS_URING_OP_LOCAL_ACCEPT) ? worker->local_fd : worker->listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    // 與 accept4() 路徑相同: 本機 IPC 以 recv 逐一取出封包,交接後也可能改由 epoll 服務
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = ring_user_data(NULL, op);
+    return 0;
+}
+
+/**
+ * @brief 取消 multishot accept (op 為 WS_URING_OP_ACCEPT 或 WS_URING_OP_LOCAL_ACCEPT)
+ *
+ * 被取消的 accept 以 -ECANCELED 結束 (不帶 IORING_CQE_F_MORE),
+ * 運行中時 ring_accept_done() 隨即以目前的 listen_fd 重新提交。
+ */
+static int ring_cancel_accept(ws_worker_t *worker, ws_uring_op_t op) {
+    struct io_uring_sqe *sqe = ws_uring_get_sqe(&worker->ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = ring_user_data(NULL, op);
+    sqe->user_data = ring_user_data(NULL, WS_URING_OP_CANCEL);
+    return 0;
+}
+
+#ifndef TESTING
+/**
+ * @brief 準備單次 poll,本機 IPC 連線可讀時以 recv 逐一取出封包
+ *
+ * 不使用 multishot: 連線關閉後 (shutdown) 最後一次 poll 結束,不會殘留請求
+ */
+static int ring_arm_poll_client(client_connection_t *client) {
+    struct io_uring_sqe *sqe = ws_uring_get_sqe(&client->worker->ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = client->fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = ring_user_data(client, WS_URING_OP_POLL);
+    return 0;
+}
+
+/**
+ * @brief 準備 multishot poll (timerfd / eventfd)
+ */
+static int ring_arm_poll(ws_worker_t *worker, int fd, ws_uring_op_t op) {
+    struct io_uring_sqe *sqe = ws_uring_get_sqe(&worker->ring);
+    if (sqe == NULL) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = ring_user_data(NULL, op);
+    return 0;
+}
+#endif
+#endif
+
+/**
+ * @brief 提交已準備的 io_uring 請求 (epoll 模式無作用)
+ *
+ * 廣播時每個客戶端只準備 SQE,釋放 lock 前以一次系統呼叫送出。
+ */
+static void submit_pending(ws_worker_t *worker) {
+#ifdef WS_USE_IO_URING
+    if (worker->use_ring) {
+        ws_uring_submit(&worker->ring);
+    }
+#else
+    (void)worker;
+#endif
+}
+
+/**
+ * @brief 將 socket 從 epoll / io_uring 移除 (關閉前)
+ */
+static void detach_client(client_connection_t *client) {
+    ws_worker_t *worker = client->worker;
+
+#ifdef WS_USE_IO_URING
+    if (worker->use_ring) {
+        // 先送出已排入的資料 (例如 Close 訊框),再以 shutdown 結束 multishot recv
+        ws_uring_submit(&worker->ring);
+        shutdown(client->fd, SHUT_RDWR);
+        return;
+    }
+#endif
+
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+}
+
+/**
+ * @brief 更新客戶端 epoll 事件 (是否需要 EPOLLOUT)
+ */
+static void update_client_events(client_connection_t *client) {
+    bool want_write = (client->tx_len > 0);
+    if (client->fd < 0 || want_write == client->want_write) {
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (want_write ? EPOLLOUT : 0);
+    ev.data.u32 = (uint32_t)(client - client->worker->clients);
+    epoll_ctl(client->worker->epoll_fd, EPOLL_CTL_MOD, client->fd, &ev);
+
+    client->want_write = want_write;
+}
+
+/**
+ * @brief 關閉連線並釋放槽位
+ */
+static void close_client(client_connection_t *client) {
+    if (!client->active) {
+        return;
+    }
+
+    ws_worker_t *worker = client->worker;
+    bool was_upgraded = client->upgraded;
+
+    if (client->fd >= 0) {
+        detach_client(client);
+        close(client->fd);
+    }
+    timer_wheel_cancel(&worker->timers, &client->keepalive);
+    ws_inflater_destroy(client->inflater);
+
+    client->active = false;
+    client->upgraded = false;
+    client->fd = -1;
+    client->inflater = NULL;
+    client->rx_len = 0;
+    client->tx_len = 0;
+    client->want_write = false;
+    __atomic_sub_fetch(&g_server_ctx.connection_count, 1, __ATOMIC_RELAXED);
+
+    if (was_upgraded) {
+        __atomic_sub_fetch(&g_server_ctx.client_count, 1, __ATOMIC_RELAXED);
+
+        // 觸發斷線回調 (id/ip 仍保留在槽位中)
+        notify_disconnect(client);
+    }
+}
+
+/**
+ * @brief 將傳送緩衝區寫入 socket
+ * @return 0 成功 (可能仍有剩餘), <0 連線錯誤
+ */
+static int flush_client(client_connection_t *client) {
+#ifdef WS_USE_IO_URING
+    if (client->worker->use_ring) {
+        return 0;  // 已由 send 請求負責
+    }
+#endif
+
+    while (client->tx_len > 0) {
+        ssize_t n = send(client->fd, client->tx_buf, client->tx_len,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
+        }
+
+        client->tx_len -= (size_t)n;
+        if (client->tx_len > 0) {
+            memmove(client->tx_buf, client->tx_buf + n, client->tx_len);
+        }
+    }
+
+    update_client_events(client);
+    return 0;
+}
+
+#ifdef WS_USE_IO_URING
+/**
+ * @brief 將位元組放入傳送緩衝區,沒有進行中的 send 時準備新的請求
+ *
+ * 請求在 submit_pending() 時才送出。send 進行中時新資料只附加在
+ * tx_buf 後段,完成後再一併送出。
+ *
+ * @return 0 成功, <0 失敗 (連線已關閉)
+ */
+static int ring_queue_bytes(client_connection_t *client, const uint8_t *data, size_t len) {
+    // 客戶端消化太慢: 斷線以免拖累其他客戶端
+    if (client->tx_len + len > sizeof(client->tx_buf)) {
+        close_client(client);
+        return -1;
+    }
+
+    memcpy(client->tx_buf + client->tx_len, data, len);
+    client->tx_len += len;
+
+    if (!client->tx_inflight && ring_start_send(client) != 0) {
+        close_client(client);
+        return -1;
+    }
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief 傳送原始位元組 (先嘗試直接寫入,剩餘部分放入傳送緩衝區)
+ * @return 0 成功, <0 失敗 (連線已關閉)
+ */
+static int queue_bytes(client_connection_t *client, const uint8_t *data, size_t len) {
+    if (client->fd < 0) {
+        return 0;  // 測試用虛擬連線: 模擬發送成功
+    }
+
+#ifdef WS_USE_IO_URING
+    if (client->worker->use_ring) {
+        return ring_queue_bytes(client, data, len);
+    }
+#endif
+
+    size_t offset = 0;
+
+    // 沒有待送資料時直接寫入,省去一次複製
+    if (client->tx_len == 0) {
+        while (offset < len) {
+            ssize_t n = send(client->fd, data + offset, len - offset,
+                             MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    break;
+                }
+                close_client(client);
+                return -1;
+            }
+            offset += (size_t)n;
+        }
+    }
+
+    size_t remaining = len - offset;
+    if (remaining == 0) {
+        return 0;
+    }
+
+    // 客戶端消化太慢: 斷線以免拖累其他客戶端
+    if (client->tx_len + remaining > sizeof(client->tx_buf)) {
+        close_client(client);
+        return -1;
+    }
+
+    memcpy(client->tx_buf + client->tx_len, data + offset, remaining);
+    client->tx_len += remaining;
+    update_client_events(client);
+
+    return 0;
+}
+
+/**
+ * @brief 傳送本機 IPC 封包 (一則完整訊息)
+ *
+ * SOCK_SEQPACKET 無法部分寫入,因此不經過 tx_buf;socket 緩衝區已滿
+ * 表示客戶端消化太慢,與 tx_buf 溢位相同直接斷線。
+ *
+ * @return 0 成功, <0 失敗 (連線已關閉)
+ */
+static int send_packet(client_connection_t *client, const uint8_t *data, size_t len) {
+    for (;;) {
+        ssize_t n = send(client->fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n != (ssize_t)len) {
+            close_client(client);
+            return -1;
+        }
+        return 0;
+    }
+}
+
+/**
+ * @brief 組裝訊框
+ * @return 訊框長度, 0 表示 payload 過大
+ */
+static size_t build_frame(uint8_t *out, uint8_t opcode, bool rsv1,
+                          const uint8_t *payload, size_t len)
+{
+    if (len > WS_SERVER_MAX_MESSAGE_SIZE) {
+        return 0;
+    }
+
+    size_t header_len = ws_frame_write_header(out, opcode, rsv1, len);
+    if (len > 0) {
+        memcpy(out + header_len, payload, len);
+    }
+    return header_len + len;
+}
+
+/**
+ * @brief 傳送單一訊框
+ */
+static int send_frame(client_connection_t *client, uint8_t opcode,
+                      const uint8_t *payload, size_t len)
+{
+    uint8_t frame[WS_FRAME_MAX_HEADER + 125];
+
+    if (client->local) {
+        return 0;  // 本機 IPC 沒有控制訊框
+    }
+
+    // 控制訊框使用堆疊緩衝區,不影響共用緩衝區
+    if (ws_frame_is_control(opcode) && len <= 125) {
+        size_t header_len = ws_frame_write_header(frame, opcode, false, len);
+        memcpy(frame + header_len, payload, len);
+        return queue_bytes(client, frame, header_len + len);
+    }
+
+    uint8_t *frame_buf = client->worker->frame_buf;
+    size_t frame_len = build_frame(frame_buf, opcode, false, payload, len);
+    if (frame_len == 0) {
+        return -1;
+    }
+    return queue_bytes(client, frame_buf, frame_len);
+}
+
+/**
+ * @brief 送出 Close 訊框並關閉連線
+ */
+static void close_client_with_code(client_connection_t *client, uint16_t code) {
+    if (client->upgraded) {
+        uint8_t payload[2] = { (uint8_t)(code >> 8), (uint8_t)(code & 0xFF) };
+        send_frame(client, WS_OPCODE_CLOSE, payload, sizeof(payload));
+        if (client->active && client->fd >= 0) {
+            flush_client(client);
+        }
+    }
+    close_client(client);
+}
+
+/**
+ * @brief 傳送資料訊框 (依協商結果壓縮)
+ */
+static int send_data(client_connection_t *client, uint8_t opcode,
+                     const uint8_t *data, size_t len)
+{
+    if (client->local) {
+        return send_packet(client, data, len);
+    }
+
+    if (client->deflate.enabled) {
+        uint8_t *deflate_buf = client->worker->deflate_frame_buf;
+        size_t compressed_len = 0;
+        int rc = ws_deflate_compress(client->deflate.server_max_window_bits,
+                                     data, len,
+                                     deflate_buf + WS_FRAME_MAX_HEADER,
+                                     WS_SERVER_MAX_MESSAGE_SIZE, &compressed_len);
+        if (rc == WS_DEFLATE_OK) {
+            uint8_t header[WS_FRAME_MAX_HEADER];
+            size_t header_len = ws_frame_write_header(header, opcode, true,
+                                                      compressed_len);
+            uint8_t *frame = deflate_buf + WS_FRAME_MAX_HEADER - header_len;
+            memcpy(frame, header, header_len);
+            return queue_bytes(client, frame, header_len + compressed_len);
+        }
+    }
+
+    return send_frame(client, opcode, data, len);
+}
+
+/**
+ * @brief 取得訊息的 CBOR 編碼 (未預先編碼時由 JSON 轉碼)
+ *
+ * @return CBOR 長度, 0 表示失敗
+ */
+static size_t encode_cbor(ws_worker_t *worker, const ws_message_t *message,
+                          const uint8_t **data)
+{
+    if (message->cbor != NULL) {
+        *data = message->cbor;
+        return message->cbor_len;
+    }
+
+    *data = worker->cbor_buf;
+    return ws_cbor_from_json(message->json, strlen(message->json),
+                             worker->cbor_buf, sizeof(worker->cbor_buf));
+}
+
+/**
+ * @brief 依客戶端編碼傳送訊息
+ */
+static int send_message(client_connection_t *client, const ws_message_t *message) {
+    if (client->encoding == WS_ENCODING_CBOR) {
+        const uint8_t *cbor;
+        size_t cbor_len = encode_cbor(client->worker, message, &cbor);
+        if (cbor_len == 0) {
+            return -1;
+        }
+        return send_data(client, WS_OPCODE_BINARY, cbor, cbor_len);
+    }
+
+    return send_data(client, WS_OPCODE_TEXT, (const uint8_t*)message->json,
+                     strlen(message->json));
+}
+
+/**
+ * @brief 將同一個訊框送給 pending 中使用指定編碼的客戶端
+ *
+ * 原文訊框只組裝一次;壓縮訊框依 server_max_window_bits 分組,
+ * 每組只壓縮一次 (伺服器固定 no_context_takeover,結果與連線無關)。
+ *
+ * @return 成功發送的客戶端數量
+ */
+static int send_shared_frame(ws_worker_t *worker, bool pending[], ws_encoding_t encoding,
+                             uint8_t opcode, const uint8_t *data, size_t len)
+{
+    size_t plain_len = build_frame(worker->frame_buf, opcode, false, data, len);
+    if (plain_len == 0) {
+        return 0;
+    }
+
+    int sent_count = 0;
+
+    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+        client_connection_t *c = &worker->clients[i];
+        if (!pending[i] || c->encoding != encoding) {
+            continue;
+        }
+
+        // 本機 IPC 直接送出 payload
+        if (c->local) {
+            pending[i] = false;
+            if (send_packet(c, data, len) == 0) {
+                sent_count++;
+            }
+            continue;
+        }
+
+        const uint8_t *frame = worker->frame_buf;
+        size_t frame_len = plain_len;
+
+        if (c->deflate.enabled) {
+            size_t compressed_len = 0;
+            uint8_t bits = c->deflate.server_max_window_bits;
+            int rc = ws_deflate_compress(bits, data, len,
+                                         worker->deflate_frame_buf + WS_FRAME_MAX_HEADER,
+                                         WS_SERVER_MAX_MESSAGE_SIZE, &compressed_len);
+            if (rc == WS_DEFLATE_OK) {
+                uint8_t header[WS_FRAME_MAX_HEADER];
+                size_t header_len = ws_frame_write_header(header, opcode, true,
+                                                          compressed_len);
+                uint8_t *out = worker->deflate_frame_buf + WS_FRAME_MAX_HEADER - header_len;
+                memcpy(out, header, header_len);
+                frame = out;
+                frame_len = header_len + compressed_len;
+            }
+
+            // 同一組參數的其他客戶端共用此訊框
+            for (int j = i; j < WS_SERVER_MAX_CLIENTS; j++) {
+                client_connection_t *other = &worker->clients[j];
+                if (pending[j] && other->encoding == encoding &&
+                    other->deflate.enabled &&
+                    other->deflate.server_max_window_bits == bits) {
+                    pending[j] = false;
+                    if (queue_bytes(other, frame, frame_len) == 0) {
+                        sent_count++;
+                    }
+                }
+            }
+            continue;
+        }
+
+        pending[i] = false;
+        if (queue_bytes(c, frame, frame_len) == 0) {
+            sent_count++;
+        }
+    }
+
+    return sent_count;
+}
+
+/**
+ * @brief 傳送相同訊息給 worker 中的多個客戶端
+ *
+ * 每種編碼只序列化一次 (CBOR 未預先編碼時只轉碼一次)
+ *
+ * @param topics 主題 bitmask, 0 表示所有客戶端
+ * @return 成功發送的客戶端數量
+ */
+static int send_shared(ws_worker_t *worker, uint32_t topics, const ws_message_t *message) {
+    bool pending[WS_SERVER_MAX_CLIENTS];
+    bool has_cbor = false;
+    uint64_t start_us = metrics_now_us();
+
+    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+        client_connection_t *c = &worker->clients[i];
+        pending[i] = is_established(c) &&
+                     (topics == 0 || (c->subscriptions & topics) != 0);
+        has_cbor |= (pending[i] && c->encoding == WS_ENCODING_CBOR);
+    }
+
+    int sent_count = send_shared_frame(worker, pending, WS_ENCODING_JSON, WS_OPCODE_TEXT,
+                                       (const uint8_t*)message->json,
+                                       strlen(message->json));
+
+    if (has_cbor) {
+        const uint8_t *cbor;
+        size_t cbor_len = encode_cbor(worker, message, &cbor);
+        if (cbor_len > 0) {
+            sent_count += send_shared_frame(worker, pending, WS_ENCODING_CBOR,
+                                            WS_OPCODE_BINARY, cbor, cbor_len);
+        }
+    }
+
+    if (sent_count > 0) {
+        metrics_observe(METRIC_WS_FANOUT_SECONDS, 0, metrics_now_us() - start_us);
+    }
+    return sent_count;
+}
+
+/* ============================================================
+ *  Internal Helper Functions - HTTP Endpoints
+ * ============================================================ */
+
+/**
+ * @brief 釋放 HTTP 回應的一個參考
+ */
+static void http_status_unref(ws_http_status_t *status) {
+    if (status != NULL && __atomic_sub_fetch(&status->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(status);
+    }
+}
+
+/**
+ * @brief 取得目前的 HTTP 回應 (增加參考計數)
+ * @return 回應, NULL 表示尚未設定狀態
+ */
+static ws_http_status_t* http_status_acquire(void) {
+    pthread_mutex_lock(&g_server_ctx.http_lock);
+    ws_http_status_t *status = g_server_ctx.http_status;
+    if (status != NULL) {
+        __atomic_add_fetch(&status->refs, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&g_server_ctx.http_lock);
+    return status;
+}
+
+/**
+ * @brief 預先組裝一個版本的 200 / 304 回應與 SSE 事件 (一次配置)
+ */
+static ws_http_status_t* http_status_create(uint64_t version, const char *json,
+                                            size_t json_len)
+{
+    size_t response_size = WS_HTTP_MAX_HEADER + json_len + 1;
+    size_t not_modified_size = WS_HTTP_MAX_HEADER;
+    size_t event_size = WS_HTTP_MAX_HEADER + json_len + 1;
+
+    ws_http_status_t *status = malloc(sizeof(ws_http_status_t) + response_size +
+                                      not_modified_size + event_size);
+    if (status == NULL) {
+        return NULL;
+    }
+
+    char *response = status->data;
+    char *not_modified = response + response_size;
+    char *event = not_modified + not_modified_size;
+
+    int response_len = ws_http_build_status(response, response_size, version,
+                                            json, json_len);
+    int not_modified_len = ws_http_build_not_modified(not_modified, not_modified_size,
+                                                      version);
+    int event_len = ws_http_build_event(event, event_size, version, json, json_len);
+    if (response_len < 0 || not_modified_len < 0 || event_len < 0) {
+        free(status);
+        return NULL;
+    }
+
+    status->refs = 1;
+    status->version = version;
+    status->response = response;
+    status->response_len = (size_t)response_len;
+    status->not_modified = not_modified;
+    status->not_modified_len = (size_t)not_modified_len;
+    status->event = event;
+    status->event_len = (size_t)event_len;
+    return status;
+}
+
+#ifndef TESTING
+/**
+ * @brief 送出錯誤回應並關閉連線
+ */
+static void http_reply_error(client_connection_t *client, const char *status) {
+    char response[128];
+    int len = ws_http_build_error(response, sizeof(response), status);
+    if (len > 0) {
+        queue_bytes(client, (const uint8_t*)response, (size_t)len);
+    }
+    close_client(client);
+}
+#endif
+
+/**
+ * @brief 回應完成: Connection: close 時關閉,否則等待下一個請求 (keep-alive)
+ *
+ * 閒置的 keep-alive 連線與未完成握手的連線使用相同的逾時
+ */
+static void http_finish(client_connection_t *client) {
+    if (client->http_close) {
+        close_client(client);
+        return;
+    }
+
+    client->http = WS_HTTP_IDLE;
+    timer_wheel_schedule(&client->worker->timers, &client->keepalive,
+                         monotonic_ms() + WS_SERVER_HANDSHAKE_TIMEOUT_MS);
+}
+
+#ifndef TESTING
+/**
+ * @brief 回應 GET /metrics (在 worker 緩衝區輸出,不配置記憶體)
+ */
+static void http_reply_metrics(client_connection_t *client) {
+    ws_worker_t *worker = client->worker;
+    int body_len = metrics_render(worker->metrics_buf, sizeof(worker->metrics_buf));
+    if (body_len < 0) {
+        http_reply_error(client, "500 Internal Server Error");
+        return;
+    }
+
+    char header[WS_HTTP_MAX_HEADER];
+    int header_len = ws_http_build_metrics_header(header, sizeof(header), (size_t)body_len);
+    if (header_len < 0) {
+        http_reply_error(client, "500 Internal Server Error");
+        return;
+    }
+
+    if (queue_bytes(client, (const uint8_t*)header, (size_t)header_len) == 0 &&
+        queue_bytes(client, (const uint8_t*)worker->metrics_buf, (size_t)body_len) == 0) {
+        http_finish(client);
+    }
+}
+
+/**
+ * @brief 處理不升級的 HTTP 請求 (GET /status, /status?version=N, /events, /metrics)
+ *
+ * @param header_len 請求標頭長度 (處理前從接收緩衝區移除)
+ */
+static void handle_http_request(client_connection_t *client, const ws_http_request_t *req,
+                                size_t header_len)
+{
+    // 先取出需要的欄位: req 指向接收緩衝區
+    uint64_t wait_version = 0;
+    ws_http_route_t route = ws_http_parse_route(req->path, &wait_version);
+    bool is_get = ws_str_equals(req->method, "GET");
+    uint64_t last_event_id = ws_http_parse_version(req->last_event_id);
+    ws_str_t if_none_match = req->if_none_match;
+
+    client->http_close = ws_str_has_token(req->connection, "close");
+
+    if (!is_get) {
+        http_reply_error(client, "405 Method Not Allowed");
+        return;
+    }
+    if (route == WS_HTTP_ROUTE_NOT_FOUND) {
+        http_reply_error(client, "404 Not Found");
+        return;
+    }
+    if (route == WS_HTTP_ROUTE_METRICS) {
+        client->rx_len -= header_len;
+        memmove(client->rx_buf, client->rx_buf + header_len, client->rx_len);
+        http_reply_metrics(client);
+        return;
+    }
+
+    ws_http_status_t *status = http_status_acquire();
+    if (status == NULL) {
+        http_reply_error(client, "503 Service Unavailable");
+        return;
+    }
+
+    bool fresh = ws_http_etag_matches(if_none_match, status->version);
+
+    client->rx_len -= header_len;
+    memmove(client->rx_buf, client->rx_buf + header_len, client->rx_len);
+
+    timer_wheel_t *timers = &client->worker->timers;
+    uint64_t now = monotonic_ms();
+
+    if (route == WS_HTTP_ROUTE_EVENTS) {
+        // 重新連線且 Last-Event-ID 已是目前版本時不重送
+        if (queue_bytes(client, (const uint8_t*)WS_HTTP_STREAM_HEADER,
+                        sizeof(WS_HTTP_STREAM_HEADER) - 1) == 0 &&
+            (last_event_id == status->version ||
+             queue_bytes(client, (const uint8_t*)status->event, status->event_len) == 0)) {
+            client->http = WS_HTTP_STREAMING;
+            client->http_version = status->version;
+            timer_wheel_schedule(timers, &client->keepalive, now + WS_SERVER_PING_INTERVAL_MS);
+        }
+    } else if (wait_version != 0 && wait_version == status->version) {
+        // 長輪詢: 版本變更或逾時才回應
+        client->http = WS_HTTP_WAITING;
+        client->http_version = wait_version;
+        timer_wheel_schedule(timers, &client->keepalive, now + WS_SERVER_LONG_POLL_TIMEOUT_MS);
+    } else {
+        const char *response = fresh ? status->not_modified : status->response;
+        size_t response_len = fresh ? status->not_modified_len : status->response_len;
+        if (queue_bytes(client, (const uint8_t*)response, response_len) == 0) {
+            http_finish(client);
+        }
+    }
+
+    http_status_unref(status);
+}
+#endif
+
+/**
+ * @brief SSE / 長輪詢的計時器到期
+ *
+ * - SSE: 送出註解行,讓中間的 proxy 與客戶端知道連線仍存活
+ * - 長輪詢: 版本沒有變更,回應 304
+ */
+static void http_timer_expired(client_connection_t *client) {
+    if (client->http == WS_HTTP_STREAMING) {
+        if (queue_bytes(client, (const uint8_t*)WS_HTTP_STREAM_KEEPALIVE,
+                        sizeof(WS_HTTP_STREAM_KEEPALIVE) - 1) == 0) {
+            timer_wheel_schedule(&client->worker->timers, &client->keepalive,
+                                 monotonic_ms() + WS_SERVER_PING_INTERVAL_MS);
+        }
+        return;
+    }
+
+    char response[WS_HTTP_MAX_HEADER];
+    int len = ws_http_build_not_modified(response, sizeof(response), client->http_version);
+    if (len < 0 || queue_bytes(client, (const uint8_t*)response, (size_t)len) != 0) {
+        close_client(client);
+        return;
+    }
+    http_finish(client);
+}
+
+/**
+ * @brief 將新版本推送給 worker 中的 SSE / 長輪詢客戶端 (持有 lock)
+ *
+ * 每個客戶端只複製預先組裝好的位元組,不重新格式化
+ */
+static void http_push_status(ws_worker_t *worker) {
+    uint64_t version = __atomic_load_n(&g_server_ctx.http_version, __ATOMIC_ACQUIRE);
+    if (version == worker->http_version) {
+        return;
+    }
+
+    ws_http_status_t *status = http_status_acquire();
+    if (status == NULL) {
+        return;
+    }
+    worker->http_version = status->version;
+
+    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+        client_connection_t *c = &worker->clients[i];
+        if (!c->active || c->upgraded || c->http == WS_HTTP_IDLE ||
+            c->http_version == status->version) {
+            continue;
+        }
+
+        if (c->http == WS_HTTP_STREAMING) {
+            c->http_version = status->version;
+            queue_bytes(c, (const uint8_t*)status->event, status->event_len);
+        } else if (queue_bytes(c, (const uint8_t*)status->response,
+                               status->response_len) == 0) {
+            http_finish(c);
+        }
+    }
+
+    http_status_unref(status);
+}
+
+/**
+ * @brief 釋放外送訊息的一個參照
+ */
+static void release_outbound(ws_outbound_t *out) {
+    if (__atomic_sub_fetch(&out->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(out);
+    }
+}
+
+/**
+ * @brief 複製訊息為可跨執行緒共用的外送訊息
+ */
+static ws_outbound_t* create_outbound(int client_id, uint32_t topics,
+                                      const ws_message_t *message, int refs)
+{
+    size_t json_len = strlen(message->json);
+    size_t cbor_len = (message->cbor != NULL) ? message->cbor_len : 0;
+
+    ws_outbound_t *out = malloc(sizeof(ws_outbound_t) + json_len + 1 + cbor_len);
+    if (out == NULL) {
+        return NULL;
+    }
+
+    out->refs = refs;
+    out->client_id = client_id;
+    out->topics = topics;
+    memcpy(out->json, message->json, json_len + 1);
+
+    out->cbor = NULL;
+    out->cbor_len = 0;
+    if (message->cbor != NULL) {
+        uint8_t *cbor = (uint8_t*)out->json + json_len + 1;
+        memcpy(cbor, message->cbor, cbor_len);
+        out->cbor = cbor;
+        out->cbor_len = cbor_len;
+    }
+
+    return out;
+}
+
+/**
+ * @brief 將外送訊息排入 worker 佇列
+ * @return 0 成功, -1 佇列已滿 (已釋放參照)
+ */
+static int post_outbound(ws_worker_t *worker, ws_outbound_t *out) {
+    if (!mpsc_queue_push(&worker->inbound, out)) {
+        release_outbound(out);
+        return -1;
+    }
+
+    signal_fd(worker->queue_fd);
+    return 0;
+}
+
+/**
+ * @brief 換上 ws_server_set_port() 建立的 listen socket (worker 執行緒,持有 lock)
+ */
+static void swap_listener(ws_worker_t *worker) {
+    int fd = __atomic_exchange_n(&worker->pending_listen_fd, -1, __ATOMIC_ACQ_REL);
+    if (fd < 0) {
+        return;
+    }
+
+    // 經由舊端口連線的客戶端隨舊 listener 結束,本機 IPC 不受影響
+    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+        client_connection_t *client = &worker->clients[i];
+        if (client->active && !client->local) {
+            close_client_with_code(client, WS_CLOSE_SERVICE_RESTART);
+        }
+    }
+
+    int old_fd = worker->listen_fd;
+    worker->listen_fd = fd;
+
+#ifdef WS_USE_IO_URING
+    if (worker->use_ring) {
+        ring_cancel_accept(worker, WS_URING_OP_ACCEPT);
+        close(old_fd);
+        return;
+    }
+#endif
+
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, old_fd, NULL);
+    close(old_fd);
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = WS_LISTEN_TAG;
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/**
+ * @brief 發送 worker 佇列中的所有訊息 (worker 執行緒,持有 lock)
+ */
+static void drain_inbound(ws_worker_t *worker) {
+    uint64_t count;
+    if (read(worker->queue_fd, &count, sizeof(count)) < 0) {
+        // 已由上一次 drain 清空
+    }
+
+    swap_listener(worker);
+
+    ws_outbound_t *out;
+    while ((out = mpsc_queue_pop(&worker->inbound)) != NULL) {
+        ws_message_t message = { out->json, out->cbor, out->cbor_len };
+
+        if (out->client_id > 0) {
+            int client_idx = find_client_by_id(worker, out->client_id);
+            if (client_idx >= 0) {
+                send_message(&worker->clients[client_idx], &message);
+            }
+        } else {
+            send_shared(worker, out->topics, &message);
+        }
+
+        release_outbound(out);
+    }
+
+    // ws_server_set_http_status() 只喚醒 worker,由 worker 推送
+    http_push_status(worker);
+}
+
+/**
+ * @brief 記錄一次發佈到 flight recorder
+ */
+static void trace_publish(int sent_count, uint32_t topics, const char *json) {
+    uint16_t clients = (sent_count < 0) ? 0 : (sent_count > UINT16_MAX) ? UINT16_MAX
+                                                                        : (uint16_t)sent_count;
+    trace_ring_record(TRACE_PUBLISH, clients, topics, (uint32_t)strlen(json));
+}
+
+/**
+ * @brief 發佈訊息 (依模式直接發送或排入各 worker 佇列)
+ *
+ * @param topics 主題 bitmask, 0 表示所有客戶端
+ * @return 收到訊息的客戶端數量, <0 失敗
+ */
+static int publish_shared(uint32_t topics, const ws_message_t *message) {
+    if (!is_threaded()) {
+        ws_worker_t *worker = &g_server_ctx.workers[0];
+        pthread_mutex_lock(&worker->lock);
+        int sent_count = send_shared(worker, topics, message);
+        submit_pending(worker);
+        pthread_mutex_unlock(&worker->lock);
+        return sent_count;
+    }
+
+    int subscribers = count_subscribers(topics);
+    if (subscribers == 0) {
+        return 0;
+    }
+
+    ws_outbound_t *out = create_outbound(0, topics, message, g_server_ctx.worker_count);
+    if (out == NULL) {
+        return -1;
+    }
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        post_outbound(&g_server_ctx.workers[w], out);
+    }
+
+    return subscribers;
+}
+
+#ifndef TESTING
+/**
+ * @brief 訊息類型對應的速率限制索引
+ */
+static int rate_limit_index(ws_message_type_t msg_type) {
+    return ((unsigned)msg_type < WS_SERVER_RATE_LIMIT_TYPES) ? (int)msg_type
+                                                            : WS_MSG_UNKNOWN;
+}
+
+/**
+ * @brief 以客戶端的令牌桶檢查訊息速率 (持有 worker lock)
+ * @return true 允許交給訊息處理器
+ */
+static bool rate_limit_allow(client_connection_t *client, ws_message_type_t msg_type) {
+    int index = rate_limit_index(msg_type);
+    uint32_t rate = __atomic_load_n(&g_server_ctx.rate_limits[index].rate, __ATOMIC_RELAXED);
+    uint32_t burst = __atomic_load_n(&g_server_ctx.rate_limits[index].burst, __ATOMIC_RELAXED);
+
+    bool allowed = token_bucket_take(&client->rate_buckets[index], rate, burst,
+                                     monotonic_ms());
+
+    ws_rate_limit_stats_t *stats = &g_server_ctx.rate_stats[index];
+    __atomic_add_fetch(allowed ? &stats->allowed : &stats->limited, 1, __ATOMIC_RELAXED);
+    return allowed;
+}
+
+/**
+ * @brief 回覆 rate_limited 錯誤 (帶回請求的 id)
+ *
+ * {"id":1,"type":"error","error":"rate_limited"}
+ */
+static void reply_rate_limited(client_connection_t *client, const char *message) {
+    char json[128];
+    json_writer_t w;
+    json_writer_init(&w, json, sizeof(json));
+    json_writer_begin_object(&w);
+
+    cJSON *root = cJSON_Parse(message);
+    cJSON *id = (root != NULL) ? cJSON_GetObjectItem(root, "id") : NULL;
+    if (cJSON_IsNumber(id) && id->valuedouble == (double)(int64_t)id->valuedouble) {
+        json_writer_kv_int(&w, "id", (int64_t)id->valuedouble);
+    } else if (cJSON_IsString(id) && strlen(id->valuestring) <= 64) {
+        json_writer_kv_string(&w, "id", id->valuestring);
+    }
+    cJSON_Delete(root);
+
+    json_writer_kv_string(&w, "type", "error");
+    json_writer_kv_string(&w, "error", "rate_limited");
+    json_writer_end_object(&w);
+
+    if (json_writer_finish(&w) != NULL) {
+        ws_message_t reply = { json, NULL, 0 };
+        send_message(client, &reply);
+    }
+}
+
+/**
+ * @brief 分派一則完整的訊息給訊息處理器
+ *
+ * 超過速率限制的訊息直接回覆 rate_limited,不交給處理器
+ * (多 worker 模式下也不佔用事件佇列)。
+ *
+ * @param message JSON 字串
+ * @param msg_type 已知的訊息類型 (CBOR 標籤), WS_MSG_UNKNOWN 表示需解析 JSON
+ */
+static void dispatch_message(client_connection_t *client, const char *message,
+                             ws_message_type_t msg_type)
+{
+    if (!g_server_ctx.message_handler) {
+        return;
+    }
+
+    if (msg_type == WS_MSG_UNKNOWN) {
+        msg_type = parse_message_type(message);
+    }
+
+    metrics_inc(METRIC_WS_MESSAGES, rate_limit_index(msg_type));
+    trace_ring_record(TRACE_MSG_IN, (uint16_t)msg_type, (uint32_t)client->id,
+                      (uint32_t)strlen(message));
+
+    if (!rate_limit_allow(client, msg_type)) {
+        reply_rate_limited(client, message);
+        return;
+    }
+
+    // 多 worker 模式: 處理器在擁有者執行緒執行
+    if (client->worker->threaded) {
+        post_event(WS_EVENT_MESSAGE, client, msg_type, message);
+        return;
+    }
+
+    uint64_t start_us = metrics_now_us();
+    char *response = g_server_ctx.message_handler(client->id, msg_type, message,
+                                                  g_server_ctx.message_handler_data);
+    metrics_observe(METRIC_WS_HANDLER_SECONDS, 0, metrics_now_us() - start_us);
+    if (response) {
+        if (is_established(client)) {
+            ws_message_t reply = { response, NULL, 0 };
+            send_message(client, &reply);
+        }
+        free(response);
+    }
+}
+#endif
+
+/**
+ * @brief Keepalive 計時器到期
+ *
+ * - 握手未完成: 關閉連線
+ * - 已送出 ping 且之後沒有收到任何資料: 視為斷線並關閉
+ * - 閒置達 WS_SERVER_PING_INTERVAL_MS: 送出 ping,等待 WS_SERVER_PONG_TIMEOUT_MS
+ * - 否則從最後收到資料的時間重新計算
+ *
+ * 收到資料時只更新 last_rx_ms,不重新排程,因此忙碌的連線不會
+ * 對時間輪造成額外負擔。
+ */
+static void on_keepalive_timer(tw_timer_t *timer, void *user_data) {
+    client_connection_t *client = (client_connection_t*)user_data;
+    (void)timer;
+
+    if (!client->active) {
+        return;
+    }
+
+    if (!client->upgraded) {
+        if (client->http != WS_HTTP_IDLE) {
+            http_timer_expired(client);
+        } else {
+            close_client(client);  // 握手逾時或 keep-alive 閒置
+        }
+        return;
+    }
+
+    timer_wheel_t *timers = &client->worker->timers;
+    uint64_t now = monotonic_ms();
+
+    if (client->ping_sent_ms != 0 && client->last_rx_ms < client->ping_sent_ms) {
+        close_client(client);  // pong 逾時
+        return;
+    }
+
+    if (now - client->last_rx_ms >= WS_SERVER_PING_INTERVAL_MS) {
+        if (send_frame(client, WS_OPCODE_PING, (const uint8_t*)"", 0) != 0 || !client->active) {
+            return;
+        }
+        client->ping_sent_ms = now;
+        timer_wheel_schedule(timers, &client->keepalive, now + WS_SERVER_PONG_TIMEOUT_MS);
+        return;
+    }
+
+    client->ping_sent_ms = 0;
+    timer_wheel_schedule(timers, &client->keepalive,
+                         client->last_rx_ms + WS_SERVER_PING_INTERVAL_MS);
+}
+
+#ifndef TESTING
+/**
+ * @brief 處理 timerfd 事件
+ */
+static void handle_timer_expired(ws_worker_t *worker) {
+    uint64_t expirations;
+    if (read(worker->timer_fd, &expirations, sizeof(expirations)) < 0) {
+        return;
+    }
+
+    timer_wheel_advance(&worker->timers, monotonic_ms());
+}
+
+/**
+ * @brief 送出 HTTP 錯誤並關閉連線
+ */
+static void reject_handshake(client_connection_t *client, const char *status) {
+    char response[128];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 %s\r\n"
+                       "Connection: close\r\n"
+                       "Sec-WebSocket-Version: 13\r\n"
+                       "Content-Length: 0\r\n"
+                       "\r\n", status);
+    if (len > 0 && (size_t)len < sizeof(response)) {
+        queue_bytes(client, (const uint8_t*)response, (size_t)len);
+    }
+    close_client(client);
+}
+
+/**
+ * @brief 連線可開始交換訊息 (WebSocket 握手完成或本機 IPC 連線建立)
+ *
+ * 本機 IPC 斷線由核心回報 (EOF),不需要 ping,取消握手計時器。
+ */
+static void establish_client(client_connection_t *client) {
+    client->upgraded = true;
+    client->connect_time = vclock_time();
+    client->subscriptions = WS_TOPIC_STATUS_FULL;
+    for (int i = 0; i < WS_SERVER_RATE_LIMIT_TYPES; i++) {
+        token_bucket_init(&client->rate_buckets[i],
+                          __atomic_load_n(&g_server_ctx.rate_limits[i].burst, __ATOMIC_RELAXED),
+                          client->last_rx_ms);
+    }
+    __atomic_add_fetch(&g_server_ctx.client_count, 1, __ATOMIC_RELAXED);
+
+    if (client->local) {
+        timer_wheel_cancel(&client->worker->timers, &client->keepalive);
+    } else {
+        timer_wheel_schedule(&client->worker->timers, &client->keepalive,
+                             client->last_rx_ms + WS_SERVER_PING_INTERVAL_MS);
+    }
+
+    // 觸發連線回調
+    notify_connect(client);
+}
+
+/**
+ * @brief 處理 HTTP Upgrade 握手
+ *
+ * @param req 已解析的 Upgrade 請求
+ * @param header_len 請求標頭長度
+ */
+static void process_handshake(client_connection_t *client, const ws_http_request_t *req,
+                              size_t header_len)
+{
+    char accept_key[WS_HANDSHAKE_ACCEPT_LEN + 1];
+    if (ws_handshake_accept_key(req->key, accept_key) != 0) {
+        reject_handshake(client, "400 Bad Request");
+        return;
+    }
+
+    // permessage-deflate 協商
+    char extensions[WS_DEFLATE_RESPONSE_SIZE];
+    bool deflate = ws_deflate_negotiate(req->extensions.ptr, req->extensions.len,
+                                        &client->deflate,
+                                        extensions, sizeof(extensions));
+    if (deflate) {
+        client->inflater = ws_inflater_create(&client->deflate);
+        if (client->inflater == NULL) {
+            memset(&client->deflate, 0, sizeof(client->deflate));
+            deflate = false;
+        }
+    }
+
+    // 子協定協商 (未提出時使用 JSON,不回傳 Sec-WebSocket-Protocol)
+    int protocol = ws_handshake_select_protocol(req->protocol, g_subprotocols,
+                                                (int)(sizeof(g_subprotocols) /
+                                                      sizeof(g_subprotocols[0])));
+    client->encoding = (protocol == WS_ENCODING_CBOR) ? WS_ENCODING_CBOR
+                                                      : WS_ENCODING_JSON;
+
+    char response[512];
+    int len = ws_handshake_build_response(response, sizeof(response), accept_key,
+                                          deflate ? extensions : NULL,
+                                          protocol >= 0 ? g_subprotocols[protocol] : NULL);
+    if (len < 0) {
+        reject_handshake(client, "500 Internal Server Error");
+        return;
+    }
+
+    // 移除已處理的請求標頭
+    client->rx_len -= header_len;
+    memmove(client->rx_buf, client->rx_buf + header_len, client->rx_len);
+
+    if (queue_bytes(client, (const uint8_t*)response, (size_t)len) != 0) {
+        return;
+    }
+
+    establish_client(client);
+}
+
+/**
+ * @brief 處理接收緩衝區中的一個 HTTP 請求 (WebSocket 握手或 HTTP 端點)
+ *
+ * 沒有 Upgrade 標頭的請求交給 HTTP 端點;帶 Upgrade 但不合法的
+ * 握手維持回應 400。
+ *
+ * @return 1 已處理, 0 請求尚未完整, -1 連線已關閉
+ */
+static int process_request(client_connection_t *client) {
+    ws_http_request_t req;
+    int header_len = ws_handshake_parse_request((const char*)client->rx_buf,
+                                                client->rx_len, &req);
+    if (header_len == WS_HANDSHAKE_INCOMPLETE) {
+        return 0;
+    }
+
+    if (header_len < 0) {
+        reject_handshake(client, "400 Bad Request");
+        return -1;
+    }
+
+    if (req.upgrade.ptr == NULL) {
+        handle_http_request(client, &req, (size_t)header_len);
+    } else if (ws_handshake_is_upgrade(&req)) {
+        process_handshake(client, &req, (size_t)header_len);
+    } else {
+        reject_handshake(client, "400 Bad Request");
+    }
+
+    return client->active ? 1 : -1;
+}
+
+/**
+ * @brief 處理接收緩衝區中所有完整的訊框
+ */
+static void process_frames(client_connection_t *client) {
+    ws_worker_t *worker = client->worker;
+    int client_id = client->id;
+
+    while (client->active && client->id == client_id && client->rx_len > 0) {
+        ws_frame_header_t hdr;
+        int rc = ws_frame_parse_header(client->rx_buf, client->rx_len, &hdr);
+        if (rc == WS_FRAME_INCOMPLETE) {
+            return;
+        }
+        if (rc != WS_FRAME_OK || !hdr.masked) {
+            // 客戶端訊框必須加 mask
+            close_client_with_code(client, WS_CLOSE_PROTOCOL_ERROR);
+            return;
+        }
+        if (hdr.payload_len > WS_SERVER_MAX_MESSAGE_SIZE) {
+            close_client_with_code(client, WS_CLOSE_TOO_BIG);
+            return;
+        }
+
+        size_t frame_len = hdr.header_len + (size_t)hdr.payload_len;
+        if (client->rx_len < frame_len) {
+            return;
+        }
+
+        uint8_t *payload = client->rx_buf + hdr.header_len;
+        size_t payload_len = (size_t)hdr.payload_len;
+        ws_frame_unmask(payload, payload_len, hdr.mask);
+
+        if (hdr.rsv1 && (!client->deflate.enabled || ws_frame_is_control(hdr.opcode))) {
+            close_client_with_code(client, WS_CLOSE_PROTOCOL_ERROR);
+            return;
+        }
+
+        switch (hdr.opcode) {
+            case WS_OPCODE_TEXT:
+            case WS_OPCODE_BINARY: {
+                if (!hdr.fin) {
+                    close_client_with_code(client, WS_CLOSE_UNSUPPORTED);
+                    return;
+                }
+
+                // 文字訊框為 JSON, 二進位訊框為 CBOR
+                bool is_cbor = (hdr.opcode == WS_OPCODE_BINARY);
+                uint8_t *msg = is_cbor ? worker->cbor_buf : (uint8_t*)worker->message_buf;
+                size_t msg_len = payload_len;
+                if (hdr.rsv1) {
+                    if (ws_inflater_inflate(client->inflater, payload, payload_len,
+                                            msg, WS_SERVER_MAX_MESSAGE_SIZE,
+                                            &msg_len) != WS_DEFLATE_OK) {
+                        close_client_with_code(client, WS_CLOSE_TOO_BIG);
+                        return;
+                    }
+                } else {
+                    memcpy(msg, payload, payload_len);
+                }
+
+                int msg_type = WS_MSG_UNKNOWN;
+                if (is_cbor) {
+                    msg_len = ws_cbor_to_json(worker->cbor_buf, msg_len, worker->message_buf,
+                                              sizeof(worker->message_buf), &msg_type);
+                    if (msg_len == 0) {
+                        close_client_with_code(client, WS_CLOSE_INVALID_DATA);
+                        return;
+                    }
+                }
+                worker->message_buf[msg_len] = '\0';
+
+                dispatch_message(client, worker->message_buf, (ws_message_type_t)msg_type);
+                break;
+            }
+
+            case WS_OPCODE_PING:
+                send_frame(client, WS_OPCODE_PONG, payload, payload_len);
+                break;
+
+            case WS_OPCODE_PONG:
+                break;
+
+            case WS_OPCODE_CLOSE:
+                close_client_with_code(client, WS_CLOSE_NORMAL);
+                return;
+
+            default:
+                // 不支援分段 (continuation) 及未定義的 opcode
+                close_client_with_code(client, WS_CLOSE_UNSUPPORTED);
+                return;
+        }
+
+        if (!client->active || client->id != client_id) {
+            return;
+        }
+
+        client->rx_len -= frame_len;
+        memmove(client->rx_buf, client->rx_buf + frame_len, client->rx_len);
+    }
+}
+
+/**
+ * @brief 接收緩衝區已滿卻仍無完整請求/訊框
+ */
+static void reject_oversized(client_connection_t *client) {
+    if (client->upgraded) {
+        close_client_with_code(client, WS_CLOSE_TOO_BIG);
+    } else {
+        reject_handshake(client, "431 Request Header Fields Too Large");
+    }
+}
+
+/**
+ * @brief 處理接收緩衝區中新到的資料 (握手或訊框)
+ * @return true 連線仍有效
+ */
+static bool process_rx(client_connection_t *client) {
+    client->last_rx_ms = monotonic_ms();
+
+    // keep-alive 的 HTTP 連線可以連續送出多個請求
+    while (!client->upgraded && client->http == WS_HTTP_IDLE) {
+        if (process_request(client) <= 0) {
+            return client->active;  // 請求尚未完整或連線已關閉
+        }
+    }
+
+    if (client->upgraded) {
+        process_frames(client);
+    } else {
+        client->rx_len = 0;  // SSE / 長輪詢期間忽略客戶端送來的資料
+    }
+    return client->active;
+}
+
+/**
+ * @brief 處理本機 IPC 可讀事件: 每個封包是一則完整的 JSON 訊息
+ *
+ * 超過 WS_SERVER_MAX_MESSAGE_SIZE 的封包 (MSG_TRUNC 回報原始長度)
+ * 視為協定錯誤並斷線;長度 0 的封包與 EOF 無法區分,同樣視為關閉。
+ */
+static void handle_local_readable(client_connection_t *client) {
+    ws_worker_t *worker = client->worker;
+    int client_id = client->id;
+
+    while (client->active && client->id == client_id) {
+        ssize_t n = recv(client->fd, worker->message_buf, WS_SERVER_MAX_MESSAGE_SIZE,
+                         MSG_DONTWAIT | MSG_TRUNC);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_client(client);
+            }
+            return;
+        }
+        if (n == 0 || n > WS_SERVER_MAX_MESSAGE_SIZE) {
+            close_client(client);
+            return;
+        }
+
+        client->last_rx_ms = monotonic_ms();
+        worker->message_buf[n] = '\0';
+        dispatch_message(client, worker->message_buf, WS_MSG_UNKNOWN);
+    }
+}
+
+/**
+ * @brief 處理可讀事件
+ */
+static void handle_client_readable(client_connection_t *client) {
+    if (client->local) {
+        handle_local_readable(client);
+        return;
+    }
+
+    for (;;) {
+        size_t space = sizeof(client->rx_buf) - client->rx_len;
+        if (space == 0) {
+            reject_oversized(client);
+            return;
+        }
+
+        ssize_t n = recv(client->fd, client->rx_buf + client->rx_len, space, 0);
+        if (n == 0) {
+            close_client(client);
+            return;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_client(client);
+            }
+            return;
+        }
+
+        client->rx_len += (size_t)n;
+        if (!process_rx(client)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 檢查來源 IP 的連線速率
+ *
+ * IP 雜湊到固定大小的表,附近 WS_ACCEPT_LIMIT_PROBE 格都被其他 IP
+ * 使用時取代最久沒有連線的項目 (被取代的 IP 重新獲得完整的 burst),
+ * 因此不配置記憶體。
+ *
+ * @return true 允許連線
+ */
+static bool accept_allowed(ws_worker_t *worker, uint32_t addr, uint64_t now) {
+    if (WS_SERVER_ACCEPT_RATE == 0 || addr == 0) {
+        return true;
+    }
+
+    uint32_t hash = (addr * 2654435761u) >> 26;  // 64 格
+    ws_accept_limit_t *victim = NULL;
+
+    for (uint32_t i = 0; i < WS_ACCEPT_LIMIT_PROBE; i++) {
+        ws_accept_limit_t *entry = &worker->accept_limits[(hash + i) % WS_ACCEPT_LIMIT_SLOTS];
+        if (entry->addr == addr) {
+            return token_bucket_take(&entry->bucket, WS_SERVER_ACCEPT_RATE,
+                                     WS_SERVER_ACCEPT_BURST, now);
+        }
+        if (victim == NULL || entry->addr == 0 ||
+            (victim->addr != 0 && entry->bucket.last_ms < victim->bucket.last_ms)) {
+            victim = entry;
+        }
+    }
+
+    victim->addr = addr;
+    token_bucket_init(&victim->bucket, WS_SERVER_ACCEPT_BURST, now);
+    return token_bucket_take(&victim->bucket, WS_SERVER_ACCEPT_RATE,
+                             WS_SERVER_ACCEPT_BURST, now);
+}
+
+/**
+ * @brief 為新連線配置槽位並啟動握手計時
+ *
+ * @param addr 來源位址, NULL 表示本機 IPC 連線
+ * @return 客戶端, NULL 表示已達上限或來源 IP 超過速率 (fd 已關閉)
+ */
+static client_connection_t* register_client(ws_worker_t *worker, int fd,
+                                            const struct sockaddr_in *addr)
+{
+    // 斷線後立刻重連的客戶端 (或惡意來源) 不佔用槽位
+    if (addr != NULL && !accept_allowed(worker, addr->sin_addr.s_addr, monotonic_ms())) {
+        close(fd);
+        return NULL;
+    }
+
+    // WS_SERVER_MAX_CLIENTS 為所有 worker 合計的上限
+    if (__atomic_add_fetch(&g_server_ctx.connection_count, 1,
+                           __ATOMIC_RELAXED) > WS_SERVER_MAX_CLIENTS) {
+        __atomic_sub_fetch(&g_server_ctx.connection_count, 1, __ATOMIC_RELAXED);
+        close(fd);  // 達到最大客戶端數
+        return NULL;
+    }
+
+    int slot = find_free_client_slot(worker);
+    if (slot < 0) {
+        __atomic_sub_fetch(&g_server_ctx.connection_count, 1, __ATOMIC_RELAXED);
+        close(fd);
+        return NULL;
+    }
+
+    client_connection_t *client = &worker->clients[slot];
+    memset(client, 0, offsetof(client_connection_t, rx_buf));
+    client->id = next_client_id(worker);
+    client->worker = worker;
+    client->fd = fd;
+    client->active = true;
+    client->rx_len = 0;
+    client->tx_len = 0;
+    memset(&client->deflate, 0, sizeof(client->deflate));
+    client->inflater = NULL;
+    if (addr != NULL) {
+        inet_ntop(AF_INET, &addr->sin_addr, client->ip, sizeof(client->ip));
+        client->port = ntohs(addr->sin_port);
+    } else {
+        client->local = true;
+        snprintf(client->ip, sizeof(client->ip), "local");
+    }
+    client->connect_time = vclock_time();
+
+    // 握手必須在時限內完成
+    client->last_rx_ms = monotonic_ms();
+    client->ping_sent_ms = 0;
+    tw_timer_init(&client->keepalive, on_keepalive_timer, client);
+    timer_wheel_schedule(&worker->timers, &client->keepalive,
+                         client->last_rx_ms + WS_SERVER_HANDSHAKE_TIMEOUT_MS);
+
+    return client;
+}
+
+/**
+ * @brief 將客戶端 socket 加入 worker 的 epoll
+ */
+static int watch_client(client_connection_t *client) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)(client - client->worker->clients);
+    return epoll_ctl(client->worker->epoll_fd, EPOLL_CTL_ADD, client->fd, &ev);
+}
+
+/**
+ * @brief 接受等待中的連線 (每次最多 WS_ACCEPT_BATCH 個)
+ *
+ * 重連風暴時一次取出多個連線;listen socket 使用 TCP_DEFER_ACCEPT,
+ * 接受時請求通常已到達,因此立即處理握手而不等下一次 epoll_wait。
+ * 超過批次上限的連線留給下一次事件 (level-triggered),
+ * 避免長時間不處理既有客戶端。
+ */
+static void accept_clients(ws_worker_t *worker) {
+    for (int accepted = 0; accepted < WS_ACCEPT_BATCH; accepted++) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        int fd = accept4(worker->listen_fd, (struct sockaddr*)&addr, &addr_len,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // EAGAIN 或錯誤: 等下一次事件
+        }
+
+        client_connection_t *client = register_client(worker, fd, &addr);
+        if (client == NULL) {
+            continue;
+        }
+
+        if (watch_client(client) != 0) {
+            close_client(client);
+            continue;
+        }
+
+        handle_client_readable(client);
+    }
+}
+
+/**
+ * @brief 接受等待中的本機 IPC 連線 (不需要握手,立即可交換訊息)
+ */
+static void accept_local_clients(ws_worker_t *worker) {
+    for (int accepted = 0; accepted < WS_ACCEPT_BATCH; accepted++) {
+        int fd = accept4(worker->local_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        client_connection_t *client = register_client(worker, fd, NULL);
+        if (client == NULL) {
+            continue;
+        }
+
+        if (watch_client(client) != 0) {
+            close_client(client);
+            continue;
+        }
+
+        establish_client(client);
+        if (client->active) {
+            handle_local_readable(client);
+        }
+    }
+}
+#endif
+
+#ifdef WS_USE_IO_URING
+/* ============================================================
+ *  Internal Helper Functions - io_uring Backend
+ * ============================================================ */
+
+#ifndef TESTING
+/**
+ * @brief multishot accept 完成 (本機 IPC 連線以 poll + recv 接收封包)
+ */
+static void ring_accept_done(ws_worker_t *worker, const struct io_uring_cqe *cqe,
+                             ws_uring_op_t op)
+{
+    if (cqe->res >= 0 && op == WS_URING_OP_LOCAL_ACCEPT) {
+        client_connection_t *client = register_client(worker, cqe->res, NULL);
+        if (client != NULL) {
+            establish_client(client);
+            if (client->active && ring_arm_poll_client(client) != 0) {
+                close_client(client);
+            }
+        }
+    } else if (cqe->res >= 0) {
+        // multishot accept 不回傳位址
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        memset(&addr, 0, sizeof(addr));
+        getpeername(cqe->res, (struct sockaddr*)&addr, &addr_len);
+
+        client_connection_t *client = register_client(worker, cqe->res, &addr);
+        if (client != NULL && ring_arm_recv(client) != 0) {
+            close_client(client);
+        }
+    }
+
+    // ws_server_export() 取消的 accept 在解除凍結時才重新提交
+    if (!(cqe->flags & IORING_CQE_F_MORE) &&
+        __atomic_load_n(&g_server_ctx.state, __ATOMIC_ACQUIRE) == WS_SERVER_RUNNING) {
+        ring_arm_accept(worker, op);
+    }
+}
+
+/**
+ * @brief multishot recv 完成: 將 buffer 內容複製到 rx_buf 並處理
+ */
+static void ring_recv_done(client_connection_t *client, const struct io_uring_cqe *cqe) {
+    ws_worker_t *worker = client->worker;
+
+    if (cqe->res == -ENOBUFS) {
+        ring_arm_recv(client);  // buffer ring 暫時用完: 處理完本輪 CQE 後重新提交
+        return;
+    }
+    if (cqe->res <= 0 || !(cqe->flags & IORING_CQE_F_BUFFER)) {
+        close_client(client);
+        return;
+    }
+
+    const uint8_t *data = ws_uring_buffer(&worker->ring,
+                                          cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    size_t len = (size_t)cqe->res;
+
+    while (len > 0) {
+        size_t space = sizeof(client->rx_buf) - client->rx_len;
+        if (space == 0) {
+            reject_oversized(client);
+            return;
+        }
+
+        size_t n = (len < space) ? len : space;
+        memcpy(client->rx_buf + client->rx_len, data, n);
+        client->rx_len += n;
+        data += n;
+        len -= n;
+
+        if (!process_rx(client)) {
+            return;
+        }
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_MORE) && ring_arm_recv(client) != 0) {
+        close_client(client);
+    }
+}
+
+/**
+ * @brief send 完成: 移除已送出的部分,還有資料時繼續送出
+ */
+static void ring_send_done(client_connection_t *client, int res) {
+    client->tx_inflight = false;
+
+    if (res < 0) {
+        close_client(client);
+        return;
+    }
+
+    size_t sent = ((size_t)res < client->tx_len) ? (size_t)res : client->tx_len;
+    client->tx_len -= sent;
+    if (client->tx_len > 0) {
+        memmove(client->tx_buf, client->tx_buf + sent, client->tx_len);
+        if (ring_start_send(client) != 0) {
+            close_client(client);
+        }
+    }
+}
+
+/**
+ * @brief 分派一個 CQE
+ */
+static void ring_handle_cqe(ws_worker_t *worker, const struct io_uring_cqe *cqe) {
+    ws_uring_op_t op = (ws_uring_op_t)(cqe->user_data & 0xFF);
+    uint32_t slot = (uint32_t)(cqe->user_data >> 8) & 0xFFFFFF;
+    int client_id = (int)(cqe->user_data >> 32);
+    bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+    switch (op) {
+    case WS_URING_OP_ACCEPT:
+    case WS_URING_OP_LOCAL_ACCEPT:
+        ring_accept_done(worker, cqe, op);
+        return;
+    case WS_URING_OP_TIMER:
+        handle_timer_expired(worker);
+        if (!more) {
+            ring_arm_poll(worker, worker->timer_fd, WS_URING_OP_TIMER);
+        }
+        return;
+    case WS_URING_OP_QUEUE:
+        drain_inbound(worker);
+        if (!more) {
+            ring_arm_poll(worker, worker->queue_fd, WS_URING_OP_QUEUE);
+        }
+        return;
+    case WS_URING_OP_CANCEL:
+        return;
+    default:
+        break;
+    }
+
+    // 連線已關閉 (或槽位已被新連線使用) 時忽略舊請求的結果
+    client_connection_t *client = NULL;
+    if (slot < WS_SERVER_MAX_CLIENTS && worker->clients[slot].active &&
+        worker->clients[slot].id == client_id) {
+        client = &worker->clients[slot];
+    }
+
+    if (client != NULL && op == WS_URING_OP_RECV) {
+        ring_recv_done(client, cqe);
+    } else if (client != NULL && op == WS_URING_OP_SEND) {
+        ring_send_done(client, cqe->res);
+    } else if (client != NULL && op == WS_URING_OP_POLL) {
+        handle_local_readable(client);
+        if (client->active && client->id == client_id && ring_arm_poll_client(client) != 0) {
+            close_client(client);
+        }
+    }
+
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        ws_uring_recycle_buffer(&worker->ring, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    }
+}
+
+/**
+ * @brief 處理 worker 的 io_uring 完成事件 (等待期間不持有 lock)
+ *
+ * 本輪處理產生的所有請求 (回應、ping、重新提交) 最後一次提交。
+ *
+ * @return 0 成功, <0 失敗
+ */
+static int service_ring(ws_worker_t *worker, int timeout_ms) {
+    if (ws_uring_wait(&worker->ring, timeout_ms) < 0) {
+        return -3;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+
+    // 每輪最多處理 WS_URING_ENTRIES 個,避免長時間持有 lock
+    struct io_uring_cqe *cqe;
+    for (int i = 0; i < WS_URING_ENTRIES &&
+                    (cqe = ws_uring_peek_cqe(&worker->ring)) != NULL; i++) {
+        struct io_uring_cqe event = *cqe;
+        ws_uring_cqe_seen(&worker->ring);
+        ring_handle_cqe(worker, &event);
+    }
+
+    ws_uring_submit(&worker->ring);
+    pthread_mutex_unlock(&worker->lock);
+    return 0;
+}
+
+/**
+ * @brief 建立 worker 的 io_uring 並提交 accept 與計時器/佇列的 poll
+ * @return 0 成功, -1 核心不支援 (改用 epoll)
+ */
+static int ring_attach(ws_worker_t *worker) {
+    ws_uring_t *ring = &worker->ring;
+
+    if (ws_uring_init(ring, WS_URING_ENTRIES) != 0) {
+        return -1;
+    }
+
+    if (ws_uring_setup_buffers(ring, WS_URING_BUFFER_GROUP, WS_URING_BUFFER_COUNT,
+                               WS_URING_BUFFER_SIZE) != 0 ||
+        !ws_uring_probe_multishot(ring) ||
+        ring_arm_accept(worker, WS_URING_OP_ACCEPT) != 0 ||
+        (worker->local_fd >= 0 && ring_arm_accept(worker, WS_URING_OP_LOCAL_ACCEPT) != 0) ||
+        ring_arm_poll(worker, worker->timer_fd, WS_URING_OP_TIMER) != 0 ||
+        ring_arm_poll(worker, worker->queue_fd, WS_URING_OP_QUEUE) != 0 ||
+        ws_uring_submit(ring) < 0) {
+        ws_uring_exit(ring);
+        return -1;
+    }
+
+    worker->use_ring = true;
+    return 0;
+}
+#endif
+#endif
+
+#ifndef TESTING
+/**
+ * @brief 關閉 worker 的 listen socket、epoll 與計時器
+ */
+static void close_worker_fds(ws_worker_t *worker) {
+#ifdef WS_USE_IO_URING
+    // 關閉 ring 會取消仍在執行的 accept/poll 請求
+    if (worker->use_ring) {
+        ws_uring_exit(&worker->ring);
+        worker->use_ring = false;
+    }
+#endif
+
+    // 檔案系統路徑的 socket 節點不會隨 close 移除 (已交給新程序時保留)
+    if (worker->local_fd >= 0 && g_server_ctx.local_path[0] != '@' &&
+        !g_server_ctx.handed_off) {
+        unlink(g_server_ctx.local_path);
+    }
+
+    int *fds[] = { &worker->listen_fd, &worker->pending_listen_fd, &worker->local_fd,
+                   &worker->timer_fd, &worker->queue_fd, &worker->epoll_fd };
+
+    for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        if (*fds[i] >= 0) {
+            close(*fds[i]);
+            *fds[i] = -1;
+        }
+    }
+}
+
+/**
+ * @brief 將 fd 加入 worker 的 epoll
+ */
+static int watch_fd(ws_worker_t *worker, int fd, uint32_t tag) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = tag;
+    return epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/**
+ * @brief 建立 worker 的事件來源: io_uring (可用時) 或 epoll
+ * @return 0 成功, -1 失敗
+ */
+static int open_poller(ws_worker_t *worker) {
+#ifdef WS_USE_IO_URING
+    // 核心不支援 (或 io_uring 被停用) 時自動退回 epoll
+    if (ring_attach(worker) == 0) {
+        return 0;
+    }
+#endif
+
+    worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (worker->epoll_fd < 0 ||
+        watch_fd(worker, worker->listen_fd, WS_LISTEN_TAG) != 0 ||
+        watch_fd(worker, worker->timer_fd, WS_TIMER_TAG) != 0 ||
+        watch_fd(worker, worker->queue_fd, WS_QUEUE_TAG) != 0 ||
+        (worker->local_fd >= 0 && watch_fd(worker, worker->local_fd, WS_LOCAL_TAG) != 0)) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 建立本機 IPC listen socket (AF_UNIX SOCK_SEQPACKET)
+ *
+ * '@' 開頭的路徑使用 abstract namespace (不建立檔案,程序結束即釋放);
+ * 其他路徑先移除上次留下的 socket 檔案。
+ *
+ * @return 0 成功, <0 失敗
+ */
+static int open_local_listener(ws_worker_t *worker) {
+    const char *path = g_server_ctx.local_path;
+    bool abstract = (path[0] == '@');
+    size_t path_len = strlen(path);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, path_len);
+    if (abstract) {
+        addr.sun_path[0] = '\0';
+    } else {
+        unlink(path);
+    }
+
+    // abstract 名稱的長度不含結尾 '\0'
+    socklen_t addr_len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) +
+                                     path_len + (abstract ? 0 : 1));
+
+    worker->local_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (worker->local_fd < 0 ||
+        bind(worker->local_fd, (struct sockaddr*)&addr, addr_len) != 0 ||
+        listen(worker->local_fd, WS_LISTEN_BACKLOG) != 0) {
+        return -5;
+    }
+    return 0;
+}
+
+/**
+ * @brief 建立 TCP listen socket
+ *
+ * 多 worker 時每個 worker 以 SO_REUSEPORT 綁定同一個端口,
+ * 由核心將新連線分散到各 worker。
+ *
+ * @return socket, -1 失敗
+ */
+static int open_tcp_socket(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // 收到請求資料後才喚醒 accept (秒), 只連線不送資料的客戶端不佔用槽位
+    int defer_secs = WS_SERVER_HANDSHAKE_TIMEOUT_MS / 1000;
+    setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer_secs, sizeof(defer_secs));
+    if (is_threaded() &&
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(fd, WS_LISTEN_BACKLOG) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief 建立 worker 的 listen socket、epoll 與計時器
+ *
+ * @return 0 成功, <0 失敗
+ */
+static int open_listener(ws_worker_t *worker) {
+    // ws_server_adopt() 接收的 socket 沿用,不重新綁定
+    if (worker->listen_fd < 0) {
+        worker->listen_fd = open_tcp_socket(g_server_ctx.port);
+    }
+    if (worker->listen_fd < 0) {
+        return -5;
+    }
+
+    // 本機 IPC 只由第一個 worker 服務 (AF_UNIX 不支援 SO_REUSEPORT 分流)
+    if (worker->index == 0 && g_server_ctx.local_path[0] != '\0' &&
+        worker->local_fd < 0 && open_local_listener(worker) != 0) {
+        close_worker_fds(worker);
+        return -5;
+    }
+
+    // keepalive: 單一 timerfd 以固定 tick 推進時間輪
+    worker->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    // 其他執行緒排入訊息時喚醒 epoll_wait / io_uring
+    worker->queue_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (worker->timer_fd < 0 || worker->queue_fd < 0 || open_poller(worker) != 0) {
+        close_worker_fds(worker);
+        return -5;
+    }
+
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_interval.tv_nsec = WS_KEEPALIVE_TICK_MS * 1000000L;
+    its.it_value = its.it_interval;
+    timerfd_settime(worker->timer_fd, 0, &its, NULL);
+
+    timer_wheel_init(&worker->timers, monotonic_ms(), WS_KEEPALIVE_TICK_MS);
+    return 0;
+}
+
+/**
+ * @brief 處理 worker 的 epoll 事件 (等待期間不持有 lock)
+ * @return 0 成功, <0 失敗
+ */
+static int service_worker(ws_worker_t *worker, int timeout_ms) {
+#ifdef WS_USE_IO_URING
+    if (worker->use_ring) {
+        return service_ring(worker, timeout_ms);
+    }
+#endif
+
+    struct epoll_event events[WS_MAX_EVENTS];
+    int n = epoll_wait(worker->epoll_fd, events, WS_MAX_EVENTS, timeout_ms);
+    if (n < 0) {
+        return (errno == EINTR) ? 0 : -3;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.u32 == WS_LISTEN_TAG) {
+            accept_clients(worker);
+            continue;
+        }
+        if (events[i].data.u32 == WS_TIMER_TAG) {
+            handle_timer_expired(worker);
+            continue;
+        }
+        if (events[i].data.u32 == WS_QUEUE_TAG) {
+            drain_inbound(worker);
+            continue;
+        }
+        if (events[i].data.u32 == WS_LOCAL_TAG) {
+            accept_local_clients(worker);
+            continue;
+        }
+
+        uint32_t slot = events[i].data.u32;
+        if (slot >= WS_SERVER_MAX_CLIENTS) {
+            continue;
+        }
+
+        client_connection_t *client = &worker->clients[slot];
+        if (!client->active) {
+            continue;
+        }
+
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            close_client(client);
+            continue;
+        }
+        if (events[i].events & EPOLLOUT) {
+            if (flush_client(client) != 0) {
+                close_client(client);
+                continue;
+            }
+        }
+        if (events[i].events & EPOLLIN) {
+            handle_client_readable(client);
+        }
+    }
+
+    pthread_mutex_unlock(&worker->lock);
+    return 0;
+}
+
+/**
+ * @brief Worker 執行緒
+ */
+static void* worker_thread(void *arg) {
+    ws_worker_t *worker = (ws_worker_t*)arg;
+
+    while (__atomic_load_n(&g_server_ctx.state, __ATOMIC_ACQUIRE) == WS_SERVER_RUNNING) {
+        if (service_worker(worker, WS_WORKER_POLL_MS) != 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+#endif
+
+/**
+ * @brief 釋放所有 worker
+ */
+static void destroy_workers(void) {
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+
+        ws_outbound_t *out;
+        while ((out = mpsc_queue_pop(&worker->inbound)) != NULL) {
+            release_outbound(out);
+        }
+        mpsc_queue_destroy(&worker->inbound);
+        pthread_mutex_destroy(&worker->lock);
+    }
+
+    free(g_server_ctx.workers);
+    g_server_ctx.workers = NULL;
+    g_server_ctx.worker_count = 0;
+}
+
+/**
+ * @brief 建立 worker (尚未開啟 socket)
+ * @return 0 成功, -1 記憶體不足
+ */
+static int create_workers(int count) {
+    ws_worker_t *workers = calloc((size_t)count, sizeof(ws_worker_t));
+    if (workers == NULL) {
+        return -1;
+    }
+
+    g_server_ctx.workers = workers;
+    g_server_ctx.worker_count = 0;
+
+    for (int w = 0; w < count; w++) {
+        ws_worker_t *worker = &workers[w];
+        worker->index = w;
+        worker->listen_fd = -1;
+        worker->epoll_fd = -1;
+        worker->timer_fd = -1;
+        worker->queue_fd = -1;
+        worker->local_fd = -1;
+        worker->pending_listen_fd = -1;
+        timer_wheel_init(&worker->timers, 0, WS_KEEPALIVE_TICK_MS);
+
+        for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+            worker->clients[i].worker = worker;
+            worker->clients[i].fd = -1;
+        }
+
+        if (mpsc_queue_init(&worker->inbound, WS_WORKER_QUEUE_SIZE) != 0) {
+            destroy_workers();
+            return -1;
+        }
+
+        // 訊息處理器可能在持有 lock 時再呼叫 ws_server_send()
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&worker->lock, &attr);
+        pthread_mutexattr_destroy(&attr);
+
+        g_server_ctx.worker_count++;
+    }
+
+    return 0;
+}
+
+#ifndef TESTING
+/**
+ * @brief 為每個 worker 建立執行緒 (多 worker 模式)
+ * @return 0 成功, -5 無法建立執行緒 (已建立的由 ws_server_stop() 結束)
+ */
+static int start_worker_threads(void) {
+    if (!is_threaded()) {
+        return 0;
+    }
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        worker->threaded = true;
+        if (pthread_create(&worker->thread, NULL, worker_thread, worker) != 0) {
+            worker->threaded = false;
+            return -5;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+/**
+ * @brief 結束 worker 執行緒 (state 已不是 RUNNING),之後所有客戶端由目前的執行緒處理
+ */
+static void join_worker_threads(void) {
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        if (worker->threaded) {
+            signal_fd(worker->queue_fd);
+            pthread_join(worker->thread, NULL);
+            worker->threaded = false;
+        }
+    }
+}
+
+/* ============================================================
+ *  Internal Helper Functions - Graceful Upgrade
+ * ============================================================ */
+
+/**
+ * @brief 連線是否可交給新程序
+ *
+ * 只交接已完成握手、沒有只存在於本程序狀態的連線: 未處理完的收發資料、
+ * 處理中的請求與客戶端 context takeover 的解壓縮視窗都無法搬移。
+ * io_uring 的 multishot recv 可能已從 socket 取走資料,因此只交接
+ * 以 poll 服務的本機 IPC 連線。
+ */
+static bool can_hand_off(const client_connection_t *client) {
+    if (!client->active || !client->upgraded || client->fd < 0 ||
+        client->rx_len > 0 || client->tx_len > 0 || client->in_flight > 0 ||
+        (client->deflate.enabled && !client->deflate.client_no_context_takeover)) {
+        return false;
+    }
+
+#ifdef WS_USE_IO_URING
+    if (client->worker->use_ring && !client->local) {
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+#if defined(WS_USE_IO_URING) && !defined(TESTING)
+/**
+ * @brief 取消 multishot accept 並處理剩下的完成事件 (凍結時,持有 lock)
+ *
+ * 仍在 ring 中的 accept 會繼續接受連線,凍結後沒有人取出就會遺失;
+ * 取消前已接受的連線照常登記 (握手中,由 ws_server_export() 關閉)。
+ */
+static void ring_stop_accepting(ws_worker_t *worker) {
+    int pending = 0;
+    if (ring_cancel_accept(worker, WS_URING_OP_ACCEPT) == 0) {
+        pending++;
+    }
+    if (worker->local_fd >= 0 && ring_cancel_accept(worker, WS_URING_OP_LOCAL_ACCEPT) == 0) {
+        pending++;
+    }
+
+    while (pending > 0 && ws_uring_submit(&worker->ring) >= 0 &&
+           ws_uring_wait(&worker->ring, WS_URING_CANCEL_WAIT_MS) == 0) {
+        struct io_uring_cqe *cqe = ws_uring_peek_cqe(&worker->ring);
+        if (cqe == NULL) {
+            break;  // 逾時
+        }
+
+        do {
+            struct io_uring_cqe event = *cqe;
+            ws_uring_cqe_seen(&worker->ring);
+            if ((ws_uring_op_t)(event.user_data & 0xFF) == WS_URING_OP_CANCEL) {
+                pending--;
+            }
+            ring_handle_cqe(worker, &event);
+        } while ((cqe = ws_uring_peek_cqe(&worker->ring)) != NULL);
+    }
+}
+#endif
+
+/**
+ * @brief 複製要交接的連線狀態
+ */
+static void export_client(const client_connection_t *client, ws_handoff_client_t *rec) {
+    memset(rec, 0, sizeof(*rec));
+    rec->id = client->id;
+    memcpy(rec->ip, client->ip, sizeof(rec->ip));
+    rec->port = client->port;
+    rec->local = client->local;
+    rec->connect_time = client->connect_time;
+    rec->subscriptions = client->subscriptions;
+    rec->encoding = client->encoding;
+    rec->deflate = client->deflate.enabled;
+    rec->server_max_window_bits = client->deflate.server_max_window_bits;
+    rec->client_max_window_bits = client->deflate.client_max_window_bits;
+    rec->last_rx_ms = client->last_rx_ms;
+    rec->ping_sent_ms = client->ping_sent_ms;
+    for (int i = 0; i < WS_SERVER_RATE_LIMIT_TYPES; i++) {
+        rec->rate_tokens[i] = client->rate_buckets[i].tokens;
+        rec->rate_last_ms[i] = client->rate_buckets[i].last_ms;
+    }
+}
+
+#ifndef TESTING
+/**
+ * @brief 將交接的連線放回槽位並加入 epoll / io_uring
+ *
+ * @return 0 成功, -1 失敗 (連線已關閉)
+ */
+static int restore_client(ws_worker_t *worker, const ws_handoff_client_t *rec, int fd) {
+    int slot = find_free_client_slot(worker);
+    if (slot < 0 || find_client_by_id(worker, rec->id) >= 0) {
+        close(fd);
+        return -1;
+    }
+
+    client_connection_t *client = &worker->clients[slot];
+    memset(client, 0, offsetof(client_connection_t, rx_buf));
+    client->id = rec->id;
+    client->worker = worker;
+    client->fd = fd;
+    client->active = true;
+    client->upgraded = true;
+    client->local = rec->local;
+    snprintf(client->ip, sizeof(client->ip), "%.*s", (int)sizeof(rec->ip) - 1, rec->ip);
+    client->port = rec->port;
+    client->connect_time = rec->connect_time;
+    client->subscriptions = rec->subscriptions;
+    client->encoding = rec->encoding;
+    client->deflate.enabled = rec->deflate;
+    client->deflate.client_no_context_takeover = rec->deflate;
+    client->deflate.server_max_window_bits = rec->server_max_window_bits;
+    client->deflate.client_max_window_bits = rec->client_max_window_bits;
+    client->last_rx_ms = rec->last_rx_ms;
+    client->ping_sent_ms = rec->ping_sent_ms;
+    for (int i = 0; i < WS_SERVER_RATE_LIMIT_TYPES; i++) {
+        client->rate_buckets[i].tokens = rec->rate_tokens[i];
+        client->rate_buckets[i].last_ms = rec->rate_last_ms[i];
+    }
+    tw_timer_init(&client->keepalive, on_keepalive_timer, client);
+
+    // 之後配置的 ID 接在交接的 ID 之後
+    int seq = (rec->id - 1 - worker->index) / g_server_ctx.worker_count;
+    if (seq >= worker->next_seq) {
+        worker->next_seq = seq + 1;
+    }
+
+    __atomic_add_fetch(&g_server_ctx.connection_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_server_ctx.client_count, 1, __ATOMIC_RELAXED);
+
+    if (client->deflate.enabled) {
+        client->inflater = ws_inflater_create(&client->deflate);
+        if (client->inflater == NULL) {
+            close_client(client);
+            return -1;
+        }
+    }
+
+    if (!client->local) {
+        uint64_t due = (client->ping_sent_ms != 0)
+                     ? client->ping_sent_ms + WS_SERVER_PONG_TIMEOUT_MS
+                     : client->last_rx_ms + WS_SERVER_PING_INTERVAL_MS;
+        timer_wheel_schedule(&worker->timers, &client->keepalive, due);
+    }
+
+    int rc;
+#ifdef WS_USE_IO_URING
+    if (worker->use_ring) {
+        rc = client->local ? ring_arm_poll_client(client) : ring_arm_recv(client);
+    } else {
+        rc = watch_client(client);
+    }
+#else
+    rc = watch_client(client);
+#endif
+
+    if (rc != 0) {
+        close_client(client);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 將 ws_server_adopt() 接收的客戶端放回所屬 worker (啟動時,尚無 worker 執行緒)
+ *
+ * ID 決定所屬 worker,worker 數與舊程序相同,因此每個客戶端回到相同的 worker。
+ */
+static void restore_adopted_clients(void) {
+    ws_server_handoff_t *handoff = g_server_ctx.adopted;
+    if (handoff == NULL) {
+        return;
+    }
+    g_server_ctx.adopted = NULL;
+
+    for (int i = 0; i < handoff->client_count; i++) {
+        const ws_handoff_client_t *rec = &handoff->clients[i];
+        ws_worker_t *worker = worker_for_client(rec->id);
+        if (worker == NULL) {
+            close(g_server_ctx.adopted_fds[i]);
+            continue;
+        }
+        restore_client(worker, rec, g_server_ctx.adopted_fds[i]);
+    }
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        submit_pending(&g_server_ctx.workers[w]);
+    }
+
+    free(handoff);
+}
+#endif
+
+/**
+ * @brief 丟棄尚未放回的交接客戶端與 listen socket (未啟動就清理時)
+ */
+static void discard_adopted(void) {
+    if (g_server_ctx.adopted == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < g_server_ctx.adopted->client_count; i++) {
+        close(g_server_ctx.adopted_fds[i]);
+    }
+    free(g_server_ctx.adopted);
+    g_server_ctx.adopted = NULL;
+
+    // 本機 socket 檔案仍屬於舊程序的 listener,只關閉 fd
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        if (worker->listen_fd >= 0) {
+            close(worker->listen_fd);
+            worker->listen_fd = -1;
+        }
+        if (worker->local_fd >= 0) {
+            close(worker->local_fd);
+            worker->local_fd = -1;
+        }
+    }
+}
+
+/* ============================================================
+ *  Public Function Implementations
+ * ============================================================ */
+
+/**
+ * @brief 初始化 WebSocket Server
+ */
+int ws_server_init(int port) {
+    if (g_server_ctx.initialized) {
+        return -1;  // 已經初始化
+    }
+
+    // 初始化上下文
+    memset(&g_server_ctx, 0, sizeof(ws_server_context_t));
+
+    g_server_ctx.port = (port > 0) ? port : WS_SERVER_DEFAULT_PORT;
+    g_server_ctx.state = WS_SERVER_STOPPED;
+    g_server_ctx.wake_fd = -1;
+    memcpy(g_server_ctx.rate_limits, g_default_rate_limits, sizeof(g_default_rate_limits));
+    snprintf(g_server_ctx.local_path, sizeof(g_server_ctx.local_path), "%s",
+             WS_SERVER_LOCAL_PATH);
+
+    // 預設單一 worker,由 ws_server_service() 服務
+    if (create_workers(1) != 0) {
+        return -1;
+    }
+
+    g_server_ctx.event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (g_server_ctx.event_fd < 0 ||
+        mpsc_queue_init(&g_server_ctx.events, WS_EVENT_QUEUE_SIZE) != 0) {
+        if (g_server_ctx.event_fd >= 0) {
+            close(g_server_ctx.event_fd);
+        }
+        destroy_workers();
+        return -1;
+    }
+
+    pthread_mutex_init(&g_server_ctx.http_lock, NULL);
+    g_server_ctx.initialized = true;
+
+    return 0;
+}
+
+/**
+ * @brief 設定訊息處理回調
+ */
+void ws_server_set_message_handler(ws_message_handler_t handler,
+                                    void *user_data) {
+    g_server_ctx.message_handler = handler;
+    g_server_ctx.message_handler_data = user_data;
+}
+
+/**
+ * @brief 設定連線回調
+ */
+void ws_server_set_connect_callback(ws_connect_callback_t handler,
+                                     void *user_data) {
+    g_server_ctx.connect_callback = handler;
+    g_server_ctx.connect_callback_data = user_data;
+}
+
+/**
+ * @brief 設定斷線回調
+ */
+void ws_server_set_disconnect_callback(ws_disconnect_callback_t handler,
+                                        void *user_data) {
+    g_server_ctx.disconnect_callback = handler;
+    g_server_ctx.disconnect_callback_data = user_data;
+}
+
+/**
+ * @brief 設定 worker 執行緒數
+ */
+int ws_server_set_workers(int count) {
+    if (!g_server_ctx.initialized || g_server_ctx.state != WS_SERVER_STOPPED ||
+        count < 1 || count > WS_SERVER_MAX_WORKERS ||
+        g_server_ctx.connection_count > 0) {
+        return -1;
+    }
+
+    if (count == g_server_ctx.worker_count) {
+        return 0;
+    }
+
+    destroy_workers();
+    if (create_workers(count) != 0) {
+        // 記憶體不足: 退回單一 worker
+        create_workers(1);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 設定本機 IPC socket 路徑
+ */
+int ws_server_set_local_path(const char *path) {
+    if (!g_server_ctx.initialized || g_server_ctx.state != WS_SERVER_STOPPED) {
+        return -1;
+    }
+
+    if (path == NULL) {
+        path = "";
+    }
+    if (strlen(path) >= sizeof(g_server_ctx.local_path) || strcmp(path, "@") == 0) {
+        return -1;
+    }
+
+    snprintf(g_server_ctx.local_path, sizeof(g_server_ctx.local_path), "%s", path);
+    return 0;
+}
+
+/**
+ * @brief 啟動 WebSocket Server
+ */
+int ws_server_start(void) {
+    if (!g_server_ctx.initialized) {
+        return -1;
+    }
+
+    if (g_server_ctx.state == WS_SERVER_RUNNING) {
+        return 0;  // 已經在運行
+    }
+
+    g_server_ctx.state = WS_SERVER_STARTING;
+
+#ifndef TESTING
+    // 生產環境: 每個 worker 建立自己的 listen socket (或沿用交接的 socket)
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        int ret = open_listener(&g_server_ctx.workers[w]);
+        if (ret != 0) {
+            discard_adopted();
+            for (int i = 0; i < w; i++) {
+                close_worker_fds(&g_server_ctx.workers[i]);
+            }
+            g_server_ctx.state = WS_SERVER_ERROR;
+            return ret;
+        }
+    }
+
+    // 平滑升級: 舊程序交接的客戶端
+    restore_adopted_clients();
+#endif
+
+    __atomic_store_n(&g_server_ctx.state, WS_SERVER_RUNNING, __ATOMIC_RELEASE);
+
+#ifndef TESTING
+    // 多 worker 模式: 每個 worker 在自己的執行緒中服務
+    if (start_worker_threads() != 0) {
+        ws_server_stop();
+        g_server_ctx.state = WS_SERVER_ERROR;
+        return -5;
+    }
+#endif
+
+    update_wake_fd();
+    return 0;
+}
+
+/**
+ * @brief 處理 WebSocket 事件 (非阻塞)
+ */
+int ws_server_service(int timeout_ms) {
+    if (!g_server_ctx.initialized || g_server_ctx.state != WS_SERVER_RUNNING) {
+        return -1;
+    }
+
+#ifndef TESTING
+    if (!is_threaded()) {
+        // 單一 worker: 在呼叫者的執行緒處理 epoll 事件
+        return service_worker(&g_server_ctx.workers[0], timeout_ms);
+    }
+#endif
+
+    // 多 worker (與 TESTING): 等待並執行 worker 轉交的回調
+    struct pollfd pfd = { .fd = g_server_ctx.event_fd, .events = POLLIN, .revents = 0 };
+    if (poll(&pfd, 1, timeout_ms) > 0) {
+        uint64_t count;
+        if (read(g_server_ctx.event_fd, &count, sizeof(count)) < 0) {
+            // 其他呼叫者已讀取
+        }
+    }
+
+    deliver_events();
+    return 0;
+}
+
+/**
+ * @brief 喚醒在 ws_server_service() 中等待的執行緒
+ */
+void ws_server_wake(void) {
+    signal_fd(__atomic_load_n(&g_server_ctx.wake_fd, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * @brief 廣播訊息給所有客戶端
+ */
+int ws_server_broadcast(const char *message) {
+    if (!g_server_ctx.initialized || message == NULL) {
+        return -1;
+    }
+
+    ws_message_t msg = { message, NULL, 0 };
+    int sent_count = publish_shared(0, &msg);
+    trace_publish(sent_count, 0, message);
+    return sent_count;
+}
+
+/**
+ * @brief 發佈訊息給訂閱指定主題的客戶端
+ */
+int ws_server_publish(uint32_t topics, const char *message) {
+    ws_message_t msg = { message, NULL, 0 };
+    return ws_server_publish_message(topics, &msg);
+}
+
+/**
+ * @brief 發佈訊息給訂閱指定主題的客戶端 (依客戶端編碼)
+ */
+int ws_server_publish_message(uint32_t topics, const ws_message_t *message) {
+    if (!g_server_ctx.initialized || message == NULL || message->json == NULL) {
+        return -1;
+    }
+
+    if (topics == 0) {
+        return 0;
+    }
+
+    int sent_count = publish_shared(topics, message);
+    trace_publish(sent_count, topics, message->json);
+    return sent_count;
+}
+
+/**
+ * @brief 為客戶端加入訂閱
+ */
+int64_t ws_server_subscribe(int client_id, uint32_t topics) {
+    if (!g_server_ctx.initialized) {
+        return -1;
+    }
+
+    ws_worker_t *worker = worker_for_client(client_id);
+    if (worker == NULL) {
+        return -2;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+
+    int client_idx = find_client_by_id(worker, client_id);
+    if (client_idx < 0) {
+        pthread_mutex_unlock(&worker->lock);
+        return -2;
+    }
+
+    client_connection_t *client = &worker->clients[client_idx];
+    client->subscriptions &= ~(uint32_t)WS_TOPIC_STATUS_FULL;
+    client->subscriptions |= (topics & WS_TOPIC_ALL);
+    int64_t subscriptions = client->subscriptions;
+
+    pthread_mutex_unlock(&worker->lock);
+    return subscriptions;
+}
+
+/**
+ * @brief 為客戶端取消訂閱
+ */
+int64_t ws_server_unsubscribe(int client_id, uint32_t topics) {
+    if (!g_server_ctx.initialized) {
+        return -1;
+    }
+
+    ws_worker_t *worker = worker_for_client(client_id);
+    if (worker == NULL) {
+        return -2;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+
+    int client_idx = find_client_by_id(worker, client_id);
+    if (client_idx < 0) {
+        pthread_mutex_unlock(&worker->lock);
+        return -2;
+    }
+
+    client_connection_t *client = &worker->clients[client_idx];
+    client->subscriptions &= ~(uint32_t)WS_TOPIC_STATUS_FULL;
+    client->subscriptions &= ~topics;
+    int64_t subscriptions = client->subscriptions;
+
+    pthread_mutex_unlock(&worker->lock);
+    return subscriptions;
+}
+
+/**
+ * @brief 取得訂閱指定主題的客戶端數量
+ */
+int ws_server_get_subscriber_count(uint32_t topics) {
+    if (!g_server_ctx.initialized || topics == 0) {
+        return 0;
+    }
+
+    return count_subscribers(topics);
+}
+
+/**
+ * @brief 登記一個非同步處理中的請求
+ */
+int ws_server_begin_request(int client_id) {
+    if (!g_server_ctx.initialized) {
+        return -1;
+    }
+
+    ws_worker_t *worker = worker_for_client(client_id);
+    if (worker == NULL) {
+        return -2;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+
+    int ret = 0;
+    int client_idx = find_client_by_id(worker, client_id);
+    if (client_idx < 0) {
+        ret = -2;
+    } else if (worker->clients[client_idx].in_flight >= WS_SERVER_MAX_IN_FLIGHT) {
+        ret = -6;
+    } else {
+        worker->clients[client_idx].in_flight++;
+    }
+
+    pthread_mutex_unlock(&worker->lock);
+    return ret;
+}
+
+/**
+ * @brief 結束一個非同步請求
+ */
+void ws_server_end_request(int client_id) {
+    if (!g_server_ctx.initialized) {
+        return;
+    }
+
+    ws_worker_t *worker = worker_for_client(client_id);
+    if (worker == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+
+    int client_idx = find_client_by_id(worker, client_id);
+    if (client_idx >= 0 && worker->clients[client_idx].in_flight > 0) {
+        worker->clients[client_idx].in_flight--;
+    }
+
+    pthread_mutex_unlock(&worker->lock);
 }
 
 /**
- * @brief 設定斷線回調
+ * @brief 設定訊息類型的速率限制
  */
-void ws_server_set_disconnect_callback(ws_disconnect_callback_t handler,
-                                        void *user_data) {
-    g_server_ctx.disconnect_callback = handler;
-    g_server_ctx.disconnect_callback_data = user_data;
+int ws_server_set_rate_limit(ws_message_type_t msg_type, const ws_rate_limit_t *limit) {
+    if (!g_server_ctx.initialized || limit == NULL ||
+        (unsigned)msg_type >= WS_SERVER_RATE_LIMIT_TYPES ||
+        (limit->rate > 0 && limit->burst == 0)) {
+        return -1;
+    }
+
+    ws_rate_limit_t *target = &g_server_ctx.rate_limits[msg_type];
+    __atomic_store_n(&target->rate, limit->rate, __ATOMIC_RELAXED);
+    __atomic_store_n(&target->burst, limit->burst, __ATOMIC_RELAXED);
+    return 0;
 }
 
 /**
- * @brief 啟動 WebSocket Server
+ * @brief 恢復預設速率限制
  */
-int ws_server_start(void) {
+void ws_server_reset_rate_limits(void) {
     if (!g_server_ctx.initialized) {
-        return -1;
+        return;
     }
-    
-    if (g_server_ctx.state == WS_SERVER_RUNNING) {
-        return 0;  // 已經在運行
+
+    for (int i = 0; i < WS_SERVER_RATE_LIMIT_TYPES; i++) {
+        ws_rate_limit_t *target = &g_server_ctx.rate_limits[i];
+        __atomic_store_n(&target->rate, g_default_rate_limits[i].rate, __ATOMIC_RELAXED);
+        __atomic_store_n(&target->burst, g_default_rate_limits[i].burst, __ATOMIC_RELAXED);
     }
-    
-    g_server_ctx.state = WS_SERVER_STARTING;
-    
-#ifndef TESTING
-    // 生產環境: 初始化 libwebsockets
-    // TODO: 實作 libwebsockets 初始化
-    // struct lws_context_creation_info info;
-    // memset(&info, 0, sizeof(info));
-    // info.port = g_server_ctx.port;
-    // info.protocols = protocols;
-    // g_server_ctx.lws_context = lws_create_context(&info);
-#endif
-    
-    g_server_ctx.state = WS_SERVER_RUNNING;
-    return 0;
 }
 
 /**
- * @brief 處理 WebSocket 事件 (非阻塞)
+ * @brief 取得訊息類型的速率限制
  */
-int ws_server_service(int timeout_ms) {
-    if (!g_server_ctx.initialized || g_server_ctx.state != WS_SERVER_RUNNING) {
+int ws_server_get_rate_limit(ws_message_type_t msg_type, ws_rate_limit_t *limit) {
+    if (!g_server_ctx.initialized || limit == NULL ||
+        (unsigned)msg_type >= WS_SERVER_RATE_LIMIT_TYPES) {
         return -1;
     }
-    
-#ifdef TESTING
-    // 測試模式: 什麼都不做
-    (void)timeout_ms;
+
+    const ws_rate_limit_t *source = &g_server_ctx.rate_limits[msg_type];
+    limit->rate = __atomic_load_n(&source->rate, __ATOMIC_RELAXED);
+    limit->burst = __atomic_load_n(&source->burst, __ATOMIC_RELAXED);
     return 0;
-#else
-    // 生產環境: 處理 libwebsockets 事件
-    // return lws_service(g_server_ctx.lws_context, timeout_ms);
+}
+
+/**
+ * @brief 取得訊息類型的速率限制統計
+ */
+int ws_server_get_rate_limit_stats(ws_message_type_t msg_type,
+                                   ws_rate_limit_stats_t *stats)
+{
+    if (!g_server_ctx.initialized || stats == NULL ||
+        (unsigned)msg_type >= WS_SERVER_RATE_LIMIT_TYPES) {
+        return -1;
+    }
+
+    const ws_rate_limit_stats_t *source = &g_server_ctx.rate_stats[msg_type];
+    stats->allowed = __atomic_load_n(&source->allowed, __ATOMIC_RELAXED);
+    stats->limited = __atomic_load_n(&source->limited, __ATOMIC_RELAXED);
     return 0;
-#endif
 }
 
 /**
- * @brief 廣播訊息給所有客戶端
+ * @brief 設定 HTTP 端點提供的狀態
  */
-int ws_server_broadcast(const char *message) {
-    if (!g_server_ctx.initialized || message == NULL) {
+int ws_server_set_http_status(uint64_t version, const char *json) {
+    if (!g_server_ctx.initialized || version == 0 || json == NULL) {
         return -1;
     }
-    
-    int sent_count = 0;
-    
-    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
-        if (g_server_ctx.clients[i].active) {
-            if (ws_server_send(g_server_ctx.clients[i].id, message) == 0) {
-                sent_count++;
-            }
+
+    ws_http_status_t *status = http_status_create(version, json, strlen(json));
+    if (status == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_server_ctx.http_lock);
+    ws_http_status_t *old = g_server_ctx.http_status;
+    g_server_ctx.http_status = status;
+    __atomic_store_n(&g_server_ctx.http_version, version, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&g_server_ctx.http_lock);
+    http_status_unref(old);
+
+    if (__atomic_load_n(&g_server_ctx.state, __ATOMIC_ACQUIRE) != WS_SERVER_RUNNING) {
+        return 0;
+    }
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        if (worker->threaded) {
+            signal_fd(worker->queue_fd);  // 由 worker 執行緒推送
+            continue;
         }
+
+        pthread_mutex_lock(&worker->lock);
+        http_push_status(worker);
+        submit_pending(worker);
+        pthread_mutex_unlock(&worker->lock);
     }
-    
-    return sent_count;
+
+    return 0;
 }
 
 /**
  * @brief 發送訊息給特定客戶端
  */
 int ws_server_send(int client_id, const char *message) {
-    if (!g_server_ctx.initialized || message == NULL) {
+    ws_message_t msg = { message, NULL, 0 };
+    return ws_server_send_message(client_id, &msg);
+}
+
+/**
+ * @brief 發送訊息給特定客戶端 (依客戶端編碼)
+ */
+int ws_server_send_message(int client_id, const ws_message_t *message) {
+    if (!g_server_ctx.initialized || message == NULL || message->json == NULL) {
         return -1;
     }
-    
-    int client_idx = find_client_by_id(client_id);
+
+    ws_worker_t *worker = worker_for_client(client_id);
+    if (worker == NULL) {
+        return -2;  // 客戶端不存在
+    }
+
+    pthread_mutex_lock(&worker->lock);
+
+    int client_idx = find_client_by_id(worker, client_id);
     if (client_idx < 0) {
+        pthread_mutex_unlock(&worker->lock);
         return -2;  // 客戶端不存在
     }
-    
-#ifdef TESTING
-    // 測試模式: 模擬發送成功
-    return 0;
-#else
-    // 生產環境: 使用 libwebsockets 發送
-    // client_connection_t *client = &g_server_ctx.clients[client_idx];
-    // lws_write(client->ws_handle, (unsigned char*)message, strlen(message), LWS_WRITE_TEXT);
-    return 0;
-#endif
+
+    trace_ring_record(TRACE_MSG_OUT, 0, (uint32_t)client_id, (uint32_t)strlen(message->json));
+
+    int ret;
+    if (worker->threaded) {
+        // 由 worker 執行緒發送,與廣播維持先後順序
+        ws_outbound_t *out = create_outbound(client_id, 0, message, 1);
+        ret = (out != NULL) ? post_outbound(worker, out) : -1;
+    } else {
+        ret = send_message(&worker->clients[client_idx], message);
+        submit_pending(worker);
+    }
+
+    pthread_mutex_unlock(&worker->lock);
+    return ret;
 }
 
 /**
  * @brief 取得連線的客戶端數量
  */
 int ws_server_get_client_count(void) {
-    return g_server_ctx.client_count;
+    return __atomic_load_n(&g_server_ctx.client_count, __ATOMIC_RELAXED);
 }
 
 /**
  * @brief 取得客戶端列表
  */
 int ws_server_get_clients(ws_client_info_t *clients, int max_count) {
-    if (clients == NULL || max_count <= 0) {
+    if (clients == NULL || max_count <= 0 || !g_server_ctx.initialized) {
         return 0;
     }
-    
+
     int count = 0;
-    for (int i = 0; i < WS_SERVER_MAX_CLIENTS && count < max_count; i++) {
-        if (g_server_ctx.clients[i].active) {
-            clients[count].id = g_server_ctx.clients[i].id;
-            snprintf(clients[count].ip, sizeof(clients[count].ip), 
-                    "%s", g_server_ctx.clients[i].ip);
-            clients[count].port = g_server_ctx.clients[i].port;
-            clients[count].connect_time = g_server_ctx.clients[i].connect_time;
-            clients[count].active = g_server_ctx.clients[i].active;
-            count++;
-        }
-    }
-    
+    for (int w = 0; w < g_server_ctx.worker_count && count < max_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        pthread_mutex_lock(&worker->lock);
+
+        for (int i = 0; i < WS_SERVER_MAX_CLIENTS && count < max_count; i++) {
+            const client_connection_t *c = &worker->clients[i];
+            if (is_established(c)) {
+                clients[count].id = c->id;
+                snprintf(clients[count].ip, sizeof(clients[count].ip), "%s", c->ip);
+                clients[count].port = c->port;
+                clients[count].connect_time = c->connect_time;
+                clients[count].active = c->active;
+                clients[count].subscriptions = c->subscriptions;
+                clients[count].encoding = c->encoding;
+                clients[count].local = c->local;
+                count++;
+            }
+        }
+
+        pthread_mutex_unlock(&worker->lock);
+    }
+
     return count;
 }
 
@@ -338,6 +3741,264 @@ int ws_server_get_port(void) {
     return g_server_ctx.port;
 }
 
+/**
+ * @brief 變更監聽端口
+ *
+ * 執行中時先為每個 worker 綁定新端口 (任一失敗則全部放棄,
+ * 繼續使用舊端口),再交給 worker 在自己的執行緒換上。
+ */
+int ws_server_set_port(int port) {
+    if (!g_server_ctx.initialized || port <= 0 || port > 65535) {
+        return -1;
+    }
+
+    if (port == g_server_ctx.port) {
+        return 0;
+    }
+
+#ifndef TESTING
+    if (g_server_ctx.state == WS_SERVER_RUNNING) {
+        int fds[WS_SERVER_MAX_WORKERS];
+
+        for (int w = 0; w < g_server_ctx.worker_count; w++) {
+            fds[w] = open_tcp_socket(port);
+            if (fds[w] < 0) {
+                for (int i = 0; i < w; i++) {
+                    close(fds[i]);
+                }
+                return -5;
+            }
+        }
+
+        for (int w = 0; w < g_server_ctx.worker_count; w++) {
+            ws_worker_t *worker = &g_server_ctx.workers[w];
+            int stale = __atomic_exchange_n(&worker->pending_listen_fd, fds[w],
+                                            __ATOMIC_ACQ_REL);
+            if (stale >= 0) {
+                close(stale);  // 上一次變更尚未換上
+            }
+            signal_fd(worker->queue_fd);
+        }
+    }
+#endif
+
+    g_server_ctx.port = port;
+    return 0;
+}
+
+/**
+ * @brief 凍結伺服器並匯出交接狀態
+ *
+ * worker 執行緒結束後由目前的執行緒處理剩下的工作: 取消 io_uring accept、
+ * 送出佇列中的訊息 (也會換上待換的 listener),最後依序收集 fd。
+ */
+int ws_server_export(ws_server_handoff_t *handoff, int *fds, int max_fds) {
+    if (!g_server_ctx.initialized || handoff == NULL || fds == NULL ||
+        max_fds < WS_SERVER_HANDOFF_MAX_FDS || g_server_ctx.state != WS_SERVER_RUNNING) {
+        return -1;
+    }
+
+    // TESTING 版本沒有 socket 可交接
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        if (g_server_ctx.workers[w].listen_fd < 0) {
+            return -1;
+        }
+    }
+
+    __atomic_store_n(&g_server_ctx.state, WS_SERVER_STOPPING, __ATOMIC_RELEASE);
+    update_wake_fd();
+    join_worker_threads();
+    deliver_events();
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        pthread_mutex_lock(&worker->lock);
+#if defined(WS_USE_IO_URING) && !defined(TESTING)
+        if (worker->use_ring) {
+            ring_stop_accepting(worker);
+        }
+#endif
+        drain_inbound(worker);
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    memset(handoff, 0, sizeof(*handoff));
+    handoff->port = g_server_ctx.port;
+    handoff->worker_count = g_server_ctx.worker_count;
+
+    int fd_count = 0;
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        fds[fd_count++] = g_server_ctx.workers[w].listen_fd;
+    }
+    if (g_server_ctx.workers[0].local_fd >= 0) {
+        snprintf(handoff->local_path, sizeof(handoff->local_path), "%s",
+                 g_server_ctx.local_path);
+        fds[fd_count++] = g_server_ctx.workers[0].local_fd;
+    }
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        pthread_mutex_lock(&worker->lock);
+
+        for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+            client_connection_t *client = &worker->clients[i];
+            if (!client->active) {
+                continue;
+            }
+
+            // 寫不完的資料留在 tx_buf,該連線不交接
+            if (client->tx_len > 0 && flush_client(client) != 0) {
+                close_client(client);
+                continue;
+            }
+
+            if (can_hand_off(client)) {
+                export_client(client, &handoff->clients[handoff->client_count++]);
+                fds[fd_count++] = client->fd;
+            } else if (client->upgraded) {
+                close_client_with_code(client, WS_CLOSE_SERVICE_RESTART);
+            } else {
+                close_client(client);
+            }
+        }
+
+        submit_pending(worker);
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    // 關閉連線的斷線回調
+    deliver_events();
+    return fd_count;
+}
+
+/**
+ * @brief 解除凍結 (交接失敗)
+ */
+void ws_server_resume(void) {
+    if (!g_server_ctx.initialized || g_server_ctx.handed_off ||
+        g_server_ctx.state != WS_SERVER_STOPPING) {
+        return;
+    }
+
+#ifdef WS_USE_IO_URING
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        if (worker->use_ring) {
+            ring_arm_accept(worker, WS_URING_OP_ACCEPT);
+            if (worker->local_fd >= 0) {
+                ring_arm_accept(worker, WS_URING_OP_LOCAL_ACCEPT);
+            }
+            ws_uring_submit(&worker->ring);
+        }
+    }
+#endif
+
+    __atomic_store_n(&g_server_ctx.state, WS_SERVER_RUNNING, __ATOMIC_RELEASE);
+
+#ifndef TESTING
+    if (start_worker_threads() != 0) {
+        ws_server_stop();
+        g_server_ctx.state = WS_SERVER_ERROR;
+        return;
+    }
+#endif
+
+    update_wake_fd();
+}
+
+/**
+ * @brief 新程序已接手: 只關閉本程序的 fd
+ *
+ * 連線由兩個程序共用同一個 socket,關閉本程序的 fd 不影響連線;
+ * 不經過 detach_client() (io_uring 時會 shutdown 連線),也不觸發斷線回調。
+ */
+void ws_server_release(void) {
+    if (!g_server_ctx.initialized || g_server_ctx.state != WS_SERVER_STOPPING) {
+        return;
+    }
+
+    g_server_ctx.handed_off = true;
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        pthread_mutex_lock(&worker->lock);
+
+        ws_outbound_t *out;
+        while ((out = mpsc_queue_pop(&worker->inbound)) != NULL) {
+            release_outbound(out);
+        }
+
+        for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+            client_connection_t *client = &worker->clients[i];
+            if (!client->active) {
+                continue;
+            }
+            if (client->fd >= 0) {
+                close(client->fd);
+            }
+            timer_wheel_cancel(&worker->timers, &client->keepalive);
+            ws_inflater_destroy(client->inflater);
+            client->inflater = NULL;
+            client->active = false;
+            client->upgraded = false;
+            client->fd = -1;
+            client->rx_len = 0;
+            client->tx_len = 0;
+        }
+
+#ifndef TESTING
+        close_worker_fds(worker);
+#endif
+
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    g_server_ctx.client_count = 0;
+    g_server_ctx.connection_count = 0;
+    g_server_ctx.state = WS_SERVER_STOPPED;
+}
+
+/**
+ * @brief 接收舊程序交接的 socket 與客戶端
+ */
+int ws_server_adopt(const ws_server_handoff_t *handoff, const int *fds, int fd_count) {
+    if (!g_server_ctx.initialized || g_server_ctx.state != WS_SERVER_STOPPED ||
+        handoff == NULL || fds == NULL || g_server_ctx.adopted != NULL ||
+        handoff->worker_count != g_server_ctx.worker_count ||
+        handoff->port <= 0 || handoff->port > 65535 ||
+        handoff->client_count < 0 || handoff->client_count > WS_SERVER_MAX_CLIENTS ||
+        memchr(handoff->local_path, '\0', sizeof(handoff->local_path)) == NULL) {
+        return -1;
+    }
+
+    int listeners = handoff->worker_count + (handoff->local_path[0] != '\0' ? 1 : 0);
+    if (fd_count != listeners + handoff->client_count) {
+        return -1;
+    }
+
+    ws_server_handoff_t *adopted = malloc(sizeof(*adopted));
+    if (adopted == NULL) {
+        return -1;
+    }
+    memcpy(adopted, handoff, sizeof(*adopted));
+
+    g_server_ctx.port = handoff->port;
+    snprintf(g_server_ctx.local_path, sizeof(g_server_ctx.local_path), "%s",
+             handoff->local_path);
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        g_server_ctx.workers[w].listen_fd = fds[w];
+    }
+    if (handoff->local_path[0] != '\0') {
+        g_server_ctx.workers[0].local_fd = fds[handoff->worker_count];
+    }
+
+    memcpy(g_server_ctx.adopted_fds, fds + listeners,
+           (size_t)handoff->client_count * sizeof(int));
+    g_server_ctx.adopted = adopted;
+    return 0;
+}
+
 /**
  * @brief 停止 WebSocket Server
  */
@@ -345,31 +4006,51 @@ void ws_server_stop(void) {
     if (!g_server_ctx.initialized) {
         return;
     }
-    
-    g_server_ctx.state = WS_SERVER_STOPPING;
-    
-#ifndef TESTING
-    // 生產環境: 關閉 libwebsockets
-    // if (g_server_ctx.lws_context) {
-    //     lws_context_destroy(g_server_ctx.lws_context);
-    //     g_server_ctx.lws_context = NULL;
-    // }
-#endif
-    
-    // 斷開所有客戶端
-    for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
-        if (g_server_ctx.clients[i].active) {
-            if (g_server_ctx.disconnect_callback) {
-                g_server_ctx.disconnect_callback(
-                    g_server_ctx.clients[i].id,
-                    g_server_ctx.disconnect_callback_data
-                );
+
+    __atomic_store_n(&g_server_ctx.state, WS_SERVER_STOPPING, __ATOMIC_RELEASE);
+    update_wake_fd();
+
+    // 先停止 worker 執行緒,之後所有客戶端都由目前的執行緒處理
+    join_worker_threads();
+
+    // 已轉交但尚未執行的回調
+    deliver_events();
+
+    for (int w = 0; w < g_server_ctx.worker_count; w++) {
+        ws_worker_t *worker = &g_server_ctx.workers[w];
+        pthread_mutex_lock(&worker->lock);
+
+        // 丟棄尚未發送的訊息
+        ws_outbound_t *out;
+        while ((out = mpsc_queue_pop(&worker->inbound)) != NULL) {
+            release_outbound(out);
+        }
+
+#if defined(WS_USE_IO_URING) && !defined(TESTING)
+        // ring 關閉後才非同步釋放 accept 持有的 listen socket: 立即重新啟動時
+        // 綁定失敗,SO_REUSEPORT 時新連線還會被分到舊 socket 而遭重置
+        if (worker->use_ring) {
+            ring_stop_accepting(worker);
+        }
+#endif
+
+        // 斷開所有客戶端
+        for (int i = 0; i < WS_SERVER_MAX_CLIENTS; i++) {
+            if (worker->clients[i].active) {
+                close_client_with_code(&worker->clients[i], WS_CLOSE_GOING_AWAY);
             }
-            g_server_ctx.clients[i].active = false;
         }
+
+#ifndef TESTING
+        // 生產環境: 關閉 listen socket
+        close_worker_fds(worker);
+#endif
+
+        pthread_mutex_unlock(&worker->lock);
     }
-    
+
     g_server_ctx.client_count = 0;
+    g_server_ctx.connection_count = 0;
     g_server_ctx.state = WS_SERVER_STOPPED;
 }
 
@@ -377,11 +4058,31 @@ void ws_server_stop(void) {
  * @brief 清理資源
  */
 void ws_server_cleanup(void) {
+    if (!g_server_ctx.initialized) {
+        return;
+    }
+
     if (g_server_ctx.state == WS_SERVER_RUNNING) {
         ws_server_stop();
     }
-    
+
+    // 接收後未啟動的交接
+    discard_adopted();
+
+    // 未交付的事件
+    ws_event_t *event;
+    while ((event = mpsc_queue_pop(&g_server_ctx.events)) != NULL) {
+        free(event);
+    }
+    mpsc_queue_destroy(&g_server_ctx.events);
+    close(g_server_ctx.event_fd);
+
+    destroy_workers();
+    ws_deflate_cleanup();
+    http_status_unref(g_server_ctx.http_status);
+    pthread_mutex_destroy(&g_server_ctx.http_lock);
     memset(&g_server_ctx, 0, sizeof(ws_server_context_t));
+    g_server_ctx.wake_fd = -1;
 }
 
 /**
@@ -394,10 +4095,73 @@ const char* ws_message_type_to_string(ws_message_type_t msg_type) {
         case WS_MSG_WAKE_PS5:   return "wake_ps5";
         case WS_MSG_PING:       return "ping";
         case WS_MSG_PONG:       return "pong";
+        case WS_MSG_SUBSCRIBE:  return "subscribe";
+        case WS_MSG_UNSUBSCRIBE: return "unsubscribe";
+        case WS_MSG_DEBUG_DUMP: return "debug_dump";
+        case WS_MSG_SERVER_STATE_HISTORY: return "server_state_history";
+        case WS_MSG_PS5_STATUS: return "ps5_status";
+        case WS_MSG_NOT_MODIFIED: return "not_modified";
+        case WS_MSG_PS5_DELTA:  return "ps5_delta";
+        case WS_MSG_WAKE_RESULT: return "wake_result";
+        case WS_MSG_WAKE_EVENT: return "wake_event";
+        case WS_MSG_STATS:      return "stats";
+        case WS_MSG_SUBSCRIBED: return "subscribed";
+        case WS_MSG_ERROR:      return "error";
         default:                return "invalid";
     }
 }
 
+/**
+ * @brief 字串轉換為訊息類型
+ */
+ws_message_type_t ws_message_type_from_string(const char *name) {
+    if (name == NULL) {
+        return WS_MSG_UNKNOWN;
+    }
+
+    // 標籤皆小於 32 (CBOR 單一 byte 可表示至 23)
+    for (int tag = WS_MSG_UNKNOWN + 1; tag < 32; tag++) {
+        const char *type_name = ws_message_type_to_string((ws_message_type_t)tag);
+        if (strcmp(type_name, "invalid") != 0 && strcmp(name, type_name) == 0) {
+            return (ws_message_type_t)tag;
+        }
+    }
+
+    return WS_MSG_UNKNOWN;
+}
+
+/**
+ * @brief 主題轉換為字串
+ */
+const char* ws_topic_to_string(ws_topic_t topic) {
+    switch (topic) {
+        case WS_TOPIC_POWER:        return "power";
+        case WS_TOPIC_NETWORK:      return "network";
+        case WS_TOPIC_SERVER_STATE: return "server_state";
+        case WS_TOPIC_WAKE:         return "wake";
+        case WS_TOPIC_STATS:        return "stats";
+        default:                    return NULL;
+    }
+}
+
+/**
+ * @brief 字串轉換為主題
+ */
+uint32_t ws_topic_from_string(const char *name) {
+    if (name == NULL) {
+        return 0;
+    }
+
+    for (uint32_t bit = 1; bit & WS_TOPIC_ALL; bit <<= 1) {
+        const char *topic_name = ws_topic_to_string((ws_topic_t)bit);
+        if (topic_name && strcmp(name, topic_name) == 0) {
+            return bit;
+        }
+    }
+
+    return 0;
+}
+
 /**
  * @brief 伺服器狀態轉換為字串
  */
@@ -422,6 +4186,8 @@ const char* ws_server_error_string(int error) {
         case -2: return "Client not found";
         case -3: return "Server not running";
         case -4: return "Max clients reached";
+        case -5: return "Socket error";
+        case -6: return "Too many requests in flight";
         default: return "Unknown error";
     }
 }
@@ -433,34 +4199,47 @@ const char* ws_server_error_string(int error) {
 #ifdef TESTING
 
 /**
- * @brief 模擬客戶端連線 (測試用)
+ * @brief 模擬客戶端連線 (測試用, 加入第一個 worker)
  */
 int ws_server_test_add_client(const char *ip, uint16_t port) {
     if (!g_server_ctx.initialized) {
         return -1;
     }
-    
-    int slot = find_free_client_slot();
-    if (slot < 0) {
+
+    ws_worker_t *worker = &g_server_ctx.workers[0];
+    int slot = find_free_client_slot(worker);
+    if (slot < 0 || g_server_ctx.connection_count >= WS_SERVER_MAX_CLIENTS) {
         return -4;  // 達到最大客戶端數
     }
-    
-    int client_id = g_server_ctx.next_client_id++;
-    
-    g_server_ctx.clients[slot].id = client_id;
-    snprintf(g_server_ctx.clients[slot].ip, sizeof(g_server_ctx.clients[slot].ip), 
-            "%s", ip);
-    g_server_ctx.clients[slot].port = port;
-    g_server_ctx.clients[slot].connect_time = time(NULL);
-    g_server_ctx.clients[slot].active = true;
+
+    client_connection_t *client = &worker->clients[slot];
+    int client_id = next_client_id(worker);
+
+    client->id = client_id;
+    snprintf(client->ip, sizeof(client->ip), "%s", ip);
+    client->port = port;
+    client->connect_time = vclock_time();
+    client->active = true;
+    client->upgraded = true;
+    client->local = false;
+    client->fd = -1;
+    client->subscriptions = WS_TOPIC_STATUS_FULL;
+    client->encoding = WS_ENCODING_JSON;
+    client->in_flight = 0;
+    client->deflate.enabled = false;
+    client->inflater = NULL;
+    client->rx_len = 0;
+    client->tx_len = 0;
+    tw_timer_init(&client->keepalive, on_keepalive_timer, client);
+    g_server_ctx.connection_count++;
     g_server_ctx.client_count++;
-    
+
     // 觸發連線回調
     if (g_server_ctx.connect_callback) {
-        g_server_ctx.connect_callback(client_id, ip, 
+        g_server_ctx.connect_callback(client_id, ip,
                                       g_server_ctx.connect_callback_data);
     }
-    
+
     return client_id;
 }
 
@@ -468,20 +4247,18 @@ int ws_server_test_add_client(const char *ip, uint16_t port) {
  * @brief 模擬客戶端斷線 (測試用)
  */
 int ws_server_test_remove_client(int client_id) {
-    int client_idx = find_client_by_id(client_id);
-    if (client_idx < 0) {
+    ws_worker_t *worker = worker_for_client(client_id);
+    if (worker == NULL) {
         return -2;
     }
-    
-    g_server_ctx.clients[client_idx].active = false;
-    g_server_ctx.client_count--;
-    
-    // 觸發斷線回調
-    if (g_server_ctx.disconnect_callback) {
-        g_server_ctx.disconnect_callback(client_id, 
-                                         g_server_ctx.disconnect_callback_data);
+
+    int client_idx = find_client_by_id(worker, client_id);
+    if (client_idx < 0) {
+        return -2;
     }
-    
+
+    close_client(&worker->clients[client_idx]);
+
     return 0;
 }
 
@@ -492,9 +4269,9 @@ char* ws_server_test_handle_message(int client_id, const char *message) {
     if (!g_server_ctx.message_handler) {
         return NULL;
     }
-    
+
     ws_message_type_t msg_type = parse_message_type(message);
-    
+
     return g_server_ctx.message_handler(client_id, msg_type, message,
                                         g_server_ctx.message_handler_data);
 }
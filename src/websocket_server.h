@@ -5,9 +5,36 @@
  * 此模組提供 WebSocket 伺服器功能:
  * - 監聽客戶端連線
  * - 處理多個客戶端
- * - 接收並回應 JSON 訊息
+ * - 接收並回應 JSON 訊息 (或以 gaming.v1.cbor 子協定交換 CBOR)
  * - 廣播狀態變更
  * 
+ * 執行緒模型:
+ * - 預設 (1 個 worker): 所有 I/O 與回調都在呼叫 ws_server_service() 的執行緒
+ * - N 個 worker (ws_server_set_workers()): 每個 worker 執行緒以 SO_REUSEPORT
+ *   擁有自己的 listen socket、epoll 與一部分客戶端;送往客戶端的訊息經由
+ *   各 worker 的 lock-free 佇列轉交,連線/斷線/訊息回調則交回呼叫
+ *   ws_server_service() 的執行緒 (擁有者執行緒) 依序執行,
+ *   因此回調中可以直接操作狀態機
+ * 
+ * 本機 IPC (ws_server_set_local_path()):
+ * - 另外監聽 AF_UNIX SOCK_SEQPACKET socket,預設為 abstract namespace 的
+ *   WS_SERVER_LOCAL_PATH,供路由器上的其他程序 (LuCI、LED/按鍵 daemon) 使用
+ * - 每個封包即一則 JSON 訊息,沒有 HTTP 握手、WebSocket 訊框與 keepalive
+ * - 與 WebSocket 客戶端共用訊息處理器、速率限制、訂閱與客戶端 ID
+ * 
+ * HTTP 端點 (ws_server_set_http_status()):
+ * - 同一個端口上不升級的 GET 請求: /status (ETag)、/status?version=N
+ *   (長輪詢)、/events (Server-Sent Events)
+ * - 回應在狀態變更時預先組裝一次,與 WebSocket 客戶端共用事件迴圈與槽位
+ * - GET /metrics: metrics.h 的 Prometheus 指標 (訊息數、處理器延遲、廣播時間等)
+ * 
+ * 平滑升級 (ws_server_export() / ws_server_adopt()):
+ * - 舊程序凍結所有 worker,把 listen socket 與可交接的客戶端 (已完成握手、
+ *   沒有未處理完的收發資料) 的 fd 與協定狀態交給新程序
+ * - 新程序在 ws_server_start() 前接收,客戶端 ID、訂閱、編碼與速率狀態不變,
+ *   客戶端不會看到斷線;無法交接的連線以 1012 (Service Restart) 關閉
+ * - 交接失敗時舊程序以 ws_server_resume() 繼續服務
+ * 
  * @author Gaming System Development Team
  * @date 2025-11-05
  * @version 1.0.0
@@ -37,8 +64,10 @@ extern "C" {
 /** 預設 WebSocket 端口 */
 #define WS_SERVER_DEFAULT_PORT          8080
 
-/** 最大客戶端連線數 */
+/** 最大客戶端連線數 (所有 worker 合計) */
+#ifndef WS_SERVER_MAX_CLIENTS
 #define WS_SERVER_MAX_CLIENTS           10
+#endif
 
 /** 最大訊息大小 (bytes) */
 #define WS_SERVER_MAX_MESSAGE_SIZE      4096
@@ -49,6 +78,47 @@ extern "C" {
 /** Pong 超時 (毫秒) */
 #define WS_SERVER_PONG_TIMEOUT_MS       5000
 
+/** 握手超時 (毫秒), 連線後未完成 Upgrade 即關閉 (亦為 HTTP keep-alive 閒置上限) */
+#define WS_SERVER_HANDSHAKE_TIMEOUT_MS  5000
+
+/** HTTP 長輪詢最長等待時間 (毫秒), 逾時回應 304 */
+#define WS_SERVER_LONG_POLL_TIMEOUT_MS  25000
+
+/** 每個來源 IP 每秒允許的新連線數 (0 表示不限制) */
+#ifndef WS_SERVER_ACCEPT_RATE
+#define WS_SERVER_ACCEPT_RATE           5
+#endif
+
+/** 每個來源 IP 可瞬間建立的連線數 */
+#ifndef WS_SERVER_ACCEPT_BURST
+#define WS_SERVER_ACCEPT_BURST          10
+#endif
+
+/** 本機 IPC socket 預設路徑 ('@' 開頭表示 abstract namespace) */
+#define WS_SERVER_LOCAL_PATH            "@gaming-server"
+
+/** 本機 IPC socket 路徑長度上限 (含結尾 '\0', 同 sockaddr_un.sun_path) */
+#define WS_SERVER_LOCAL_PATH_MAX        108
+
+/** worker 執行緒數上限 */
+#define WS_SERVER_MAX_WORKERS           16
+
+/** 每個連線同時處理中的非同步請求上限 */
+#define WS_SERVER_MAX_IN_FLIGHT         4
+
+/**
+ * 可限制速率的訊息類型數 (客戶端送出的類型 WS_MSG_UNKNOWN - WS_MSG_SERVER_STATE_HISTORY;
+ * 客戶端送來的其他類型以 WS_MSG_UNKNOWN 計算)
+ */
+#define WS_SERVER_RATE_LIMIT_TYPES      (WS_MSG_SERVER_STATE_HISTORY + 1)
+
+/** 平滑升級交接的 fd 上限 (每個 worker 的 listen socket、本機 IPC socket、客戶端) */
+#define WS_SERVER_HANDOFF_MAX_FDS       (WS_SERVER_MAX_WORKERS + 1 + WS_SERVER_MAX_CLIENTS)
+
+/** 子協定 (Sec-WebSocket-Protocol) */
+#define WS_SUBPROTOCOL_JSON             "gaming.v1.json"
+#define WS_SUBPROTOCOL_CBOR             "gaming.v1.cbor"
+
 /* ============================================================
  *  Type Definitions
  * ============================================================ */
@@ -64,6 +134,35 @@ typedef enum {
     WS_SERVER_ERROR,            /**< 錯誤狀態 */
 } ws_server_state_t;
 
+/**
+ * @brief 訂閱主題 (可用 | 組合為 bitmask)
+ */
+typedef enum {
+    WS_TOPIC_POWER          = 1u << 0,  /**< PS5 電源狀態 */
+    WS_TOPIC_NETWORK        = 1u << 1,  /**< PS5 網路狀態 */
+    WS_TOPIC_SERVER_STATE   = 1u << 2,  /**< 伺服器狀態機狀態 */
+    WS_TOPIC_WAKE           = 1u << 3,  /**< 喚醒事件 */
+    WS_TOPIC_STATS          = 1u << 4,  /**< 統計資訊 */
+    
+    /**
+     * 尚未送出 subscribe/unsubscribe 的舊版客戶端:
+     * 電源改變時收到完整 ps5_status (相容舊行為)
+     */
+    WS_TOPIC_STATUS_FULL    = 1u << 15,
+} ws_topic_t;
+
+/** 所有可由客戶端訂閱的主題 */
+#define WS_TOPIC_ALL    (WS_TOPIC_POWER | WS_TOPIC_NETWORK | \
+                         WS_TOPIC_SERVER_STATE | WS_TOPIC_WAKE | WS_TOPIC_STATS)
+
+/**
+ * @brief 訊息編碼 (握手時以子協定協商)
+ */
+typedef enum {
+    WS_ENCODING_JSON = 0,       /**< JSON 文字訊框 (預設) */
+    WS_ENCODING_CBOR,           /**< CBOR 二進位訊框 */
+} ws_encoding_t;
+
 /**
  * @brief 客戶端資訊
  */
@@ -73,25 +172,105 @@ typedef struct {
     uint16_t port;              /**< 端口 */
     time_t connect_time;        /**< 連線時間 */
     bool active;                /**< 是否活躍 */
+    uint32_t subscriptions;     /**< 訂閱主題 bitmask */
+    ws_encoding_t encoding;     /**< 訊息編碼 */
+    bool local;                 /**< 本機 IPC 連線 (ip 為 "local") */
 } ws_client_info_t;
 
 /**
  * @brief WebSocket 訊息類型
+ * 
+ * 數值即為 CBOR 編碼中的訊息標籤,已發佈的值不可更改
  */
 typedef enum {
     WS_MSG_UNKNOWN = 0,         /**< 未知訊息 */
-    WS_MSG_QUERY_PS5,           /**< 查詢 PS5 狀態 */
-    WS_MSG_WAKE_PS5,            /**< 喚醒 PS5 */
-    WS_MSG_PING,                /**< Ping */
-    WS_MSG_PONG,                /**< Pong */
+    WS_MSG_QUERY_PS5 = 1,       /**< 查詢 PS5 狀態 */
+    WS_MSG_WAKE_PS5 = 2,        /**< 喚醒 PS5 */
+    WS_MSG_PING = 3,            /**< Ping */
+    WS_MSG_PONG = 4,            /**< Pong */
+    WS_MSG_SUBSCRIBE = 5,       /**< 訂閱主題 */
+    WS_MSG_UNSUBSCRIBE = 6,     /**< 取消訂閱主題 */
+    WS_MSG_DEBUG_DUMP = 7,      /**< 讀取 flight recorder 記錄 (回應類型相同) */
+    WS_MSG_SERVER_STATE_HISTORY = 8, /**< 讀取狀態轉換歷史 (回應類型相同) */
+    
+    /* 伺服器 → 客戶端 */
+    WS_MSG_PS5_STATUS = 16,     /**< 完整狀態快照 */
+    WS_MSG_NOT_MODIFIED = 17,   /**< 快照未變更 */
+    WS_MSG_PS5_DELTA = 18,      /**< 狀態差異 */
+    WS_MSG_WAKE_RESULT = 19,    /**< 喚醒結果 */
+    WS_MSG_WAKE_EVENT = 20,     /**< 喚醒事件 */
+    WS_MSG_STATS = 21,          /**< 統計差異 */
+    WS_MSG_SUBSCRIBED = 22,     /**< 訂閱結果 */
+    WS_MSG_ERROR = 23,          /**< 請求錯誤 */
 } ws_message_type_t;
 
+/**
+ * @brief 外送訊息 (可同時帶有兩種編碼)
+ * 
+ * cbor 為 NULL 時,送給 CBOR 客戶端前由 json 轉碼
+ */
+typedef struct {
+    const char *json;           /**< JSON 文字 */
+    const uint8_t *cbor;        /**< 預先編碼的 CBOR (可為 NULL) */
+    size_t cbor_len;            /**< CBOR 長度 */
+} ws_message_t;
+
+/**
+ * @brief 訊息速率限制 (每個客戶端、每種訊息類型各一個令牌桶)
+ */
+typedef struct {
+    uint32_t rate;              /**< 每秒允許的訊息數, 0 表示不限制 */
+    uint32_t burst;             /**< 可連續送出的訊息數 */
+} ws_rate_limit_t;
+
+/**
+ * @brief 訊息速率限制統計 (所有客戶端合計, 溢位後從 0 開始)
+ */
+typedef struct {
+    uint32_t allowed;           /**< 交給訊息處理器的訊息數 */
+    uint32_t limited;           /**< 超過速率而回覆 rate_limited 的訊息數 */
+} ws_rate_limit_stats_t;
+
+/**
+ * @brief 交接的客戶端 (平滑升級)
+ */
+typedef struct {
+    int id;                     /**< 客戶端 ID (新程序沿用) */
+    char ip[16];                /**< IP 位址 */
+    uint16_t port;              /**< 端口 */
+    bool local;                 /**< 本機 IPC 連線 */
+    time_t connect_time;        /**< 連線時間 */
+    uint32_t subscriptions;     /**< 訂閱主題 bitmask */
+    ws_encoding_t encoding;     /**< 訊息編碼 */
+    bool deflate;               /**< permessage-deflate (只交接 client_no_context_takeover) */
+    uint8_t server_max_window_bits;
+    uint8_t client_max_window_bits;
+    uint64_t last_rx_ms;        /**< 最後收到資料的時間 (CLOCK_MONOTONIC, 兩個程序共用) */
+    uint64_t ping_sent_ms;      /**< 等待 pong 的 ping 時間, 0 表示未等待 */
+    uint32_t rate_tokens[WS_SERVER_RATE_LIMIT_TYPES];   /**< 速率令牌桶 */
+    uint64_t rate_last_ms[WS_SERVER_RATE_LIMIT_TYPES];
+} ws_handoff_client_t;
+
+/**
+ * @brief 交接的伺服器狀態 (fd 另外以 SCM_RIGHTS 傳遞)
+ * 
+ * fd 順序: 每個 worker 的 listen socket (worker_count 個)、
+ * 本機 IPC socket (local_path 非空時)、clients[] 依序的 socket。
+ */
+typedef struct {
+    int port;                   /**< 監聽端口 */
+    int worker_count;           /**< worker 數 (新程序必須相同) */
+    char local_path[WS_SERVER_LOCAL_PATH_MAX];  /**< 本機 IPC 路徑, 空字串表示沒有 */
+    int client_count;           /**< clients[] 的有效筆數 */
+    ws_handoff_client_t clients[WS_SERVER_MAX_CLIENTS];
+} ws_server_handoff_t;
+
 /**
  * @brief 訊息處理回調函數類型
  * 
  * @param client_id 客戶端 ID
  * @param msg_type 訊息類型
- * @param payload 訊息內容 (JSON 字串)
+ * @param payload 訊息內容 (JSON 字串, CBOR 客戶端的訊息已轉為 JSON)
  * @param user_data 使用者資料
  * @return 回應訊息 (JSON 字串,需由呼叫者使用 free() 釋放), NULL 表示不回應
  */
@@ -159,6 +338,30 @@ void ws_server_set_connect_callback(ws_connect_callback_t handler,
 void ws_server_set_disconnect_callback(ws_disconnect_callback_t handler,
                                         void *user_data);
 
+/**
+ * @brief 設定 worker 執行緒數 (須在 ws_server_start() 之前呼叫)
+ * 
+ * 1 (預設) 表示不建立執行緒,由 ws_server_service() 處理所有 I/O。
+ * 大於 1 時 ws_server_start() 會建立對應數量的 worker,
+ * WS_SERVER_MAX_CLIENTS 仍是所有 worker 合計的上限。
+ * 
+ * @param count worker 數 (1 - WS_SERVER_MAX_WORKERS)
+ * @return 0 成功, -1 參數無效或伺服器已啟動
+ */
+int ws_server_set_workers(int count);
+
+/**
+ * @brief 設定本機 IPC socket 路徑 (須在 ws_server_start() 之前呼叫)
+ * 
+ * '@' 開頭表示 abstract namespace (例如 "@gaming-server"),
+ * 其他值為檔案系統路徑 (啟動時移除殘留檔案,停止時刪除)。
+ * 本機客戶端以 SOCK_SEQPACKET 連線,每個封包為一則 JSON 訊息。
+ * 
+ * @param path 路徑, NULL 或空字串表示不監聽
+ * @return 0 成功, -1 路徑過長或伺服器已啟動
+ */
+int ws_server_set_local_path(const char *path);
+
 /**
  * @brief 啟動 WebSocket Server
  * 
@@ -167,15 +370,25 @@ void ws_server_set_disconnect_callback(ws_disconnect_callback_t handler,
 int ws_server_start(void);
 
 /**
- * @brief 處理 WebSocket 事件 (非阻塞)
+ * @brief 等待並處理 WebSocket 事件
  * 
- * 此函數應該在主循環中定期呼叫
+ * 主循環的等待點: 阻塞到有 I/O、worker 轉交的回調、ws_server_wake()
+ * 或 timeout_ms 到期。多 worker 模式下只負責在呼叫者的執行緒執行
+ * worker 轉交的回調。
  * 
  * @param timeout_ms 超時時間 (毫秒), 0 為立即返回
- * @return 0 成功, <0 失敗
+ * @return 0 成功, <0 失敗 (伺服器未執行時立即返回)
  */
 int ws_server_service(int timeout_ms);
 
+/**
+ * @brief 喚醒在 ws_server_service() 中等待的執行緒
+ * 
+ * 只寫入 eventfd,可在信號處理與其他執行緒呼叫 (async-signal-safe)。
+ * 伺服器未執行時不做任何事。
+ */
+void ws_server_wake(void);
+
 /**
  * @brief 廣播訊息給所有客戶端
  * 
@@ -193,6 +406,127 @@ int ws_server_broadcast(const char *message);
  */
 int ws_server_send(int client_id, const char *message);
 
+/**
+ * @brief 發佈訊息給訂閱指定主題的客戶端
+ * 
+ * @param topics 主題 bitmask,客戶端訂閱任一主題即會收到
+ * @param message 訊息內容 (JSON 字串)
+ * @return 成功發送的客戶端數量, <0 失敗
+ */
+int ws_server_publish(uint32_t topics, const char *message);
+
+/**
+ * @brief 發送訊息給特定客戶端 (依客戶端編碼選擇 JSON 或 CBOR)
+ * 
+ * @param client_id 客戶端 ID
+ * @param message 訊息
+ * @return 0 成功, <0 失敗
+ */
+int ws_server_send_message(int client_id, const ws_message_t *message);
+
+/**
+ * @brief 發佈訊息給訂閱指定主題的客戶端 (依客戶端編碼選擇 JSON 或 CBOR)
+ * 
+ * 多 worker 模式下訊息排入各 worker 的佇列後即返回,
+ * 回傳值為當下的訂閱者數量。
+ * 
+ * @param topics 主題 bitmask
+ * @param message 訊息
+ * @return 成功發送的客戶端數量, <0 失敗
+ */
+int ws_server_publish_message(uint32_t topics, const ws_message_t *message);
+
+/**
+ * @brief 設定 HTTP 端點提供的狀態 (每次狀態快照更新時呼叫)
+ * 
+ * 立即組裝 200 / 304 回應與 SSE 事件,並推送給 /events 串流與
+ * 等待此版本之後變更的長輪詢客戶端。尚未設定時 HTTP 端點回應 503。
+ * 
+ * @param version 狀態版本 (ETag 與 SSE 事件 id), 必須 >0
+ * @param json 狀態 JSON (不可包含換行)
+ * @return 0 成功, -1 參數無效或記憶體不足
+ */
+int ws_server_set_http_status(uint64_t version, const char *json);
+
+/**
+ * @brief 為客戶端加入訂閱
+ * 
+ * 第一次呼叫時會清除舊版相容的 WS_TOPIC_STATUS_FULL
+ * 
+ * @param client_id 客戶端 ID
+ * @param topics 主題 bitmask
+ * @return 更新後的訂閱 bitmask, <0 失敗
+ */
+int64_t ws_server_subscribe(int client_id, uint32_t topics);
+
+/**
+ * @brief 為客戶端取消訂閱
+ * 
+ * @param client_id 客戶端 ID
+ * @param topics 主題 bitmask
+ * @return 更新後的訂閱 bitmask, <0 失敗
+ */
+int64_t ws_server_unsubscribe(int client_id, uint32_t topics);
+
+/**
+ * @brief 取得發佈至指定主題時會收到訊息的客戶端數量
+ * 
+ * @param topics 主題 bitmask
+ * @return 客戶端數量
+ */
+int ws_server_get_subscriber_count(uint32_t topics);
+
+/**
+ * @brief 登記一個非同步處理中的請求
+ * 
+ * 回應稍後才送出的請求 (例如 wake_ps5) 須先登記,
+ * 完成後呼叫 ws_server_end_request()。斷線時計數自動清除。
+ * 
+ * @param client_id 客戶端 ID
+ * @return 0 成功, -2 客戶端不存在, -6 超過 WS_SERVER_MAX_IN_FLIGHT
+ */
+int ws_server_begin_request(int client_id);
+
+/**
+ * @brief 結束一個非同步請求
+ * 
+ * @param client_id 客戶端 ID (已斷線時忽略)
+ */
+void ws_server_end_request(int client_id);
+
+/**
+ * @brief 設定訊息類型的速率限制
+ * 
+ * 超過速率的訊息不會交給訊息處理器,而是直接回覆
+ * {"id":...,"type":"error","error":"rate_limited"}。
+ * 可在執行期間呼叫,已連線的客戶端下一則訊息即套用。
+ * 
+ * @param msg_type 訊息類型 (< WS_SERVER_RATE_LIMIT_TYPES)
+ * @param limit 速率限制 (rate 為 0 表示不限制)
+ * @return 0 成功, -1 參數無效
+ */
+int ws_server_set_rate_limit(ws_message_type_t msg_type, const ws_rate_limit_t *limit);
+
+/**
+ * @brief 恢復所有訊息類型的預設速率限制 (可在執行期間呼叫)
+ */
+void ws_server_reset_rate_limits(void);
+
+/**
+ * @brief 取得訊息類型的速率限制
+ * 
+ * @return 0 成功, -1 參數無效
+ */
+int ws_server_get_rate_limit(ws_message_type_t msg_type, ws_rate_limit_t *limit);
+
+/**
+ * @brief 取得訊息類型的速率限制統計
+ * 
+ * @return 0 成功, -1 參數無效
+ */
+int ws_server_get_rate_limit_stats(ws_message_type_t msg_type,
+                                   ws_rate_limit_stats_t *stats);
+
 /**
  * @brief 取得連線的客戶端數量
  * 
@@ -223,6 +557,55 @@ ws_server_state_t ws_server_get_state(void);
  */
 int ws_server_get_port(void);
 
+/**
+ * @brief 變更監聽端口 (可在執行期間呼叫)
+ * 
+ * 執行中時新端口綁定成功後才關閉舊 listener;經由 TCP 連線的客戶端
+ * 以 1012 (Service Restart) 關閉,本機 IPC 客戶端不受影響。
+ * 綁定失敗時繼續使用舊端口。
+ * 
+ * @param port 新端口
+ * @return 0 成功, -1 參數無效, -5 無法綁定新端口
+ */
+int ws_server_set_port(int port);
+
+/**
+ * @brief 凍結伺服器並匯出交接狀態 (平滑升級, 擁有者執行緒)
+ * 
+ * 停止 worker 執行緒與所有 I/O,送出佇列中的訊息後,
+ * 無法交接的連線以 1012 關閉。之後只能呼叫 ws_server_resume()
+ * (交接失敗) 或 ws_server_release() (新程序已接手)。
+ * 
+ * @param handoff 輸出狀態
+ * @param fds 輸出 fd (仍屬於本程序)
+ * @param max_fds fds 容量 (至少 WS_SERVER_HANDOFF_MAX_FDS)
+ * @return fd 數量, <0 表示失敗 (伺服器繼續運行)
+ */
+int ws_server_export(ws_server_handoff_t *handoff, int *fds, int max_fds);
+
+/**
+ * @brief 交接失敗: 解除凍結並繼續服務
+ */
+void ws_server_resume(void);
+
+/**
+ * @brief 交接成功: 關閉本程序的 fd,不送出 Close 訊框也不移除本機 socket 檔案
+ */
+void ws_server_release(void);
+
+/**
+ * @brief 接收舊程序交接的 socket 與客戶端 (在 ws_server_start() 之前)
+ * 
+ * 端口與本機 IPC 路徑改用交接的值;成功後 fd 屬於伺服器,
+ * 失敗時 fd 仍由呼叫者關閉。客戶端不觸發連線回調。
+ * 
+ * @param handoff ws_server_export() 的狀態
+ * @param fds 對應的 fd
+ * @param fd_count fd 數量
+ * @return 0 成功, -1 參數無效、worker 數不同或伺服器已啟動
+ */
+int ws_server_adopt(const ws_server_handoff_t *handoff, const int *fds, int fd_count);
+
 /**
  * @brief 停止 WebSocket Server
  */
@@ -241,6 +624,30 @@ void ws_server_cleanup(void);
  */
 const char* ws_message_type_to_string(ws_message_type_t msg_type);
 
+/**
+ * @brief 字串轉換為訊息類型
+ * 
+ * @param name 訊息類型字串
+ * @return 訊息類型, WS_MSG_UNKNOWN 表示無效
+ */
+ws_message_type_t ws_message_type_from_string(const char *name);
+
+/**
+ * @brief 主題轉換為字串
+ * 
+ * @param topic 單一主題
+ * @return 主題字串, NULL 表示無效
+ */
+const char* ws_topic_to_string(ws_topic_t topic);
+
+/**
+ * @brief 字串轉換為主題
+ * 
+ * @param name 主題字串 (power, network, server_state, wake, stats)
+ * @return 主題 bit, 0 表示無效
+ */
+uint32_t ws_topic_from_string(const char *name);
+
 /**
  * @brief 伺服器狀態轉換為字串
  * 
@@ -257,6 +664,25 @@ const char* ws_server_state_to_string(ws_server_state_t state);
  */
 const char* ws_server_error_string(int error);
 
+#ifdef TESTING
+/**
+ * @brief 模擬客戶端連線 (測試用, 觸發連線回調)
+ * 
+ * @return 客戶端 ID, <0 表示失敗
+ */
+int ws_server_test_add_client(const char *ip, uint16_t port);
+
+/**
+ * @brief 模擬客戶端斷線 (測試用, 觸發斷線回調)
+ */
+int ws_server_test_remove_client(int client_id);
+
+/**
+ * @brief 模擬接收訊息 (測試用, 呼叫訊息處理器)
+ */
+char* ws_server_test_handle_message(int client_id, const char *message);
+#endif // TESTING
+
 /** @} */ // end of WebSocketServer group
 
 #ifdef __cplusplus
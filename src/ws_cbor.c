@@ -0,0 +1,786 @@
+/**
+ * @file ws_cbor.c
+ * @brief Compact Binary Encoding Implementation
+ *
+ * 只實作本協定用到的 CBOR 子集:
+ * 整數、文字字串、array、map、true/false/null、float64 (僅 JSON → CBOR)。
+ * 不支援 byte string、tag 與不定長度 (indefinite-length) 項目。
+ *
+ * @version 1.0.0
+ * @date 2025-11-21
+ */
+
+#include "ws_cbor.h"
+#include "json_writer.h"
+#include "websocket_server.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define CBOR_MAJOR_UINT     0
+#define CBOR_MAJOR_NINT     1
+#define CBOR_MAJOR_BYTES    2
+#define CBOR_MAJOR_TEXT     3
+#define CBOR_MAJOR_ARRAY    4
+#define CBOR_MAJOR_MAP      5
+#define CBOR_MAJOR_TAG      6
+#define CBOR_MAJOR_SIMPLE   7
+
+#define CBOR_FALSE          0xF4
+#define CBOR_TRUE           0xF5
+#define CBOR_NULL           0xF6
+#define CBOR_FLOAT32        0xFA
+#define CBOR_FLOAT64        0xFB
+
+/** 數字字面值最大長度 */
+#define JSON_NUMBER_MAX     32
+
+/* ============================================================
+ *  Helper Functions - Writer
+ * ============================================================ */
+
+/**
+ * @brief 項目標頭長度 (major type + 參數)
+ */
+static size_t head_size(uint64_t arg) {
+    if (arg < 24) {
+        return 1;
+    } else if (arg <= 0xFF) {
+        return 2;
+    } else if (arg <= 0xFFFF) {
+        return 3;
+    } else if (arg <= 0xFFFFFFFFu) {
+        return 5;
+    }
+    return 9;
+}
+
+/**
+ * @brief 寫入項目標頭到指定位置 (呼叫者確認空間足夠)
+ */
+static void encode_head(uint8_t *out, uint8_t major, uint64_t arg) {
+    size_t size = head_size(arg);
+    major = (uint8_t)(major << 5);
+
+    switch (size) {
+        case 1: out[0] = major | (uint8_t)arg; return;
+        case 2: out[0] = major | 24; break;
+        case 3: out[0] = major | 25; break;
+        case 5: out[0] = major | 26; break;
+        default: out[0] = major | 27; break;
+    }
+
+    for (size_t i = 1; i < size; i++) {
+        out[i] = (uint8_t)(arg >> (8 * (size - 1 - i)));
+    }
+}
+
+static bool reserve(cbor_writer_t *w, size_t len) {
+    if (w->overflow || w->len + len > w->cap) {
+        w->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+static void put_head(cbor_writer_t *w, uint8_t major, uint64_t arg) {
+    if (reserve(w, head_size(arg))) {
+        encode_head(w->buf + w->len, major, arg);
+        w->len += head_size(arg);
+    }
+}
+
+static void put_byte(cbor_writer_t *w, uint8_t b) {
+    if (reserve(w, 1)) {
+        w->buf[w->len++] = b;
+    }
+}
+
+static void put_text(cbor_writer_t *w, const char *s, size_t len) {
+    put_head(w, CBOR_MAJOR_TEXT, len);
+    if (reserve(w, len)) {
+        memcpy(w->buf + w->len, s, len);
+        w->len += len;
+    }
+}
+
+/**
+ * @brief 回填容器標頭
+ *
+ * 轉碼時元素數量事先未知,先保留 1 byte,結束後依實際數量修正
+ *
+ * @param pos 保留的位置
+ */
+static void patch_head(cbor_writer_t *w, size_t pos, uint8_t major, size_t count) {
+    if (w->overflow) {
+        return;
+    }
+
+    size_t extra = head_size(count) - 1;
+    if (extra > 0) {
+        if (!reserve(w, extra)) {
+            return;
+        }
+        memmove(w->buf + pos + 1 + extra, w->buf + pos + 1, w->len - pos - 1);
+        w->len += extra;
+    }
+    encode_head(w->buf + pos, major, count);
+}
+
+/* ============================================================
+ *  Public API Implementation - Writer
+ * ============================================================ */
+
+void cbor_writer_init(cbor_writer_t *w, uint8_t *buf, size_t cap) {
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->cap = cap;
+    w->overflow = (buf == NULL || cap == 0);
+}
+
+void cbor_writer_map(cbor_writer_t *w, size_t count) {
+    put_head(w, CBOR_MAJOR_MAP, count);
+}
+
+void cbor_writer_array(cbor_writer_t *w, size_t count) {
+    put_head(w, CBOR_MAJOR_ARRAY, count);
+}
+
+void cbor_writer_int(cbor_writer_t *w, int64_t value) {
+    if (value >= 0) {
+        put_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+    } else {
+        // -1 - n 編碼為 n
+        put_head(w, CBOR_MAJOR_NINT, (uint64_t)(-1 - value));
+    }
+}
+
+void cbor_writer_text(cbor_writer_t *w, const char *value) {
+    if (value == NULL) {
+        cbor_writer_null(w);
+        return;
+    }
+    put_text(w, value, strlen(value));
+}
+
+void cbor_writer_bool(cbor_writer_t *w, bool value) {
+    put_byte(w, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void cbor_writer_null(cbor_writer_t *w) {
+    put_byte(w, CBOR_NULL);
+}
+
+size_t cbor_writer_finish(const cbor_writer_t *w) {
+    return w->overflow ? 0 : w->len;
+}
+
+/* ============================================================
+ *  Helper Functions - JSON → CBOR
+ * ============================================================ */
+
+typedef struct {
+    const char *p;
+    const char *end;
+    cbor_writer_t *w;
+    int depth;
+} json_reader_t;
+
+static bool json_value(json_reader_t *r);
+
+static void skip_space(json_reader_t *r) {
+    while (r->p < r->end &&
+           (*r->p == ' ' || *r->p == '\t' || *r->p == '\n' || *r->p == '\r')) {
+        r->p++;
+    }
+}
+
+static bool expect_literal(json_reader_t *r, const char *literal) {
+    size_t len = strlen(literal);
+    if ((size_t)(r->end - r->p) < len || memcmp(r->p, literal, len) != 0) {
+        return false;
+    }
+    r->p += len;
+    return true;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool read_hex4(json_reader_t *r, uint32_t *out) {
+    if (r->end - r->p < 4) {
+        return false;
+    }
+
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        int h = hex_value(r->p[i]);
+        if (h < 0) {
+            return false;
+        }
+        v = (v << 4) | (uint32_t)h;
+    }
+
+    r->p += 4;
+    *out = v;
+    return true;
+}
+
+static size_t put_utf8(uint8_t *out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (uint8_t)cp;
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = (uint8_t)(0xC0 | (cp >> 6));
+        out[1] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = (uint8_t)(0xE0 | (cp >> 12));
+        out[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (uint8_t)(0xF0 | (cp >> 18));
+    out[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (uint8_t)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/**
+ * @brief 解析 JSON 字串並直接寫成 CBOR text
+ *
+ * 解碼後長度不會超過原始長度,先依原始長度保留標頭空間,
+ * 完成後若標頭可以更短再往前搬移。
+ */
+static bool json_string(json_reader_t *r) {
+    if (r->p >= r->end || *r->p != '"') {
+        return false;
+    }
+    r->p++;
+
+    const char *close = r->p;
+    while (close < r->end && *close != '"') {
+        close += (*close == '\\') ? 2 : 1;
+    }
+    if (close >= r->end) {
+        return false;
+    }
+
+    cbor_writer_t *w = r->w;
+    size_t max_len = (size_t)(close - r->p);
+    size_t reserved = head_size(max_len);
+    if (!reserve(w, reserved + max_len)) {
+        return false;
+    }
+
+    uint8_t *start = w->buf + w->len + reserved;
+    uint8_t *out = start;
+
+    while (r->p < close) {
+        char c = *r->p++;
+        if (c != '\\') {
+            *out++ = (uint8_t)c;
+            continue;
+        }
+
+        char esc = *r->p++;
+        switch (esc) {
+            case '"':  *out++ = '"';  break;
+            case '\\': *out++ = '\\'; break;
+            case '/':  *out++ = '/';  break;
+            case 'b':  *out++ = '\b'; break;
+            case 'f':  *out++ = '\f'; break;
+            case 'n':  *out++ = '\n'; break;
+            case 'r':  *out++ = '\r'; break;
+            case 't':  *out++ = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!read_hex4(r, &cp)) {
+                    return false;
+                }
+                // Surrogate pair
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (close - r->p < 6 || r->p[0] != '\\' || r->p[1] != 'u') {
+                        return false;
+                    }
+                    r->p += 2;
+                    if (!read_hex4(r, &low) || low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                out += put_utf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    r->p = close + 1;
+
+    size_t len = (size_t)(out - start);
+    size_t actual = head_size(len);
+    if (actual < reserved) {
+        memmove(w->buf + w->len + actual, start, len);
+    }
+    encode_head(w->buf + w->len, CBOR_MAJOR_TEXT, len);
+    w->len += actual + len;
+    return true;
+}
+
+static bool json_number(json_reader_t *r) {
+    char literal[JSON_NUMBER_MAX + 1];
+    size_t len = 0;
+    bool is_float = false;
+
+    while (r->p < r->end && len < JSON_NUMBER_MAX) {
+        char c = *r->p;
+        if (c == '.' || c == 'e' || c == 'E') {
+            is_float = true;
+        } else if (!(c == '-' || c == '+' || (c >= '0' && c <= '9'))) {
+            break;
+        }
+        literal[len++] = c;
+        r->p++;
+    }
+    literal[len] = '\0';
+
+    if (len == 0 || len == JSON_NUMBER_MAX) {
+        return false;
+    }
+
+    char *end = NULL;
+    if (!is_float) {
+        // 超出 int64 範圍時改以 float64 編碼,不截成 INT64_MIN/MAX
+        errno = 0;
+        long long value = strtoll(literal, &end, 10);
+        if (end == literal + len && errno != ERANGE) {
+            cbor_writer_int(r->w, value);
+            return true;
+        }
+    }
+
+    double d = strtod(literal, &end);
+    if (end != literal + len || !isfinite(d)) {
+        return false;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    put_byte(r->w, CBOR_FLOAT64);
+    if (reserve(r->w, 8)) {
+        for (int i = 0; i < 8; i++) {
+            r->w->buf[r->w->len++] = (uint8_t)(bits >> (56 - 8 * i));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 解析 "type" 欄位的值
+ *
+ * 已知訊息類型寫成 key 0 + 整數標籤,否則保留文字 key
+ */
+static bool json_type_field(json_reader_t *r) {
+    cbor_writer_t *w = r->w;
+
+    if (r->p < r->end && *r->p == '"') {
+        const char *name = r->p + 1;
+        const char *close = memchr(name, '"', (size_t)(r->end - name));
+        if (close && close - name < 32 && memchr(name, '\\', (size_t)(close - name)) == NULL) {
+            char type[32];
+            memcpy(type, name, (size_t)(close - name));
+            type[close - name] = '\0';
+
+            ws_message_type_t tag = ws_message_type_from_string(type);
+            if (tag != WS_MSG_UNKNOWN) {
+                cbor_writer_int(w, WS_CBOR_KEY_TYPE);
+                cbor_writer_int(w, tag);
+                r->p = close + 1;
+                return true;
+            }
+        }
+    }
+
+    put_text(w, "type", 4);
+    return json_value(r);
+}
+
+static bool json_container(json_reader_t *r, bool is_object) {
+    char close = is_object ? '}' : ']';
+    cbor_writer_t *w = r->w;
+
+    if (++r->depth > WS_CBOR_MAX_DEPTH) {
+        return false;
+    }
+
+    r->p++;  // '{' 或 '['
+    size_t head_pos = w->len;
+    put_byte(w, 0);  // 稍後回填
+    size_t count = 0;
+
+    skip_space(r);
+    if (r->p < r->end && *r->p == close) {
+        r->p++;
+    } else {
+        for (;;) {
+            skip_space(r);
+            if (is_object) {
+                bool is_type = (r->depth == 1 && r->end - r->p >= 6 &&
+                                memcmp(r->p, "\"type\"", 6) == 0);
+                if (is_type) {
+                    r->p += 6;
+                } else if (!json_string(r)) {
+                    return false;
+                }
+
+                skip_space(r);
+                if (r->p >= r->end || *r->p != ':') {
+                    return false;
+                }
+                r->p++;
+                skip_space(r);
+
+                if (is_type ? !json_type_field(r) : !json_value(r)) {
+                    return false;
+                }
+            } else if (!json_value(r)) {
+                return false;
+            }
+            count++;
+
+            skip_space(r);
+            if (r->p >= r->end) {
+                return false;
+            }
+            if (*r->p == ',') {
+                r->p++;
+                continue;
+            }
+            if (*r->p != close) {
+                return false;
+            }
+            r->p++;
+            break;
+        }
+    }
+
+    r->depth--;
+    patch_head(w, head_pos, is_object ? CBOR_MAJOR_MAP : CBOR_MAJOR_ARRAY, count);
+    return !w->overflow;
+}
+
+static bool json_value(json_reader_t *r) {
+    skip_space(r);
+    if (r->p >= r->end) {
+        return false;
+    }
+
+    switch (*r->p) {
+        case '{':
+            return json_container(r, true);
+        case '[':
+            return json_container(r, false);
+        case '"':
+            return json_string(r);
+        case 't':
+            cbor_writer_bool(r->w, true);
+            return expect_literal(r, "true");
+        case 'f':
+            cbor_writer_bool(r->w, false);
+            return expect_literal(r, "false");
+        case 'n':
+            cbor_writer_null(r->w);
+            return expect_literal(r, "null");
+        default:
+            return json_number(r);
+    }
+}
+
+/* ============================================================
+ *  Helper Functions - CBOR → JSON
+ * ============================================================ */
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    json_writer_t *w;
+    int depth;
+    int msg_type;
+} cbor_reader_t;
+
+static bool cbor_value(cbor_reader_t *r);
+
+/**
+ * @brief 讀取項目標頭
+ */
+static bool read_head(cbor_reader_t *r, uint8_t *major, uint8_t *info, uint64_t *arg) {
+    if (r->p >= r->end) {
+        return false;
+    }
+
+    *major = *r->p >> 5;
+    *info = *r->p & 0x1F;
+    r->p++;
+
+    size_t size;
+    if (*info < 24) {
+        *arg = *info;
+        return true;
+    } else if (*info == 24) {
+        size = 1;
+    } else if (*info == 25) {
+        size = 2;
+    } else if (*info == 26) {
+        size = 4;
+    } else if (*info == 27) {
+        size = 8;
+    } else {
+        return false;  // 不定長度或保留值
+    }
+
+    if ((size_t)(r->end - r->p) < size) {
+        return false;
+    }
+
+    *arg = 0;
+    for (size_t i = 0; i < size; i++) {
+        *arg = (*arg << 8) | *r->p++;
+    }
+    return true;
+}
+
+static bool read_text(cbor_reader_t *r, uint64_t len, const char **text) {
+    if ((uint64_t)(r->end - r->p) < len) {
+        return false;
+    }
+    *text = (const char*)r->p;
+    r->p += len;
+    return true;
+}
+
+static bool cbor_float(cbor_reader_t *r, uint8_t info, uint64_t arg) {
+    double d;
+    if (info == 27) {
+        memcpy(&d, &arg, sizeof(d));
+    } else if (info == 26) {
+        uint32_t bits = (uint32_t)arg;
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        d = f;
+    } else {
+        return false;
+    }
+
+    char number[JSON_NUMBER_MAX];
+    int len = snprintf(number, sizeof(number), "%.17g", d);
+    if (len <= 0 || (size_t)len >= sizeof(number) || !isfinite(d)) {
+        return false;  // NaN/Infinity 無法以 JSON 表示
+    }
+    json_writer_raw(r->w, number, (size_t)len);
+    return true;
+}
+
+static bool cbor_map(cbor_reader_t *r, uint64_t count) {
+    json_writer_begin_object(r->w);
+
+    for (uint64_t i = 0; i < count; i++) {
+        uint8_t major, info;
+        uint64_t arg;
+        if (!read_head(r, &major, &info, &arg)) {
+            return false;
+        }
+
+        if (major == CBOR_MAJOR_TEXT) {
+            const char *key;
+            if (!read_text(r, arg, &key)) {
+                return false;
+            }
+            json_writer_key_len(r->w, key, (size_t)arg);
+        } else if (major == CBOR_MAJOR_UINT && arg == WS_CBOR_KEY_TYPE && r->depth == 1) {
+            // {0: tag} → "type":"name"
+            uint8_t tag_major, tag_info;
+            uint64_t tag;
+            if (!read_head(r, &tag_major, &tag_info, &tag) ||
+                tag_major != CBOR_MAJOR_UINT || tag > 0xFF) {
+                return false;
+            }
+            const char *name = ws_message_type_to_string((ws_message_type_t)tag);
+            json_writer_kv_string(r->w, "type", name);
+            r->msg_type = (int)tag;
+            continue;
+        } else {
+            return false;  // 只接受文字 key
+        }
+
+        if (!cbor_value(r)) {
+            return false;
+        }
+    }
+
+    json_writer_end_object(r->w);
+    return true;
+}
+
+static bool cbor_value(cbor_reader_t *r) {
+    uint8_t major, info;
+    uint64_t arg;
+    if (!read_head(r, &major, &info, &arg)) {
+        return false;
+    }
+
+    switch (major) {
+        case CBOR_MAJOR_UINT:
+            if (arg > INT64_MAX) {
+                return false;
+            }
+            json_writer_int(r->w, (int64_t)arg);
+            return true;
+
+        case CBOR_MAJOR_NINT:
+            if (arg > INT64_MAX) {
+                return false;
+            }
+            json_writer_int(r->w, -1 - (int64_t)arg);
+            return true;
+
+        case CBOR_MAJOR_TEXT: {
+            const char *text;
+            if (!read_text(r, arg, &text)) {
+                return false;
+            }
+            json_writer_string_len(r->w, text, (size_t)arg);
+            return true;
+        }
+
+        case CBOR_MAJOR_ARRAY:
+        case CBOR_MAJOR_MAP: {
+            // 每個元素至少 1 byte,避免惡意的巨大數量
+            if (arg > (uint64_t)(r->end - r->p) || ++r->depth > WS_CBOR_MAX_DEPTH) {
+                return false;
+            }
+
+            bool ok;
+            if (major == CBOR_MAJOR_MAP) {
+                ok = cbor_map(r, arg);
+            } else {
+                json_writer_begin_array(r->w);
+                ok = true;
+                for (uint64_t i = 0; ok && i < arg; i++) {
+                    ok = cbor_value(r);
+                }
+                json_writer_end_array(r->w);
+            }
+
+            r->depth--;
+            return ok;
+        }
+
+        case CBOR_MAJOR_SIMPLE:
+            switch (info) {
+                case CBOR_FALSE & 0x1F: json_writer_bool(r->w, false); return true;
+                case CBOR_TRUE & 0x1F:  json_writer_bool(r->w, true);  return true;
+                case CBOR_NULL & 0x1F:  json_writer_null(r->w);        return true;
+                default:                return cbor_float(r, info, arg);
+            }
+
+        default:
+            return false;  // byte string 與 tag 不支援
+    }
+}
+
+/* ============================================================
+ *  Public API Implementation - Transcoding
+ * ============================================================ */
+
+size_t ws_cbor_from_json(const char *json, size_t json_len, uint8_t *out, size_t size) {
+    if (json == NULL || out == NULL) {
+        return 0;
+    }
+
+    cbor_writer_t w;
+    cbor_writer_init(&w, out, size);
+
+    json_reader_t r = { json, json + json_len, &w, 0 };
+    if (!json_value(&r)) {
+        return 0;
+    }
+
+    skip_space(&r);
+    if (r.p != r.end) {
+        return 0;
+    }
+
+    return cbor_writer_finish(&w);
+}
+
+size_t ws_cbor_append_field(const uint8_t *cbor, size_t len, const char *key,
+                            const uint8_t *value, size_t value_len,
+                            uint8_t *out, size_t size)
+{
+    if (cbor == NULL || len == 0 || value == NULL || out == NULL) {
+        return 0;
+    }
+
+    uint8_t major = cbor[0] >> 5;
+    uint8_t count = cbor[0] & 0x1F;
+    if ((major != CBOR_MAJOR_ARRAY && major != CBOR_MAJOR_MAP) || count >= 23 ||
+        (major == CBOR_MAJOR_MAP && key == NULL)) {
+        return 0;
+    }
+
+    cbor_writer_t w;
+    cbor_writer_init(&w, out, size);
+    put_byte(&w, (uint8_t)((major << 5) | (count + 1)));
+    if (reserve(&w, len - 1)) {
+        memcpy(w.buf + w.len, cbor + 1, len - 1);
+        w.len += len - 1;
+    }
+    if (major == CBOR_MAJOR_MAP) {
+        cbor_writer_text(&w, key);
+    }
+    if (reserve(&w, value_len)) {
+        memcpy(w.buf + w.len, value, value_len);
+        w.len += value_len;
+    }
+
+    return cbor_writer_finish(&w);
+}
+
+size_t ws_cbor_to_json(const uint8_t *data, size_t len, char *out, size_t size,
+                       int *msg_type)
+{
+    if (msg_type) {
+        *msg_type = 0;
+    }
+
+    if (data == NULL || out == NULL) {
+        return 0;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, out, size);
+
+    cbor_reader_t r = { data, data + len, &w, 0, 0 };
+    if (!cbor_value(&r) || r.p != r.end || json_writer_finish(&w) == NULL) {
+        return 0;
+    }
+
+    if (msg_type) {
+        *msg_type = r.msg_type;
+    }
+    return json_writer_length(&w);
+}
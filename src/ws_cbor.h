@@ -0,0 +1,166 @@
+/**
+ * @file ws_cbor.h
+ * @brief Compact Binary Encoding - gaming.v1.cbor 子協定 (RFC 8949)
+ *
+ * 此模組提供:
+ * - 零配置 CBOR 編碼器 (介面比照 json_writer)
+ * - JSON → CBOR 轉碼 (送給 gaming.v1.cbor 客戶端)
+ * - CBOR → JSON 轉碼 (交給既有的訊息處理器)
+ *
+ * 一般訊息編碼為 map,"type" 以整數 key 0 加上 ws_message_type_t
+ * 標籤表示,其他欄位保留文字 key:
+ * @code
+ * {0: 5, "topics": ["power"]}          // subscribe
+ * @endcode
+ *
+ * 狀態與喚醒結果使用固定佈局 (array),列舉值直接以整數傳送:
+ * @code
+ * [WS_MSG_PS5_STATUS, version, power, network, server_state, stale]
+ * [WS_MSG_NOT_MODIFIED, version]
+ * [WS_MSG_WAKE_RESULT, success]
+ * @endcode
+ *
+ * 每種佈局的元素數固定,可選的欄位也一律佔位 (ps5_status 的 stale 為
+ * bool,未確認的暫定狀態為 true),客戶端以索引讀取。
+ *
+ * 請求帶有 id 時,回應的 map 加上 "id" 欄位,固定佈局則在最後附加 id
+ * (ps5_status 的索引 6、not_modified 與 wake_result 的索引 2)。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-21
+ * @version 1.0.0
+ */
+
+#ifndef WS_CBOR_H
+#define WS_CBOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 訊息類型的整數 key */
+#define WS_CBOR_KEY_TYPE        0
+
+/** 轉碼最大巢狀深度 */
+#define WS_CBOR_MAX_DEPTH       16
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief CBOR Writer 狀態 (可放在堆疊上)
+ */
+typedef struct {
+    uint8_t *buf;               /**< 輸出緩衝區 */
+    size_t cap;                 /**< 緩衝區容量 */
+    size_t len;                 /**< 已寫入長度 */
+    bool overflow;              /**< 緩衝區不足 */
+} cbor_writer_t;
+
+/* ============================================================
+ *  Public Function Declarations - Writer
+ * ============================================================ */
+
+/**
+ * @brief 初始化 Writer
+ */
+void cbor_writer_init(cbor_writer_t *w, uint8_t *buf, size_t cap);
+
+/**
+ * @brief 開始 map (count 組 key/value)
+ */
+void cbor_writer_map(cbor_writer_t *w, size_t count);
+
+/**
+ * @brief 開始 array (count 個元素)
+ */
+void cbor_writer_array(cbor_writer_t *w, size_t count);
+
+/**
+ * @brief 寫入整數
+ */
+void cbor_writer_int(cbor_writer_t *w, int64_t value);
+
+/**
+ * @brief 寫入文字字串 (NULL 寫入 null)
+ */
+void cbor_writer_text(cbor_writer_t *w, const char *value);
+
+/**
+ * @brief 寫入布林值
+ */
+void cbor_writer_bool(cbor_writer_t *w, bool value);
+
+/**
+ * @brief 寫入 null
+ */
+void cbor_writer_null(cbor_writer_t *w);
+
+/**
+ * @brief 完成輸出
+ *
+ * @return 輸出長度, 0 表示溢位
+ */
+size_t cbor_writer_finish(const cbor_writer_t *w);
+
+/* ============================================================
+ *  Public Function Declarations - Transcoding
+ * ============================================================ */
+
+/**
+ * @brief JSON 轉為 CBOR
+ *
+ * @param json JSON 文字
+ * @param json_len 長度
+ * @param out 輸出緩衝區
+ * @param size 緩衝區大小
+ * @return 輸出長度, 0 表示格式錯誤或緩衝區不足
+ */
+size_t ws_cbor_from_json(const char *json, size_t json_len, uint8_t *out, size_t size);
+
+/**
+ * @brief 在最外層容器附加一個欄位
+ *
+ * map 加上 key/value;固定佈局 (array) 則將 value 附加為最後一個元素。
+ * 最外層元素數量須小於 23。
+ *
+ * @param cbor 原始 CBOR
+ * @param len 長度
+ * @param key 欄位名稱 (array 時忽略)
+ * @param value 已編碼的 CBOR 值
+ * @param value_len 長度
+ * @param out 輸出緩衝區
+ * @param size 緩衝區大小
+ * @return 輸出長度, 0 表示不支援或緩衝區不足
+ */
+size_t ws_cbor_append_field(const uint8_t *cbor, size_t len, const char *key,
+                            const uint8_t *value, size_t value_len,
+                            uint8_t *out, size_t size);
+
+/**
+ * @brief CBOR 轉為 JSON
+ *
+ * @param data CBOR 資料
+ * @param len 長度
+ * @param out 輸出緩衝區 (以 '\0' 結尾)
+ * @param size 緩衝區大小
+ * @param msg_type 輸出訊息類型標籤 (可為 NULL), 無法辨識時為 0
+ * @return JSON 長度, 0 表示格式錯誤或緩衝區不足
+ */
+size_t ws_cbor_to_json(const uint8_t *data, size_t len, char *out, size_t size,
+                       int *msg_type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WS_CBOR_H */
@@ -0,0 +1,409 @@
+/**
+ * @file ws_deflate.c
+ * @brief permessage-deflate Implementation (zlib)
+ *
+ * @version 1.0.0
+ * @date 2025-11-21
+ */
+
+#include "ws_deflate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <zlib.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define WS_DEFLATE_MIN_WINDOW   9   // zlib raw deflate 不支援 8
+#define WS_DEFLATE_MAX_WINDOW   15
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+struct ws_inflater {
+    z_stream stream;
+    bool no_context_takeover;
+};
+
+typedef struct {
+    z_stream stream;
+    bool initialized;
+} shared_deflater_t;
+
+/* ============================================================
+ *  Global Variables
+ * ============================================================ */
+
+/** 依 window bits 共用的壓縮器 (索引: bits - WS_DEFLATE_MIN_WINDOW) */
+static shared_deflater_t g_deflaters[WS_DEFLATE_MAX_WINDOW - WS_DEFLATE_MIN_WINDOW + 1];
+
+/** 共用壓縮器可能被多個 worker 執行緒同時使用 */
+static pthread_mutex_t g_deflaters_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ============================================================
+ *  Helper Functions - Negotiation
+ * ============================================================ */
+
+static const char* skip_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+static size_t trimmed_len(const char *p, const char *end) {
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+    return (size_t)(end - p);
+}
+
+static bool token_equals(const char *p, size_t len, const char *token) {
+    return strlen(token) == len && strncasecmp(p, token, len) == 0;
+}
+
+/**
+ * @brief 解析 window bits 參數值 (可含引號)
+ * @return 8-15, 0 表示無值, -1 表示格式錯誤
+ */
+static int parse_window_bits(const char *value, size_t len) {
+    if (value == NULL) {
+        return 0;
+    }
+
+    if (len >= 2 && value[0] == '"' && value[len - 1] == '"') {
+        value++;
+        len -= 2;
+    }
+
+    if (len == 0 || len > 2) {
+        return -1;
+    }
+
+    int bits = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (value[i] < '0' || value[i] > '9') {
+            return -1;
+        }
+        bits = bits * 10 + (value[i] - '0');
+    }
+
+    return (bits >= 8 && bits <= 15) ? bits : -1;
+}
+
+/**
+ * @brief 解析單一擴充提議
+ *
+ * @param offer "permessage-deflate; param; param=value"
+ * @param end 提議結尾
+ * @param params 協商結果
+ * @param client_bits 客戶端 window bits (0 表示未指定, -1 表示未帶值)
+ * @return true 表示可接受
+ */
+static bool parse_offer(const char *offer, const char *end,
+                        ws_deflate_params_t *params, int *client_bits)
+{
+    const char *semi = memchr(offer, ';', (size_t)(end - offer));
+    const char *name_end = semi ? semi : end;
+
+    offer = skip_ws(offer, name_end);
+    if (!token_equals(offer, trimmed_len(offer, name_end), "permessage-deflate")) {
+        return false;
+    }
+
+    memset(params, 0, sizeof(*params));
+    *client_bits = 0;
+
+    bool seen_server_nct = false;
+    bool seen_client_nct = false;
+    bool seen_server_bits = false;
+    bool seen_client_bits = false;
+
+    const char *p = semi;
+    while (p != NULL && p < end) {
+        p++;  // 跳過 ';'
+        size_t remaining = (size_t)(end - p);
+        const char *next = memchr(p, ';', remaining);
+        size_t param_len = next ? (size_t)(next - p) : remaining;
+        const char *param_end = p + param_len;
+
+        // '=' 只在此參數範圍內尋找 (前導空白不影響結果)
+        const char *eq = memchr(p, '=', param_len);
+        const char *name = skip_ws(p, eq ? eq : param_end);
+        size_t name_len = trimmed_len(name, eq ? eq : param_end);
+
+        const char *value = NULL;
+        size_t value_len = 0;
+        if (eq) {
+            value = skip_ws(eq + 1, param_end);
+            value_len = trimmed_len(value, param_end);
+        }
+
+        // 重複參數或未知參數: 拒絕此提議
+        if (token_equals(name, name_len, "server_no_context_takeover")) {
+            if (seen_server_nct || value) {
+                return false;
+            }
+            seen_server_nct = true;
+        } else if (token_equals(name, name_len, "client_no_context_takeover")) {
+            if (seen_client_nct || value) {
+                return false;
+            }
+            seen_client_nct = true;
+            params->client_no_context_takeover = true;
+        } else if (token_equals(name, name_len, "server_max_window_bits")) {
+            int bits = parse_window_bits(value, value_len);
+            if (seen_server_bits || bits <= 0) {
+                return false;
+            }
+            // zlib 無法產生 8-bit window 的 raw deflate,拒絕此提議
+            if (bits < WS_DEFLATE_MIN_WINDOW) {
+                return false;
+            }
+            seen_server_bits = true;
+            params->server_max_window_bits = (uint8_t)bits;
+        } else if (token_equals(name, name_len, "client_max_window_bits")) {
+            int bits = parse_window_bits(value, value_len);
+            if (seen_client_bits || bits < 0) {
+                return false;
+            }
+            seen_client_bits = true;
+            *client_bits = (bits == 0) ? -1 : bits;
+        } else {
+            return false;
+        }
+
+        p = next;
+    }
+
+    if (params->server_max_window_bits == 0) {
+        params->server_max_window_bits = WS_DEFLATE_MAX_WINDOW;
+    }
+    params->client_max_window_bits = (*client_bits > 0) ? (uint8_t)*client_bits
+                                                        : WS_DEFLATE_MAX_WINDOW;
+    params->enabled = true;
+    return true;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+bool ws_deflate_negotiate(const char *offer, size_t offer_len,
+                          ws_deflate_params_t *params,
+                          char *response, size_t size)
+{
+    if (params == NULL || response == NULL || size == 0) {
+        return false;
+    }
+
+    memset(params, 0, sizeof(*params));
+    response[0] = '\0';
+
+    if (offer == NULL || offer_len == 0) {
+        return false;
+    }
+
+    // 依客戶端偏好順序,接受第一個可支援的提議
+    const char *p = offer;
+    const char *end = offer + offer_len;
+    while (p < end) {
+        const char *comma = memchr(p, ',', (size_t)(end - p));
+        const char *item_end = comma ? comma : end;
+
+        int client_bits = 0;
+        if (parse_offer(p, item_end, params, &client_bits)) {
+            // "; client_max_window_bits=" + 最長的 int 與 '\0'
+            char server_bits[48] = "";
+            char client_bits_str[48] = "";
+
+            if (params->server_max_window_bits != WS_DEFLATE_MAX_WINDOW) {
+                snprintf(server_bits, sizeof(server_bits),
+                         "; server_max_window_bits=%u", params->server_max_window_bits);
+            }
+            if (client_bits > 0) {
+                snprintf(client_bits_str, sizeof(client_bits_str),
+                         "; client_max_window_bits=%d", client_bits);
+            }
+
+            int len = snprintf(response, size,
+                               "permessage-deflate; server_no_context_takeover%s%s%s",
+                               params->client_no_context_takeover
+                                   ? "; client_no_context_takeover" : "",
+                               server_bits, client_bits_str);
+            if (len > 0 && (size_t)len < size) {
+                return true;
+            }
+
+            memset(params, 0, sizeof(*params));
+            response[0] = '\0';
+            return false;
+        }
+
+        p = item_end + 1;
+    }
+
+    memset(params, 0, sizeof(*params));
+    return false;
+}
+
+/**
+ * @brief 以共用壓縮器壓縮 (呼叫者持有 g_deflaters_lock)
+ */
+static int compress_shared(uint8_t window_bits, const uint8_t *in, size_t in_len,
+                           uint8_t *out, size_t out_size, size_t *out_len)
+{
+    if (in == NULL || out == NULL || out_len == NULL ||
+        window_bits < WS_DEFLATE_MIN_WINDOW || window_bits > WS_DEFLATE_MAX_WINDOW) {
+        return WS_DEFLATE_ERROR;
+    }
+
+#if WS_DEFLATE_THRESHOLD > 0
+    if (in_len < WS_DEFLATE_THRESHOLD) {
+        return WS_DEFLATE_NO_GAIN;
+    }
+#endif
+
+    shared_deflater_t *d = &g_deflaters[window_bits - WS_DEFLATE_MIN_WINDOW];
+    if (!d->initialized) {
+        memset(&d->stream, 0, sizeof(d->stream));
+        if (deflateInit2(&d->stream, WS_DEFLATE_LEVEL, Z_DEFLATED,
+                         -(int)window_bits, WS_DEFLATE_MEM_LEVEL,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            return WS_DEFLATE_ERROR;
+        }
+        d->initialized = true;
+    } else {
+        // server_no_context_takeover: 每則訊息獨立壓縮
+        deflateReset(&d->stream);
+    }
+
+    d->stream.next_in = (Bytef*)in;
+    d->stream.avail_in = (uInt)in_len;
+    d->stream.next_out = out;
+    d->stream.avail_out = (uInt)out_size;
+
+    int ret = deflate(&d->stream, Z_SYNC_FLUSH);
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+        return WS_DEFLATE_ERROR;
+    }
+
+    // 輸出緩衝區耗盡時無法確定 flush 已完成
+    if (d->stream.avail_in != 0 || d->stream.avail_out == 0) {
+        return WS_DEFLATE_TOO_BIG;
+    }
+
+    size_t len = out_size - d->stream.avail_out;
+    if (len < 4 || memcmp(out + len - 4, "\x00\x00\xff\xff", 4) != 0) {
+        return WS_DEFLATE_ERROR;
+    }
+    len -= 4;
+
+    if (len >= in_len) {
+        return WS_DEFLATE_NO_GAIN;
+    }
+
+    *out_len = len;
+    return WS_DEFLATE_OK;
+}
+
+int ws_deflate_compress(uint8_t window_bits, const uint8_t *in, size_t in_len,
+                        uint8_t *out, size_t out_size, size_t *out_len)
+{
+    pthread_mutex_lock(&g_deflaters_lock);
+    int rc = compress_shared(window_bits, in, in_len, out, out_size, out_len);
+    pthread_mutex_unlock(&g_deflaters_lock);
+    return rc;
+}
+
+ws_inflater_t* ws_inflater_create(const ws_deflate_params_t *params) {
+    if (params == NULL || !params->enabled) {
+        return NULL;
+    }
+
+    ws_inflater_t *inflater = (ws_inflater_t*)calloc(1, sizeof(ws_inflater_t));
+    if (inflater == NULL) {
+        return NULL;
+    }
+
+    // 以最大 window 解壓縮,可相容任何較小的客戶端 window
+    if (inflateInit2(&inflater->stream, -WS_DEFLATE_MAX_WINDOW) != Z_OK) {
+        free(inflater);
+        return NULL;
+    }
+
+    inflater->no_context_takeover = params->client_no_context_takeover;
+    return inflater;
+}
+
+int ws_inflater_inflate(ws_inflater_t *inflater, const uint8_t *in, size_t in_len,
+                        uint8_t *out, size_t out_size, size_t *out_len)
+{
+    static const uint8_t tail[4] = { 0x00, 0x00, 0xFF, 0xFF };
+
+    if (inflater == NULL || in == NULL || out == NULL || out_len == NULL) {
+        return WS_DEFLATE_ERROR;
+    }
+
+    inflater->stream.next_out = out;
+    inflater->stream.avail_out = (uInt)out_size;
+
+    // 先處理 payload,再補上被移除的 0x00 0x00 0xFF 0xFF
+    const uint8_t *chunks[2] = { in, tail };
+    size_t lens[2] = { in_len, sizeof(tail) };
+
+    for (int i = 0; i < 2; i++) {
+        inflater->stream.next_in = (Bytef*)chunks[i];
+        inflater->stream.avail_in = (uInt)lens[i];
+
+        while (inflater->stream.avail_in > 0) {
+            int ret = inflate(&inflater->stream, Z_SYNC_FLUSH);
+            if (ret == Z_STREAM_END) {
+                break;
+            }
+            if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                inflateReset(&inflater->stream);
+                return WS_DEFLATE_ERROR;
+            }
+            if (inflater->stream.avail_out == 0) {
+                inflateReset(&inflater->stream);
+                return WS_DEFLATE_TOO_BIG;
+            }
+            if (ret == Z_BUF_ERROR) {
+                break;
+            }
+        }
+    }
+
+    *out_len = out_size - inflater->stream.avail_out;
+
+    if (inflater->no_context_takeover) {
+        inflateReset(&inflater->stream);
+    }
+
+    return WS_DEFLATE_OK;
+}
+
+void ws_inflater_destroy(ws_inflater_t *inflater) {
+    if (inflater == NULL) {
+        return;
+    }
+
+    inflateEnd(&inflater->stream);
+    free(inflater);
+}
+
+void ws_deflate_cleanup(void) {
+    for (size_t i = 0; i < sizeof(g_deflaters) / sizeof(g_deflaters[0]); i++) {
+        if (g_deflaters[i].initialized) {
+            deflateEnd(&g_deflaters[i].stream);
+            g_deflaters[i].initialized = false;
+        }
+    }
+}
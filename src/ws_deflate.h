@@ -0,0 +1,143 @@
+/**
+ * @file ws_deflate.h
+ * @brief permessage-deflate Extension - RFC 7692 壓縮擴充
+ *
+ * 此模組提供:
+ * - Sec-WebSocket-Extensions 協商
+ * - 伺服器訊息壓縮 (固定 server_no_context_takeover)
+ * - 客戶端訊息解壓縮
+ *
+ * 伺服器端永遠使用 no_context_takeover,因此相同內容在相同
+ * server_max_window_bits 下的壓縮結果與連線無關,廣播時只需
+ * 壓縮一次即可分享給所有協商出相同參數的客戶端。
+ * 壓縮器依 window bits 共用,不隨連線數增加記憶體。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-21
+ * @version 1.0.0
+ */
+
+#ifndef WS_DEFLATE_H
+#define WS_DEFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 小於此長度的訊息不壓縮 (bytes,見 tests/bench_deflate.c) */
+#ifndef WS_DEFLATE_THRESHOLD
+#define WS_DEFLATE_THRESHOLD        64
+#endif
+
+/** 壓縮等級 (1-9) */
+#define WS_DEFLATE_LEVEL            6
+
+/** zlib memLevel (較小值可降低路由器上的記憶體用量) */
+#define WS_DEFLATE_MEM_LEVEL        4
+
+/** 協商回應最大長度 */
+#define WS_DEFLATE_RESPONSE_SIZE    128
+
+#define WS_DEFLATE_OK               0
+#define WS_DEFLATE_ERROR           -1
+#define WS_DEFLATE_NO_GAIN         -2  /**< 壓縮後未變小,應送出原文 */
+#define WS_DEFLATE_TOO_BIG         -3  /**< 輸出緩衝區不足 */
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 協商結果
+ */
+typedef struct {
+    bool enabled;                       /**< 是否啟用 */
+    bool client_no_context_takeover;    /**< 客戶端每則訊息重置 context */
+    uint8_t server_max_window_bits;     /**< 伺服器壓縮 window bits (9-15) */
+    uint8_t client_max_window_bits;     /**< 客戶端壓縮 window bits (9-15) */
+} ws_deflate_params_t;
+
+/**
+ * @brief 客戶端訊息解壓縮器 (每個連線一個)
+ */
+typedef struct ws_inflater ws_inflater_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 協商 permessage-deflate
+ *
+ * @param offer Sec-WebSocket-Extensions 標頭值
+ * @param offer_len 長度
+ * @param params 協商結果
+ * @param response 回應的擴充字串
+ * @param size 回應緩衝區大小
+ * @return true 表示接受某個提議
+ */
+bool ws_deflate_negotiate(const char *offer, size_t offer_len,
+                          ws_deflate_params_t *params,
+                          char *response, size_t size);
+
+/**
+ * @brief 壓縮一則伺服器訊息
+ *
+ * 已移除結尾的 0x00 0x00 0xFF 0xFF,可直接作為 RSV1 訊框的 payload
+ *
+ * @param window_bits server_max_window_bits
+ * @param in 原始訊息
+ * @param in_len 長度
+ * @param out 輸出緩衝區
+ * @param out_size 輸出緩衝區大小
+ * @param out_len 輸出長度
+ * @return WS_DEFLATE_OK, WS_DEFLATE_NO_GAIN, WS_DEFLATE_TOO_BIG, WS_DEFLATE_ERROR
+ */
+int ws_deflate_compress(uint8_t window_bits, const uint8_t *in, size_t in_len,
+                        uint8_t *out, size_t out_size, size_t *out_len);
+
+/**
+ * @brief 建立解壓縮器
+ *
+ * @param params 協商結果
+ * @return 解壓縮器, NULL 表示失敗
+ */
+ws_inflater_t* ws_inflater_create(const ws_deflate_params_t *params);
+
+/**
+ * @brief 解壓縮一則客戶端訊息
+ *
+ * @param inflater 解壓縮器
+ * @param in 壓縮後的 payload
+ * @param in_len 長度
+ * @param out 輸出緩衝區
+ * @param out_size 輸出緩衝區大小
+ * @param out_len 輸出長度
+ * @return WS_DEFLATE_OK, WS_DEFLATE_TOO_BIG, WS_DEFLATE_ERROR
+ */
+int ws_inflater_inflate(ws_inflater_t *inflater, const uint8_t *in, size_t in_len,
+                        uint8_t *out, size_t out_size, size_t *out_len);
+
+/**
+ * @brief 釋放解壓縮器
+ */
+void ws_inflater_destroy(ws_inflater_t *inflater);
+
+/**
+ * @brief 釋放共用壓縮器
+ */
+void ws_deflate_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WS_DEFLATE_H */
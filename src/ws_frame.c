@@ -0,0 +1,123 @@
+/**
+ * @file ws_frame.c
+ * @brief WebSocket Frame Codec Implementation
+ *
+ * @version 1.0.0
+ * @date 2025-11-21
+ */
+
+#include "ws_frame.h"
+
+#include <string.h>
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int ws_frame_parse_header(const uint8_t *buf, size_t len, ws_frame_header_t *hdr) {
+    if (buf == NULL || hdr == NULL) {
+        return WS_FRAME_ERROR;
+    }
+
+    if (len < 2) {
+        return WS_FRAME_INCOMPLETE;
+    }
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->fin = (buf[0] & 0x80) != 0;
+    hdr->rsv1 = (buf[0] & 0x40) != 0;
+    hdr->opcode = buf[0] & 0x0F;
+    hdr->masked = (buf[1] & 0x80) != 0;
+
+    // RSV2/RSV3 未協商任何擴充,必須為 0
+    if (buf[0] & 0x30) {
+        return WS_FRAME_ERROR;
+    }
+
+    size_t pos = 2;
+    uint64_t payload_len = buf[1] & 0x7F;
+
+    if (payload_len == 126) {
+        if (len < pos + 2) {
+            return WS_FRAME_INCOMPLETE;
+        }
+        payload_len = ((uint64_t)buf[2] << 8) | buf[3];
+        pos += 2;
+    } else if (payload_len == 127) {
+        if (len < pos + 8) {
+            return WS_FRAME_INCOMPLETE;
+        }
+        payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_len = (payload_len << 8) | buf[2 + i];
+        }
+        if (payload_len & (1ULL << 63)) {
+            return WS_FRAME_ERROR;
+        }
+        pos += 8;
+    }
+
+    // 控制訊框不可分段且 payload 不超過 125 bytes
+    if (ws_frame_is_control(hdr->opcode) && (!hdr->fin || payload_len > 125)) {
+        return WS_FRAME_ERROR;
+    }
+
+    if (hdr->masked) {
+        if (len < pos + 4) {
+            return WS_FRAME_INCOMPLETE;
+        }
+        memcpy(hdr->mask, buf + pos, 4);
+        pos += 4;
+    }
+
+    hdr->payload_len = payload_len;
+    hdr->header_len = pos;
+    return WS_FRAME_OK;
+}
+
+void ws_frame_unmask(uint8_t *payload, size_t len, const uint8_t mask[4]) {
+    size_t i = 0;
+
+    // 以 32-bit 為單位處理 (mask 週期為 4 bytes)
+    uint32_t mask32;
+    memcpy(&mask32, mask, 4);
+    for (; i + 4 <= len; i += 4) {
+        uint32_t word;
+        memcpy(&word, payload + i, 4);
+        word ^= mask32;
+        memcpy(payload + i, &word, 4);
+    }
+
+    for (; i < len; i++) {
+        payload[i] ^= mask[i & 3];
+    }
+}
+
+size_t ws_frame_write_header(uint8_t *out, uint8_t opcode, bool rsv1,
+                             size_t payload_len)
+{
+    out[0] = (uint8_t)(0x80 | (rsv1 ? 0x40 : 0x00) | (opcode & 0x0F));
+
+    if (payload_len < 126) {
+        out[1] = (uint8_t)payload_len;
+        return 2;
+    }
+
+    if (payload_len <= 0xFFFF) {
+        out[1] = 126;
+        out[2] = (uint8_t)(payload_len >> 8);
+        out[3] = (uint8_t)(payload_len & 0xFF);
+        return 4;
+    }
+
+    out[1] = 127;
+    uint64_t len64 = (uint64_t)payload_len;
+    for (int i = 0; i < 8; i++) {
+        out[2 + i] = (uint8_t)(len64 >> (56 - 8 * i));
+    }
+    return 10;
+}
+
+bool ws_frame_is_control(uint8_t opcode) {
+    return (opcode & 0x08) != 0;
+}
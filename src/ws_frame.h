@@ -0,0 +1,115 @@
+/**
+ * @file ws_frame.h
+ * @brief WebSocket Frame Codec - RFC 6455 訊框編解碼
+ *
+ * 此模組只處理位元組層級的訊框格式,不涉及 socket:
+ * - 解析客戶端訊框標頭 (含 mask)
+ * - 產生伺服器訊框標頭 (伺服器訊框不加 mask)
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-21
+ * @version 1.0.0
+ */
+
+#ifndef WS_FRAME_H
+#define WS_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define WS_OPCODE_CONTINUATION  0x0
+#define WS_OPCODE_TEXT          0x1
+#define WS_OPCODE_BINARY        0x2
+#define WS_OPCODE_CLOSE         0x8
+#define WS_OPCODE_PING          0x9
+#define WS_OPCODE_PONG          0xA
+
+/** 伺服器訊框標頭最大長度 (無 mask) */
+#define WS_FRAME_MAX_HEADER     10
+
+/** Close 狀態碼 */
+#define WS_CLOSE_NORMAL         1000
+#define WS_CLOSE_GOING_AWAY     1001
+#define WS_CLOSE_PROTOCOL_ERROR 1002
+#define WS_CLOSE_UNSUPPORTED    1003
+#define WS_CLOSE_INVALID_DATA   1007
+#define WS_CLOSE_POLICY         1008
+#define WS_CLOSE_TOO_BIG        1009
+#define WS_CLOSE_SERVICE_RESTART 1012
+
+/** 解析結果 */
+#define WS_FRAME_OK             1
+#define WS_FRAME_INCOMPLETE     0
+#define WS_FRAME_ERROR         -1
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 訊框標頭
+ */
+typedef struct {
+    bool fin;                   /**< 最後一個分段 */
+    bool rsv1;                  /**< RSV1 (permessage-deflate 壓縮旗標) */
+    uint8_t opcode;             /**< Opcode */
+    bool masked;                /**< 是否有 mask */
+    uint8_t mask[4];            /**< Mask key */
+    uint64_t payload_len;       /**< Payload 長度 */
+    size_t header_len;          /**< 標頭長度 */
+} ws_frame_header_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 解析訊框標頭
+ *
+ * @param buf 接收緩衝區
+ * @param len 緩衝區內資料長度
+ * @param hdr 輸出標頭
+ * @return WS_FRAME_OK, WS_FRAME_INCOMPLETE (需要更多資料), WS_FRAME_ERROR
+ */
+int ws_frame_parse_header(const uint8_t *buf, size_t len, ws_frame_header_t *hdr);
+
+/**
+ * @brief 解除 payload 的 mask (原地處理)
+ *
+ * @param payload Payload
+ * @param len 長度
+ * @param mask Mask key
+ */
+void ws_frame_unmask(uint8_t *payload, size_t len, const uint8_t mask[4]);
+
+/**
+ * @brief 產生伺服器訊框標頭 (FIN=1,無 mask)
+ *
+ * @param out 輸出緩衝區 (至少 WS_FRAME_MAX_HEADER bytes)
+ * @param opcode Opcode
+ * @param rsv1 是否設定 RSV1 (壓縮)
+ * @param payload_len Payload 長度
+ * @return 標頭長度
+ */
+size_t ws_frame_write_header(uint8_t *out, uint8_t opcode, bool rsv1,
+                             size_t payload_len);
+
+/**
+ * @brief 判斷是否為控制訊框 opcode
+ */
+bool ws_frame_is_control(uint8_t opcode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WS_FRAME_H */
@@ -0,0 +1,515 @@
+/**
+ * @file ws_handshake.c
+ * @brief WebSocket Handshake Implementation
+ *
+ * SHA-1 與 Base64 只用於計算 Sec-WebSocket-Accept,
+ * 為避免額外依賴 (OpenSSL/mbedTLS) 在此自行實作。
+ *
+ * 重新開機後所有客戶端幾乎同時重連,握手集中在同一秒內:
+ * - 標頭結尾以 memchr() 搜尋 (libc 以字組/SIMD 實作)
+ * - x86_64 CPU 支援 SHA 指令集時以 SHA-NI 計算區塊 (執行期偵測),
+ *   其他平台使用一般實作
+ *
+ * @version 1.0.0
+ * @date 2025-11-21
+ */
+
+#include "ws_handshake.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define WS_HANDSHAKE_SHA_NI     1
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define WS_HANDSHAKE_GUID   "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+/** Sec-WebSocket-Key 為 16 bytes 的 Base64 (24 字元) */
+#define WS_HANDSHAKE_KEY_LEN    24
+
+/* ============================================================
+ *  Helper Functions - String
+ * ============================================================ */
+
+static ws_str_t trim(const char *start, const char *end) {
+    while (start < end && (*start == ' ' || *start == '\t')) {
+        start++;
+    }
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+
+    ws_str_t s = { start, (size_t)(end - start) };
+    return s;
+}
+
+static bool name_equals(const char *name, size_t len, const char *expected) {
+    return strlen(expected) == len && strncasecmp(name, expected, len) == 0;
+}
+
+bool ws_str_equals(ws_str_t value, const char *s) {
+    return value.ptr != NULL && name_equals(value.ptr, value.len, s);
+}
+
+bool ws_str_has_token(ws_str_t value, const char *token) {
+    if (value.ptr == NULL || token == NULL) {
+        return false;
+    }
+
+    const char *p = value.ptr;
+    const char *end = value.ptr + value.len;
+
+    while (p < end) {
+        const char *comma = memchr(p, ',', (size_t)(end - p));
+        const char *item_end = comma ? comma : end;
+
+        ws_str_t item = trim(p, item_end);
+        if (ws_str_equals(item, token)) {
+            return true;
+        }
+
+        p = item_end + 1;
+    }
+
+    return false;
+}
+
+/* ============================================================
+ *  Helper Functions - SHA-1 / Base64
+ * ============================================================ */
+
+#define ROTL32(x, n)    (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void sha1_block(uint32_t h[5], const uint8_t block[64]) {
+    uint32_t w[80];
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = ROTL32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+
+        uint32_t temp = ROTL32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = ROTL32(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+#ifdef WS_HANDSHAKE_SHA_NI
+/**
+ * @brief 以 SHA-NI 處理一個區塊 (每個指令完成 4 輪)
+ */
+__attribute__((target("sha,sse4.1")))
+static void sha1_block_shani(uint32_t h[5], const uint8_t block[64]) {
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)h), 0x1B);
+    __m128i e0 = _mm_set_epi32((int)h[4], 0, 0, 0);
+    __m128i abcd_save = abcd;
+    __m128i e0_save = e0;
+    __m128i e1;
+
+    __m128i msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 0)), mask);
+    __m128i msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 16)), mask);
+    __m128i msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 32)), mask);
+    __m128i msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 48)), mask);
+
+    // 0-3
+    e0 = _mm_add_epi32(e0, msg0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+    // 4-7
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+    // 8-11
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    /*
+     * 12-67: 每 4 輪的排程相同,只有暫存器輪替
+     * (ea/eb: E 累加器, ma: 本輪訊息字, mb: 完成排程, mc/md: 排程中)
+     */
+#define SHA1_ROUNDS4(ea, eb, ma, mb, mc, md, f)     \
+    do {                                            \
+        ea = _mm_sha1nexte_epu32(ea, ma);           \
+        eb = abcd;                                  \
+        mb = _mm_sha1msg2_epu32(mb, ma);            \
+        abcd = _mm_sha1rnds4_epu32(abcd, ea, f);    \
+        md = _mm_sha1msg1_epu32(md, ma);            \
+        mc = _mm_xor_si128(mc, ma);                 \
+    } while (0)
+
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 0);    // 12-15
+    SHA1_ROUNDS4(e0, e1, msg0, msg1, msg2, msg3, 0);    // 16-19
+    SHA1_ROUNDS4(e1, e0, msg1, msg2, msg3, msg0, 1);    // 20-23
+    SHA1_ROUNDS4(e0, e1, msg2, msg3, msg0, msg1, 1);    // 24-27
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 1);    // 28-31
+    SHA1_ROUNDS4(e0, e1, msg0, msg1, msg2, msg3, 1);    // 32-35
+    SHA1_ROUNDS4(e1, e0, msg1, msg2, msg3, msg0, 1);    // 36-39
+    SHA1_ROUNDS4(e0, e1, msg2, msg3, msg0, msg1, 2);    // 40-43
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 2);    // 44-47
+    SHA1_ROUNDS4(e0, e1, msg0, msg1, msg2, msg3, 2);    // 48-51
+    SHA1_ROUNDS4(e1, e0, msg1, msg2, msg3, msg0, 2);    // 52-55
+    SHA1_ROUNDS4(e0, e1, msg2, msg3, msg0, msg1, 2);    // 56-59
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 3);    // 60-63
+    SHA1_ROUNDS4(e0, e1, msg0, msg1, msg2, msg3, 3);    // 64-67
+
+#undef SHA1_ROUNDS4
+
+    // 68-71
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    // 72-75
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+    // 76-79
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+
+    _mm_storeu_si128((__m128i*)h, _mm_shuffle_epi32(abcd, 0x1B));
+    h[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+/**
+ * @brief CPU 是否支援 SHA 指令集 (CPUID.7.0:EBX[29],結果快取)
+ */
+static bool cpu_has_sha(void) {
+    static int cached = -1;
+    int has = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+
+    if (has < 0) {
+        unsigned int eax, ebx, ecx, edx;
+        has = 0;
+        if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29)) &&
+            __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_1)) {
+            has = 1;
+        }
+        __atomic_store_n(&cached, has, __ATOMIC_RELAXED);
+    }
+
+    return has != 0;
+}
+#endif
+
+/**
+ * @brief SHA-1 (僅用於短訊息,一次處理完畢)
+ */
+static void sha1(const uint8_t *data, size_t len, uint8_t digest[20]) {
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint8_t block[64];
+    size_t pos = 0;
+
+    void (*process_block)(uint32_t h[5], const uint8_t block[64]) = sha1_block;
+#ifdef WS_HANDSHAKE_SHA_NI
+    if (cpu_has_sha()) {
+        process_block = sha1_block_shani;
+    }
+#endif
+
+    while (len - pos >= 64) {
+        process_block(h, data + pos);
+        pos += 64;
+    }
+
+    // 補齊: 0x80 + 0x00... + 64-bit 長度 (bits)
+    size_t rem = len - pos;
+    memset(block, 0, sizeof(block));
+    memcpy(block, data + pos, rem);
+    block[rem] = 0x80;
+
+    if (rem >= 56) {
+        process_block(h, block);
+        memset(block, 0, sizeof(block));
+    }
+
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++) {
+        block[63 - i] = (uint8_t)(bits >> (8 * i));
+    }
+    process_block(h, block);
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = (uint8_t)(h[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(h[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(h[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)h[i];
+    }
+}
+
+static const char g_base64_chars[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * @brief Base64 編碼 (輸出含 '\0')
+ */
+static size_t base64_encode(const uint8_t *in, size_t len, char *out) {
+    size_t o = 0;
+    size_t i = 0;
+
+    for (; i + 3 <= len; i += 3) {
+        uint32_t v = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8) | in[i + 2];
+        out[o++] = g_base64_chars[(v >> 18) & 0x3F];
+        out[o++] = g_base64_chars[(v >> 12) & 0x3F];
+        out[o++] = g_base64_chars[(v >> 6) & 0x3F];
+        out[o++] = g_base64_chars[v & 0x3F];
+    }
+
+    if (i < len) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) {
+            v |= (uint32_t)in[i + 1] << 8;
+        }
+        out[o++] = g_base64_chars[(v >> 18) & 0x3F];
+        out[o++] = g_base64_chars[(v >> 12) & 0x3F];
+        out[o++] = (i + 1 < len) ? g_base64_chars[(v >> 6) & 0x3F] : '=';
+        out[o++] = '=';
+    }
+
+    out[o] = '\0';
+    return o;
+}
+
+/* ============================================================
+ *  Helper Functions - Request
+ * ============================================================ */
+
+/**
+ * @brief 找到標頭結尾 (空行) 之後的位置
+ *
+ * 只在 '\n' 處比對前面的 "\r\n\r",一般請求約 10 行,
+ * 比逐字元比對少很多次分支。
+ *
+ * @return 結尾之後的位置, NULL 表示尚未收到完整標頭
+ */
+static const char* find_header_end(const char *buf, size_t len) {
+    const char *p = buf;
+    const char *end = buf + len;
+
+    while (p < end && (p = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        if (p - buf >= 3 && p[-1] == '\r' && p[-2] == '\n' && p[-3] == '\r') {
+            return p + 1;
+        }
+        p++;
+    }
+
+    return NULL;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int ws_handshake_parse_request(const char *buf, size_t len, ws_http_request_t *req) {
+    if (buf == NULL || req == NULL) {
+        return WS_HANDSHAKE_ERROR;
+    }
+
+    memset(req, 0, sizeof(*req));
+
+    // 找到標頭結尾
+    const char *end = find_header_end(buf, len);
+
+    if (end == NULL) {
+        return (len >= WS_HANDSHAKE_MAX_REQUEST) ? WS_HANDSHAKE_ERROR
+                                                 : WS_HANDSHAKE_INCOMPLETE;
+    }
+
+    if ((size_t)(end - buf) > WS_HANDSHAKE_MAX_REQUEST) {
+        return WS_HANDSHAKE_ERROR;
+    }
+
+    // 請求行: METHOD SP PATH SP HTTP/1.x CRLF
+    const char *line_end = memchr(buf, '\r', (size_t)(end - buf));
+    const char *sp1 = memchr(buf, ' ', (size_t)(line_end - buf));
+    if (sp1 == NULL) {
+        return WS_HANDSHAKE_ERROR;
+    }
+    const char *sp2 = memchr(sp1 + 1, ' ', (size_t)(line_end - sp1 - 1));
+    if (sp2 == NULL || (size_t)(line_end - sp2 - 1) < 8 ||
+        strncmp(sp2 + 1, "HTTP/1.", 7) != 0) {
+        return WS_HANDSHAKE_ERROR;
+    }
+
+    req->method.ptr = buf;
+    req->method.len = (size_t)(sp1 - buf);
+    req->path.ptr = sp1 + 1;
+    req->path.len = (size_t)(sp2 - sp1 - 1);
+
+    // 標頭: Name: value CRLF
+    const char *p = line_end + 2;
+    while (p < end - 2) {
+        const char *eol = memchr(p, '\r', (size_t)(end - p));
+        if (eol == NULL || eol[1] != '\n') {
+            return WS_HANDSHAKE_ERROR;
+        }
+
+        const char *colon = memchr(p, ':', (size_t)(eol - p));
+        if (colon == NULL || colon == p) {
+            return WS_HANDSHAKE_ERROR;
+        }
+
+        size_t name_len = (size_t)(colon - p);
+        ws_str_t value = trim(colon + 1, eol);
+
+        if (name_equals(p, name_len, "Upgrade")) {
+            req->upgrade = value;
+        } else if (name_equals(p, name_len, "Connection")) {
+            req->connection = value;
+        } else if (name_equals(p, name_len, "Sec-WebSocket-Key")) {
+            req->key = value;
+        } else if (name_equals(p, name_len, "Sec-WebSocket-Version")) {
+            req->version = value;
+        } else if (name_equals(p, name_len, "Sec-WebSocket-Extensions")) {
+            req->extensions = value;
+        } else if (name_equals(p, name_len, "Sec-WebSocket-Protocol")) {
+            req->protocol = value;
+        } else if (name_equals(p, name_len, "If-None-Match")) {
+            req->if_none_match = value;
+        } else if (name_equals(p, name_len, "Last-Event-ID")) {
+            req->last_event_id = value;
+        }
+
+        p = eol + 2;
+    }
+
+    req->header_len = (size_t)(end - buf);
+    return (int)req->header_len;
+}
+
+bool ws_handshake_is_upgrade(const ws_http_request_t *req) {
+    if (req == NULL) {
+        return false;
+    }
+
+    return ws_str_equals(req->method, "GET") &&
+           ws_str_has_token(req->upgrade, "websocket") &&
+           ws_str_has_token(req->connection, "Upgrade") &&
+           ws_str_equals(req->version, "13") &&
+           req->key.ptr != NULL && req->key.len == WS_HANDSHAKE_KEY_LEN;
+}
+
+int ws_handshake_select_protocol(ws_str_t offered, const char *const *supported, int count) {
+    if (offered.ptr == NULL || supported == NULL) {
+        return -1;
+    }
+
+    const char *p = offered.ptr;
+    const char *end = offered.ptr + offered.len;
+
+    while (p < end) {
+        const char *comma = memchr(p, ',', (size_t)(end - p));
+        const char *item_end = comma ? comma : end;
+
+        ws_str_t item = trim(p, item_end);
+        for (int i = 0; i < count; i++) {
+            if (ws_str_equals(item, supported[i])) {
+                return i;
+            }
+        }
+
+        p = item_end + 1;
+    }
+
+    return -1;
+}
+
+int ws_handshake_accept_key(ws_str_t key, char *out) {
+    if (key.ptr == NULL || key.len != WS_HANDSHAKE_KEY_LEN || out == NULL) {
+        return -1;
+    }
+
+    uint8_t input[WS_HANDSHAKE_KEY_LEN + sizeof(WS_HANDSHAKE_GUID) - 1];
+    memcpy(input, key.ptr, WS_HANDSHAKE_KEY_LEN);
+    memcpy(input + WS_HANDSHAKE_KEY_LEN, WS_HANDSHAKE_GUID, sizeof(WS_HANDSHAKE_GUID) - 1);
+
+    uint8_t digest[20];
+    sha1(input, sizeof(input), digest);
+    base64_encode(digest, sizeof(digest), out);
+
+    return 0;
+}
+
+int ws_handshake_build_response(char *out, size_t size, const char *accept_key,
+                                const char *extensions, const char *protocol)
+{
+    if (out == NULL || accept_key == NULL) {
+        return -1;
+    }
+
+    int len = snprintf(out, size,
+                       "HTTP/1.1 101 Switching Protocols\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Accept: %s\r\n"
+                       "%s%s%s"
+                       "%s%s%s"
+                       "\r\n",
+                       accept_key,
+                       extensions ? "Sec-WebSocket-Extensions: " : "",
+                       extensions ? extensions : "",
+                       extensions ? "\r\n" : "",
+                       protocol ? "Sec-WebSocket-Protocol: " : "",
+                       protocol ? protocol : "",
+                       protocol ? "\r\n" : "");
+
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+
+    return len;
+}
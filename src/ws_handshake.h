@@ -0,0 +1,137 @@
+/**
+ * @file ws_handshake.h
+ * @brief WebSocket Handshake - HTTP Upgrade 請求解析與回應
+ *
+ * 此模組處理 RFC 6455 開場握手:
+ * - 解析 HTTP 請求 (不配置記憶體,欄位以指標 + 長度指向原緩衝區)
+ * - 計算 Sec-WebSocket-Accept (SHA-1 + Base64)
+ * - 產生 101 Switching Protocols 回應
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-21
+ * @version 1.0.0
+ */
+
+#ifndef WS_HANDSHAKE_H
+#define WS_HANDSHAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** HTTP 請求標頭最大長度 */
+#define WS_HANDSHAKE_MAX_REQUEST    2048
+
+/** Sec-WebSocket-Accept 長度 (Base64 of SHA-1) */
+#define WS_HANDSHAKE_ACCEPT_LEN     28
+
+/** 解析結果 */
+#define WS_HANDSHAKE_INCOMPLETE     0
+#define WS_HANDSHAKE_ERROR         -1
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 字串片段 (指向原緩衝區,不以 '\0' 結尾)
+ */
+typedef struct {
+    const char *ptr;            /**< 起始位置, NULL 表示不存在 */
+    size_t len;                 /**< 長度 */
+} ws_str_t;
+
+/**
+ * @brief 解析後的 HTTP 請求
+ */
+typedef struct {
+    ws_str_t method;            /**< 方法 (GET) */
+    ws_str_t path;              /**< 路徑 */
+    ws_str_t upgrade;           /**< Upgrade */
+    ws_str_t connection;        /**< Connection */
+    ws_str_t key;               /**< Sec-WebSocket-Key */
+    ws_str_t version;           /**< Sec-WebSocket-Version */
+    ws_str_t extensions;        /**< Sec-WebSocket-Extensions */
+    ws_str_t protocol;          /**< Sec-WebSocket-Protocol */
+    ws_str_t if_none_match;     /**< If-None-Match (GET /status) */
+    ws_str_t last_event_id;     /**< Last-Event-ID (GET /events) */
+    size_t header_len;          /**< 請求標頭總長度 (含結尾空行) */
+} ws_http_request_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 解析 HTTP 請求標頭
+ *
+ * @param buf 接收緩衝區
+ * @param len 資料長度
+ * @param req 輸出結果 (欄位指向 buf)
+ * @return >0 標頭長度, WS_HANDSHAKE_INCOMPLETE 需要更多資料,
+ *         WS_HANDSHAKE_ERROR 格式錯誤
+ */
+int ws_handshake_parse_request(const char *buf, size_t len, ws_http_request_t *req);
+
+/**
+ * @brief 是否為合法的 WebSocket Upgrade 請求
+ */
+bool ws_handshake_is_upgrade(const ws_http_request_t *req);
+
+/**
+ * @brief 逗號分隔的標頭值中是否包含 token (不分大小寫)
+ */
+bool ws_str_has_token(ws_str_t value, const char *token);
+
+/**
+ * @brief 字串片段是否等於 s (不分大小寫)
+ */
+bool ws_str_equals(ws_str_t value, const char *s);
+
+/**
+ * @brief 選擇子協定
+ *
+ * 依客戶端 Sec-WebSocket-Protocol 的順序,選出第一個伺服器支援的子協定
+ *
+ * @param offered 客戶端提出的子協定清單
+ * @param supported 伺服器支援的子協定
+ * @param count supported 數量
+ * @return supported 中的索引, -1 表示沒有共同的子協定
+ */
+int ws_handshake_select_protocol(ws_str_t offered, const char *const *supported, int count);
+
+/**
+ * @brief 計算 Sec-WebSocket-Accept
+ *
+ * @param key Sec-WebSocket-Key
+ * @param out 輸出 (至少 WS_HANDSHAKE_ACCEPT_LEN + 1 bytes)
+ * @return 0 成功, <0 失敗
+ */
+int ws_handshake_accept_key(ws_str_t key, char *out);
+
+/**
+ * @brief 產生 101 Switching Protocols 回應
+ *
+ * @param out 輸出緩衝區
+ * @param size 緩衝區大小
+ * @param accept_key Sec-WebSocket-Accept
+ * @param extensions 協商後的擴充 (NULL 表示無)
+ * @param protocol 協商後的子協定 (NULL 表示無)
+ * @return 回應長度, <0 表示緩衝區不足
+ */
+int ws_handshake_build_response(char *out, size_t size, const char *accept_key,
+                                const char *extensions, const char *protocol);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WS_HANDSHAKE_H */
@@ -0,0 +1,238 @@
+/**
+ * @file ws_http.c
+ * @brief Plain HTTP Endpoints Implementation
+ *
+ * ETag 直接使用快照版本 ("N"),因此比對不需要雜湊 body。
+ *
+ * @version 1.0.0
+ * @date 2025-11-26
+ */
+
+#include "ws_http.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* ============================================================
+ *  Helper Functions
+ * ============================================================ */
+
+/**
+ * @brief 解析十進位數字 [p, end)
+ * @return 數值, 0 表示格式錯誤或溢位
+ */
+static uint64_t parse_decimal(const char *p, const char *end) {
+    uint64_t value = 0;
+
+    if (p >= end) {
+        return 0;
+    }
+
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9' || value > (UINT64_MAX - 9) / 10) {
+            return 0;
+        }
+        value = value * 10 + (uint64_t)(*p - '0');
+    }
+
+    return value;
+}
+
+static bool segment_equals(const char *p, const char *end, const char *s) {
+    size_t len = strlen(s);
+    return (size_t)(end - p) == len && memcmp(p, s, len) == 0;
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+ws_http_route_t ws_http_parse_route(ws_str_t path, uint64_t *version) {
+    if (version) {
+        *version = 0;
+    }
+    if (path.ptr == NULL) {
+        return WS_HTTP_ROUTE_NOT_FOUND;
+    }
+
+    const char *end = path.ptr + path.len;
+    const char *query = memchr(path.ptr, '?', path.len);
+    const char *path_end = query ? query : end;
+
+    if (segment_equals(path.ptr, path_end, "/events")) {
+        return WS_HTTP_ROUTE_EVENTS;
+    }
+    if (segment_equals(path.ptr, path_end, "/metrics")) {
+        return WS_HTTP_ROUTE_METRICS;
+    }
+    if (!segment_equals(path.ptr, path_end, "/status")) {
+        return WS_HTTP_ROUTE_NOT_FOUND;
+    }
+
+    // query string: version=N (其他參數忽略)
+    const char *p = query ? query + 1 : end;
+    while (p < end) {
+        const char *amp = memchr(p, '&', (size_t)(end - p));
+        const char *item_end = amp ? amp : end;
+
+        if ((size_t)(item_end - p) > 8 && memcmp(p, "version=", 8) == 0 && version) {
+            *version = parse_decimal(p + 8, item_end);
+        }
+
+        p = item_end + 1;
+    }
+
+    return WS_HTTP_ROUTE_STATUS;
+}
+
+bool ws_http_etag_matches(ws_str_t if_none_match, uint64_t version) {
+    if (if_none_match.ptr == NULL) {
+        return false;
+    }
+
+    const char *p = if_none_match.ptr;
+    const char *end = p + if_none_match.len;
+
+    while (p < end) {
+        const char *comma = memchr(p, ',', (size_t)(end - p));
+        const char *item_end = comma ? comma : end;
+
+        while (p < item_end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        const char *tag_end = item_end;
+        while (tag_end > p && (tag_end[-1] == ' ' || tag_end[-1] == '\t')) {
+            tag_end--;
+        }
+
+        if (segment_equals(p, tag_end, "*")) {
+            return true;
+        }
+
+        // 弱比較: W/"N" 與 "N" 視為相同
+        if (tag_end - p >= 2 && p[0] == 'W' && p[1] == '/') {
+            p += 2;
+        }
+        if (tag_end - p >= 3 && p[0] == '"' && tag_end[-1] == '"' &&
+            parse_decimal(p + 1, tag_end - 1) == version) {
+            return true;
+        }
+
+        p = item_end + 1;
+    }
+
+    return false;
+}
+
+uint64_t ws_http_parse_version(ws_str_t value) {
+    if (value.ptr == NULL) {
+        return 0;
+    }
+    return parse_decimal(value.ptr, value.ptr + value.len);
+}
+
+int ws_http_build_status(char *out, size_t size, uint64_t version,
+                         const char *json, size_t json_len)
+{
+    if (out == NULL || json == NULL) {
+        return -1;
+    }
+
+    int len = snprintf(out, size,
+                       "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: application/json\r\n"
+                       "Content-Length: %zu\r\n"
+                       "ETag: \"%" PRIu64 "\"\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Access-Control-Expose-Headers: ETag\r\n"
+                       "\r\n",
+                       json_len, version);
+
+    if (len < 0 || (size_t)len + json_len >= size) {
+        return -1;
+    }
+
+    memcpy(out + len, json, json_len);
+    out[len + json_len] = '\0';
+    return len + (int)json_len;
+}
+
+int ws_http_build_not_modified(char *out, size_t size, uint64_t version) {
+    if (out == NULL) {
+        return -1;
+    }
+
+    int len = snprintf(out, size,
+                       "HTTP/1.1 304 Not Modified\r\n"
+                       "ETag: \"%" PRIu64 "\"\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Access-Control-Expose-Headers: ETag\r\n"
+                       "\r\n",
+                       version);
+
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+
+    return len;
+}
+
+int ws_http_build_event(char *out, size_t size, uint64_t version,
+                        const char *json, size_t json_len)
+{
+    if (out == NULL || json == NULL) {
+        return -1;
+    }
+
+    int len = snprintf(out, size, "id: %" PRIu64 "\nevent: ps5_status\ndata: ", version);
+
+    // body + "\n\n" + '\0'
+    if (len < 0 || (size_t)len + json_len + 3 > size) {
+        return -1;
+    }
+
+    memcpy(out + len, json, json_len);
+    memcpy(out + len + json_len, "\n\n", 3);
+    return len + (int)json_len + 2;
+}
+
+int ws_http_build_metrics_header(char *out, size_t size, size_t body_len) {
+    if (out == NULL) {
+        return -1;
+    }
+
+    int len = snprintf(out, size,
+                       "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/plain; version=0.0.4\r\n"
+                       "Content-Length: %zu\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "\r\n",
+                       body_len);
+
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+
+    return len;
+}
+
+int ws_http_build_error(char *out, size_t size, const char *status) {
+    if (out == NULL || status == NULL) {
+        return -1;
+    }
+
+    int len = snprintf(out, size,
+                       "HTTP/1.1 %s\r\n"
+                       "Connection: close\r\n"
+                       "Content-Length: 0\r\n"
+                       "\r\n", status);
+
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+
+    return len;
+}
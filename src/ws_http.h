@@ -0,0 +1,130 @@
+/**
+ * @file ws_http.h
+ * @brief Plain HTTP Endpoints - 無法使用 WebSocket 的輕量客戶端
+ *
+ * 此模組提供 (與 WebSocket 同一個端口):
+ * - GET /status              目前狀態快照,帶 ETag (If-None-Match 相符時 304)
+ * - GET /status?version=N    長輪詢: 版本仍為 N 時等待變更 (逾時回 304)
+ * - GET /events              Server-Sent Events,每次狀態變更推送一則事件
+ * - GET /metrics             Prometheus 文字格式指標 (metrics.h)
+ *
+ * 只負責解析請求路徑與組裝回應,連線與事件迴圈由 websocket_server 處理。
+ * 回應在狀態變更時預先組裝一次,所有 HTTP 客戶端共用。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-26
+ * @version 1.0.0
+ */
+
+#ifndef WS_HTTP_H
+#define WS_HTTP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ws_handshake.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 回應標頭 (不含 body) 的最大長度 */
+#define WS_HTTP_MAX_HEADER          320
+
+/** SSE 串流開始時的回應標頭 */
+#define WS_HTTP_STREAM_HEADER \
+    "HTTP/1.1 200 OK\r\n" \
+    "Content-Type: text/event-stream\r\n" \
+    "Cache-Control: no-cache\r\n" \
+    "Access-Control-Allow-Origin: *\r\n" \
+    "\r\n"
+
+/** SSE 保持連線的註解行 */
+#define WS_HTTP_STREAM_KEEPALIVE    ": keepalive\n\n"
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief 請求路徑
+ */
+typedef enum {
+    WS_HTTP_ROUTE_NOT_FOUND = 0,    /**< 未知路徑 */
+    WS_HTTP_ROUTE_STATUS,           /**< /status */
+    WS_HTTP_ROUTE_EVENTS,           /**< /events */
+    WS_HTTP_ROUTE_METRICS,          /**< /metrics */
+} ws_http_route_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 解析請求路徑
+ *
+ * @param path 請求路徑 (含 query string)
+ * @param version 輸出 ?version=N, 0 表示未指定
+ * @return 路徑類型
+ */
+ws_http_route_t ws_http_parse_route(ws_str_t path, uint64_t *version);
+
+/**
+ * @brief If-None-Match 是否包含此版本的 ETag ("N"、W/"N" 或 *)
+ */
+bool ws_http_etag_matches(ws_str_t if_none_match, uint64_t version);
+
+/**
+ * @brief 解析十進位版本號 (Last-Event-ID)
+ *
+ * @return 版本號, 0 表示不存在或格式錯誤
+ */
+uint64_t ws_http_parse_version(ws_str_t value);
+
+/**
+ * @brief 產生 200 OK 狀態回應 (標頭 + JSON body)
+ *
+ * @return 回應長度, <0 表示緩衝區不足
+ */
+int ws_http_build_status(char *out, size_t size, uint64_t version,
+                         const char *json, size_t json_len);
+
+/**
+ * @brief 產生 304 Not Modified 回應
+ *
+ * @return 回應長度, <0 表示緩衝區不足
+ */
+int ws_http_build_not_modified(char *out, size_t size, uint64_t version);
+
+/**
+ * @brief 產生 SSE 事件 (id 為版本號, JSON 不可包含換行)
+ *
+ * @return 事件長度, <0 表示緩衝區不足
+ */
+int ws_http_build_event(char *out, size_t size, uint64_t version,
+                        const char *json, size_t json_len);
+
+/**
+ * @brief 產生 /metrics 回應標頭 (body 由呼叫者接著送出)
+ *
+ * @return 標頭長度, <0 表示緩衝區不足
+ */
+int ws_http_build_metrics_header(char *out, size_t size, size_t body_len);
+
+/**
+ * @brief 產生錯誤回應 (回應後關閉連線)
+ *
+ * @param status 狀態行,例如 "404 Not Found"
+ * @return 回應長度, <0 表示緩衝區不足
+ */
+int ws_http_build_error(char *out, size_t size, const char *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WS_HTTP_H */
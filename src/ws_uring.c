@@ -0,0 +1,324 @@
+/**
+ * @file ws_uring.c
+ * @brief Minimal io_uring Wrapper Implementation
+ *
+ * SQ/CQ 以單一 mmap 對應 (IORING_FEAT_SINGLE_MMAP)。
+ * SQE 先寫入本地的 sqe_tail,ws_uring_submit() 才以 release 發佈
+ * 給核心並呼叫一次 io_uring_enter(),因此一次廣播的所有寫入只需
+ * 一次系統呼叫。
+ *
+ * @version 1.0.0
+ * @date 2025-11-24
+ */
+
+#ifdef WS_USE_IO_URING
+
+#include "ws_uring.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+/** ws_uring_probe_multishot() 使用的 user_data */
+#define WS_URING_PROBE_DATA     UINT64_MAX
+
+/* ============================================================
+ *  System Calls
+ * ============================================================ */
+
+static int sys_setup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete,
+                     unsigned flags, const void *arg, size_t arg_size)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, arg, arg_size);
+}
+
+static int sys_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* ============================================================
+ *  Public API Implementation
+ * ============================================================ */
+
+int ws_uring_init(ws_uring_t *ring, unsigned entries) {
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+
+    // CQ 放大為 4 倍: 每個連線同時有 multishot recv 與 send
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    int fd = sys_setup(entries, &params);
+    if (fd < 0) {
+        return -1;  // ENOSYS / EPERM (io_uring_disabled)
+    }
+
+    unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP |
+                        IORING_FEAT_EXT_ARG | IORING_FEAT_FAST_POLL;
+    if ((params.features & required) != required) {
+        close(fd);
+        return -1;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->ring_size = (sq_size > cq_size) ? sq_size : cq_size;
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->ring_ptr = mmap(NULL, ring->ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->ring_ptr == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        munmap(ring->ring_ptr, ring->ring_size);
+        close(fd);
+        return -1;
+    }
+
+    uint8_t *base = ring->ring_ptr;
+    ring->sq_head = (unsigned*)(base + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(base + params.sq_off.tail);
+    ring->sq_array = (unsigned*)(base + params.sq_off.array);
+    ring->sq_mask = *(unsigned*)(base + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->sqe_tail = *ring->sq_tail;
+
+    ring->cq_head = (unsigned*)(base + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(base + params.cq_off.tail);
+    ring->cq_mask = *(unsigned*)(base + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(base + params.cq_off.cqes);
+
+    // SQ 索引陣列固定為 1:1 對應
+    for (unsigned i = 0; i < params.sq_entries; i++) {
+        ring->sq_array[i] = i;
+    }
+
+    ring->fd = fd;
+    return 0;
+}
+
+void ws_uring_exit(ws_uring_t *ring) {
+    if (ring->fd < 0) {
+        return;
+    }
+
+    // 關閉 ring 會取消所有未完成的請求
+    close(ring->fd);
+
+    if (ring->buf_ring != NULL) {
+        munmap(ring->buf_ring, ring->buf_ring_size);
+    }
+    free(ring->buf_base);
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->ring_ptr, ring->ring_size);
+
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+int ws_uring_setup_buffers(ws_uring_t *ring, uint16_t group, unsigned count,
+                           unsigned size)
+{
+    if ((count & (count - 1)) != 0 || count > 32768) {
+        return -1;
+    }
+
+    // buffer ring 必須頁對齊
+    ring->buf_ring_size = count * sizeof(struct io_uring_buf);
+    ring->buf_ring = mmap(NULL, ring->buf_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->buf_ring == MAP_FAILED) {
+        ring->buf_ring = NULL;
+        return -1;
+    }
+
+    ring->buf_base = malloc((size_t)count * size);
+    if (ring->buf_base == NULL) {
+        munmap(ring->buf_ring, ring->buf_ring_size);
+        ring->buf_ring = NULL;
+        return -1;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring->buf_ring;
+    reg.ring_entries = count;
+    reg.bgid = group;
+
+    if (sys_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        free(ring->buf_base);
+        munmap(ring->buf_ring, ring->buf_ring_size);
+        ring->buf_base = NULL;
+        ring->buf_ring = NULL;
+        return -1;
+    }
+
+    ring->buf_count = count;
+    ring->buf_size = size;
+    ring->buf_group = group;
+
+    for (unsigned bid = 0; bid < count; bid++) {
+        ws_uring_recycle_buffer(ring, bid);
+    }
+
+    return 0;
+}
+
+const uint8_t* ws_uring_buffer(const ws_uring_t *ring, unsigned bid) {
+    return ring->buf_base + (size_t)bid * ring->buf_size;
+}
+
+void ws_uring_recycle_buffer(ws_uring_t *ring, unsigned bid) {
+    if (bid >= ring->buf_count) {
+        return;
+    }
+
+    // tail 與 bufs[0].resv 重疊,只有本執行緒寫入
+    uint16_t tail = ring->buf_ring->tail;
+    struct io_uring_buf *buf = &ring->buf_ring->bufs[tail & (ring->buf_count - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(ring->buf_base + (size_t)bid * ring->buf_size);
+    buf->len = ring->buf_size;
+    buf->bid = (uint16_t)bid;
+
+    __atomic_store_n(&ring->buf_ring->tail, (uint16_t)(tail + 1), __ATOMIC_RELEASE);
+}
+
+struct io_uring_sqe* ws_uring_get_sqe(ws_uring_t *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+    if (ring->sqe_tail - head >= ring->sq_entries) {
+        // SQ 已滿: 先交給核心
+        if (ws_uring_submit(ring) < 0) {
+            return NULL;
+        }
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (ring->sqe_tail - head >= ring->sq_entries) {
+            return NULL;
+        }
+    }
+
+    struct io_uring_sqe *sqe = &ring->sqes[ring->sqe_tail & ring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sqe_tail++;
+    return sqe;
+}
+
+int ws_uring_submit(ws_uring_t *ring) {
+    unsigned tail = *ring->sq_tail;
+    unsigned pending = ring->sqe_tail - tail;
+    if (pending == 0) {
+        return 0;
+    }
+
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+
+    int ret;
+    do {
+        ret = sys_enter(ring->fd, pending, 0, 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+
+    return (ret < 0) ? -errno : ret;
+}
+
+int ws_uring_wait(ws_uring_t *ring, int timeout_ms) {
+    if (__atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE) != *ring->cq_head) {
+        return 0;
+    }
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+    }
+
+    int ret = sys_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                        &arg, sizeof(arg));
+    if (ret < 0 && errno != ETIME && errno != EINTR) {
+        return -errno;
+    }
+    return 0;
+}
+
+struct io_uring_cqe* ws_uring_peek_cqe(ws_uring_t *ring) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+void ws_uring_cqe_seen(ws_uring_t *ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+bool ws_uring_probe_multishot(ws_uring_t *ring) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) {
+        return false;
+    }
+
+    bool supported = false;
+    bool terminated = false;
+
+    struct io_uring_sqe *sqe = ws_uring_get_sqe(ring);
+    if (sqe != NULL && write(sv[1], "x", 1) == 1) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = sv[0];
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->buf_group = ring->buf_group;
+        sqe->user_data = WS_URING_PROBE_DATA;
+        ws_uring_submit(ring);
+
+        // 第一個 CQE: 收到 1 byte 且請求仍在執行 (F_MORE)
+        struct io_uring_cqe *cqe;
+        while (ws_uring_wait(ring, 1000) == 0 && (cqe = ws_uring_peek_cqe(ring)) != NULL) {
+            if (cqe->flags & IORING_CQE_F_BUFFER) {
+                ws_uring_recycle_buffer(ring, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+            }
+            supported = (cqe->res == 1 && (cqe->flags & IORING_CQE_F_MORE));
+            terminated = !(cqe->flags & IORING_CQE_F_MORE);
+            ws_uring_cqe_seen(ring);
+            break;
+        }
+    }
+
+    // 關閉對端讓請求結束,避免殘留的 CQE 進入正式迴圈
+    close(sv[1]);
+    while (supported && !terminated && ws_uring_wait(ring, 1000) == 0) {
+        struct io_uring_cqe *cqe = ws_uring_peek_cqe(ring);
+        if (cqe == NULL) {
+            break;
+        }
+        if (cqe->flags & IORING_CQE_F_BUFFER) {
+            ws_uring_recycle_buffer(ring, cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        }
+        terminated = !(cqe->flags & IORING_CQE_F_MORE);
+        ws_uring_cqe_seen(ring);
+    }
+    close(sv[0]);
+
+    return supported && terminated;
+}
+
+#endif /* WS_USE_IO_URING */
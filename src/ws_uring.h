@@ -0,0 +1,164 @@
+/**
+ * @file ws_uring.h
+ * @brief Minimal io_uring Wrapper - WebSocket 伺服器的 io_uring 後端
+ *
+ * 此模組提供:
+ * - 直接以系統呼叫建立 io_uring (不依賴 liburing)
+ * - SQE 取得 / 批次提交 / 帶逾時的等待
+ * - Provided buffer ring (核心自動挑選接收緩衝區)
+ * - 執行期偵測: 核心不支援所需功能時回傳錯誤,由呼叫者退回 epoll
+ *
+ * 需要 Linux 6.0 以上 (multishot accept/recv、buffer ring、EXT_ARG)。
+ * 只在定義 WS_USE_IO_URING 時編譯,其餘平台此標頭不提供任何宣告。
+ *
+ * 執行緒: SQ 只能由持有呼叫者鎖的執行緒操作;ws_uring_wait() 只讀取
+ * CQ,可以在不持有鎖的情況下呼叫。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-24
+ * @version 1.0.0
+ */
+
+#ifndef WS_URING_H
+#define WS_URING_H
+
+#ifdef WS_USE_IO_URING
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <linux/io_uring.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+/**
+ * @brief io_uring 實例
+ */
+typedef struct {
+    int fd;                             /**< ring fd, -1 表示未建立 */
+
+    // Submission queue
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_array;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned sqe_tail;                  /**< 已準備但尚未發佈的位置 */
+    struct io_uring_sqe *sqes;
+
+    // Completion queue
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+
+    // mmap 區域
+    void *ring_ptr;
+    size_t ring_size;
+    size_t sqes_size;
+
+    // Provided buffer ring
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_size;
+    uint8_t *buf_base;
+    unsigned buf_count;
+    unsigned buf_size;
+    uint16_t buf_group;
+} ws_uring_t;
+
+/* ============================================================
+ *  Public Function Declarations
+ * ============================================================ */
+
+/**
+ * @brief 建立 io_uring
+ *
+ * @param ring 實例
+ * @param entries SQ 大小
+ * @return 0 成功, -1 核心不支援或資源不足
+ */
+int ws_uring_init(ws_uring_t *ring, unsigned entries);
+
+/**
+ * @brief 釋放 io_uring 與 buffer ring
+ */
+void ws_uring_exit(ws_uring_t *ring);
+
+/**
+ * @brief 註冊 provided buffer ring
+ *
+ * @param ring 實例
+ * @param group buffer group ID (SQE 的 buf_group)
+ * @param count 緩衝區數量 (2 的次方)
+ * @param size 每個緩衝區大小
+ * @return 0 成功, -1 失敗
+ */
+int ws_uring_setup_buffers(ws_uring_t *ring, uint16_t group, unsigned count,
+                           unsigned size);
+
+/**
+ * @brief 取得 buffer 內容
+ */
+const uint8_t* ws_uring_buffer(const ws_uring_t *ring, unsigned bid);
+
+/**
+ * @brief 將 buffer 還給核心
+ */
+void ws_uring_recycle_buffer(ws_uring_t *ring, unsigned bid);
+
+/**
+ * @brief 檢查核心是否支援 multishot recv (Linux 6.0+)
+ *
+ * 以 socketpair 實際送出一次 multishot recv 確認,須先註冊 buffer ring
+ */
+bool ws_uring_probe_multishot(ws_uring_t *ring);
+
+/**
+ * @brief 取得一個已清零的 SQE
+ *
+ * SQ 已滿時先提交再重試一次
+ *
+ * @return SQE, NULL 表示 SQ 已滿
+ */
+struct io_uring_sqe* ws_uring_get_sqe(ws_uring_t *ring);
+
+/**
+ * @brief 提交所有已準備的 SQE (一次系統呼叫,沒有待提交時不呼叫)
+ *
+ * @return 提交數量, <0 失敗
+ */
+int ws_uring_submit(ws_uring_t *ring);
+
+/**
+ * @brief 等待至少一個 CQE (不提交 SQE)
+ *
+ * @param timeout_ms 逾時 (毫秒), <0 表示無限等待
+ * @return 0 有 CQE 或逾時, <0 失敗
+ */
+int ws_uring_wait(ws_uring_t *ring, int timeout_ms);
+
+/**
+ * @brief 取得下一個 CQE
+ *
+ * @return CQE, NULL 表示沒有
+ */
+struct io_uring_cqe* ws_uring_peek_cqe(ws_uring_t *ring);
+
+/**
+ * @brief 標記 CQE 已處理
+ */
+void ws_uring_cqe_seen(ws_uring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WS_USE_IO_URING */
+
+#endif /* WS_URING_H */
@@ -0,0 +1,264 @@
+/**
+ * @file async_log_test.c
+ * @brief 非同步日誌 (async_log) 限速與佇列測試
+ *
+ * 以模擬時鐘 (vclock) 控制限速視窗,TESTING 版本的記錄寫到 stderr,
+ * 測試期間將 stderr 導向暫存檔後比對:
+ * - 每個呼叫位置一個視窗內最多 ASYNC_LOG_SITE_BURST 筆,錯誤為
+ *   ASYNC_LOG_ERROR_BURST 筆
+ * - 視窗結束後的下一次呼叫先輸出 "repeated N more times" 摘要;
+ *   之後不再呼叫的位置在 async_log_stop() 時補上摘要
+ * - 背景執行緒未讀取時佇列滿,丟棄的筆數在寫出時回報
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-09
+ * @version 1.0.0
+ */
+
+#include "async_log.h"
+#include "vclock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 與 async_log.c 相同 */
+#define ASYNC_LOG_QUEUE_SIZE    256
+
+/** 佇列滿之後多寫入的筆數 */
+#define OVERFLOW_RECORDS        10
+
+/** 模擬的牆上時間起點 (2025-12-08 00:00:00 UTC) */
+#define SIM_START_REALTIME      1765152000
+
+/** 等待背景執行緒的真實時間上限 */
+#define THREAD_WAIT_MS          2000
+
+#define CAPTURE_MAX_SIZE        (128 * 1024)
+
+/* ============================================================
+ *  Checks
+ * ============================================================ */
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* ============================================================
+ *  Captured Output
+ * ============================================================ */
+
+static char g_output[CAPTURE_MAX_SIZE];
+static FILE *g_capture = NULL;
+static int g_saved_stderr = -1;
+
+static void begin_capture(void) {
+    fflush(stderr);
+    g_capture = tmpfile();
+    g_saved_stderr = dup(STDERR_FILENO);
+    if (g_capture == NULL || g_saved_stderr < 0 ||
+        dup2(fileno(g_capture), STDERR_FILENO) < 0) {
+        perror("capture");
+        exit(1);
+    }
+}
+
+/**
+ * @brief 還原 stderr,擷取的內容放在 g_output
+ */
+static void end_capture(void) {
+    fflush(stderr);
+    dup2(g_saved_stderr, STDERR_FILENO);
+    close(g_saved_stderr);
+
+    rewind(g_capture);
+    size_t n = fread(g_output, 1, sizeof(g_output) - 1, g_capture);
+    g_output[n] = '\0';
+    fclose(g_capture);
+    g_capture = NULL;
+}
+
+/**
+ * @brief 擷取內容中包含 text 的行數
+ */
+static int count_lines(const char *text) {
+    int count = 0;
+    for (const char *line = g_output; *line != '\0'; ) {
+        const char *end = strchr(line, '\n');
+        size_t len = end ? (size_t)(end - line) : strlen(line);
+        const char *hit = strstr(line, text);
+        if (hit != NULL && hit < line + len) {
+            count++;
+        }
+        line += len + (end ? 1 : 0);
+    }
+    return count;
+}
+
+/* ============================================================
+ *  Tests
+ * ============================================================ */
+
+/**
+ * @brief 一般等級: 視窗內 ASYNC_LOG_SITE_BURST 筆,下一個視窗先輸出摘要
+ */
+static void test_site_burst(void) {
+    static async_log_site_t site = { .fmt = "warn %d", .level = ASYNC_LOG_WARNING };
+    const int calls = ASYNC_LOG_SITE_BURST + 3;
+
+    begin_capture();
+    for (int i = 0; i < calls; i++) {
+        async_log_write(&site, ASYNC_LOG_WARNING, "warn %d", i);
+    }
+    // 視窗結束前 1 ms 仍被略過
+    vclock_advance((ASYNC_LOG_SITE_WINDOW_MS - 1) * VCLOCK_US_PER_MS);
+    async_log_write(&site, ASYNC_LOG_WARNING, "warn %d", calls);
+    vclock_advance(VCLOCK_US_PER_MS);
+    async_log_write(&site, ASYNC_LOG_WARNING, "warn %d", calls + 1);
+    end_capture();
+
+    char expected[512];
+    int len = 0;
+    for (int i = 0; i < ASYNC_LOG_SITE_BURST; i++) {
+        len += snprintf(expected + len, sizeof(expected) - (size_t)len, "[WARNING] warn %d\n", i);
+    }
+    snprintf(expected + len, sizeof(expected) - (size_t)len,
+             "[WARNING] Message repeated %d more times (rate limited): warn %%d\n"
+             "[WARNING] warn %d\n",
+             calls - ASYNC_LOG_SITE_BURST + 1, calls + 1);
+
+    CHECK(strcmp(g_output, expected) == 0, "site burst output:\n%s--- want:\n%s", g_output, expected);
+}
+
+/**
+ * @brief 錯誤等級使用較大的 ASYNC_LOG_ERROR_BURST
+ */
+static void test_error_burst(void) {
+    static async_log_site_t error_site = { .fmt = "error %d", .level = ASYNC_LOG_ERROR };
+    static async_log_site_t info_site = { .fmt = "info %d", .level = ASYNC_LOG_INFO };
+    const int calls = ASYNC_LOG_ERROR_BURST + 7;
+
+    begin_capture();
+    for (int i = 0; i < calls; i++) {
+        async_log_write(&error_site, ASYNC_LOG_ERROR, "error %d", i);
+        async_log_write(&info_site, ASYNC_LOG_INFO, "info %d", i);
+    }
+    vclock_advance(ASYNC_LOG_SITE_WINDOW_MS * VCLOCK_US_PER_MS);
+    async_log_write(&error_site, ASYNC_LOG_ERROR, "error %d", calls);
+    async_log_write(&info_site, ASYNC_LOG_INFO, "info %d", calls);
+    end_capture();
+
+    CHECK(ASYNC_LOG_ERROR_BURST > ASYNC_LOG_SITE_BURST, "error burst %d not above %d",
+          ASYNC_LOG_ERROR_BURST, ASYNC_LOG_SITE_BURST);
+    CHECK(count_lines("[ERROR] error ") == ASYNC_LOG_ERROR_BURST + 1,
+          "%d error records, want %d", count_lines("[ERROR] error "), ASYNC_LOG_ERROR_BURST + 1);
+    CHECK(count_lines("[INFO] info ") == ASYNC_LOG_SITE_BURST + 1,
+          "%d info records, want %d", count_lines("[INFO] info "), ASYNC_LOG_SITE_BURST + 1);
+
+    char summary[128];
+    snprintf(summary, sizeof(summary), "[ERROR] Message repeated %d more times (rate limited): error",
+             calls - ASYNC_LOG_ERROR_BURST);
+    CHECK(count_lines(summary) == 1, "missing \"%s\"", summary);
+    snprintf(summary, sizeof(summary), "[INFO] Message repeated %d more times (rate limited): info",
+             calls - ASYNC_LOG_SITE_BURST);
+    CHECK(count_lines(summary) == 1, "missing \"%s\"", summary);
+}
+
+/**
+ * @brief 不再呼叫的位置: async_log_stop() 補上摘要
+ */
+static void test_flush_on_stop(void) {
+    static async_log_site_t site = { .fmt = "quiet %d", .level = ASYNC_LOG_INFO };
+
+    begin_capture();
+    for (int i = 0; i < ASYNC_LOG_SITE_BURST + 2; i++) {
+        async_log_write(&site, ASYNC_LOG_INFO, "quiet %d", i);
+    }
+    async_log_stop();
+    end_capture();
+
+    CHECK(count_lines("[INFO] Message repeated 2 more times (rate limited): quiet %d") == 1,
+          "no summary at stop:\n%s", g_output);
+}
+
+static bool wait_for_sleeper(void) {
+    for (int waited = 0; waited < THREAD_WAIT_MS; waited++) {
+        if (vclock_sleepers() > 0) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return false;
+}
+
+/**
+ * @brief 佇列滿: 丟棄新記錄並在寫出時回報筆數
+ *
+ * 模擬時鐘不推進,背景執行緒第一次讀取後停在 vclock_sleep_us(),
+ * 寫入的記錄都留在佇列中,直到 async_log_stop()。
+ */
+static void test_queue_full(void) {
+    static async_log_site_t sites[ASYNC_LOG_QUEUE_SIZE + OVERFLOW_RECORDS];
+    const int total = ASYNC_LOG_QUEUE_SIZE + OVERFLOW_RECORDS;
+
+    begin_capture();
+    CHECK(async_log_start(ASYNC_LOG_DEBUG) == 0, "async_log_start failed");
+    CHECK(wait_for_sleeper(), "drain thread never slept");
+
+    // 每筆使用不同的呼叫位置,不受限速影響
+    for (int i = 0; i < total; i++) {
+        sites[i].fmt = "record %d";
+        sites[i].level = ASYNC_LOG_INFO;
+        async_log_write(&sites[i], ASYNC_LOG_INFO, "record %d", i);
+    }
+    async_log_stop();
+    end_capture();
+
+    CHECK(count_lines("[INFO] record ") == ASYNC_LOG_QUEUE_SIZE, "%d records written, want %d",
+          count_lines("[INFO] record "), ASYNC_LOG_QUEUE_SIZE);
+
+    char text[64];
+    snprintf(text, sizeof(text), "[INFO] record %d\n", ASYNC_LOG_QUEUE_SIZE - 1);
+    CHECK(strstr(g_output, text) != NULL, "last queued record missing");
+    snprintf(text, sizeof(text), "[INFO] record %d\n", ASYNC_LOG_QUEUE_SIZE);
+    CHECK(strstr(g_output, text) == NULL, "record written although the queue was full");
+
+    snprintf(text, sizeof(text), "[WARNING] Log queue full, dropped %d messages",
+             OVERFLOW_RECORDS);
+    CHECK(count_lines(text) == 1, "missing \"%s\"", text);
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+int main(void) {
+    vclock_use_simulated(SIM_START_REALTIME);
+    // 呼叫位置的第一個視窗從時鐘 0 起算 (真實時鐘下早已過期),先推進一個視窗
+    vclock_advance(ASYNC_LOG_SITE_WINDOW_MS * VCLOCK_US_PER_MS);
+
+    test_site_burst();
+    test_error_burst();
+    test_flush_on_stop();
+    test_queue_full();
+
+    if (g_failures > 0) {
+        fprintf(stderr, "async_log_test: %d failures\n", g_failures);
+        return 1;
+    }
+    printf("async_log_test: OK\n");
+    return 0;
+}
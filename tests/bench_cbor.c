@@ -0,0 +1,299 @@
+/**
+ * @file bench_cbor.c
+ * @brief gaming.v1.cbor 與 JSON 狀態訊息的編碼/解碼成本比較
+ *
+ * 項目:
+ * - 編碼 ps5_status: json_writer (render_snapshot 的 JSON) 與
+ *   cbor_writer 固定佈局,另列 cJSON 建樹 + PrintUnformatted 作為對照
+ * - 客戶端解碼 ps5_status: cJSON_Parse + GetObjectItem 與固定陣列解碼
+ * - 伺服器接收請求: cJSON_Parse 取 "type" 與 CBOR 請求轉為 JSON
+ *   (ws_cbor_to_json,websocket_server 接收 CBOR 訊框時的路徑)
+ *
+ * 輸出每次呼叫的平均奈秒數與訊息大小。cJSON 的數字取決於連結的版本,
+ * 結果開頭列出 cJSON_Version()。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-08
+ * @version 1.0.0
+ */
+
+#include "bench_util.h"
+#include "json_writer.h"
+#include "ws_cbor.h"
+#include "websocket_server.h"
+
+#include <cjson/cJSON.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+/* ============================================================
+ *  Sample Messages
+ * ============================================================ */
+
+/** 固定佈局的範例值 (PS5_POWER_ON、PS5_NET_ONLINE、SERVER_STATE_MONITORING) */
+#define SAMPLE_VERSION      4242
+#define SAMPLE_POWER        3
+#define SAMPLE_NETWORK      2
+#define SAMPLE_STATE        1
+
+static char g_status_json[256];
+static size_t g_status_json_len;
+static uint8_t g_status_cbor[64];
+static size_t g_status_cbor_len;
+
+static const char k_request_json[] = "{\"type\":\"query_ps5\",\"id\":17}";
+static uint8_t g_request_cbor[64];
+static size_t g_request_cbor_len;
+
+/* ============================================================
+ *  Encoders
+ * ============================================================ */
+
+static size_t encode_json(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "ps5_status");
+    json_writer_kv_int(&w, "version", SAMPLE_VERSION);
+    json_writer_kv_string(&w, "power", "ON");
+    json_writer_kv_string(&w, "network", "online");
+    json_writer_kv_string(&w, "server_state", "MONITORING");
+    json_writer_end_object(&w);
+    return json_writer_finish(&w) ? json_writer_length(&w) : 0;
+}
+
+static size_t encode_cbor(uint8_t *buf, size_t cap) {
+    cbor_writer_t c;
+    cbor_writer_init(&c, buf, cap);
+    cbor_writer_array(&c, 6);
+    cbor_writer_int(&c, WS_MSG_PS5_STATUS);
+    cbor_writer_int(&c, SAMPLE_VERSION);
+    cbor_writer_int(&c, SAMPLE_POWER);
+    cbor_writer_int(&c, SAMPLE_NETWORK);
+    cbor_writer_int(&c, SAMPLE_STATE);
+    cbor_writer_bool(&c, false);
+    return cbor_writer_finish(&c);
+}
+
+static void bench_encode_json(void *arg) {
+    (void)arg;
+    char buf[256];
+    BENCH_KEEP(encode_json(buf, sizeof(buf)));
+}
+
+static void bench_encode_cbor(void *arg) {
+    (void)arg;
+    uint8_t buf[64];
+    BENCH_KEEP(encode_cbor(buf, sizeof(buf)));
+}
+
+static void bench_encode_cjson(void *arg) {
+    (void)arg;
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", "ps5_status");
+    cJSON_AddNumberToObject(root, "version", SAMPLE_VERSION);
+    cJSON_AddStringToObject(root, "power", "ON");
+    cJSON_AddStringToObject(root, "network", "online");
+    cJSON_AddStringToObject(root, "server_state", "MONITORING");
+    char *text = cJSON_PrintUnformatted(root);
+    BENCH_KEEP(text);
+    free(text);
+    cJSON_Delete(root);
+}
+
+/* ============================================================
+ *  Client-side Decoders
+ * ============================================================ */
+
+typedef struct {
+    int64_t version;
+    int power;
+    int network;
+    int state;
+    bool stale;
+} status_fields_t;
+
+/**
+ * @brief 讀取一個小於 2^32 的無號/負整數 (固定佈局只用到這些)
+ */
+static bool read_small_int(const uint8_t **p, const uint8_t *end, int64_t *out) {
+    if (*p >= end) {
+        return false;
+    }
+    uint8_t major = **p >> 5;
+    uint8_t info = **p & 0x1F;
+    (*p)++;
+    if (major > 1) {
+        return false;
+    }
+
+    uint64_t v;
+    if (info < 24) {
+        v = info;
+    } else {
+        int n = (info == 24) ? 1 : (info == 25) ? 2 : (info == 26) ? 4 : 0;
+        if (n == 0 || end - *p < n) {
+            return false;
+        }
+        v = 0;
+        for (int i = 0; i < n; i++) {
+            v = (v << 8) | *(*p)++;
+        }
+    }
+
+    *out = (major == 0) ? (int64_t)v : -1 - (int64_t)v;
+    return true;
+}
+
+static bool decode_cbor(const uint8_t *data, size_t len, status_fields_t *out) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+    int64_t v[5];
+
+    // 6 個元素,附加 id 時 7 個
+    if (len == 0 || (*p != 0x86 && *p != 0x87)) {
+        return false;
+    }
+    p++;
+    for (int i = 0; i < 5; i++) {
+        if (!read_small_int(&p, end, &v[i])) {
+            return false;
+        }
+    }
+    if (p == end || (*p != 0xF4 && *p != 0xF5)) {
+        return false;
+    }
+    out->stale = (*p++ == 0xF5);
+    if (v[0] != WS_MSG_PS5_STATUS) {
+        return false;
+    }
+
+    out->version = v[1];
+    out->power = (int)v[2];
+    out->network = (int)v[3];
+    out->state = (int)v[4];
+    return true;
+}
+
+static int lookup(const char *s, const char *const *names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(s, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool decode_cjson(const char *json, status_fields_t *out) {
+    static const char *const k_power[] = { "UNKNOWN", "OFF", "STANDBY", "ON" };
+    static const char *const k_network[] = { "unknown", "offline", "online" };
+    static const char *const k_state[] = { "INIT", "MONITORING", "PS5_DETECTED", "CLIENT_CONNECTED" };
+
+    cJSON *root = cJSON_Parse(json);
+    if (root == NULL) {
+        return false;
+    }
+
+    cJSON *type = cJSON_GetObjectItem(root, "type");
+    cJSON *version = cJSON_GetObjectItem(root, "version");
+    cJSON *power = cJSON_GetObjectItem(root, "power");
+    cJSON *network = cJSON_GetObjectItem(root, "network");
+    cJSON *state = cJSON_GetObjectItem(root, "server_state");
+    bool ok = cJSON_IsString(type) && strcmp(type->valuestring, "ps5_status") == 0 &&
+              cJSON_IsNumber(version) && cJSON_IsString(power) &&
+              cJSON_IsString(network) && cJSON_IsString(state);
+    if (ok) {
+        out->version = (int64_t)version->valuedouble;
+        out->power = lookup(power->valuestring, k_power, 4);
+        out->network = lookup(network->valuestring, k_network, 3);
+        out->state = lookup(state->valuestring, k_state, 4);
+        out->stale = cJSON_IsTrue(cJSON_GetObjectItem(root, "stale"));
+    }
+
+    cJSON_Delete(root);
+    return ok;
+}
+
+static void bench_decode_cjson(void *arg) {
+    (void)arg;
+    status_fields_t f;
+    BENCH_KEEP(decode_cjson(g_status_json, &f));
+    BENCH_KEEP(f.state);
+}
+
+static void bench_decode_cbor(void *arg) {
+    (void)arg;
+    status_fields_t f;
+    BENCH_KEEP(decode_cbor(g_status_cbor, g_status_cbor_len, &f));
+    BENCH_KEEP(f.state);
+}
+
+/* ============================================================
+ *  Server-side Request Handling
+ * ============================================================ */
+
+static void bench_request_cjson(void *arg) {
+    (void)arg;
+    cJSON *root = cJSON_Parse(k_request_json);
+    cJSON *type = cJSON_GetObjectItem(root, "type");
+    BENCH_KEEP(ws_message_type_from_string(cJSON_IsString(type) ? type->valuestring : ""));
+    cJSON_Delete(root);
+}
+
+static void bench_request_cbor(void *arg) {
+    (void)arg;
+    char json[128];
+    int type = 0;
+    BENCH_KEEP(ws_cbor_to_json(g_request_cbor, g_request_cbor_len, json, sizeof(json), &type));
+    BENCH_KEEP(type);
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+static void report(const char *name, double ns, size_t bytes) {
+    if (bytes > 0) {
+        printf("  %-34s %9.1f ns/op  %4zu bytes\n", name, ns, bytes);
+    } else {
+        printf("  %-34s %9.1f ns/op\n", name, ns);
+    }
+}
+
+int main(void) {
+    g_status_json_len = encode_json(g_status_json, sizeof(g_status_json));
+    g_status_cbor_len = encode_cbor(g_status_cbor, sizeof(g_status_cbor));
+    g_request_cbor_len = ws_cbor_from_json(k_request_json, strlen(k_request_json),
+                                           g_request_cbor, sizeof(g_request_cbor));
+    if (g_status_json_len == 0 || g_status_cbor_len == 0 || g_request_cbor_len == 0) {
+        fprintf(stderr, "bench_cbor: failed to build sample messages\n");
+        return 1;
+    }
+
+    status_fields_t a, b;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    if (!decode_cjson(g_status_json, &a) || !decode_cbor(g_status_cbor, g_status_cbor_len, &b) ||
+        memcmp(&a, &b, sizeof(a)) != 0) {
+        fprintf(stderr, "bench_cbor: JSON and CBOR decoders disagree\n");
+        return 1;
+    }
+
+    printf("cJSON %s\n", cJSON_Version());
+
+    printf("encode ps5_status\n");
+    report("json_writer", bench_run(bench_encode_json, NULL), g_status_json_len);
+    report("cbor_writer (fixed layout)", bench_run(bench_encode_cbor, NULL), g_status_cbor_len);
+    report("cJSON build + PrintUnformatted", bench_run(bench_encode_cjson, NULL), g_status_json_len);
+
+    printf("client decode ps5_status\n");
+    report("cJSON_Parse + GetObjectItem", bench_run(bench_decode_cjson, NULL), 0);
+    report("fixed array", bench_run(bench_decode_cbor, NULL), 0);
+
+    printf("server receive query_ps5\n");
+    report("cJSON_Parse + type lookup", bench_run(bench_request_cjson, NULL), strlen(k_request_json));
+    report("ws_cbor_to_json", bench_run(bench_request_cbor, NULL), g_request_cbor_len);
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+/**
+ * @file bench_deflate.c
+ * @brief permessage-deflate 對狀態訊息的 CPU 成本與節省的位元組
+ *
+ * 以 -DWS_DEFLATE_THRESHOLD=0 編譯 ws_deflate.c,量測每種訊息實際
+ * 壓縮後的大小與 ws_deflate_compress() 的時間,再依假設的訊息組合
+ * 計算不同門檻下每個客戶端每小時的位元組與壓縮 CPU 時間。
+ *
+ * 位元組含 WebSocket 訊框標頭 (伺服器訊框不遮罩)。廣播時相同參數的
+ * 客戶端共用同一份壓縮結果,因此 CPU 成本以「每則訊息」計,
+ * 節省的位元組以「每個客戶端」計。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-08
+ * @version 1.0.0
+ */
+
+#include "bench_util.h"
+#include "json_writer.h"
+#include "trace_ring.h"
+#include "ws_deflate.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define MESSAGE_SIZE        4096
+#define WINDOW_BITS         15
+
+/** 與 main.c 相同的 debug_dump 每頁筆數 */
+#define DEBUG_DUMP_RECORDS  32
+
+/* ============================================================
+ *  Message Mix
+ * ============================================================ */
+
+typedef struct {
+    const char *name;
+    size_t (*build)(char *buf, size_t cap);
+    unsigned per_hour;              /**< 假設的每客戶端每小時數量 */
+    size_t len;
+    size_t deflated_len;            /**< 0 表示壓縮後未變小 */
+    double ns;
+} sample_t;
+
+static size_t finish(json_writer_t *w) {
+    return json_writer_finish(w) ? json_writer_length(w) : 0;
+}
+
+static size_t build_not_modified(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "not_modified");
+    json_writer_kv_int(&w, "version", 4242);
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static size_t build_delta(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "ps5_delta");
+    json_writer_kv_int(&w, "version", 4243);
+    json_writer_kv_string(&w, "power", "STANDBY");
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static size_t build_stats(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "stats");
+    json_writer_kv_int(&w, "clients", 12);
+    json_writer_kv_int(&w, "wake_requests", 318);
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static size_t build_wake_event(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "wake_event");
+    json_writer_kv_string(&w, "stage", "attempt");
+    json_writer_kv_int(&w, "client_id", 7);
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static size_t build_status(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "ps5_status");
+    json_writer_kv_int(&w, "version", 4242);
+    json_writer_kv_string(&w, "power", "ON");
+    json_writer_kv_string(&w, "network", "online");
+    json_writer_kv_string(&w, "server_state", "MONITORING");
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static size_t build_history(char *buf, size_t cap) {
+    static const char *const k_states[] = {
+        "INIT", "MONITORING", "PS5_DETECTED", "CLIENT_CONNECTED", "WAKING_PS5", "ERROR",
+    };
+    static const char *const k_steps[][3] = {
+        { "INIT", "MONITORING", "INIT_COMPLETE" },
+        { "MONITORING", "PS5_DETECTED", "PS5_POWER_ON" },
+        { "PS5_DETECTED", "CLIENT_CONNECTED", "CLIENT_CONNECT" },
+        { "CLIENT_CONNECTED", "WAKING_PS5", "WAKE_REQUEST" },
+        { "WAKING_PS5", "CLIENT_CONNECTED", "WAKE_COMPLETE" },
+        { "CLIENT_CONNECTED", "MONITORING", "CLIENT_DISCONNECT" },
+    };
+
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "server_state_history");
+    json_writer_kv_string(&w, "state", "MONITORING");
+    json_writer_kv_int(&w, "now_ms", 86400123);
+    json_writer_kv_int(&w, "in_state_ms", 3605);
+    json_writer_kv_int(&w, "transitions", 42);
+    json_writer_key(&w, "time_in_state_ms");
+    json_writer_begin_object(&w);
+    for (int s = 0; s < 6; s++) {
+        json_writer_kv_int(&w, k_states[s], 1000 + s * 7919);
+    }
+    json_writer_end_object(&w);
+    json_writer_key(&w, "history");
+    json_writer_begin_array(&w);
+    for (int i = 0; i < 16; i++) {
+        json_writer_begin_array(&w);
+        json_writer_int(&w, 86000000 + i * 25013);
+        json_writer_string(&w, k_steps[i % 6][0]);
+        json_writer_string(&w, k_steps[i % 6][1]);
+        json_writer_string(&w, k_steps[i % 6][2]);
+        json_writer_end_array(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static size_t build_debug_dump(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "debug_dump");
+    json_writer_kv_int(&w, "next", 1000 + DEBUG_DUMP_RECORDS);
+    json_writer_key(&w, "records");
+    json_writer_begin_array(&w);
+    for (int i = 0; i < DEBUG_DUMP_RECORDS; i++) {
+        trace_event_t event = (trace_event_t)(1 + (i * 7) % (TRACE_EVENT_COUNT - 1));
+        json_writer_begin_array(&w);
+        json_writer_int(&w, 1000 + i);
+        json_writer_int(&w, 86400000000000LL + (int64_t)i * 1234567);
+        json_writer_string(&w, trace_event_to_string(event));
+        json_writer_int(&w, i % 4);
+        json_writer_int(&w, 1 + i % 12);
+        json_writer_int(&w, 40 + (i * 13) % 200);
+        json_writer_end_array(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+/**
+ * 假設的每客戶端每小時訊息數: 訂閱 stats (每秒最多一次差異)、
+ * PS5 每小時數次狀態變化、偶爾重新連線與查詢,除錯訊息很少。
+ */
+static sample_t g_samples[] = {
+    { "not_modified",         build_not_modified, 60,   0, 0, 0 },
+    { "ps5_delta",            build_delta,        12,   0, 0, 0 },
+    { "stats",                build_stats,        900,  0, 0, 0 },
+    { "wake_event",           build_wake_event,   6,    0, 0, 0 },
+    { "ps5_status",           build_status,       4,    0, 0, 0 },
+    { "server_state_history", build_history,      1,    0, 0, 0 },
+    { "debug_dump",           build_debug_dump,   1,    0, 0, 0 },
+};
+
+#define SAMPLE_COUNT    (sizeof(g_samples) / sizeof(g_samples[0]))
+
+/* ============================================================
+ *  Benchmark
+ * ============================================================ */
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+} compress_arg_t;
+
+static void bench_compress(void *arg) {
+    const compress_arg_t *a = (const compress_arg_t *)arg;
+    uint8_t out[MESSAGE_SIZE];
+    size_t out_len = 0;
+    BENCH_KEEP(ws_deflate_compress(WINDOW_BITS, a->data, a->len, out, sizeof(out), &out_len));
+    BENCH_KEEP(out_len);
+}
+
+/** 伺服器訊框標頭長度 (不遮罩) */
+static size_t frame_header_len(size_t payload) {
+    return payload < 126 ? 2 : payload <= 0xFFFF ? 4 : 10;
+}
+
+static size_t wire_bytes(const sample_t *s, size_t threshold) {
+    if (s->len >= threshold && s->deflated_len > 0) {
+        return frame_header_len(s->deflated_len) + s->deflated_len;
+    }
+    return frame_header_len(s->len) + s->len;
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+int main(void) {
+    static const size_t k_thresholds[] = { 0, 32, 64, 128, 256, 1024, MESSAGE_SIZE };
+
+    if (WS_DEFLATE_THRESHOLD != 0) {
+        fprintf(stderr, "bench_deflate: build with -DWS_DEFLATE_THRESHOLD=0\n");
+        return 1;
+    }
+
+    printf("window bits %d, level %d, memLevel %d\n",
+           WINDOW_BITS, WS_DEFLATE_LEVEL, WS_DEFLATE_MEM_LEVEL);
+    printf("  %-22s %6s %9s %10s %10s\n", "message", "bytes", "deflated", "ns/msg", "ns/saved");
+
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        sample_t *s = &g_samples[i];
+        char json[MESSAGE_SIZE];
+        uint8_t out[MESSAGE_SIZE];
+
+        s->len = s->build(json, sizeof(json));
+        if (s->len == 0) {
+            fprintf(stderr, "bench_deflate: %s does not fit\n", s->name);
+            return 1;
+        }
+
+        size_t out_len = 0;
+        int rc = ws_deflate_compress(WINDOW_BITS, (const uint8_t *)json, s->len,
+                                     out, sizeof(out), &out_len);
+        s->deflated_len = (rc == WS_DEFLATE_OK) ? out_len : 0;
+
+        compress_arg_t arg = { (const uint8_t *)json, s->len };
+        s->ns = bench_run(bench_compress, &arg);
+
+        if (s->deflated_len > 0) {
+            printf("  %-22s %6zu %9zu %10.0f %10.1f\n", s->name, s->len, s->deflated_len,
+                   s->ns, s->ns / (double)(s->len - s->deflated_len));
+        } else {
+            printf("  %-22s %6zu %9s %10.0f %10s\n", s->name, s->len, "no gain", s->ns, "-");
+        }
+    }
+
+    printf("\nper client per hour (mix above; CPU is per message, shared by a broadcast)\n");
+    printf("  %-10s %10s %10s %10s\n", "threshold", "bytes", "saved", "cpu us");
+
+    uint64_t plain = 0;
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        plain += (uint64_t)g_samples[i].per_hour * wire_bytes(&g_samples[i], MESSAGE_SIZE);
+    }
+
+    for (size_t t = 0; t < sizeof(k_thresholds) / sizeof(k_thresholds[0]); t++) {
+        uint64_t bytes = 0;
+        double cpu_ns = 0;
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            const sample_t *s = &g_samples[i];
+            bytes += (uint64_t)s->per_hour * wire_bytes(s, k_thresholds[t]);
+            if (s->len >= k_thresholds[t]) {
+                cpu_ns += (double)s->per_hour * s->ns;
+            }
+        }
+        printf("  %-10zu %10llu %9.1f%% %10.1f\n", k_thresholds[t], (unsigned long long)bytes,
+               100.0 * (double)(plain - bytes) / (double)plain, cpu_ns / 1000.0);
+    }
+
+    ws_deflate_cleanup();
+    return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file bench_json_writer.c
+ * @brief json_writer 與 cJSON 建樹 + cJSON_PrintUnformatted 的比較
+ *
+ * 以 main.c 實際送出的訊息為樣本:
+ * - ps5_status (status_snapshot.c 的 render_snapshot)
+ * - wake_result (send_wake_result)
+ * - error,訊息內含需要跳脫的字元
+ * - stats (多個整數欄位)
+ *
+ * 兩邊都先驗證輸出位元組相同,再量測每則訊息的平均奈秒數。
+ * cJSON 的數字取決於連結的版本,結果開頭列出 cJSON_Version()。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-08
+ * @version 1.0.0
+ */
+
+#include "bench_util.h"
+#include "json_writer.h"
+
+#include <cjson/cJSON.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+/* ============================================================
+ *  Messages
+ * ============================================================ */
+
+#define MESSAGE_SIZE    512
+
+static const char k_error_text[] = "Invalid \"wake\" request:\n\tmissing target";
+
+typedef struct {
+    const char *name;
+    size_t (*writer)(char *buf, size_t cap);
+    cJSON* (*build)(void);
+} sample_t;
+
+static size_t finish(json_writer_t *w) {
+    return json_writer_finish(w) ? json_writer_length(w) : 0;
+}
+
+static size_t writer_status(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "ps5_status");
+    json_writer_kv_int(&w, "version", 4242);
+    json_writer_kv_string(&w, "power", "ON");
+    json_writer_kv_string(&w, "network", "online");
+    json_writer_kv_string(&w, "server_state", "MONITORING");
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static cJSON* build_status(void) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", "ps5_status");
+    cJSON_AddNumberToObject(root, "version", 4242);
+    cJSON_AddStringToObject(root, "power", "ON");
+    cJSON_AddStringToObject(root, "network", "online");
+    cJSON_AddStringToObject(root, "server_state", "MONITORING");
+    return root;
+}
+
+static size_t writer_wake_result(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "wake_result");
+    json_writer_kv_bool(&w, "success", true);
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static cJSON* build_wake_result(void) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", "wake_result");
+    cJSON_AddBoolToObject(root, "success", true);
+    return root;
+}
+
+static size_t writer_error(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "error");
+    json_writer_kv_string(&w, "error", k_error_text);
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static cJSON* build_error(void) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", "error");
+    cJSON_AddStringToObject(root, "error", k_error_text);
+    return root;
+}
+
+static size_t writer_stats(char *buf, size_t cap) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "type", "stats");
+    json_writer_kv_int(&w, "clients", 12);
+    json_writer_kv_int(&w, "state_version", 4242);
+    json_writer_kv_int(&w, "wake_requests", 318);
+    json_writer_kv_int(&w, "rate_limited", 7);
+    json_writer_end_object(&w);
+    return finish(&w);
+}
+
+static cJSON* build_stats(void) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", "stats");
+    cJSON_AddNumberToObject(root, "clients", 12);
+    cJSON_AddNumberToObject(root, "state_version", 4242);
+    cJSON_AddNumberToObject(root, "wake_requests", 318);
+    cJSON_AddNumberToObject(root, "rate_limited", 7);
+    return root;
+}
+
+static const sample_t k_samples[] = {
+    { "ps5_status",  writer_status,      build_status },
+    { "wake_result", writer_wake_result, build_wake_result },
+    { "error",       writer_error,       build_error },
+    { "stats",       writer_stats,       build_stats },
+};
+
+/* ============================================================
+ *  Benchmarks
+ * ============================================================ */
+
+static void bench_writer(void *arg) {
+    const sample_t *s = (const sample_t *)arg;
+    char buf[MESSAGE_SIZE];
+    BENCH_KEEP(s->writer(buf, sizeof(buf)));
+}
+
+static void bench_cjson(void *arg) {
+    const sample_t *s = (const sample_t *)arg;
+    cJSON *root = s->build();
+    char *text = cJSON_PrintUnformatted(root);
+    BENCH_KEEP(text);
+    free(text);
+    cJSON_Delete(root);
+}
+
+/**
+ * @brief 確認兩邊輸出相同 (比較的是同一則訊息)
+ */
+static bool same_output(const sample_t *s) {
+    char buf[MESSAGE_SIZE];
+    size_t len = s->writer(buf, sizeof(buf));
+
+    cJSON *root = s->build();
+    char *text = cJSON_PrintUnformatted(root);
+    bool same = text != NULL && len == strlen(text) && memcmp(buf, text, len) == 0;
+    if (!same) {
+        fprintf(stderr, "%s differs:\n  json_writer: %.*s\n  cJSON:       %s\n",
+                s->name, (int)len, buf, text ? text : "(null)");
+    }
+    free(text);
+    cJSON_Delete(root);
+    return same;
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+int main(void) {
+    printf("cJSON %s\n", cJSON_Version());
+    printf("  %-12s %6s %12s %12s %8s\n", "message", "bytes", "json_writer", "cJSON", "speedup");
+
+    for (size_t i = 0; i < sizeof(k_samples) / sizeof(k_samples[0]); i++) {
+        const sample_t *s = &k_samples[i];
+        char buf[MESSAGE_SIZE];
+
+        if (!same_output(s)) {
+            return 1;
+        }
+
+        double writer_ns = bench_run(bench_writer, (void *)s);
+        double cjson_ns = bench_run(bench_cjson, (void *)s);
+        printf("  %-12s %6zu %9.1f ns %9.1f ns %7.1fx\n", s->name, s->writer(buf, sizeof(buf)),
+               writer_ns, cjson_ns, cjson_ns / writer_ns);
+    }
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file bench_util.h
+ * @brief 基準程式共用的計時與統計輔助函數
+ *
+ * 每個基準先暖身,再重複執行到至少 BENCH_MIN_NS,輸出每次呼叫的
+ * 平均時間。延遲分佈以 bench_percentile() 取百分位數。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-08
+ * @version 1.0.0
+ */
+
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** 每個項目最少執行時間 */
+#define BENCH_MIN_NS        (200ULL * 1000 * 1000)
+
+/** 阻止編譯器移除結果 */
+#define BENCH_KEEP(x)       __asm__ __volatile__("" : : "g"(x) : "memory")
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t bench_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 重複執行 fn 並回傳每次呼叫的平均奈秒數
+ */
+static inline double bench_run(void (*fn)(void *), void *arg) {
+    for (int i = 0; i < 1000; i++) {
+        fn(arg);
+    }
+
+    uint64_t iterations = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+    do {
+        for (int i = 0; i < 1000; i++) {
+            fn(arg);
+        }
+        iterations += 1000;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+
+    return (double)elapsed / (double)iterations;
+}
+
+static inline int bench_compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 排序後取百分位數 (會修改 samples 的順序)
+ */
+static inline uint64_t bench_percentile(uint64_t *samples, size_t count, double pct) {
+    if (count == 0) {
+        return 0;
+    }
+    qsort(samples, count, sizeof(samples[0]), bench_compare_u64);
+    size_t idx = (size_t)(pct / 100.0 * (double)(count - 1) + 0.5);
+    return samples[idx];
+}
+
+#endif /* BENCH_UTIL_H */
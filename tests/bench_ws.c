@@ -0,0 +1,898 @@
+/**
+ * @file bench_ws.c
+ * @brief WebSocket 伺服器的端對端基準 (同一程序內的伺服器與客戶端)
+ *
+ * 主執行緒與 main.c 相同: 以 ws_server_service() 等待並執行回調;
+ * 客戶端在另一個執行緒以非阻塞 socket 與自己的 epoll 驅動。
+ *
+ * 模式:
+ * - rtt: 每個客戶端依序送出 query_ps5,量測到收到回應為止的延遲。
+ *   訊息處理器在主執行緒執行,多 worker 時經過 worker → 主執行緒
+ *   → worker 的轉交,可比較 -w 1 與 -w N
+ * - broadcast: 主執行緒廣播 ps5_status,等所有客戶端收到後再送下一則;
+ *   量測每份送達的延遲與每次廣播伺服器端的系統呼叫數
+ * - storm: 重連風暴,所有客戶端同時連線,量測到全部完成握手為止的時間;
+ *   全部關閉、伺服器端也釋放槽位後再進行下一輪,共 -n 輪。
+ *   另外量測單次握手 (解析、Sec-WebSocket-Accept、101 回應) 的 CPU 時間
+ *
+ * -l 改用本機 IPC (AF_UNIX SOCK_SEQPACKET, abstract "@bench-ws"): 沒有握手與
+ * 訊框,每個封包即一則 JSON 訊息,可與 WebSocket 路徑直接比較。
+ *
+ * 系統呼叫以 -Wl,--wrap 攔截 libc 包裝函數計數 (io_uring_enter 經由
+ * syscall()),只計算伺服器執行緒。bench_ws_uring 以 WS_USE_IO_URING
+ * 編譯,其餘相同,可直接比較兩種後端。
+ *
+ * @code
+ * ./bench_ws rtt [-w WORKERS] [-c CLIENTS] [-n REQUESTS] [-p PORT] [-l]
+ * ./bench_ws broadcast [-w WORKERS] [-c CLIENTS] [-n BROADCASTS] [-p PORT] [-l]
+ * ./bench_ws storm [-w WORKERS] [-c CLIENTS] [-n ROUNDS] [-p PORT]
+ * @endcode
+ *
+ * 以 WS_SERVER_MAX_CLIENTS=256、WS_SERVER_ACCEPT_RATE=0 編譯 (見 Makefile),
+ * 所有客戶端都來自 127.0.0.1,預設的每 IP 連線速率會拒絕風暴。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-08
+ * @version 1.0.0
+ */
+
+// GNU extensions for memmem()
+#define _GNU_SOURCE
+
+#include "bench_util.h"
+#include "websocket_server.h"
+#include "ws_handshake.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define BENCH_DEFAULT_PORT      18080
+#define BENCH_MAX_CLIENTS       1024
+#define CLIENT_BUFFER_SIZE      8192
+
+/** -l 的本機 IPC 路徑 (abstract namespace) */
+#define BENCH_LOCAL_PATH        "@bench-ws"
+
+static const char k_upgrade_request[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Version: 13\r\n"
+    "\r\n";
+
+static const char k_query[] = "{\"type\":\"query_ps5\"}";
+
+static const char k_status[] =
+    "{\"type\":\"ps5_status\",\"version\":4242,\"power\":\"ON\","
+    "\"network\":\"online\",\"server_state\":\"MONITORING\"}";
+
+/* ============================================================
+ *  Type Definitions
+ * ============================================================ */
+
+typedef enum {
+    CLIENT_CONNECTING = 0,
+    CLIENT_UPGRADING,
+    CLIENT_OPEN,
+    CLIENT_CLOSED,
+} client_state_t;
+
+typedef struct bench_client {
+    int fd;
+    client_state_t state;
+    uint8_t buf[CLIENT_BUFFER_SIZE];
+    size_t len;
+    uint64_t sent_ns;               /**< 最後一個請求送出的時間 */
+    int remaining;                  /**< 尚未送出的請求數 */
+} bench_client_t;
+
+typedef struct {
+    int workers;
+    int clients;
+    int requests;
+    int port;
+    bool local;                     /**< 本機 IPC 取代 WebSocket */
+} bench_options_t;
+
+/** 模式的回調 */
+typedef struct {
+    void (*on_open)(bench_client_t *c);     /**< 客戶端執行緒 */
+    void (*on_message)(bench_client_t *c, const uint8_t *payload, size_t len);
+    void (*service)(void);                  /**< 主執行緒, NULL 表示只等待事件 */
+    void (*begin)(void);                    /**< 客戶端執行緒,第一次連線之前 */
+    void (*after_events)(void);             /**< 客戶端執行緒,每批事件處理之後 */
+} bench_mode_t;
+
+/** 計數的系統呼叫 */
+typedef enum {
+    SYS_SEND = 0,
+    SYS_RECV,
+    SYS_READ,
+    SYS_WRITE,
+    SYS_EPOLL_WAIT,
+    SYS_EPOLL_CTL,
+    SYS_ACCEPT4,
+    SYS_POLL,
+    SYS_URING_ENTER,
+    SYS_OTHER,
+    SYS_COUNT
+} syscall_kind_t;
+
+/* ============================================================
+ *  Global State
+ * ============================================================ */
+
+static bench_options_t g_opt = { 1, 8, 2000, BENCH_DEFAULT_PORT, false };
+static bench_client_t *g_clients;
+static const bench_mode_t *g_mode;
+static int g_epoll_fd = -1;
+static uint64_t g_connect_ns;       /**< 最近一次 connect_all() 的時間 */
+static int g_open_count;            /**< 已完成握手的客戶端數 (atomic) */
+static int g_done_count;            /**< 已完成的客戶端數 */
+static volatile int g_finished;     /**< 客戶端執行緒結束 (atomic) */
+
+static uint64_t g_syscalls[SYS_COUNT];
+static bool g_counting;             /**< 量測期間 (atomic) */
+static __thread bool t_uncounted;   /**< 客戶端執行緒不計數 */
+
+static uint64_t *g_samples;
+static size_t g_sample_count;
+static size_t g_sample_cap;
+
+/* ============================================================
+ *  Helpers
+ * ============================================================ */
+
+static void record_sample(uint64_t ns) {
+    if (g_sample_count < g_sample_cap) {
+        g_samples[g_sample_count++] = ns;
+    }
+}
+
+static void print_latency(const char *label, double seconds, size_t ops) {
+    uint64_t p50 = bench_percentile(g_samples, g_sample_count, 50);
+    uint64_t p99 = bench_percentile(g_samples, g_sample_count, 99);
+    uint64_t max = g_sample_count ? g_samples[g_sample_count - 1] : 0;
+    printf("%-10s %s workers=%d clients=%d  %8.0f ops/s  p50 %7.1f us  p99 %7.1f us  "
+           "max %7.1f us\n", label, g_opt.local ? "local" : "ws   ", g_opt.workers, g_opt.clients, (double)ops / seconds,
+           (double)p50 / 1000.0, (double)p99 / 1000.0, (double)max / 1000.0);
+}
+
+/* ============================================================
+ *  System Call Counting
+ * ============================================================ */
+
+static const char *const k_syscall_names[SYS_COUNT] = {
+    "send", "recv", "read", "write", "epoll_wait", "epoll_ctl", "accept4", "poll",
+    "io_uring_enter", "other",
+};
+
+static inline void count_syscall(syscall_kind_t kind) {
+    if (!t_uncounted && __atomic_load_n(&g_counting, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&g_syscalls[kind], 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void reset_syscalls(void) {
+    for (int i = 0; i < SYS_COUNT; i++) {
+        __atomic_store_n(&g_syscalls[i], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&g_counting, true, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 輸出每次操作的系統呼叫數與後端 (有 io_uring_enter 即為 io_uring)
+ */
+static void print_syscalls(uint64_t ops) {
+    uint64_t total = 0;
+    for (int i = 0; i < SYS_COUNT; i++) {
+        total += __atomic_load_n(&g_syscalls[i], __ATOMIC_RELAXED);
+    }
+
+    printf("  backend %s, %.2f syscalls/op:",
+           g_syscalls[SYS_URING_ENTER] ? "io_uring" : "epoll", (double)total / (double)ops);
+    for (int i = 0; i < SYS_COUNT; i++) {
+        if (g_syscalls[i] > 0) {
+            printf(" %s %.2f", k_syscall_names[i], (double)g_syscalls[i] / (double)ops);
+        }
+    }
+    printf("\n");
+}
+
+ssize_t __real_send(int fd, const void *buf, size_t len, int flags);
+ssize_t __real_recv(int fd, void *buf, size_t len, int flags);
+ssize_t __real_read(int fd, void *buf, size_t len);
+ssize_t __real_write(int fd, const void *buf, size_t len);
+int __real_epoll_wait(int epfd, struct epoll_event *events, int max, int timeout);
+int __real_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event);
+int __real_accept4(int fd, struct sockaddr *addr, socklen_t *len, int flags);
+int __real_poll(struct pollfd *fds, nfds_t nfds, int timeout);
+long __real_syscall(long number, ...);
+
+ssize_t __wrap_send(int fd, const void *buf, size_t len, int flags) {
+    count_syscall(SYS_SEND);
+    return __real_send(fd, buf, len, flags);
+}
+
+ssize_t __wrap_recv(int fd, void *buf, size_t len, int flags) {
+    count_syscall(SYS_RECV);
+    return __real_recv(fd, buf, len, flags);
+}
+
+ssize_t __wrap_read(int fd, void *buf, size_t len) {
+    count_syscall(SYS_READ);
+    return __real_read(fd, buf, len);
+}
+
+ssize_t __wrap_write(int fd, const void *buf, size_t len) {
+    count_syscall(SYS_WRITE);
+    return __real_write(fd, buf, len);
+}
+
+int __wrap_epoll_wait(int epfd, struct epoll_event *events, int max, int timeout) {
+    count_syscall(SYS_EPOLL_WAIT);
+    return __real_epoll_wait(epfd, events, max, timeout);
+}
+
+int __wrap_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event) {
+    count_syscall(SYS_EPOLL_CTL);
+    return __real_epoll_ctl(epfd, op, fd, event);
+}
+
+int __wrap_accept4(int fd, struct sockaddr *addr, socklen_t *len, int flags) {
+    count_syscall(SYS_ACCEPT4);
+    return __real_accept4(fd, addr, len, flags);
+}
+
+int __wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout) {
+    count_syscall(SYS_POLL);
+    return __real_poll(fds, nfds, timeout);
+}
+
+long __wrap_syscall(long number, ...) {
+    va_list ap;
+    long a[6];
+
+    // ws_uring 最多傳 6 個參數,多讀的值不會被核心使用
+    va_start(ap, number);
+    for (int i = 0; i < 6; i++) {
+        a[i] = va_arg(ap, long);
+    }
+    va_end(ap);
+
+    count_syscall(number == __NR_io_uring_enter ? SYS_URING_ENTER : SYS_OTHER);
+    return __real_syscall(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+/* ============================================================
+ *  WebSocket Client
+ * ============================================================ */
+
+static void client_opened(bench_client_t *c) {
+    c->state = CLIENT_OPEN;
+    __atomic_add_fetch(&g_open_count, 1, __ATOMIC_RELEASE);
+    g_mode->on_open(c);
+}
+
+/**
+ * @brief 連線到本機 IPC socket (連線立即完成,直接進入 OPEN)
+ */
+static int local_connect(bench_client_t *c) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path + 1, BENCH_LOCAL_PATH + 1, sizeof(BENCH_LOCAL_PATH) - 2);
+    socklen_t len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) +
+                                sizeof(BENCH_LOCAL_PATH) - 1);
+
+    c->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c->fd < 0) {
+        return -1;
+    }
+    if (connect(c->fd, (struct sockaddr *)&addr, len) < 0) {
+        close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+
+    c->len = 0;
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+    if (epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, c->fd, &ev) < 0) {
+        return -1;
+    }
+    client_opened(c);
+    return 0;
+}
+
+static int client_connect(bench_client_t *c) {
+    if (g_opt.local) {
+        return local_connect(c);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)g_opt.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c->fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(c->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+
+    c->state = CLIENT_CONNECTING;
+    c->len = 0;
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT, .data.ptr = c };
+    return epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, c->fd, &ev);
+}
+
+static void client_close(bench_client_t *c) {
+    if (c->fd >= 0) {
+        epoll_ctl(g_epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+        close(c->fd);
+        c->fd = -1;
+    }
+    c->state = CLIENT_CLOSED;
+}
+
+/**
+ * @brief 送出遮罩後的文字訊框 (小訊息一次寫完)
+ */
+static int client_send_text(bench_client_t *c, const char *text) {
+    static const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+    uint8_t frame[256];
+    size_t len = strlen(text);
+
+    if (g_opt.local) {
+        return (send(c->fd, text, len, MSG_NOSIGNAL) == (ssize_t)len) ? 0 : -1;
+    }
+    if (len > 125) {
+        return -1;
+    }
+    frame[0] = 0x81;
+    frame[1] = (uint8_t)(0x80 | len);
+    memcpy(frame + 2, mask, 4);
+    for (size_t i = 0; i < len; i++) {
+        frame[6 + i] = (uint8_t)text[i] ^ mask[i & 3];
+    }
+
+    return (send(c->fd, frame, 6 + len, MSG_NOSIGNAL) == (ssize_t)(6 + len)) ? 0 : -1;
+}
+
+/**
+ * @brief 處理緩衝區中完整的訊框
+ */
+static void client_parse_frames(bench_client_t *c) {
+    size_t off = 0;
+
+    while (c->state == CLIENT_OPEN && c->len - off >= 2) {
+        const uint8_t *p = c->buf + off;
+        size_t header = 2;
+        size_t payload = p[1] & 0x7F;
+
+        if (payload == 126) {
+            if (c->len - off < 4) {
+                break;
+            }
+            payload = ((size_t)p[2] << 8) | p[3];
+            header = 4;
+        } else if (payload == 127) {
+            client_close(c);
+            return;
+        }
+        if (c->len - off < header + payload) {
+            break;
+        }
+
+        uint8_t opcode = p[0] & 0x0F;
+        if (opcode == 0x1 || opcode == 0x2) {
+            g_mode->on_message(c, p + header, payload);
+        } else if (opcode == 0x8) {
+            client_close(c);
+            return;
+        }
+        off += header + payload;
+    }
+
+    memmove(c->buf, c->buf + off, c->len - off);
+    c->len -= off;
+}
+
+/**
+ * @brief 本機 IPC: 每個封包即一則訊息
+ */
+static void local_readable(bench_client_t *c) {
+    while (c->state == CLIENT_OPEN) {
+        ssize_t n = recv(c->fd, c->buf, sizeof(c->buf), 0);
+        if (n <= 0) {
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            client_close(c);
+            return;
+        }
+        g_mode->on_message(c, c->buf, (size_t)n);
+    }
+}
+
+static void client_readable(bench_client_t *c) {
+    if (g_opt.local) {
+        local_readable(c);
+        return;
+    }
+
+    for (;;) {
+        if (c->len == sizeof(c->buf)) {
+            client_close(c);
+            return;
+        }
+        ssize_t n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+        if (n <= 0) {
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            client_close(c);
+            return;
+        }
+        c->len += (size_t)n;
+    }
+
+    if (c->state == CLIENT_UPGRADING) {
+        uint8_t *end = memmem(c->buf, c->len, "\r\n\r\n", 4);
+        if (end == NULL) {
+            return;
+        }
+        if (c->len < 12 || memcmp(c->buf + 9, "101", 3) != 0) {
+            fprintf(stderr, "bench_ws: upgrade rejected: %.*s\n", (int)(end - c->buf),
+                    (const char *)c->buf);
+            client_close(c);
+            return;
+        }
+        size_t consumed = (size_t)(end - c->buf) + 4;
+        memmove(c->buf, c->buf + consumed, c->len - consumed);
+        c->len -= consumed;
+        client_opened(c);
+    }
+
+    client_parse_frames(c);
+}
+
+static void client_writable(bench_client_t *c) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+        client_close(c);
+        return;
+    }
+
+    ssize_t n = send(c->fd, k_upgrade_request, sizeof(k_upgrade_request) - 1, MSG_NOSIGNAL);
+    if (n != (ssize_t)(sizeof(k_upgrade_request) - 1)) {
+        client_close(c);
+        return;
+    }
+
+    c->state = CLIENT_UPGRADING;
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+/* ============================================================
+ *  Client Thread
+ * ============================================================ */
+
+static bool all_done(void) {
+    int closed = 0;
+    for (int i = 0; i < g_opt.clients; i++) {
+        closed += (g_clients[i].state == CLIENT_CLOSED);
+    }
+    return g_done_count + closed >= g_opt.clients;
+}
+
+static void connect_all(void) {
+    g_connect_ns = bench_now_ns();
+    for (int i = 0; i < g_opt.clients; i++) {
+        if (client_connect(&g_clients[i]) < 0) {
+            perror("bench_ws: connect");
+            g_clients[i].state = CLIENT_CLOSED;
+        }
+    }
+}
+
+static void* client_thread(void *arg) {
+    (void)arg;
+    struct epoll_event events[64];
+
+    t_uncounted = true;
+
+    if (g_mode->begin) {
+        g_mode->begin();
+    }
+    connect_all();
+
+    while (!all_done()) {
+        int n = epoll_wait(g_epoll_fd, events, 64, 5000);
+        if (n == 0) {
+            int states[CLIENT_CLOSED + 1] = { 0 };
+            for (int i = 0; i < g_opt.clients; i++) {
+                states[g_clients[i].state]++;
+            }
+            fprintf(stderr, "bench_ws: no progress for 5 s (connecting %d, upgrading %d, "
+                    "open %d, closed %d)\n", states[CLIENT_CONNECTING], states[CLIENT_UPGRADING],
+                    states[CLIENT_OPEN], states[CLIENT_CLOSED]);
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            bench_client_t *c = (bench_client_t *)events[i].data.ptr;
+            if (c->state == CLIENT_CONNECTING && (events[i].events & (EPOLLOUT | EPOLLERR))) {
+                client_writable(c);
+            } else if (c->state != CLIENT_CLOSED) {
+                client_readable(c);
+            }
+        }
+        if (g_mode->after_events) {
+            g_mode->after_events();
+        }
+    }
+
+    __atomic_store_n(&g_finished, 1, __ATOMIC_RELEASE);
+    ws_server_wake();
+    return NULL;
+}
+
+/* ============================================================
+ *  Server
+ * ============================================================ */
+
+static char* handle_message(int client_id, ws_message_type_t msg_type,
+                            const char *payload, void *user_data) {
+    (void)client_id;
+    (void)payload;
+    (void)user_data;
+    return (msg_type == WS_MSG_QUERY_PS5) ? strdup(k_status) : NULL;
+}
+
+static int server_start(void) {
+    static const ws_rate_limit_t unlimited = { 0, 0 };
+
+    if (ws_server_init(g_opt.port) != 0 ||
+        ws_server_set_workers(g_opt.workers) != 0 ||
+        ws_server_set_local_path(g_opt.local ? BENCH_LOCAL_PATH : NULL) != 0) {
+        return -1;
+    }
+    ws_server_set_message_handler(handle_message, NULL);
+    for (int t = 0; t < WS_SERVER_RATE_LIMIT_TYPES; t++) {
+        ws_server_set_rate_limit((ws_message_type_t)t, &unlimited);
+    }
+    return ws_server_start();
+}
+
+/**
+ * @brief 啟動伺服器與客戶端,主執行緒服務到客戶端結束
+ *
+ * @return 經過的秒數, <0 失敗
+ */
+static double run(const bench_mode_t *mode) {
+    g_mode = mode;
+    g_clients = calloc((size_t)g_opt.clients, sizeof(bench_client_t));
+    g_sample_cap = (size_t)g_opt.clients * (size_t)(g_opt.requests > 0 ? g_opt.requests : 1);
+    g_samples = calloc(g_sample_cap, sizeof(uint64_t));
+    g_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (g_clients == NULL || g_samples == NULL || g_epoll_fd < 0) {
+        return -1;
+    }
+    for (int i = 0; i < g_opt.clients; i++) {
+        g_clients[i].fd = -1;
+    }
+
+    if (server_start() != 0) {
+        fprintf(stderr, "bench_ws: failed to start server on port %d\n", g_opt.port);
+        return -1;
+    }
+
+    pthread_t thread;
+    uint64_t start = bench_now_ns();
+    if (pthread_create(&thread, NULL, client_thread, NULL) != 0) {
+        return -1;
+    }
+    while (!__atomic_load_n(&g_finished, __ATOMIC_ACQUIRE)) {
+        if (mode->service) {
+            mode->service();
+        } else {
+            ws_server_service(1000);
+        }
+    }
+    double seconds = (double)(bench_now_ns() - start) / 1e9;
+    __atomic_store_n(&g_counting, false, __ATOMIC_RELAXED);
+    pthread_join(thread, NULL);
+
+    for (int i = 0; i < g_opt.clients; i++) {
+        client_close(&g_clients[i]);
+    }
+    ws_server_stop();
+    ws_server_cleanup();
+    close(g_epoll_fd);
+
+    if (g_done_count < g_opt.clients) {
+        fprintf(stderr, "bench_ws: only %d of %d clients finished\n", g_done_count, g_opt.clients);
+        return -1;
+    }
+    return seconds;
+}
+
+/* ============================================================
+ *  Mode: rtt
+ * ============================================================ */
+
+static void rtt_send(bench_client_t *c) {
+    if (c->remaining == 0) {
+        g_done_count++;
+        return;
+    }
+    c->remaining--;
+    c->sent_ns = bench_now_ns();
+    if (client_send_text(c, k_query) != 0) {
+        client_close(c);
+    }
+}
+
+static void rtt_open(bench_client_t *c) {
+    c->remaining = g_opt.requests;
+    rtt_send(c);
+}
+
+static void rtt_message(bench_client_t *c, const uint8_t *payload, size_t len) {
+    (void)payload;
+    (void)len;
+    record_sample(bench_now_ns() - c->sent_ns);
+    rtt_send(c);
+}
+
+static const bench_mode_t k_mode_rtt = { rtt_open, rtt_message, NULL, NULL, NULL };
+
+/* ============================================================
+ *  Mode: broadcast
+ * ============================================================ */
+
+static struct {
+    bool started;
+    int sent;
+    uint64_t start_ns;              /**< 目前這則廣播的開始時間 (atomic) */
+    int received;                   /**< 所有客戶端收到的總份數 (atomic) */
+} g_broadcast;
+
+static void broadcast_open(bench_client_t *c) {
+    c->remaining = g_opt.requests;
+}
+
+static void broadcast_message(bench_client_t *c, const uint8_t *payload, size_t len) {
+    (void)payload;
+    (void)len;
+    record_sample(bench_now_ns() - __atomic_load_n(&g_broadcast.start_ns, __ATOMIC_ACQUIRE));
+    if (--c->remaining == 0) {
+        g_done_count++;
+    }
+
+    // 最後一份送達時喚醒主執行緒送出下一則
+    int received = __atomic_add_fetch(&g_broadcast.received, 1, __ATOMIC_ACQ_REL);
+    if (received % g_opt.clients == 0) {
+        ws_server_wake();
+    }
+}
+
+static void broadcast_service(void) {
+    if (!g_broadcast.started) {
+        // 等所有客戶端在兩端都完成握手
+        if (__atomic_load_n(&g_open_count, __ATOMIC_ACQUIRE) < g_opt.clients ||
+            ws_server_get_client_count() < g_opt.clients) {
+            ws_server_service(10);
+            return;
+        }
+        g_broadcast.started = true;
+        reset_syscalls();
+    }
+
+    if (g_broadcast.sent < g_opt.requests &&
+        __atomic_load_n(&g_broadcast.received, __ATOMIC_ACQUIRE) ==
+            g_broadcast.sent * g_opt.clients) {
+        g_broadcast.sent++;
+        __atomic_store_n(&g_broadcast.start_ns, bench_now_ns(), __ATOMIC_RELEASE);
+        ws_server_broadcast(k_status);
+    }
+
+    ws_server_service(1000);
+}
+
+static const bench_mode_t k_mode_broadcast = {
+    broadcast_open, broadcast_message, broadcast_service, NULL, NULL
+};
+
+/* ============================================================
+ *  Mode: storm
+ * ============================================================ */
+
+static struct {
+    int round;                      /**< 已完成的輪數 */
+    int opened;                     /**< 本輪已完成握手的客戶端數 */
+} g_storm;
+
+static void storm_begin(void) {
+    reset_syscalls();
+}
+
+static void storm_open(bench_client_t *c) {
+    (void)c;
+    g_storm.opened++;
+}
+
+static void storm_message(bench_client_t *c, const uint8_t *payload, size_t len) {
+    (void)c;
+    (void)payload;
+    (void)len;
+}
+
+static void storm_after_events(void) {
+    if (g_storm.opened < g_opt.clients) {
+        return;
+    }
+    record_sample(bench_now_ns() - g_connect_ns);
+    g_storm.opened = 0;
+
+    for (int i = 0; i < g_opt.clients; i++) {
+        client_close(&g_clients[i]);
+    }
+    if (++g_storm.round == g_opt.requests) {
+        g_done_count = g_opt.clients;
+        return;
+    }
+
+    // 伺服器端也釋放所有槽位後才是下一輪完整的風暴
+    uint64_t deadline = bench_now_ns() + 5000000000ull;
+    while (ws_server_get_client_count() > 0 && bench_now_ns() < deadline) {
+        usleep(100);
+    }
+    connect_all();
+}
+
+static const bench_mode_t k_mode_storm = {
+    storm_open, storm_message, NULL, storm_begin, storm_after_events
+};
+
+/** 伺服器處理一個 Upgrade 請求的 CPU 工作 (不含系統呼叫) */
+static void bench_handshake(void *arg) {
+    (void)arg;
+    ws_http_request_t req;
+    char accept_key[WS_HANDSHAKE_ACCEPT_LEN + 1];
+    char response[512];
+
+    int header_len = ws_handshake_parse_request(k_upgrade_request,
+                                                sizeof(k_upgrade_request) - 1, &req);
+    BENCH_KEEP(header_len);
+    BENCH_KEEP(ws_handshake_is_upgrade(&req));
+    BENCH_KEEP(ws_handshake_accept_key(req.key, accept_key));
+    BENCH_KEEP(ws_handshake_build_response(response, sizeof(response), accept_key, NULL, NULL));
+}
+
+static void bench_accept_key(void *arg) {
+    (void)arg;
+    static const ws_str_t key = { "dGhlIHNhbXBsZSBub25jZQ==", 24 };
+    char accept_key[WS_HANDSHAKE_ACCEPT_LEN + 1];
+    BENCH_KEEP(ws_handshake_accept_key(key, accept_key));
+}
+
+static void print_storm(void) {
+    uint64_t p50 = bench_percentile(g_samples, g_sample_count, 50);
+    uint64_t max = g_sample_count ? g_samples[g_sample_count - 1] : 0;
+    uint64_t connections = (uint64_t)g_sample_count * (uint64_t)g_opt.clients;
+
+    printf("%-10s workers=%d clients=%d  all established p50 %7.2f ms  max %7.2f ms  "
+           "(%.1f us/connection)\n",
+           "storm", g_opt.workers, g_opt.clients, (double)p50 / 1e6, (double)max / 1e6,
+           (double)p50 / 1000.0 / (double)g_opt.clients);
+    print_syscalls(connections);
+
+    double handshake_ns = bench_run(bench_handshake, NULL);
+    double accept_key_ns = bench_run(bench_accept_key, NULL);
+    printf("  handshake CPU %.0f ns/connection (Sec-WebSocket-Accept %.0f ns), "
+           "%.1f%% of p50\n", handshake_ns, accept_key_ns,
+           100.0 * handshake_ns * (double)g_opt.clients / (double)p50);
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+static void usage(void) {
+    fprintf(stderr, "usage: bench_ws rtt|broadcast|storm [-w WORKERS] [-c CLIENTS] [-n COUNT] "
+            "[-p PORT] [-l]\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    const char *mode = argv[1];
+
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "w:c:n:p:l")) != -1) {
+        switch (opt) {
+            case 'w': g_opt.workers = atoi(optarg); break;
+            case 'c': g_opt.clients = atoi(optarg); break;
+            case 'n': g_opt.requests = atoi(optarg); break;
+            case 'p': g_opt.port = atoi(optarg); break;
+            case 'l': g_opt.local = true; break;
+            default:  usage(); return 1;
+        }
+    }
+    if (g_opt.clients < 1 || g_opt.clients > BENCH_MAX_CLIENTS || g_opt.requests < 1) {
+        usage();
+        return 1;
+    }
+
+    if (strcmp(mode, "rtt") == 0) {
+        double seconds = run(&k_mode_rtt);
+        if (seconds < 0) {
+            return 1;
+        }
+        print_latency("rtt", seconds, g_sample_count);
+        return 0;
+    }
+
+    if (strcmp(mode, "broadcast") == 0) {
+        double seconds = run(&k_mode_broadcast);
+        if (seconds < 0) {
+            return 1;
+        }
+        print_latency("broadcast", seconds, (size_t)g_opt.requests);
+        print_syscalls((uint64_t)g_opt.requests);
+        return 0;
+    }
+
+    if (strcmp(mode, "storm") == 0) {
+        if (g_opt.local) {
+            fprintf(stderr, "bench_ws: storm measures the WebSocket upgrade, -l is not supported\n");
+            return 1;
+        }
+        if (g_opt.clients > WS_SERVER_MAX_CLIENTS || WS_SERVER_ACCEPT_RATE != 0) {
+            fprintf(stderr, "bench_ws: storm needs WS_SERVER_MAX_CLIENTS >= %d and "
+                    "WS_SERVER_ACCEPT_RATE=0\n", g_opt.clients);
+            return 1;
+        }
+        if (run(&k_mode_storm) < 0) {
+            return 1;
+        }
+        print_storm();
+        return 0;
+    }
+
+    usage();
+    return 1;
+}
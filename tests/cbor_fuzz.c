@@ -0,0 +1,530 @@
+/**
+ * @file cbor_fuzz.c
+ * @brief gaming.v1.cbor 轉碼器的 round-trip 與變異測試
+ *
+ * 每個案例隨機產生一份 JSON,同時產生兩種寫法:
+ * - canonical: json_writer 會輸出的形式 (無空白、最少跳脫)
+ * - noisy: 語意相同但加入空白、\/ 與 \uXXXX (含 surrogate pair) 跳脫
+ *
+ * 檢查:
+ * 1. noisy → CBOR → JSON 必須等於 canonical
+ * 2. 之後 JSON → CBOR → JSON 不再改變 (fixed point)
+ * 3. 變異後的 CBOR/JSON (翻轉、插入、刪除、截斷) 放在剛好大小的
+ *    heap 緩衝區轉碼,由 ASan/UBSan 檢查越界;轉碼成功時同樣須滿足 2
+ *
+ * @code
+ * ./cbor_fuzz [ITERATIONS] [SEED]
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-08
+ * @version 1.0.0
+ */
+
+#include "ws_cbor.h"
+#include "websocket_server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdarg.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define FUZZ_DEFAULT_ITERATIONS     20000
+#define FUZZ_TEXT_SIZE              8192
+#define FUZZ_MAX_DEPTH              6
+#define FUZZ_MUTATIONS              8
+
+/* ============================================================
+ *  Random Source
+ * ============================================================ */
+
+static uint64_t g_rng;
+
+static uint32_t rnd(void) {
+    // xorshift64*
+    g_rng ^= g_rng >> 12;
+    g_rng ^= g_rng << 25;
+    g_rng ^= g_rng >> 27;
+    return (uint32_t)((g_rng * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t rnd_below(uint32_t n) {
+    return rnd() % n;
+}
+
+/* ============================================================
+ *  Generator
+ * ============================================================ */
+
+typedef struct {
+    char canonical[FUZZ_TEXT_SIZE];
+    size_t canonical_len;
+    char noisy[FUZZ_TEXT_SIZE];
+    size_t noisy_len;
+    bool overflow;
+} fuzz_doc_t;
+
+static void append(char *buf, size_t *len, bool *overflow, const char *data, size_t n) {
+    if (*len + n + 1 > FUZZ_TEXT_SIZE) {
+        *overflow = true;
+        return;
+    }
+    memcpy(buf + *len, data, n);
+    *len += n;
+    buf[*len] = '\0';
+}
+
+/** 兩種寫法相同的片段 */
+static void emit_both(fuzz_doc_t *d, const char *s) {
+    append(d->canonical, &d->canonical_len, &d->overflow, s, strlen(s));
+    append(d->noisy, &d->noisy_len, &d->overflow, s, strlen(s));
+}
+
+static void emit_canonical(fuzz_doc_t *d, const char *s, size_t n) {
+    append(d->canonical, &d->canonical_len, &d->overflow, s, n);
+}
+
+static void emit_noisy(fuzz_doc_t *d, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void emit_noisy(fuzz_doc_t *d, const char *fmt, ...) {
+    char tmp[64];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    append(d->noisy, &d->noisy_len, &d->overflow, tmp, (size_t)n);
+}
+
+static void emit_space(fuzz_doc_t *d) {
+    static const char *const k_spaces[] = { "", "", "", " ", "\n", "\t ", "\r\n  " };
+    emit_noisy(d, "%s", k_spaces[rnd_below(7)]);
+}
+
+/** 依 json_writer 的規則跳脫一個字元 (canonical) */
+static void canonical_char(fuzz_doc_t *d, uint32_t cp, const char *utf8, size_t utf8_len) {
+    char esc[8];
+    switch (cp) {
+        case '"':  emit_canonical(d, "\\\"", 2); return;
+        case '\\': emit_canonical(d, "\\\\", 2); return;
+        case '\b': emit_canonical(d, "\\b", 2);  return;
+        case '\f': emit_canonical(d, "\\f", 2);  return;
+        case '\n': emit_canonical(d, "\\n", 2);  return;
+        case '\r': emit_canonical(d, "\\r", 2);  return;
+        case '\t': emit_canonical(d, "\\t", 2);  return;
+        default:
+            if (cp < 0x20) {
+                snprintf(esc, sizeof(esc), "\\u%04" PRIx32, cp);
+                emit_canonical(d, esc, 6);
+            } else {
+                emit_canonical(d, utf8, utf8_len);
+            }
+            return;
+    }
+}
+
+/** 以任一種合法寫法輸出一個字元 (noisy) */
+static void noisy_char(fuzz_doc_t *d, uint32_t cp, const char *utf8, size_t utf8_len) {
+    bool must_escape = (cp < 0x20 || cp == '"' || cp == '\\');
+
+    if (rnd_below(4) == 0 || (must_escape && rnd_below(2) == 0)) {
+        if (cp >= 0x10000) {
+            uint32_t v = cp - 0x10000;
+            emit_noisy(d, "\\u%04" PRIX32 "\\u%04" PRIx32, 0xD800 + (v >> 10), 0xDC00 + (v & 0x3FF));
+        } else {
+            emit_noisy(d, rnd_below(2) ? "\\u%04" PRIx32 : "\\u%04" PRIX32, cp);
+        }
+        return;
+    }
+
+    switch (cp) {
+        case '"':  emit_noisy(d, "\\\""); return;
+        case '\\': emit_noisy(d, "\\\\"); return;
+        case '/':  emit_noisy(d, rnd_below(2) ? "\\/" : "/"); return;
+        case '\b': emit_noisy(d, "\\b");  return;
+        case '\f': emit_noisy(d, "\\f");  return;
+        case '\n': emit_noisy(d, "\\n");  return;
+        case '\r': emit_noisy(d, "\\r");  return;
+        case '\t': emit_noisy(d, "\\t");  return;
+        default:
+            if (cp < 0x20) {
+                emit_noisy(d, "\\u%04" PRIx32, cp);
+            } else {
+                append(d->noisy, &d->noisy_len, &d->overflow, utf8, utf8_len);
+            }
+            return;
+    }
+}
+
+static size_t encode_utf8(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static uint32_t random_codepoint(void) {
+    static const uint32_t k_special[] = {
+        '"', '\\', '/', '\b', '\f', '\n', '\r', '\t', 0x00, 0x01, 0x1F, 0x7F,
+        0xE9, 0x4E2D, 0xFFFD, 0x1F600, 0x10FFFF,
+    };
+
+    switch (rnd_below(4)) {
+        case 0:
+            return k_special[rnd_below(sizeof(k_special) / sizeof(k_special[0]))];
+        case 1: {
+            uint32_t cp = 0x80 + rnd_below(0x10FFFF - 0x80);
+            return (cp >= 0xD800 && cp <= 0xDFFF) ? 0xFFFD : cp;
+        }
+        default:
+            return 0x20 + rnd_below(0x5F);
+    }
+}
+
+static void gen_string_text(fuzz_doc_t *d, const char *text) {
+    emit_both(d, "\"");
+    for (const char *p = text; *p; p++) {
+        canonical_char(d, (uint32_t)(unsigned char)*p, p, 1);
+        noisy_char(d, (uint32_t)(unsigned char)*p, p, 1);
+    }
+    emit_both(d, "\"");
+}
+
+static void gen_string(fuzz_doc_t *d) {
+    emit_both(d, "\"");
+    int len = (int)rnd_below(rnd_below(8) == 0 ? 200 : 12);
+    for (int i = 0; i < len; i++) {
+        uint32_t cp = random_codepoint();
+        char utf8[4];
+        size_t n = encode_utf8(cp, utf8);
+        canonical_char(d, cp, utf8, n);
+        noisy_char(d, cp, utf8, n);
+    }
+    emit_both(d, "\"");
+}
+
+static void gen_number(fuzz_doc_t *d) {
+    char num[40];
+
+    switch (rnd_below(5)) {
+        case 0:
+            snprintf(num, sizeof(num), "%d", (int)rnd_below(24));
+            break;
+        case 1:
+            snprintf(num, sizeof(num), "%" PRId64, (int64_t)(((uint64_t)rnd() << 32) | rnd()));
+            break;
+        case 2:
+            snprintf(num, sizeof(num), "%s", rnd_below(2) ? "-9223372036854775808"
+                                                          : "9223372036854775807");
+            break;
+        default: {
+            double v = ((double)(int32_t)rnd() / 65536.0) * (rnd_below(2) ? 1e-3 : 1e12);
+            snprintf(num, sizeof(num), "%.17g", v);
+            break;
+        }
+    }
+
+    emit_both(d, num);
+}
+
+static void gen_value(fuzz_doc_t *d, int depth);
+
+static void gen_container(fuzz_doc_t *d, int depth, bool is_object) {
+    emit_both(d, is_object ? "{" : "[");
+
+    int count = (int)rnd_below(depth >= FUZZ_MAX_DEPTH ? 1 : 6);
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            emit_space(d);
+            emit_both(d, ",");
+        }
+        emit_space(d);
+
+        if (is_object) {
+            // 最外層的 "type" 以整數標籤編碼
+            if (depth == 1 && rnd_below(3) == 0) {
+                emit_both(d, "\"type\"");
+                emit_space(d);
+                emit_both(d, ":");
+                emit_space(d);
+                const char *name = ws_message_type_to_string((ws_message_type_t)rnd_below(25));
+                gen_string_text(d, name);
+                continue;
+            }
+            gen_string(d);
+            emit_space(d);
+            emit_both(d, ":");
+            emit_space(d);
+        }
+        gen_value(d, depth);
+    }
+
+    emit_space(d);
+    emit_both(d, is_object ? "}" : "]");
+}
+
+static void gen_value(fuzz_doc_t *d, int depth) {
+    switch (rnd_below(depth >= FUZZ_MAX_DEPTH ? 6 : 8)) {
+        case 0:  gen_string(d); break;
+        case 1:  gen_number(d); break;
+        case 2:  emit_both(d, "true"); break;
+        case 3:  emit_both(d, "false"); break;
+        case 4:  emit_both(d, "null"); break;
+        case 5:  gen_string(d); break;
+        case 6:  gen_container(d, depth + 1, false); break;
+        default: gen_container(d, depth + 1, true); break;
+    }
+}
+
+/* ============================================================
+ *  Checks
+ * ============================================================ */
+
+static unsigned g_cases;
+static unsigned g_mutants;
+static unsigned g_mutants_decoded;
+
+static void dump_hex(const char *label, const uint8_t *data, size_t len) {
+    fprintf(stderr, "%s (%zu bytes):", label, len);
+    for (size_t i = 0; i < len; i++) {
+        fprintf(stderr, "%s%02x", (i % 32) ? " " : "\n  ", data[i]);
+    }
+    fprintf(stderr, "\n");
+}
+
+/**
+ * @brief JSON → CBOR → JSON 不再改變
+ * @return true 成功
+ */
+static bool check_fixed_point(const char *json, size_t json_len) {
+    static uint8_t cbor[FUZZ_TEXT_SIZE];
+    static char again[FUZZ_TEXT_SIZE];
+
+    size_t cbor_len = ws_cbor_from_json(json, json_len, cbor, sizeof(cbor));
+    if (cbor_len == 0) {
+        fprintf(stderr, "FAIL: transcoder output does not parse back\n  %s\n", json);
+        return false;
+    }
+
+    size_t again_len = ws_cbor_to_json(cbor, cbor_len, again, sizeof(again), NULL);
+    if (again_len != json_len || memcmp(again, json, json_len) != 0) {
+        fprintf(stderr, "FAIL: not a fixed point\n  first:  %s\n  second: %.*s\n",
+                json, (int)again_len, again);
+        dump_hex("cbor", cbor, cbor_len);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief 變異 src 後放入剛好大小的 heap 緩衝區
+ */
+static uint8_t* mutate(const uint8_t *src, size_t len, size_t *out_len) {
+    uint8_t *out = malloc(len + 8);
+    if (out == NULL) {
+        return NULL;
+    }
+    memcpy(out, src, len);
+
+    int edits = 1 + (int)rnd_below(3);
+    for (int i = 0; i < edits && len > 0; i++) {
+        size_t pos = rnd_below((uint32_t)len);
+        switch (rnd_below(5)) {
+            case 0:
+                out[pos] ^= (uint8_t)(1u << rnd_below(8));
+                break;
+            case 1:
+                out[pos] = (uint8_t)rnd();
+                break;
+            case 2:
+                memmove(out + pos, out + pos + 1, len - pos - 1);
+                len--;
+                break;
+            case 3:
+                if (i == 0) {
+                    memmove(out + pos + 1, out + pos, len - pos);
+                    out[pos] = (uint8_t)rnd();
+                    len++;
+                }
+                break;
+            default:
+                len = pos;
+                break;
+        }
+    }
+
+    // 剛好大小,讓 ASan 抓到任何超出結尾的讀取
+    uint8_t *exact = malloc(len > 0 ? len : 1);
+    if (exact != NULL) {
+        memcpy(exact, out, len);
+    }
+    free(out);
+    *out_len = len;
+    return exact;
+}
+
+static bool fuzz_mutants(const uint8_t *cbor, size_t cbor_len, const char *json, size_t json_len) {
+    static uint8_t cbor_out[FUZZ_TEXT_SIZE];
+    static char json_out[FUZZ_TEXT_SIZE];
+
+    for (int i = 0; i < FUZZ_MUTATIONS; i++) {
+        size_t len;
+        uint8_t *m = mutate(cbor, cbor_len, &len);
+        if (m == NULL) {
+            return false;
+        }
+        g_mutants++;
+        size_t out_len = ws_cbor_to_json(m, len, json_out, sizeof(json_out), NULL);
+        free(m);
+        if (out_len > 0) {
+            g_mutants_decoded++;
+            if (!check_fixed_point(json_out, out_len)) {
+                return false;
+            }
+        }
+
+        m = mutate((const uint8_t*)json, json_len, &len);
+        if (m == NULL) {
+            return false;
+        }
+        g_mutants++;
+        out_len = ws_cbor_from_json((const char*)m, len, cbor_out, sizeof(cbor_out));
+        free(m);
+        if (out_len > 0) {
+            g_mutants_decoded++;
+            if (ws_cbor_to_json(cbor_out, out_len, json_out, sizeof(json_out), NULL) == 0) {
+                fprintf(stderr, "FAIL: accepted JSON produced undecodable CBOR\n");
+                dump_hex("cbor", cbor_out, out_len);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool run_case(void) {
+    static fuzz_doc_t doc;
+    static uint8_t cbor[FUZZ_TEXT_SIZE];
+    static char json[FUZZ_TEXT_SIZE];
+
+    memset(&doc, 0, sizeof(doc));
+    if (rnd_below(4) == 0) {
+        gen_value(&doc, 0);
+    } else {
+        gen_container(&doc, 1, true);
+    }
+    if (doc.overflow) {
+        return true;  // 太大,略過
+    }
+    g_cases++;
+
+    size_t cbor_len = ws_cbor_from_json(doc.noisy, doc.noisy_len, cbor, sizeof(cbor));
+    if (cbor_len == 0) {
+        fprintf(stderr, "FAIL: valid JSON rejected\n  %s\n", doc.noisy);
+        return false;
+    }
+
+    size_t json_len = ws_cbor_to_json(cbor, cbor_len, json, sizeof(json), NULL);
+    if (json_len != doc.canonical_len || memcmp(json, doc.canonical, json_len) != 0) {
+        fprintf(stderr, "FAIL: round trip changed the value\n  input:    %s\n"
+                        "  expected: %s\n  got:      %.*s\n",
+                doc.noisy, doc.canonical, (int)json_len, json);
+        dump_hex("cbor", cbor, cbor_len);
+        return false;
+    }
+
+    return check_fixed_point(json, json_len) &&
+           fuzz_mutants(cbor, cbor_len, doc.noisy, doc.noisy_len);
+}
+
+/* ============================================================
+ *  Fixed Cases
+ * ============================================================ */
+
+typedef struct {
+    const char *input;
+    const char *expected;           /**< NULL 表示必須拒絕 */
+} fixed_case_t;
+
+static const fixed_case_t k_fixed_cases[] = {
+    // 超出 int64 的整數以 float64 編碼,不可截成 INT64_MAX
+    { "[9223372036854775808]",      "[9.2233720368547758e+18]" },
+    { "[-9223372036854775809]",     "[-9.2233720368547758e+18]" },
+    { "[18446744073709551616]",     "[1.8446744073709552e+19]" },
+    { "{\"type\":\"ping\"}",          "{\"type\":\"ping\"}" },
+    { "\"\\ud83d\\ude00\"",             "\"\xf0\x9f\x98\x80\"" },
+    { "\"\\ud83d\"",                   NULL },
+    { "[1,]",                       NULL },
+    { "{\"a\" 1}",                  NULL },
+    { "[1e999]",                    NULL },
+};
+
+static bool run_fixed_cases(void) {
+    static uint8_t cbor[FUZZ_TEXT_SIZE];
+    static char json[FUZZ_TEXT_SIZE];
+
+    for (size_t i = 0; i < sizeof(k_fixed_cases) / sizeof(k_fixed_cases[0]); i++) {
+        const fixed_case_t *c = &k_fixed_cases[i];
+        size_t cbor_len = ws_cbor_from_json(c->input, strlen(c->input), cbor, sizeof(cbor));
+        size_t json_len = cbor_len ? ws_cbor_to_json(cbor, cbor_len, json, sizeof(json), NULL) : 0;
+
+        if (c->expected == NULL) {
+            if (json_len != 0) {
+                fprintf(stderr, "FAIL: accepted %s as %.*s\n", c->input, (int)json_len, json);
+                return false;
+            }
+        } else if (json_len != strlen(c->expected) || memcmp(json, c->expected, json_len) != 0) {
+            fprintf(stderr, "FAIL: %s\n  expected: %s\n  got:      %.*s\n",
+                    c->input, c->expected, (int)json_len, json);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+int main(int argc, char *argv[]) {
+    unsigned long iterations = (argc > 1) ? strtoul(argv[1], NULL, 10) : FUZZ_DEFAULT_ITERATIONS;
+    uint64_t seed = (argc > 2) ? strtoull(argv[2], NULL, 0) : 0x9E3779B97F4A7C15ULL;
+    g_rng = seed ? seed : 1;
+
+    if (!run_fixed_cases()) {
+        return 1;
+    }
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        if (!run_case()) {
+            fprintf(stderr, "cbor_fuzz: failed at iteration %lu (seed 0x%" PRIx64 ")\n",
+                    i, seed);
+            return 1;
+        }
+    }
+
+    printf("cbor_fuzz: %u cases, %u mutants (%u decoded), seed 0x%" PRIx64 ": OK\n",
+           g_cases, g_mutants, g_mutants_decoded, seed);
+    return 0;
+}
@@ -0,0 +1,315 @@
+/**
+ * @file handoff_test.c
+ * @brief 平滑升級交接通道 (upgrade_handoff) 測試
+ *
+ * 以 socketpair 代替新舊程序,依 HELLO / STATE / READY 的順序交換:
+ * - STATE 內容 (狀態機、CEC 與客戶端紀錄) 原樣送達
+ * - 以 SCM_RIGHTS 傳遞的 listen socket 與客戶端連線在舊端關閉後仍可使用,
+ *   收到的 fd 已設定 close-on-exec
+ * - 長度不符時回傳 -1 並關閉收到的 fd (連線的另一端看到 EOF)
+ * - 等待 READY 時收到 ABORT 回傳 -1
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-09
+ * @version 1.0.0
+ */
+
+#include "upgrade_handoff.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define RECV_TIMEOUT_MS     1000
+#define TEST_CLIENT_ID      42
+
+/* ============================================================
+ *  Checks
+ * ============================================================ */
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* ============================================================
+ *  Helpers
+ * ============================================================ */
+
+/**
+ * @brief 建立 127.0.0.1 上的 listen socket (隨機端口)
+ */
+static int open_listener(uint16_t *port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static uint16_t bound_port(int fd) {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(fd, (struct sockaddr*)&addr, &addr_len) != 0 || addr.sin_family != AF_INET) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+static bool is_cloexec(int fd) {
+    int flags = fcntl(fd, F_GETFD);
+    return flags >= 0 && (flags & FD_CLOEXEC);
+}
+
+/**
+ * @brief 由 from 寫入一則資料,檢查 to 收到相同內容
+ */
+static bool echo_ok(int from, int to, const char *text) {
+    size_t len = strlen(text);
+    if (write(from, text, len) != (ssize_t)len) {
+        return false;
+    }
+
+    char buf[64];
+    ssize_t n = read(to, buf, sizeof(buf));
+    return n == (ssize_t)len && memcmp(buf, text, len) == 0;
+}
+
+/**
+ * @brief 舊程序匯出的狀態: 一個 worker 與一個已訂閱的 CBOR 客戶端
+ */
+static void fill_state(upgrade_state_t *state, uint16_t port) {
+    memset(state, 0, sizeof(*state));
+
+    state->cec_power = PS5_POWER_ON;
+    state->cec_update_time = 1765152000;
+    state->ps5_cache_time = 1765151990;
+    state->status_version = 17;
+    state->wake_requests = 3;
+
+    state->sm.state = SERVER_STATE_CLIENT_CONNECTED;
+    state->sm.ps5_power = PS5_POWER_ON;
+    state->sm.ps5_network = PS5_NET_ONLINE;
+    state->sm.client_count = 1;
+    state->sm.error_count = 2;
+
+    state->ws.port = port;
+    state->ws.worker_count = 1;
+    state->ws.client_count = 1;
+
+    ws_handoff_client_t *client = &state->ws.clients[0];
+    client->id = TEST_CLIENT_ID;
+    snprintf(client->ip, sizeof(client->ip), "192.168.1.50");
+    client->port = 50123;
+    client->connect_time = 1765151000;
+    client->subscriptions = WS_TOPIC_STATUS_FULL;
+    client->encoding = WS_ENCODING_CBOR;
+    client->deflate = true;
+    client->server_max_window_bits = 15;
+    client->client_max_window_bits = 12;
+    client->last_rx_ms = 123456789;
+    client->ping_sent_ms = 123450000;
+    for (int i = 0; i < WS_SERVER_RATE_LIMIT_TYPES; i++) {
+        client->rate_tokens[i] = (uint32_t)(1000 + i);
+        client->rate_last_ms[i] = 123400000u + (uint64_t)i;
+    }
+}
+
+/* ============================================================
+ *  Tests
+ * ============================================================ */
+
+/**
+ * @brief 完整交接: 狀態與 fd 都送達新程序
+ */
+static void test_handoff(void) {
+    int channel[2];
+    int conn[2];
+    uint16_t port = 0;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channel) != 0 ||
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, conn) != 0) {
+        CHECK(0, "socketpair: %s", strerror(errno));
+        return;
+    }
+    int listen_fd = open_listener(&port);
+    CHECK(listen_fd >= 0, "listen socket: %s", strerror(errno));
+    if (listen_fd < 0) {
+        return;
+    }
+
+    int old_end = channel[0];
+    int new_end = channel[1];
+
+    upgrade_state_t *sent = malloc(sizeof(*sent));
+    upgrade_state_t *received = malloc(sizeof(*received));
+    if (sent == NULL || received == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    fill_state(sent, port);
+    memset(received, 0xA5, sizeof(*received));
+
+    // 新程序 -> 舊程序: HELLO
+    CHECK(upgrade_handoff_send(new_end, UPGRADE_MSG_HELLO, NULL, 0, NULL, 0) == 0, "send HELLO");
+    CHECK(upgrade_handoff_recv(old_end, UPGRADE_MSG_HELLO, NULL, 0, NULL, 0, NULL,
+                               RECV_TIMEOUT_MS) == 1, "recv HELLO");
+
+    // 舊程序 -> 新程序: STATE + fd (listen socket 在前,客戶端在後),送出後舊端關閉
+    int fds[2] = { listen_fd, conn[0] };
+    CHECK(upgrade_handoff_send(old_end, UPGRADE_MSG_STATE, sent, sizeof(*sent), fds, 2) == 0,
+          "send STATE");
+    close(listen_fd);
+    close(conn[0]);
+
+    int adopted[WS_SERVER_HANDOFF_MAX_FDS];
+    int adopted_count = -1;
+    int rc = upgrade_handoff_recv(new_end, UPGRADE_MSG_STATE, received, sizeof(*received),
+                                  adopted, WS_SERVER_HANDOFF_MAX_FDS, &adopted_count,
+                                  RECV_TIMEOUT_MS);
+    CHECK(rc == 1, "recv STATE returned %d", rc);
+    CHECK(adopted_count == 2, "%d fds received, want 2", adopted_count);
+
+    if (rc == 1) {
+        CHECK(memcmp(sent, received, sizeof(*sent)) == 0, "state differs after handoff");
+        const ws_handoff_client_t *client = &received->ws.clients[0];
+        CHECK(client->id == TEST_CLIENT_ID && strcmp(client->ip, "192.168.1.50") == 0 &&
+              client->encoding == WS_ENCODING_CBOR && client->deflate,
+              "client record: id %d ip %s", client->id, client->ip);
+        CHECK(received->sm.state == SERVER_STATE_CLIENT_CONNECTED && received->sm.client_count == 1,
+              "state machine snapshot: state %d, %d clients",
+              received->sm.state, received->sm.client_count);
+    }
+
+    if (adopted_count == 2) {
+        // listen socket: 同一個綁定的端口,仍在監聽
+        int accepting = 0;
+        socklen_t opt_len = sizeof(accepting);
+        getsockopt(adopted[0], SOL_SOCKET, SO_ACCEPTCONN, &accepting, &opt_len);
+        CHECK(bound_port(adopted[0]) == port && accepting,
+              "listen socket: port %u (want %u), accepting %d", bound_port(adopted[0]), port,
+              accepting);
+
+        // 客戶端連線: 舊端已關閉,雙向資料仍可傳遞
+        CHECK(echo_ok(conn[1], adopted[1], "ping"), "client -> adopted fd");
+        CHECK(echo_ok(adopted[1], conn[1], "pong"), "adopted fd -> client");
+
+        CHECK(is_cloexec(adopted[0]) && is_cloexec(adopted[1]), "received fds without FD_CLOEXEC");
+
+        close(adopted[0]);
+        close(adopted[1]);
+    }
+
+    // 新程序 -> 舊程序: READY
+    CHECK(upgrade_handoff_send(new_end, UPGRADE_MSG_READY, NULL, 0, NULL, 0) == 0, "send READY");
+    CHECK(upgrade_handoff_recv(old_end, UPGRADE_MSG_READY, NULL, 0, NULL, 0, NULL,
+                               RECV_TIMEOUT_MS) == 1, "recv READY");
+
+    free(sent);
+    free(received);
+    close(conn[1]);
+    close(old_end);
+    close(new_end);
+}
+
+/**
+ * @brief 內容長度不符: 收到的 fd 被關閉,客戶端看到連線結束
+ */
+static void test_length_mismatch(void) {
+    int channel[2];
+    int conn[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channel) != 0 ||
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, conn) != 0) {
+        CHECK(0, "socketpair: %s", strerror(errno));
+        return;
+    }
+
+    uint32_t payload[4] = { 1, 2, 3, 4 };
+    CHECK(upgrade_handoff_send(channel[0], UPGRADE_MSG_STATE, payload, sizeof(payload),
+                               &conn[0], 1) == 0, "send STATE");
+    close(conn[0]);
+
+    uint32_t short_payload[3];
+    int fds[WS_SERVER_HANDOFF_MAX_FDS];
+    int fd_count = -1;
+    int rc = upgrade_handoff_recv(channel[1], UPGRADE_MSG_STATE, short_payload,
+                                  sizeof(short_payload), fds, WS_SERVER_HANDOFF_MAX_FDS,
+                                  &fd_count, RECV_TIMEOUT_MS);
+    CHECK(rc == -1, "recv with the wrong length returned %d", rc);
+    CHECK(fd_count == 0, "%d fds returned", fd_count);
+
+    char buf[8];
+    CHECK(read(conn[1], buf, sizeof(buf)) == 0, "received fd left open");
+
+    close(conn[1]);
+    close(channel[0]);
+    close(channel[1]);
+}
+
+/**
+ * @brief 等待 READY 時收到 ABORT
+ */
+static void test_abort(void) {
+    int channel[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channel) != 0) {
+        CHECK(0, "socketpair: %s", strerror(errno));
+        return;
+    }
+
+    CHECK(upgrade_handoff_recv(channel[0], UPGRADE_MSG_READY, NULL, 0, NULL, 0, NULL, 0) == 0,
+          "recv without a message did not time out");
+
+    CHECK(upgrade_handoff_send(channel[1], UPGRADE_MSG_ABORT, NULL, 0, NULL, 0) == 0, "send ABORT");
+    CHECK(upgrade_handoff_recv(channel[0], UPGRADE_MSG_READY, NULL, 0, NULL, 0, NULL,
+                               RECV_TIMEOUT_MS) == -1, "ABORT accepted as READY");
+
+    close(channel[0]);
+    close(channel[1]);
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+int main(void) {
+    test_handoff();
+    test_length_mismatch();
+    test_abort();
+
+    if (g_failures > 0) {
+        fprintf(stderr, "handoff_test: %d failures\n", g_failures);
+        return 1;
+    }
+    printf("handoff_test: OK\n");
+    return 0;
+}
@@ -0,0 +1,416 @@
+/**
+ * @file server_sm_test.c
+ * @brief 伺服器狀態機轉換表測試
+ *
+ * 項目:
+ * - 轉換表的每一列 (含守衛成立與不成立) 經 server_sm_post() 驅動,
+ *   沒有對應列的 (狀態, 事件) 組合不得改變狀態
+ * - RESET 從任何狀態回到 MONITORING 並清除計數
+ * - on_state_enter 回調中 (dispatching 已設定) 送出的事件進入佇列,
+ *   於目前事件處理完後依序執行
+ * - 喚醒失敗: 依連線數與電源狀態回到 CLIENT_CONNECTED、PS5_DETECTED
+ *   或 MONITORING,錯誤計數超過 3 次後進入 ERROR
+ * - server_sm_write_graph() 的輸出與 server_sm_graph.dot 相同
+ *
+ * 轉換表有意改變時以下列命令重新產生 server_sm_graph.dot 並檢查差異:
+ *   ./gaming-server-test --state-graph > server_sm_graph.dot
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-09
+ * @version 1.0.0
+ */
+
+#include "server_state_machine.h"
+#include "vclock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define GRAPH_GOLDEN_PATH   "server_sm_graph.dot"
+#define GRAPH_MAX_SIZE      8192
+#define MAX_ENTERED         16
+
+/* ============================================================
+ *  Checks
+ * ============================================================ */
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* ============================================================
+ *  Helpers
+ * ============================================================ */
+
+/** 狀態機所在的情境 (經 server_sm_restore() 設定) */
+typedef struct {
+    server_state_t state;
+    int clients;
+    ps5_power_state_t power;
+    int errors;
+} sm_setup_t;
+
+static server_context_t* create_at(const sm_setup_t *setup) {
+    server_config_t config;
+    memset(&config, 0, sizeof(config));
+
+    server_context_t *ctx = server_sm_create(&config);
+    if (ctx == NULL) {
+        fprintf(stderr, "server_sm_create failed\n");
+        exit(1);
+    }
+
+    server_sm_snapshot_t snap = {
+        .state = setup->state,
+        .ps5_power = setup->power,
+        .ps5_network = PS5_NET_UNKNOWN,
+        .client_count = setup->clients,
+        .error_count = setup->errors,
+    };
+    if (server_sm_restore(ctx, &snap) != 0) {
+        fprintf(stderr, "server_sm_restore(%s) failed\n", server_state_to_string(setup->state));
+        exit(1);
+    }
+    return ctx;
+}
+
+static uint64_t transition_total(server_context_t *ctx) {
+    server_sm_history_t history;
+    server_sm_get_history(ctx, &history);
+    return history.transitions;
+}
+
+/* ============================================================
+ *  Transition Table
+ * ============================================================ */
+
+/** 一列轉換 (或其守衛不成立的情況) 的預期結果 */
+typedef struct {
+    sm_setup_t setup;
+    server_event_t event;
+    int arg;
+    server_state_t expect;
+} sm_case_t;
+
+#define ON      PS5_POWER_ON
+#define OFF     PS5_POWER_STANDBY
+
+static const sm_case_t k_cases[] = {
+    // INIT
+    { { SERVER_STATE_INIT, 1, OFF, 0 }, SERVER_EVENT_START, 0, SERVER_STATE_CLIENT_CONNECTED },
+    { { SERVER_STATE_INIT, 0, OFF, 0 }, SERVER_EVENT_START, 0, SERVER_STATE_MONITORING },
+
+    // MONITORING
+    { { SERVER_STATE_MONITORING, 0, OFF, 0 }, SERVER_EVENT_POWER_CHANGED, ON, SERVER_STATE_PS5_DETECTED },
+    { { SERVER_STATE_MONITORING, 0, ON, 0 }, SERVER_EVENT_POWER_CHANGED, OFF, SERVER_STATE_MONITORING },
+    { { SERVER_STATE_MONITORING, 0, OFF, 0 }, SERVER_EVENT_CLIENT_CONNECTED, 1, SERVER_STATE_CLIENT_CONNECTED },
+    { { SERVER_STATE_MONITORING, 0, OFF, 5 }, SERVER_EVENT_WAKE_COMPLETED, 0, SERVER_STATE_ERROR },
+    { { SERVER_STATE_MONITORING, 0, OFF, 4 }, SERVER_EVENT_WAKE_COMPLETED, 0, SERVER_STATE_MONITORING },
+    { { SERVER_STATE_MONITORING, 0, OFF, 9 }, SERVER_EVENT_WAKE_COMPLETED, 1, SERVER_STATE_ERROR },
+    { { SERVER_STATE_MONITORING, 0, OFF, 5 }, SERVER_EVENT_ERROR, 0, SERVER_STATE_ERROR },
+    { { SERVER_STATE_MONITORING, 0, OFF, 4 }, SERVER_EVENT_ERROR, 0, SERVER_STATE_MONITORING },
+
+    // PS5_DETECTED
+    { { SERVER_STATE_PS5_DETECTED, 1, ON, 0 }, SERVER_EVENT_POWER_CHANGED, OFF, SERVER_STATE_CLIENT_CONNECTED },
+    { { SERVER_STATE_PS5_DETECTED, 0, ON, 0 }, SERVER_EVENT_POWER_CHANGED, OFF, SERVER_STATE_MONITORING },
+    { { SERVER_STATE_PS5_DETECTED, 0, ON, 0 }, SERVER_EVENT_POWER_CHANGED, ON, SERVER_STATE_PS5_DETECTED },
+    { { SERVER_STATE_PS5_DETECTED, 0, ON, 0 }, SERVER_EVENT_CLIENT_CONNECTED, 1, SERVER_STATE_CLIENT_CONNECTED },
+
+    // CLIENT_CONNECTED
+    { { SERVER_STATE_CLIENT_CONNECTED, 1, OFF, 0 }, SERVER_EVENT_WAKE_REQUESTED, 0, SERVER_STATE_WAKING_PS5 },
+    { { SERVER_STATE_CLIENT_CONNECTED, 1, ON, 0 }, SERVER_EVENT_WAKE_REQUESTED, 0, SERVER_STATE_CLIENT_CONNECTED },
+    { { SERVER_STATE_CLIENT_CONNECTED, 1, ON, 0 }, SERVER_EVENT_CLIENT_DISCONNECTED, 1, SERVER_STATE_PS5_DETECTED },
+    { { SERVER_STATE_CLIENT_CONNECTED, 1, OFF, 0 }, SERVER_EVENT_CLIENT_DISCONNECTED, 1, SERVER_STATE_MONITORING },
+    { { SERVER_STATE_CLIENT_CONNECTED, 2, OFF, 0 }, SERVER_EVENT_CLIENT_DISCONNECTED, 1, SERVER_STATE_CLIENT_CONNECTED },
+
+    // WAKING_PS5
+    { { SERVER_STATE_WAKING_PS5, 1, OFF, 3 }, SERVER_EVENT_WAKE_COMPLETED, 0, SERVER_STATE_ERROR },
+    { { SERVER_STATE_WAKING_PS5, 1, OFF, 5 }, SERVER_EVENT_WAKE_COMPLETED, 1, SERVER_STATE_CLIENT_CONNECTED },
+    { { SERVER_STATE_WAKING_PS5, 0, ON, 0 }, SERVER_EVENT_WAKE_COMPLETED, 1, SERVER_STATE_PS5_DETECTED },
+    { { SERVER_STATE_WAKING_PS5, 0, OFF, 0 }, SERVER_EVENT_WAKE_COMPLETED, 1, SERVER_STATE_MONITORING },
+    { { SERVER_STATE_WAKING_PS5, 1, OFF, 3 }, SERVER_EVENT_ERROR, 0, SERVER_STATE_ERROR },
+    { { SERVER_STATE_WAKING_PS5, 1, OFF, 2 }, SERVER_EVENT_ERROR, 0, SERVER_STATE_WAKING_PS5 },
+};
+
+#undef ON
+#undef OFF
+
+#define CASE_COUNT ((int)(sizeof(k_cases) / sizeof(k_cases[0])))
+
+static void run_case(const sm_case_t *c, int index) {
+    server_context_t *ctx = create_at(&c->setup);
+    uint64_t before = transition_total(ctx);
+
+    CHECK(server_sm_post(ctx, c->event, c->arg) == 0, "case %d: post failed", index);
+
+    server_state_t state = server_sm_get_state(ctx);
+    CHECK(state == c->expect, "case %d: %s + %s(%d) (clients %d, errors %d) -> %s, want %s",
+          index, server_state_to_string(c->setup.state), server_event_to_string(c->event),
+          c->arg, c->setup.clients, c->setup.errors,
+          server_state_to_string(state), server_state_to_string(c->expect));
+
+    // 狀態不變的列不記錄轉換
+    uint64_t recorded = transition_total(ctx) - before;
+    CHECK(recorded == (c->expect != c->setup.state ? 1u : 0u),
+          "case %d: %llu transitions recorded", index, (unsigned long long)recorded);
+
+    server_sm_destroy(ctx);
+}
+
+static bool has_case(server_state_t state, server_event_t event) {
+    for (int i = 0; i < CASE_COUNT; i++) {
+        if (k_cases[i].setup.state == state && k_cases[i].event == event) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 沒有對應列的組合: 在各種連線數、電源狀態與錯誤計數下狀態都不變
+ */
+static void test_unlisted_pairs(void) {
+    static const sm_setup_t k_contexts[] = {
+        { SERVER_STATE_INIT, 0, PS5_POWER_STANDBY, 0 },
+        { SERVER_STATE_INIT, 1, PS5_POWER_ON, 0 },
+        { SERVER_STATE_INIT, 2, PS5_POWER_STANDBY, 10 },
+        { SERVER_STATE_INIT, 1, PS5_POWER_UNKNOWN, 10 },
+    };
+    static const int k_args[] = { 0, 1, PS5_POWER_ON, PS5_POWER_STANDBY };
+
+    for (int s = 0; s < SERVER_STATE_COUNT; s++) {
+        for (int e = 0; e < SERVER_EVENT_COUNT; e++) {
+            if (e == SERVER_EVENT_RESET || has_case((server_state_t)s, (server_event_t)e)) {
+                continue;
+            }
+            for (size_t c = 0; c < sizeof(k_contexts) / sizeof(k_contexts[0]); c++) {
+                for (size_t a = 0; a < sizeof(k_args) / sizeof(k_args[0]); a++) {
+                    sm_setup_t setup = k_contexts[c];
+                    setup.state = (server_state_t)s;
+
+                    server_context_t *ctx = create_at(&setup);
+                    server_sm_post(ctx, (server_event_t)e, k_args[a]);
+                    server_state_t state = server_sm_get_state(ctx);
+                    CHECK(state == (server_state_t)s, "%s + %s(%d) (clients %d, errors %d) -> %s",
+                          server_state_to_string((server_state_t)s),
+                          server_event_to_string((server_event_t)e), k_args[a],
+                          setup.clients, setup.errors, server_state_to_string(state));
+                    server_sm_destroy(ctx);
+                }
+            }
+        }
+    }
+}
+
+static void test_reset(void) {
+    for (int s = 0; s < SERVER_STATE_COUNT; s++) {
+        sm_setup_t setup = { (server_state_t)s, 2, PS5_POWER_ON, 7 };
+        server_context_t *ctx = create_at(&setup);
+
+        server_sm_post(ctx, SERVER_EVENT_RESET, 0);
+
+        CHECK(server_sm_get_state(ctx) == SERVER_STATE_MONITORING,
+              "RESET from %s -> %s", server_state_to_string((server_state_t)s),
+              server_state_to_string(server_sm_get_state(ctx)));
+        CHECK(ctx->client_count == 0 && ctx->error_count == 0,
+              "RESET from %s: clients %d, errors %d",
+              server_state_to_string((server_state_t)s), ctx->client_count, ctx->error_count);
+        CHECK(ctx->ps5_power == PS5_POWER_UNKNOWN, "RESET kept power state %d", ctx->ps5_power);
+        server_sm_destroy(ctx);
+    }
+}
+
+/* ============================================================
+ *  Events Posted While Dispatching
+ * ============================================================ */
+
+typedef struct {
+    server_context_t *ctx;
+    server_state_t entered[MAX_ENTERED];
+    int count;
+} reentry_t;
+
+static void on_enter_posting(server_state_t state, void *user_data) {
+    reentry_t *r = (reentry_t*)user_data;
+    if (r->count < MAX_ENTERED) {
+        r->entered[r->count] = state;
+    }
+    r->count++;
+
+    // 第一次進入 CLIENT_CONNECTED 時送出兩個事件,應排入佇列而非立即處理
+    if (state == SERVER_STATE_CLIENT_CONNECTED && r->count == 1) {
+        CHECK(r->ctx->dispatching, "callback runs without dispatching set");
+
+        CHECK(server_sm_post(r->ctx, SERVER_EVENT_WAKE_REQUESTED, 0) == 0, "nested post failed");
+        CHECK(server_sm_get_state(r->ctx) == SERVER_STATE_CLIENT_CONNECTED,
+              "nested WAKE_REQUESTED dispatched before the callback returned (%s)",
+              server_state_to_string(server_sm_get_state(r->ctx)));
+
+        CHECK(server_sm_post(r->ctx, SERVER_EVENT_WAKE_COMPLETED, 1) == 0, "nested post failed");
+        CHECK(r->ctx->queue_count == 2, "%d events queued, want 2", r->ctx->queue_count);
+        CHECK(r->count == 1, "callback re-entered from a nested post");
+    }
+}
+
+static void test_post_while_dispatching(void) {
+    sm_setup_t setup = { SERVER_STATE_MONITORING, 0, PS5_POWER_STANDBY, 0 };
+    server_context_t *ctx = create_at(&setup);
+
+    reentry_t r = { .ctx = ctx };
+    server_sm_set_state_callback(ctx, on_enter_posting, &r);
+
+    server_sm_post(ctx, SERVER_EVENT_CLIENT_CONNECTED, 1);
+
+    static const server_state_t k_expect[] = {
+        SERVER_STATE_CLIENT_CONNECTED,
+        SERVER_STATE_WAKING_PS5,
+        SERVER_STATE_CLIENT_CONNECTED,
+    };
+    CHECK(r.count == 3, "%d states entered, want 3", r.count);
+    for (int i = 0; i < 3 && i < r.count; i++) {
+        CHECK(r.entered[i] == k_expect[i], "entered[%d] = %s, want %s", i,
+              server_state_to_string(r.entered[i]), server_state_to_string(k_expect[i]));
+    }
+
+    // 歷史中的觸發事件與送出順序一致
+    server_sm_history_t history;
+    server_sm_get_history(ctx, &history);
+    static const server_event_t k_events[] = {
+        SERVER_EVENT_CLIENT_CONNECTED,
+        SERVER_EVENT_WAKE_REQUESTED,
+        SERVER_EVENT_WAKE_COMPLETED,
+    };
+    CHECK(history.count >= 3, "%d history entries", history.count);
+    for (int i = 0; i < 3 && history.count >= 3; i++) {
+        const server_sm_history_entry_t *e = &history.entries[history.count - 3 + i];
+        CHECK(e->event == k_events[i], "history[%d] event %s, want %s", i,
+              server_event_to_string(e->event), server_event_to_string(k_events[i]));
+    }
+
+    CHECK(!ctx->dispatching && ctx->queue_count == 0,
+          "dispatching %d, %d events left", ctx->dispatching, ctx->queue_count);
+    server_sm_destroy(ctx);
+}
+
+/* ============================================================
+ *  Failed Wake
+ * ============================================================ */
+
+static void test_failed_wake(void) {
+    static const struct {
+        int clients;
+        ps5_power_state_t power;
+        server_state_t expect;
+    } k_exits[] = {
+        { 1, PS5_POWER_STANDBY, SERVER_STATE_CLIENT_CONNECTED },
+        { 0, PS5_POWER_ON, SERVER_STATE_PS5_DETECTED },
+        { 0, PS5_POWER_STANDBY, SERVER_STATE_MONITORING },
+    };
+
+    // 單次失敗: 不停留在 WAKING_PS5
+    for (size_t i = 0; i < sizeof(k_exits) / sizeof(k_exits[0]); i++) {
+        sm_setup_t setup = { SERVER_STATE_WAKING_PS5, k_exits[i].clients, k_exits[i].power, 0 };
+        server_context_t *ctx = create_at(&setup);
+
+        server_sm_on_wake_completed(ctx, false);
+        CHECK(server_sm_get_state(ctx) == k_exits[i].expect,
+              "failed wake (clients %d, power %d) -> %s, want %s",
+              k_exits[i].clients, k_exits[i].power,
+              server_state_to_string(server_sm_get_state(ctx)),
+              server_state_to_string(k_exits[i].expect));
+        CHECK(ctx->error_count == 1, "error count %d after one failure", ctx->error_count);
+        CHECK(!ctx->wake_requested, "wake_requested not cleared");
+        server_sm_destroy(ctx);
+    }
+
+    // 連續失敗: 前 3 次回到 CLIENT_CONNECTED,第 4 次進入 ERROR
+    sm_setup_t setup = { SERVER_STATE_CLIENT_CONNECTED, 1, PS5_POWER_STANDBY, 0 };
+    server_context_t *ctx = create_at(&setup);
+    for (int attempt = 1; attempt <= 4; attempt++) {
+        server_sm_on_wake_requested(ctx);
+        CHECK(server_sm_get_state(ctx) == SERVER_STATE_WAKING_PS5,
+              "attempt %d: wake request -> %s", attempt,
+              server_state_to_string(server_sm_get_state(ctx)));
+
+        server_sm_on_wake_completed(ctx, false);
+        server_state_t want = attempt <= 3 ? SERVER_STATE_CLIENT_CONNECTED : SERVER_STATE_ERROR;
+        CHECK(server_sm_get_state(ctx) == want, "attempt %d: failed wake -> %s, want %s",
+              attempt, server_state_to_string(server_sm_get_state(ctx)),
+              server_state_to_string(want));
+    }
+    server_sm_destroy(ctx);
+}
+
+/* ============================================================
+ *  Graph Output
+ * ============================================================ */
+
+static size_t read_all(FILE *fp, char *buf, size_t size) {
+    rewind(fp);
+    size_t n = fread(buf, 1, size - 1, fp);
+    buf[n] = '\0';
+    return n;
+}
+
+static void test_graph(const char *golden_path) {
+    static char actual[GRAPH_MAX_SIZE];
+    static char expected[GRAPH_MAX_SIZE];
+
+    FILE *out = tmpfile();
+    CHECK(out != NULL, "tmpfile failed");
+    if (out == NULL) {
+        return;
+    }
+    CHECK(server_sm_write_graph(out) == 0, "server_sm_write_graph failed");
+    size_t actual_len = read_all(out, actual, sizeof(actual));
+    fclose(out);
+
+    FILE *golden = fopen(golden_path, "r");
+    CHECK(golden != NULL, "cannot open %s", golden_path);
+    if (golden == NULL) {
+        return;
+    }
+    size_t expected_len = read_all(golden, expected, sizeof(expected));
+    fclose(golden);
+
+    CHECK(actual_len == expected_len && memcmp(actual, expected, actual_len) == 0,
+          "state graph differs from %s:\n%s", golden_path, actual);
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+int main(int argc, char *argv[]) {
+    const char *golden_path = argc > 1 ? argv[1] : GRAPH_GOLDEN_PATH;
+
+    vclock_use_simulated(0);
+
+    for (int i = 0; i < CASE_COUNT; i++) {
+        run_case(&k_cases[i], i);
+    }
+    test_unlisted_pairs();
+    test_reset();
+    test_post_while_dispatching();
+    test_failed_wake();
+    test_graph(golden_path);
+
+    if (g_failures > 0) {
+        fprintf(stderr, "server_sm_test: %d failures\n", g_failures);
+        return 1;
+    }
+    printf("server_sm_test: %d transition cases: OK\n", CASE_COUNT);
+    return 0;
+}
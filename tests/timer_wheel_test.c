@@ -0,0 +1,327 @@
+/**
+ * @file timer_wheel_test.c
+ * @brief 階層式時間輪的單元測試
+ *
+ * 項目:
+ * - 新增、取消、重新排程與 count / tw_timer_pending()
+ * - 到期時間向上取整到 tick,已過去的時間在下一個 tick 觸發
+ * - 跨越各層邊界 (64、64^2、64^3 tick) 的 cascade,並從非 0 的
+ *   目前 tick 開始,每個計時器都必須剛好在到期的 tick 觸發一次
+ * - 同一格的計時器: 相同 tick 依排程順序觸發,cascade 下來的
+ *   依到期順序觸發;回調中取消同一格的其他計時器
+ * - 隨機的到期時間與推進步長
+ *
+ * @code
+ * ./timer_wheel_test [SEED]
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-09
+ * @version 1.0.0
+ */
+
+#include "timer_wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+#define TICK_MS             100
+#define BASE_MS             1000000
+
+#define MAX_TIMERS          512
+#define RANDOM_TIMERS       400
+#define RANDOM_ROUNDS       20
+
+/** 第 L 層每格的 tick 數 */
+#define LEVEL_TICKS(level)  (1ull << (TIMER_WHEEL_SLOT_BITS * (level)))
+
+/* ============================================================
+ *  Checks
+ * ============================================================ */
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* ============================================================
+ *  Test Timers
+ * ============================================================ */
+
+typedef struct {
+    tw_timer_t timer;
+    timer_wheel_t *wheel;
+    int id;
+    uint64_t due_tick;          /**< 預期觸發的 tick */
+    uint64_t fired_tick;        /**< 實際觸發的 tick */
+    int fired;                  /**< 觸發次數 */
+    tw_timer_t *cancel;         /**< 觸發時取消的計時器 (可為 NULL) */
+} test_timer_t;
+
+static test_timer_t g_timers[MAX_TIMERS];
+
+/** 觸發順序 (id) */
+static int g_order[MAX_TIMERS];
+static int g_order_count = 0;
+
+static void on_timer(tw_timer_t *timer, void *user_data) {
+    test_timer_t *t = (test_timer_t*)user_data;
+    (void)timer;
+
+    t->fired++;
+    t->fired_tick = t->wheel->current;
+    if (g_order_count < MAX_TIMERS) {
+        g_order[g_order_count++] = t->id;
+    }
+    if (t->cancel != NULL) {
+        timer_wheel_cancel(t->wheel, t->cancel);
+    }
+}
+
+static void reset(timer_wheel_t *wheel) {
+    timer_wheel_init(wheel, BASE_MS, TICK_MS);
+    memset(g_timers, 0, sizeof(g_timers));
+    for (int i = 0; i < MAX_TIMERS; i++) {
+        g_timers[i].wheel = wheel;
+        g_timers[i].id = i;
+        tw_timer_init(&g_timers[i].timer, on_timer, &g_timers[i]);
+    }
+    g_order_count = 0;
+}
+
+static uint64_t tick_ms(uint64_t tick) {
+    return BASE_MS + tick * TICK_MS;
+}
+
+/**
+ * @brief 在 tick due 排程計時器 i
+ */
+static void schedule_at(timer_wheel_t *wheel, int i, uint64_t due) {
+    g_timers[i].due_tick = due;
+    timer_wheel_schedule(wheel, &g_timers[i].timer, tick_ms(due));
+}
+
+/**
+ * @brief 檢查前 count 個計時器都剛好在預期的 tick 觸發一次
+ */
+static void check_fired(int count, const char *what) {
+    for (int i = 0; i < count; i++) {
+        const test_timer_t *t = &g_timers[i];
+        CHECK(t->fired == 1 && t->fired_tick == t->due_tick,
+              "%s: timer %d due %" PRIu64 " fired %d times, at %" PRIu64,
+              what, i, t->due_tick, t->fired, t->fired_tick);
+    }
+}
+
+/* ============================================================
+ *  Tests
+ * ============================================================ */
+
+static void test_schedule_cancel(void) {
+    timer_wheel_t wheel;
+    reset(&wheel);
+
+    // 向上取整: 1 ms 後在 tick 1,剛好一個 tick 也在 tick 1
+    timer_wheel_schedule(&wheel, &g_timers[0].timer, BASE_MS + 1);
+    timer_wheel_schedule(&wheel, &g_timers[1].timer, BASE_MS + TICK_MS);
+    g_timers[0].due_tick = g_timers[1].due_tick = 1;
+    // 已過去的時間: 下一個 tick
+    timer_wheel_schedule(&wheel, &g_timers[2].timer, 0);
+    g_timers[2].due_tick = 1;
+
+    schedule_at(&wheel, 3, 10);
+    schedule_at(&wheel, 4, 10);
+    schedule_at(&wheel, 5, 200);
+    CHECK(wheel.count == 6, "count %zu after 6 schedules", wheel.count);
+    CHECK(tw_timer_pending(&g_timers[4].timer), "scheduled timer not pending");
+
+    // 取消與重複取消
+    timer_wheel_cancel(&wheel, &g_timers[4].timer);
+    timer_wheel_cancel(&wheel, &g_timers[4].timer);
+    CHECK(!tw_timer_pending(&g_timers[4].timer), "cancelled timer still pending");
+    CHECK(wheel.count == 5, "count %zu after cancel", wheel.count);
+
+    // 重新排程取代原本的到期時間 (200 → 20)
+    schedule_at(&wheel, 5, 20);
+    CHECK(wheel.count == 5, "count %zu after reschedule", wheel.count);
+
+    // 提早推進不觸發 (tick 1 差 1 ms)
+    CHECK(timer_wheel_advance(&wheel, BASE_MS + TICK_MS - 1) == 0, "fired before tick 1");
+    CHECK(timer_wheel_advance(&wheel, tick_ms(1)) == 3, "tick 1 did not fire 3 timers");
+    CHECK(timer_wheel_advance(&wheel, tick_ms(300)) == 2, "ticks 2-300 did not fire 2 timers");
+
+    CHECK(g_timers[4].fired == 0, "cancelled timer fired");
+    g_timers[4].fired = 1;
+    g_timers[4].fired_tick = g_timers[4].due_tick;
+    check_fired(6, "schedule/cancel");
+    CHECK(wheel.count == 0, "count %zu after all fired", wheel.count);
+
+    // 排程在目前 tick (已處理過) 延到下一個 tick
+    schedule_at(&wheel, 6, 300);
+    g_timers[6].due_tick = 301;
+    CHECK(timer_wheel_advance(&wheel, tick_ms(301)) == 1 && g_timers[6].fired_tick == 301,
+          "timer at the current tick fired at %" PRIu64, g_timers[6].fired_tick);
+}
+
+static void test_cascade(uint64_t start, bool full_range) {
+    timer_wheel_t wheel;
+    reset(&wheel);
+    timer_wheel_advance(&wheel, tick_ms(start));
+
+    // 每層邊界的前後一個 tick
+    int n = 0;
+    for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        uint64_t edge = LEVEL_TICKS(level);
+        for (int d = -1; d <= 1; d++) {
+            schedule_at(&wheel, n++, start + edge + (uint64_t)d);
+        }
+        // 對齊到下一個邊界 (目前 tick 不在邊界上時,cascade 在此觸發)
+        uint64_t aligned = (start / edge + 1) * edge;
+        schedule_at(&wheel, n++, aligned);
+        schedule_at(&wheel, n++, aligned + 1);
+    }
+    schedule_at(&wheel, n++, start + 1);
+
+    // 最遠的距離與超過範圍 (在最遠可排程的 tick 觸發) 需要推進 64^4 tick
+    uint64_t end = start + LEVEL_TICKS(TIMER_WHEEL_LEVELS - 1) + 2;
+    if (full_range) {
+        schedule_at(&wheel, n++, start + LEVEL_TICKS(TIMER_WHEEL_LEVELS) - 1);
+        timer_wheel_schedule(&wheel, &g_timers[n].timer,
+                             tick_ms(start + LEVEL_TICKS(TIMER_WHEEL_LEVELS) + 500));
+        g_timers[n].due_tick = start + LEVEL_TICKS(TIMER_WHEEL_LEVELS) - 1;
+        n++;
+        end = start + LEVEL_TICKS(TIMER_WHEEL_LEVELS);
+    }
+
+    CHECK(wheel.count == (size_t)n, "count %zu, expected %d", wheel.count, n);
+
+    // 大步推進 (每次跨越多層) 與逐 tick 推進結果相同
+    for (uint64_t tick = start; tick < end; tick += 4093) {
+        timer_wheel_advance(&wheel, tick_ms(tick));
+    }
+    timer_wheel_advance(&wheel, tick_ms(end));
+
+    char what[48];
+    snprintf(what, sizeof(what), "cascade from tick %" PRIu64, start);
+    check_fired(n, what);
+    CHECK(wheel.count == 0, "%s: %zu timers left", what, wheel.count);
+}
+
+static void test_same_slot_order(void) {
+    timer_wheel_t wheel;
+    reset(&wheel);
+
+    // 同一 tick: 依排程順序
+    for (int i = 0; i < 8; i++) {
+        schedule_at(&wheel, i, 5);
+    }
+    timer_wheel_advance(&wheel, tick_ms(5));
+    for (int i = 0; i < 8; i++) {
+        CHECK(g_order[i] == i, "same tick: position %d fired timer %d", i, g_order[i]);
+    }
+
+    // 同一個第 1 層格子 (tick 128-191),反向排程後依到期順序觸發
+    reset(&wheel);
+    for (int i = 0; i < 8; i++) {
+        schedule_at(&wheel, i, 128 + (uint64_t)(7 - i) * 8);
+    }
+    schedule_at(&wheel, 8, 128 + 7 * 8);    // 與 timer 0 同一 tick,排在後面
+    timer_wheel_advance(&wheel, tick_ms(300));
+    static const int k_expected[] = { 7, 6, 5, 4, 3, 2, 1, 0, 8 };
+    for (int i = 0; i < 9; i++) {
+        CHECK(g_order[i] == k_expected[i], "level 1 slot: position %d fired timer %d (expected %d)",
+              i, g_order[i], k_expected[i]);
+    }
+    check_fired(9, "level 1 slot");
+
+    // 回調取消同一 tick 中排在後面的計時器
+    reset(&wheel);
+    schedule_at(&wheel, 0, 70);
+    schedule_at(&wheel, 1, 70);
+    schedule_at(&wheel, 2, 70);
+    g_timers[0].cancel = &g_timers[1].timer;
+    CHECK(timer_wheel_advance(&wheel, tick_ms(70)) == 2, "cancel in callback");
+    CHECK(g_timers[1].fired == 0 && g_timers[2].fired == 1 && wheel.count == 0,
+          "timer cancelled from a callback still fired");
+}
+
+static uint64_t g_rng;
+
+static uint64_t rnd(void) {
+    // xorshift64*
+    g_rng ^= g_rng >> 12;
+    g_rng ^= g_rng << 25;
+    g_rng ^= g_rng >> 27;
+    return g_rng * 0x2545F4914F6CDD1DULL;
+}
+
+static void test_random(void) {
+    for (int round = 0; round < RANDOM_ROUNDS; round++) {
+        timer_wheel_t wheel;
+        reset(&wheel);
+        uint64_t now = rnd() % 100000;
+        timer_wheel_advance(&wheel, tick_ms(now));
+
+        // 第 0-2 層的距離 (第 3 層由 test_cascade 涵蓋)
+        for (int i = 0; i < RANDOM_TIMERS; i++) {
+            uint64_t range = LEVEL_TICKS(1 + rnd() % (TIMER_WHEEL_LEVELS - 1)) - 1;
+            schedule_at(&wheel, i, now + 1 + rnd() % range);
+        }
+        // 部分取消
+        for (int i = 0; i < RANDOM_TIMERS; i += 7) {
+            timer_wheel_cancel(&wheel, &g_timers[i].timer);
+        }
+
+        uint64_t end = now + LEVEL_TICKS(TIMER_WHEEL_LEVELS - 1);
+        while (now < end) {
+            now += 1 + rnd() % ((rnd() & 1) ? 50 : 5000);
+            timer_wheel_advance(&wheel, tick_ms(now));
+        }
+
+        for (int i = 0; i < RANDOM_TIMERS; i++) {
+            const test_timer_t *t = &g_timers[i];
+            int expected = (i % 7 == 0) ? 0 : 1;
+            CHECK(t->fired == expected && (expected == 0 || t->fired_tick == t->due_tick),
+                  "random round %d: timer %d due %" PRIu64 " fired %d times, at %" PRIu64,
+                  round, i, t->due_tick, t->fired, t->fired_tick);
+        }
+        CHECK(wheel.count == 0, "random round %d: %zu timers left", round, wheel.count);
+    }
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+int main(int argc, char *argv[]) {
+    uint64_t seed = (argc > 1) ? strtoull(argv[1], NULL, 0) : 0x9E3779B97F4A7C15ULL;
+    g_rng = seed ? seed : 1;
+
+    test_schedule_cancel();
+    test_cascade(0, false);
+    test_cascade(70, true);
+    test_cascade(LEVEL_TICKS(2) - 3, false);
+    test_same_slot_order();
+    test_random();
+
+    if (g_failures > 0) {
+        fprintf(stderr, "timer_wheel_test: %d failures (seed 0x%" PRIx64 ")\n", g_failures, seed);
+        return 1;
+    }
+    printf("timer_wheel_test: seed 0x%" PRIx64 ": OK\n", seed);
+    return 0;
+}
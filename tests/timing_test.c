@@ -0,0 +1,342 @@
+/**
+ * @file timing_test.c
+ * @brief 以模擬時鐘 (vclock) 驗證與時間相關的行為
+ *
+ * 項目:
+ * - CEC 輪詢: 每 CEC_POLL_INTERVAL_MS 一次,回報的狀態在下一次輪詢才
+ *   生效,連續失敗 CEC_MAX_CONSECUTIVE_ERRORS 次後變為 UNKNOWN,
+ *   cec_monitor_set_poll_interval() 從下一次睡眠開始生效
+ * - 喚醒: 失敗後間隔 1 秒重試,最多 WAKE_MAX_RETRIES 次,
+ *   ps5_wake_verify() 等待 WAKE_VERIFY_DELAY_MS
+ * - 網路狀態刷新讀取的偵測快取: 超過 PS5_CACHE_MAX_AGE 秒後失效
+ *
+ * 數小時的模擬時間在數毫秒內跑完。CEC 監控執行緒在背景執行,
+ * 每次推進時間前等它回到 vclock_sleep_us(),期限才會從預期的時間起算。
+ *
+ * @author Gaming System Development Team
+ * @date 2025-12-09
+ * @version 1.0.0
+ */
+
+#include "cec_monitor.h"
+#include "ps5_wake.h"
+#include "ps5_detector.h"
+#include "trace_ring.h"
+#include "vclock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ============================================================
+ *  Constants
+ * ============================================================ */
+
+/** 與 cec_monitor.c 相同 */
+#define CEC_POLL_INTERVAL_US        (5000 * VCLOCK_US_PER_MS)
+#define CEC_MAX_CONSECUTIVE_ERRORS  5
+
+/** 與 ps5_wake.c 相同 */
+#define WAKE_RETRY_US               VCLOCK_US_PER_SEC
+#define WAKE_VERIFY_US              (3000 * VCLOCK_US_PER_MS)
+#define WAKE_MAX_RETRIES            3
+
+/** 模擬的牆上時間起點 (2025-12-08 00:00:00 UTC) */
+#define SIM_START_REALTIME          1765152000
+
+/** 等待背景執行緒的真實時間上限 */
+#define THREAD_WAIT_MS              2000
+
+#define MAX_TRANSITIONS             16
+
+/* ============================================================
+ *  Checks
+ * ============================================================ */
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* ============================================================
+ *  Observed Transitions
+ * ============================================================ */
+
+typedef struct {
+    int value;              /**< ps5_power_state_t 或喚醒結果 */
+    uint64_t time_us;       /**< 觸發時的模擬時間 */
+} transition_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static transition_t g_transitions[MAX_TRANSITIONS];
+static int g_transition_count = 0;
+
+static void record_transition(int value) {
+    pthread_mutex_lock(&g_lock);
+    if (g_transition_count < MAX_TRANSITIONS) {
+        g_transitions[g_transition_count].value = value;
+        g_transitions[g_transition_count].time_us = vclock_now_us();
+        g_transition_count++;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+static int transition_count(void) {
+    pthread_mutex_lock(&g_lock);
+    int count = g_transition_count;
+    pthread_mutex_unlock(&g_lock);
+    return count;
+}
+
+static transition_t transition_at(int i) {
+    pthread_mutex_lock(&g_lock);
+    transition_t t = g_transitions[i];
+    pthread_mutex_unlock(&g_lock);
+    return t;
+}
+
+static void reset_transitions(void) {
+    pthread_mutex_lock(&g_lock);
+    g_transition_count = 0;
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void on_power_changed(ps5_power_state_t state, void *user_data) {
+    (void)user_data;
+    record_transition((int)state);
+}
+
+static void on_wake_result(bool success, void *user_data) {
+    (void)user_data;
+    record_transition(success ? 1 : 0);
+}
+
+/**
+ * @brief 讀取 since 之後某類型的 trace 記錄
+ *
+ * @return 筆數
+ */
+static int read_trace(uint64_t since, trace_event_t event, trace_record_t *out, int max) {
+    trace_record_t records[64];
+    int found = 0;
+    int n;
+
+    while ((n = trace_ring_read(since, records, 64, &since)) > 0) {
+        for (int i = 0; i < n; i++) {
+            if (records[i].event == event && found < max) {
+                out[found++] = records[i];
+            }
+        }
+    }
+    return found;
+}
+
+/* ============================================================
+ *  CEC Poll Interval
+ * ============================================================ */
+
+static uint64_t g_poll_since;
+
+static int poll_count(void) {
+    trace_record_t polls[64];
+    return read_trace(g_poll_since, TRACE_CEC_POLL, polls, 64);
+}
+
+/**
+ * @brief 推進時間,等監控執行緒完成 expected 次輪詢並回到睡眠
+ */
+static void advance_and_wait(uint64_t us, int expected) {
+    vclock_advance(us);
+
+    for (int ms = 0; ms < THREAD_WAIT_MS; ms++) {
+        if (poll_count() == expected && vclock_sleepers() == 1) {
+            return;
+        }
+        usleep(1000);
+    }
+    CHECK(false, "monitor thread: %d polls, %d sleepers (expected %d polls)",
+          poll_count(), vclock_sleepers(), expected);
+}
+
+static void test_cec_poll(void) {
+    reset_transitions();
+    g_poll_since = trace_ring_next_seq();
+
+    cec_monitor_init();
+    cec_monitor_set_callback(on_power_changed, NULL);
+    cec_monitor_test_set_power(PS5_POWER_ON);
+
+    uint64_t t0 = vclock_now_us();
+    CHECK(cec_monitor_start() == 0, "cec_monitor_start failed");
+
+    // 啟動時立即輪詢一次
+    advance_and_wait(0, 1);
+    CHECK(transition_count() == 1 && transition_at(0).value == PS5_POWER_ON &&
+          transition_at(0).time_us == t0, "first poll did not report ON at start");
+
+    // 回報的狀態在下一次輪詢才生效
+    cec_monitor_test_set_power(PS5_POWER_STANDBY);
+    advance_and_wait(CEC_POLL_INTERVAL_US - 1, 1);
+    CHECK(transition_count() == 1, "poll ran before the interval elapsed");
+    advance_and_wait(1, 2);
+    CHECK(transition_count() == 2 && transition_at(1).value == PS5_POWER_STANDBY &&
+          transition_at(1).time_us == t0 + CEC_POLL_INTERVAL_US,
+          "STANDBY not reported exactly one interval later");
+
+    // 查詢失敗: 第 CEC_MAX_CONSECUTIVE_ERRORS 次才變為 UNKNOWN
+    cec_monitor_test_set_power(PS5_POWER_UNKNOWN);
+    for (int i = 1; i <= CEC_MAX_CONSECUTIVE_ERRORS; i++) {
+        CHECK(transition_count() == 2, "UNKNOWN after %d failed polls", i - 1);
+        advance_and_wait(CEC_POLL_INTERVAL_US, 2 + i);
+    }
+    CHECK(transition_count() == 3 && transition_at(2).value == PS5_POWER_UNKNOWN &&
+          transition_at(2).time_us == t0 + (1 + CEC_MAX_CONSECUTIVE_ERRORS) * CEC_POLL_INTERVAL_US,
+          "UNKNOWN not reported after %d failed polls", CEC_MAX_CONSECUTIVE_ERRORS);
+
+    trace_record_t polls[64];
+    int n = read_trace(g_poll_since, TRACE_CEC_POLL, polls, 64);
+    CHECK(n == 2 + CEC_MAX_CONSECUTIVE_ERRORS, "%d polls recorded", n);
+    for (int i = 1; i < n; i++) {
+        CHECK(polls[i].time_ns - polls[i - 1].time_ns == CEC_POLL_INTERVAL_US * 1000ULL,
+              "poll %d spaced %" PRIu64 " ns", i, polls[i].time_ns - polls[i - 1].time_ns);
+    }
+    CHECK(polls[n - 1].a2 == CEC_MAX_CONSECUTIVE_ERRORS, "error streak %u", polls[n - 1].a2);
+
+    // 新的間隔從下一次睡眠開始
+    cec_monitor_set_poll_interval(1000);
+    cec_monitor_test_set_power(PS5_POWER_ON);
+    uint64_t t1 = vclock_now_us();
+    advance_and_wait(CEC_POLL_INTERVAL_US, n + 1);
+    advance_and_wait(1000 * VCLOCK_US_PER_MS, n + 2);
+    CHECK(transition_count() == 4 && transition_at(3).value == PS5_POWER_ON &&
+          transition_at(3).time_us == t1 + CEC_POLL_INTERVAL_US,
+          "ON not reported at the next poll");
+    CHECK(vclock_now_us() - t1 == CEC_POLL_INTERVAL_US + 1000 * VCLOCK_US_PER_MS,
+          "new interval not applied");
+
+    cec_monitor_stop();
+    cec_monitor_cleanup();
+}
+
+/* ============================================================
+ *  Wake Retry and Verify
+ * ============================================================ */
+
+static void test_wake_retry(void) {
+    // 單執行緒: 重試與驗證的睡眠直接推進時間
+    vclock_set_auto_advance(true);
+    ps5_wake_init();
+    ps5_wake_set_callback(on_wake_result, NULL);
+
+    // 兩次失敗後成功
+    reset_transitions();
+    uint64_t since = trace_ring_next_seq();
+    uint64_t t0 = vclock_now_us();
+    ps5_wake_test_fail_attempts(2);
+    CHECK(ps5_wake_send() == 0, "wake failed after 2 failed attempts");
+    CHECK(vclock_now_us() - t0 == 2 * WAKE_RETRY_US,
+          "two retries took %" PRIu64 " us", vclock_now_us() - t0);
+    CHECK(transition_count() == 1 && transition_at(0).value == 1 &&
+          transition_at(0).time_us == t0 + 2 * WAKE_RETRY_US, "success not reported at the third attempt");
+    CHECK(ps5_wake_get_retry_count() == 0, "retry count not reset after success");
+
+    trace_record_t attempts[8];
+    int n = read_trace(since, TRACE_WAKE_ATTEMPT, attempts, 8);
+    CHECK(n == 3, "%d attempts recorded", n);
+    for (int i = 0; i < n && i < 3; i++) {
+        CHECK(attempts[i].a0 == i + 1 && attempts[i].a1 == (i < 2 ? 1u : 0u) &&
+              attempts[i].time_ns / 1000 == t0 + (uint64_t)i * WAKE_RETRY_US,
+              "attempt %d: #%u result %u", i, attempts[i].a0, attempts[i].a1);
+    }
+
+    // 全部失敗: 最後一次之後不再等待
+    reset_transitions();
+    t0 = vclock_now_us();
+    ps5_wake_test_fail_attempts(WAKE_MAX_RETRIES);
+    CHECK(ps5_wake_send() == -1, "wake succeeded with every attempt failing");
+    CHECK(vclock_now_us() - t0 == (WAKE_MAX_RETRIES - 1) * WAKE_RETRY_US,
+          "failed wake took %" PRIu64 " us", vclock_now_us() - t0);
+    CHECK(transition_count() == 1 && transition_at(0).value == 0, "failure not reported once");
+    CHECK(ps5_wake_get_retry_count() == WAKE_MAX_RETRIES, "retry count %d",
+          ps5_wake_get_retry_count());
+
+    // 驗證前等待 PS5 啟動
+    ps5_power_state_t state = PS5_POWER_UNKNOWN;
+    t0 = vclock_now_us();
+    CHECK(ps5_wake_verify(&state) == 0 && state == PS5_POWER_ON, "verify failed");
+    CHECK(vclock_now_us() - t0 == WAKE_VERIFY_US, "verify waited %" PRIu64 " us",
+          vclock_now_us() - t0);
+
+    ps5_wake_cleanup();
+    vclock_set_auto_advance(false);
+}
+
+/* ============================================================
+ *  Detector Cache Expiry
+ * ============================================================ */
+
+static void test_cache_expiry(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/timing_test.%d.cache", (int)getpid());
+
+    CHECK(ps5_detector_init("192.168.100.0/24", path) == PS5_DETECT_OK, "detector init failed");
+
+    ps5_info_t info;
+    memset(&info, 0, sizeof(info));
+    snprintf(info.ip, sizeof(info.ip), "192.168.100.50");
+    snprintf(info.mac, sizeof(info.mac), "00:11:22:33:44:55");
+    info.online = true;
+    info.last_seen = vclock_time();
+    CHECK(ps5_detector_save_cache(&info) == PS5_DETECT_OK, "save cache failed");
+
+    ps5_info_t cached;
+    vclock_advance((uint64_t)PS5_CACHE_MAX_AGE * VCLOCK_US_PER_SEC);
+    CHECK(ps5_detector_get_cached(&cached) == PS5_DETECT_OK && cached.online,
+          "cache expired before %d s", PS5_CACHE_MAX_AGE);
+
+    vclock_advance(VCLOCK_US_PER_SEC);
+    CHECK(ps5_detector_get_cached(&cached) == PS5_DETECT_ERROR_CACHE_INVALID,
+          "cache still valid after %d s", PS5_CACHE_MAX_AGE + 1);
+
+    ps5_detector_cleanup();
+    unlink(path);
+}
+
+/* ============================================================
+ *  Main
+ * ============================================================ */
+
+int main(void) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    vclock_use_simulated(SIM_START_REALTIME);
+    uint64_t sim_start_us = vclock_now_us();
+
+    test_cec_poll();
+    test_wake_retry();
+    test_cache_expiry();
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double real_ms = (double)(end.tv_sec - start.tv_sec) * 1e3 +
+                     (double)(end.tv_nsec - start.tv_nsec) / 1e6;
+
+    if (g_failures > 0) {
+        fprintf(stderr, "timing_test: %d failures\n", g_failures);
+        return 1;
+    }
+    printf("timing_test: %.0f s simulated in %.1f ms: OK\n",
+           (double)(vclock_now_us() - sim_start_us) / 1e6, real_ms);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file trace_decode.c
+ * @brief Flight Recorder Decoder - 將 trace 檔案轉成時間軸
+ *
+ * 讀取 gaming-server 在 SIGUSR1 時輸出的檔案 (trace_ring.h),
+ * 每筆記錄輸出一行: 牆上時間、與前一筆的間隔、序號與事件內容。
+ * 序號不連續表示中間的記錄已被覆蓋或寫入中。
+ *
+ * 在開發主機上編譯 (與路由器相同的位元組順序),或 make -C tests trace_decode:
+ * @code
+ * cc -O2 -Isrc -o trace_decode tools/trace_decode.c src/trace_ring.c src/vclock.c -lpthread
+ * ./trace_decode gaming-server.trace
+ * @endcode
+ *
+ * @author Gaming System Development Team
+ * @date 2025-11-28
+ * @version 1.0.0
+ */
+
+#include "trace_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s TRACE_FILE\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (fp == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    trace_file_header_t header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s: not a trace file\n", argv[1]);
+        fclose(fp);
+        return 1;
+    }
+    if (header.version != TRACE_FILE_VERSION || header.record_size != sizeof(trace_record_t)) {
+        fprintf(stderr, "%s: unsupported version %" PRIu32 " (record size %" PRIu32 ")\n",
+                argv[1], header.version, header.record_size);
+        fclose(fp);
+        return 1;
+    }
+
+    printf("# %" PRIu64 " records, first seq %" PRIu64 "\n", header.count, header.first_seq);
+
+    trace_record_t record;
+    uint64_t prev_ns = 0;
+    uint64_t expected_seq = header.first_seq;
+    char line[160];
+
+    while (fread(&record, sizeof(record), 1, fp) == 1) {
+        if (record.seq != expected_seq) {
+            printf("# ... %" PRIu64 " records lost\n", record.seq - expected_seq);
+        }
+        expected_seq = record.seq + 1;
+
+        int64_t wall_ns = (int64_t)record.time_ns + header.realtime_offset_ns;
+        time_t sec = (time_t)(wall_ns / 1000000000);
+        struct tm tm;
+        char stamp[32];
+        localtime_r(&sec, &tm);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+
+        double delta = (prev_ns != 0) ? (double)(record.time_ns - prev_ns) / 1e9 : 0.0;
+        prev_ns = record.time_ns;
+
+        if (trace_record_format(&record, line, sizeof(line)) < 0) {
+            snprintf(line, sizeof(line), "event=%u", record.event);
+        }
+
+        printf("%s.%06" PRId64 "  +%10.6f  #%-8" PRIu64 " %s\n", stamp,
+               (wall_ns % 1000000000) / 1000, delta, record.seq, line);
+    }
+
+    fclose(fp);
+    return 0;
+}